@@ -40,7 +40,8 @@ public class MeshDeformationToolkit : ModuleRules
 				"Slate",
 				"SlateCore",
                 "Rawmesh", // Need access to UE4's Rawmesh to write Static Meshes
-                "ProceduralMeshComponent"
+                "ProceduralMeshComponent",
+				"Json" // The batch commandlet's report
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
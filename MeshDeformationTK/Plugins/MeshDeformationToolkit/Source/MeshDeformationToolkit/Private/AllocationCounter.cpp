@@ -0,0 +1,149 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformAtomics.h"
+#include "Templates/TypeCompatibleBytes.h"
+
+#include "AllocationCounter.h"
+
+namespace
+{
+	/// The innermost counter in scope on each thread
+	thread_local FScopedAllocationCounter *ThreadCounter = nullptr;
+
+	/// An allocator which passes everything on to the one it wraps, counting the allocations
+	/// made on threads with a counter in scope.
+	class FCountingMalloc: public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc *InInnerMalloc)
+			: InnerMalloc(InInnerMalloc)
+		{
+		}
+
+		virtual void *Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			FScopedAllocationCounter::RecordAllocation(Count);
+			return InnerMalloc->Malloc(Count, Alignment);
+		}
+
+		virtual void *Realloc(void *Original, SIZE_T Count, uint32 Alignment) override
+		{
+			// Reallocating to 0 is a free.
+			if (Count>0)
+			{
+				FScopedAllocationCounter::RecordAllocation(Count);
+			}
+			return InnerMalloc->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void *Original) override
+		{
+			InnerMalloc->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return InnerMalloc->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void *Original, SIZE_T &SizeOut) override
+		{
+			return InnerMalloc->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual void SetupTLSCachesOnCurrentThread() override
+		{
+			InnerMalloc->SetupTLSCachesOnCurrentThread();
+		}
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+		{
+			InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread();
+		}
+
+		virtual void GetAllocatorStats(FGenericMemoryStats &OutStats) override
+		{
+			InnerMalloc->GetAllocatorStats(OutStats);
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return InnerMalloc->IsInternallyThreadSafe();
+		}
+
+		virtual bool ValidateHeap() override
+		{
+			return InnerMalloc->ValidateHeap();
+		}
+
+		virtual const TCHAR *GetDescriptiveName() override
+		{
+			return InnerMalloc->GetDescriptiveName();
+		}
+
+	private:
+		FMalloc *InnerMalloc;
+	};
+
+	/// Put the counting allocator in front of GMalloc, the first time this is called.
+	///
+	/// It's never taken out again, and never destroyed, so no thread can be left calling into
+	/// it after it's gone.  GMalloc is swapped with a single atomic exchange, and as both
+	/// allocators share one heap it doesn't matter which of them any other thread uses.
+	void InstallCountingMalloc()
+	{
+		static const bool bInstalled = []()
+		{
+			static TTypeCompatibleBytes<FCountingMalloc> Storage;
+			FCountingMalloc *CountingMalloc = ::new (Storage.GetTypedPtr()) FCountingMalloc(GMalloc);
+			FPlatformAtomics::InterlockedExchangePtr((void **)&GMalloc, CountingMalloc);
+			return true;
+		}();
+		(void)bInstalled;
+	}
+}
+
+FScopedAllocationCounter::FScopedAllocationCounter()
+	: OuterCounter(ThreadCounter)
+{
+	InstallCountingMalloc();
+	ThreadCounter = this;
+}
+
+FScopedAllocationCounter::~FScopedAllocationCounter()
+{
+	ThreadCounter = OuterCounter;
+	if (OuterCounter)
+	{
+		OuterCounter->AllocationCount += AllocationCount;
+		OuterCounter->BytesAllocated += BytesAllocated;
+	}
+}
+
+void FScopedAllocationCounter::Reset()
+{
+	AllocationCount = 0;
+	BytesAllocated = 0;
+}
+
+int64 FScopedAllocationCounter::GetAllocationCount() const
+{
+	return AllocationCount;
+}
+
+int64 FScopedAllocationCounter::GetBytesAllocated() const
+{
+	return BytesAllocated;
+}
+
+void FScopedAllocationCounter::RecordAllocation(SIZE_T Size)
+{
+	// Only the calling thread touches its counter, so this doesn't need to be atomic.
+	if (FScopedAllocationCounter *Counter = ThreadCounter)
+	{
+		++Counter->AllocationCount;
+		Counter->BytesAllocated += (int64)Size;
+	}
+}
@@ -0,0 +1,580 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+// No engine headers here, see DeformationCore.h.
+#include <cmath>
+
+#include "DeformationCore.h"
+
+namespace
+{
+	using Float3 = DeformationCore::Float3;
+
+	/// Squared lengths below this are treated as zero, matching the engine's SMALL_NUMBER
+	const float SmallNumber = 1.e-8f;
+
+	/// The number of words in a mask of Count weights
+	inline int32_t GetMaskWordCount(int32_t Count)
+	{
+		return (Count+31)/32;
+	}
+
+	/// The bits of the last word of a mask which hold weights
+	inline uint32_t GetLastMaskWordBits(int32_t Count)
+	{
+		return Count%32==0 ? ~0u : (1u<<(Count%32))-1;
+	}
+
+	/// The number of set bits in a word
+	inline int32_t CountBits(uint32_t Bits)
+	{
+		Bits = Bits-((Bits>>1)&0x55555555u);
+		Bits = (Bits&0x33333333u)+((Bits>>2)&0x33333333u);
+		Bits = (Bits+(Bits>>4))&0x0f0f0f0fu;
+		return (int32_t)((Bits*0x01010101u)>>24);
+	}
+
+	inline Float3 AddVectors(const Float3 &A, const Float3 &B)
+	{
+		return {A.X+B.X, A.Y+B.Y, A.Z+B.Z};
+	}
+
+	inline Float3 SubtractVectors(const Float3 &A, const Float3 &B)
+	{
+		return {A.X-B.X, A.Y-B.Y, A.Z-B.Z};
+	}
+
+	inline Float3 ScaleVector(const Float3 &A, float Scale)
+	{
+		return {A.X*Scale, A.Y*Scale, A.Z*Scale};
+	}
+
+	inline float Dot(const Float3 &A, const Float3 &B)
+	{
+		return A.X*B.X+A.Y*B.Y+A.Z*B.Z;
+	}
+
+	inline float Size(const Float3 &A)
+	{
+		return std::sqrt(Dot(A, A));
+	}
+
+	/// Lerp as A + (B-A) * Alpha
+	inline Float3 LerpVectors(const Float3 &A, const Float3 &B, float Alpha)
+	{
+		return AddVectors(A, ScaleVector(SubtractVectors(B, A), Alpha));
+	}
+
+	inline float LerpFloat(float A, float B, float Alpha)
+	{
+		return A+(B-A)*Alpha;
+	}
+
+	inline float ClampFloat(float Value, float Min, float Max)
+	{
+		return Value<Min ? Min : Value<Max ? Value : Max;
+	}
+
+	/// The unit vector in the same direction, or zero if it's too short to normalize, as
+	/// with FVector::GetSafeNormal
+	inline Float3 SafeNormal(const Float3 &A)
+	{
+		const float SizeSquared = Dot(A, A);
+		if (SizeSquared==1.0f)
+		{
+			return A;
+		}
+		if (SizeSquared<SmallNumber)
+		{
+			return {0.0f, 0.0f, 0.0f};
+		}
+		return ScaleVector(A, 1.0f/std::sqrt(SizeSquared));
+	}
+
+	/// How far along the line from LineStart to LineEnd the nearest point to Point is, with
+	/// 0.0 being LineStart and 1.0 LineEnd
+	inline float LineParameter(const Float3 &LineStart, const Float3 &LineDirection, const Float3 &Point)
+	{
+		const float LengthSquared = Dot(LineDirection, LineDirection);
+		return LengthSquared<SmallNumber ? 0.0f : Dot(SubtractVectors(Point, LineStart), LineDirection)/LengthSquared;
+	}
+
+	/// The weight for a distance with a linear falloff between InnerRadius and InnerRadius+SelectionRadius
+	inline float Falloff(float Distance, float InnerRadius, float SelectionRadius)
+	{
+		return 1.0f-ClampFloat((Distance-InnerRadius)/SelectionRadius, 0.0f, 1.0f);
+	}
+}
+
+void DeformationCore::Inflate(Float3 *Positions, const Float3 *Normals, int32_t Count, float Offset, const float *Weights)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		const float Weight = Weights ? Weights[Index] : 1.0f;
+		Positions[Index] = AddVectors(Positions[Index], ScaleVector(Normals[Index], Offset*Weight));
+	}
+}
+
+void DeformationCore::LerpTowards(Float3 *Positions, int32_t Count, const Float3 &Target, float Alpha, const float *Weights)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		const float Weight = Weights ? Weights[Index] : 1.0f;
+		Positions[Index] = LerpVectors(Positions[Index], Target, Alpha*Weight);
+	}
+}
+
+void DeformationCore::MoveTowards(
+	Float3 *Positions, int32_t Count, const Float3 &Target, float Distance, bool bLimitAtTarget,
+	const float *Weights)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Float3 &Position = Positions[Index];
+		const float AdjustedDistance = Distance*(Weights ? Weights[Index] : 1.0f);
+		const Float3 ToTarget = SubtractVectors(Target, Position);
+
+		// If we're limited then stop at the target rather than moving through it.
+		if (bLimitAtTarget && AdjustedDistance>=Size(ToTarget))
+		{
+			Position = Target;
+		}
+		else
+		{
+			Position = AddVectors(Position, ScaleVector(SafeNormal(ToTarget), AdjustedDistance));
+		}
+	}
+}
+
+void DeformationCore::RotateAroundAxis(
+	Float3 *Positions, int32_t Count, const Float3 &Center, const Float3 &Axis, const Float3 &UnitAxis,
+	float AngleInDegrees, const float *Weights)
+{
+	const float DegreesToRadians = 3.14159265358979323846f/180.0f;
+	const float XX = UnitAxis.X*UnitAxis.X;
+	const float YY = UnitAxis.Y*UnitAxis.Y;
+	const float ZZ = UnitAxis.Z*UnitAxis.Z;
+	const float XY = UnitAxis.X*UnitAxis.Y;
+	const float YZ = UnitAxis.Y*UnitAxis.Z;
+	const float ZX = UnitAxis.Z*UnitAxis.X;
+
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Float3 &Position = Positions[Index];
+		const Float3 ClosestPointOnLine = AddVectors(Center, ScaleVector(Axis, LineParameter(Center, Axis, Position)));
+		const Float3 Offset = SubtractVectors(Position, ClosestPointOnLine);
+
+		// The angle varies per vertex so the rotation matrix does too, this is the same
+		// axis-angle rotation as FVector::RotateAngleAxis.
+		const float Angle = AngleInDegrees*(Weights ? Weights[Index] : 1.0f)*DegreesToRadians;
+		const float S = std::sin(Angle);
+		const float C = std::cos(Angle);
+		const float OMC = 1.0f-C;
+		const float XS = UnitAxis.X*S;
+		const float YS = UnitAxis.Y*S;
+		const float ZS = UnitAxis.Z*S;
+
+		const Float3 Rotated = {
+			(OMC*XX+C)*Offset.X+(OMC*XY-ZS)*Offset.Y+(OMC*ZX+YS)*Offset.Z,
+			(OMC*XY+ZS)*Offset.X+(OMC*YY+C)*Offset.Y+(OMC*YZ-XS)*Offset.Z,
+			(OMC*ZX-YS)*Offset.X+(OMC*YZ+XS)*Offset.Y+(OMC*ZZ+C)*Offset.Z
+		};
+		Position = AddVectors(ClosestPointOnLine, Rotated);
+	}
+}
+
+void DeformationCore::ScaleAlongAxis(
+	Float3 *Positions, int32_t Count, const Float3 &Center, const Float3 &Axis, float Scale,
+	const float *Weights)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Float3 &Position = Positions[Index];
+
+		// Only the component along the axis is scaled, the offset from the axis is kept.
+		const float AlongAxis = LineParameter(Center, Axis, Position);
+		const Float3 ClosestPointOnLine = AddVectors(Center, ScaleVector(Axis, AlongAxis));
+		const Float3 Offset = SubtractVectors(Position, ClosestPointOnLine);
+		const Float3 Scaled = AddVectors(AddVectors(Center, ScaleVector(Axis, AlongAxis*Scale)), Offset);
+		Position = LerpVectors(Position, Scaled, Weights ? Weights[Index] : 1.0f);
+	}
+}
+
+void DeformationCore::Spherize(
+	Float3 *Positions, int32_t Count, const Float3 &Center, float Radius, float Strength,
+	const float *Weights)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Float3 &Position = Positions[Index];
+		const Float3 RelativeToCenter = SubtractVectors(Position, Center);
+		const float TargetLength = LerpFloat(
+			Size(RelativeToCenter), Radius, Strength*(Weights ? Weights[Index] : 1.0f)
+		);
+		Position = AddVectors(Center, ScaleVector(SafeNormal(RelativeToCenter), TargetLength));
+	}
+}
+
+void DeformationCore::SelectInVolume(const Float3 *Positions, int32_t Count, const Float3 &CornerA, const Float3 &CornerB, float *Out)
+{
+	const float MinX = CornerA.X<CornerB.X ? CornerA.X : CornerB.X;
+	const float MaxX = CornerA.X<CornerB.X ? CornerB.X : CornerA.X;
+	const float MinY = CornerA.Y<CornerB.Y ? CornerA.Y : CornerB.Y;
+	const float MaxY = CornerA.Y<CornerB.Y ? CornerB.Y : CornerA.Y;
+	const float MinZ = CornerA.Z<CornerB.Z ? CornerA.Z : CornerB.Z;
+	const float MaxZ = CornerA.Z<CornerB.Z ? CornerB.Z : CornerA.Z;
+
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		const Float3 &Position = Positions[Index];
+		const bool bInVolume =
+			(Position.X>=MinX)&&(Position.X<=MaxX)&&
+			(Position.Y>=MinY)&&(Position.Y<=MaxY)&&
+			(Position.Z>=MinZ)&&(Position.Z<=MaxZ);
+		Out[Index] = bInVolume ? 1.0f : 0.0f;
+	}
+}
+
+void DeformationCore::SelectLinear(
+	const Float3 *Positions, int32_t Count, const Float3 &LineStart, const Float3 &LineEnd, bool bLimitToLine,
+	float *Out)
+{
+	const Float3 LineDirection = SubtractVectors(LineEnd, LineStart);
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		// The parameter along the line is the ratio of the distance from the start to the
+		// line length, positions past either end get the limits.
+		const float AlongLine = LineParameter(LineStart, LineDirection, Positions[Index]);
+		if (AlongLine>=1.0f)
+		{
+			Out[Index] = bLimitToLine ? 0.0f : 1.0f;
+		}
+		else
+		{
+			Out[Index] = AlongLine>0.0f ? AlongLine : 0.0f;
+		}
+	}
+}
+
+void DeformationCore::SelectNear(
+	const Float3 *Positions, int32_t Count, const Float3 &Center, float InnerRadius, float OuterRadius,
+	float *Out)
+{
+	const float SelectionRadius = OuterRadius-InnerRadius;
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = Falloff(Size(SubtractVectors(Positions[Index], Center)), InnerRadius, SelectionRadius);
+	}
+}
+
+void DeformationCore::SelectNearLine(
+	const Float3 *Positions, int32_t Count, const Float3 &LineStart, const Float3 &LineEnd,
+	float InnerRadius, float OuterRadius, bool bLineIsInfinite, float *Out)
+{
+	const float SelectionRadius = OuterRadius-InnerRadius;
+	const Float3 LineDirection = SubtractVectors(LineEnd, LineStart);
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		const Float3 &Position = Positions[Index];
+		float AlongLine = LineParameter(LineStart, LineDirection, Position);
+		if (!bLineIsInfinite)
+		{
+			AlongLine = ClampFloat(AlongLine, 0.0f, 1.0f);
+		}
+		const Float3 NearestPointOnLine = AddVectors(LineStart, ScaleVector(LineDirection, AlongLine));
+		Out[Index] = Falloff(Size(SubtractVectors(Position, NearestPointOnLine)), InnerRadius, SelectionRadius);
+	}
+}
+
+void DeformationCore::Add(const float *A, const float *B, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]+B[Index];
+	}
+}
+
+void DeformationCore::AddScalar(const float *A, float Value, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]+Value;
+	}
+}
+
+void DeformationCore::Clamp(const float *A, float Min, float Max, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = ClampFloat(A[Index], Min, Max);
+	}
+}
+
+void DeformationCore::Divide(const float *A, const float *B, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]/B[Index];
+	}
+}
+
+void DeformationCore::DivideByScalar(const float *A, float Value, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]/Value;
+	}
+}
+
+void DeformationCore::DivideScalarBy(float Value, const float *A, int32_t Count, float *Out)
+{
+	// Weights near zero are pushed to 'near zero' to avoid dividing by zero.
+	const float ZeroThreshold = 0.01f;
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		float Divisor = A[Index];
+		if (std::fabs(Divisor)<ZeroThreshold)
+		{
+			Divisor = Divisor<0 ? -ZeroThreshold : ZeroThreshold;
+		}
+		Out[Index] = Value/Divisor;
+	}
+}
+
+void DeformationCore::Lerp(const float *A, const float *B, float Alpha, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = LerpFloat(A[Index], B[Index], Alpha);
+	}
+}
+
+void DeformationCore::LerpByWeights(const float *A, const float *B, const float *Alpha, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = LerpFloat(A[Index], B[Index], Alpha[Index]);
+	}
+}
+
+void DeformationCore::LerpToScalar(const float *A, float Value, float Alpha, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = LerpFloat(A[Index], Value, Alpha);
+	}
+}
+
+void DeformationCore::Max(const float *A, const float *B, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]>=B[Index] ? A[Index] : B[Index];
+	}
+}
+
+void DeformationCore::MaxScalar(const float *A, float Value, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]>=Value ? A[Index] : Value;
+	}
+}
+
+void DeformationCore::Min(const float *A, const float *B, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]<=B[Index] ? A[Index] : B[Index];
+	}
+}
+
+void DeformationCore::MinScalar(const float *A, float Value, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]<=Value ? A[Index] : Value;
+	}
+}
+
+void DeformationCore::Multiply(const float *A, const float *B, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]*B[Index];
+	}
+}
+
+void DeformationCore::MultiplyScalar(const float *A, float Value, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]*Value;
+	}
+}
+
+void DeformationCore::OneMinus(const float *A, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = 1.0f-A[Index];
+	}
+}
+
+void DeformationCore::Power(const float *A, float Exp, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = std::pow(A[Index], Exp);
+	}
+}
+
+void DeformationCore::RemapPeriodic(const float *A, int32_t NumberOfRepeats, bool bIncludeReversals, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		const float ScaledValue = A[Index]*NumberOfRepeats;
+		const bool bIsOdd = (static_cast<int32_t>(std::floor(ScaledValue))%2)==1;
+		const float Repeat = std::fmod(ScaledValue, 1.0f);
+		Out[Index] = bIncludeReversals && bIsOdd ? 1.0f-Repeat : Repeat;
+	}
+}
+
+void DeformationCore::RemapToRange(const float *A, float Min, float Max, int32_t Count, float *Out)
+{
+	if (Count<=0)
+	{
+		return;
+	}
+
+	float CurrentMinimum = A[0];
+	float CurrentMaximum = A[0];
+	for (int32_t Index = 1; Index<Count; ++Index)
+	{
+		CurrentMinimum = A[Index]<CurrentMinimum ? A[Index] : CurrentMinimum;
+		CurrentMaximum = A[Index]>CurrentMaximum ? A[Index] : CurrentMaximum;
+	}
+
+	// A flat input has no range to scale so maps to Min.
+	if (CurrentMinimum==CurrentMaximum)
+	{
+		Set(Min, Count, Out);
+		return;
+	}
+
+	const float Scale = (Max-Min)/(CurrentMaximum-CurrentMinimum);
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = (A[Index]-CurrentMinimum)*Scale+Min;
+	}
+}
+
+void DeformationCore::Set(float Value, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = Value;
+	}
+}
+
+void DeformationCore::Subtract(const float *A, const float *B, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]-B[Index];
+	}
+}
+
+void DeformationCore::SubtractFromScalar(float Value, const float *A, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = Value-A[Index];
+	}
+}
+
+void DeformationCore::SubtractScalar(const float *A, float Value, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		Out[Index] = A[Index]-Value;
+	}
+}
+
+void DeformationCore::AndMask(const uint32_t *A, const uint32_t *B, int32_t Count, uint32_t *Out)
+{
+	const int32_t WordCount = GetMaskWordCount(Count);
+	for (int32_t Index = 0; Index<WordCount; ++Index)
+	{
+		Out[Index] = A[Index]&B[Index];
+	}
+}
+
+int32_t DeformationCore::CountMask(const uint32_t *A, int32_t Count)
+{
+	const int32_t WordCount = GetMaskWordCount(Count);
+	int32_t SetBits = 0;
+	for (int32_t Index = 0; Index<WordCount; ++Index)
+	{
+		SetBits += CountBits(A[Index]);
+	}
+	return SetBits;
+}
+
+void DeformationCore::NotMask(const uint32_t *A, int32_t Count, uint32_t *Out)
+{
+	const int32_t WordCount = GetMaskWordCount(Count);
+	for (int32_t Index = 0; Index<WordCount; ++Index)
+	{
+		Out[Index] = ~A[Index];
+	}
+
+	// Keep the bits past the last weight clear.
+	if (WordCount>0)
+	{
+		Out[WordCount-1] &= GetLastMaskWordBits(Count);
+	}
+}
+
+void DeformationCore::OrMask(const uint32_t *A, const uint32_t *B, int32_t Count, uint32_t *Out)
+{
+	const int32_t WordCount = GetMaskWordCount(Count);
+	for (int32_t Index = 0; Index<WordCount; ++Index)
+	{
+		Out[Index] = A[Index]|B[Index];
+	}
+}
+
+void DeformationCore::PackMask(const float *A, float Threshold, int32_t Count, uint32_t *Out)
+{
+	const int32_t WordCount = GetMaskWordCount(Count);
+	for (int32_t WordIndex = 0; WordIndex<WordCount; ++WordIndex)
+	{
+		const int32_t FirstWeight = WordIndex*32;
+		const int32_t WeightCount = Count-FirstWeight<32 ? Count-FirstWeight : 32;
+
+		uint32_t Word = 0;
+		for (int32_t Bit = 0; Bit<WeightCount; ++Bit)
+		{
+			Word |= (A[FirstWeight+Bit]>=Threshold ? 1u : 0u)<<Bit;
+		}
+		Out[WordIndex] = Word;
+	}
+}
+
+void DeformationCore::UnpackMask(const uint32_t *A, int32_t FirstBit, int32_t Count, float *Out)
+{
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		const int32_t Bit = FirstBit+Index;
+		Out[Index] = (A[Bit/32]>>(Bit%32))&1u ? 1.0f : 0.0f;
+	}
+}
+
+void DeformationCore::XorMask(const uint32_t *A, const uint32_t *B, int32_t Count, uint32_t *Out)
+{
+	const int32_t WordCount = GetMaskWordCount(Count);
+	for (int32_t Index = 0; Index<WordCount; ++Index)
+	{
+		Out[Index] = A[Index]^B[Index];
+	}
+}
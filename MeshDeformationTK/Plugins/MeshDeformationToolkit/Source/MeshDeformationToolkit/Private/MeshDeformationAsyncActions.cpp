@@ -0,0 +1,487 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformTime.h"
+
+#include "MeshDeformationAsyncActions.h"
+
+DECLARE_CYCLE_STAT(TEXT("AsyncAction Tick"), STAT_MDT_AsyncActionTick, STATGROUP_MeshDeformationToolkit);
+
+namespace
+{
+	/// The number of vertices processed between checks of the time budget.  A single line trace
+	/// or spline query is cheap, so checking the clock after every vertex would be a real cost.
+	const int32 VerticesPerBatch = 64;
+
+	/// The number of times *RebuildNormalsAsync* rebuilds the normals of a mesh which keeps
+	/// being deformed before it settles for the latest ones
+	const int32 MaxNormalsRebuilds = 3;
+}
+
+void UMeshDeformationAsyncAction::Activate()
+{
+	if (!Geometry)
+	{
+		// The factory has already logged why the work couldn't be prepared.
+		Finish(false);
+		return;
+	}
+
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &UMeshDeformationAsyncAction::Tick)
+	);
+}
+
+void UMeshDeformationAsyncAction::Cancel()
+{
+	bCancelRequested = true;
+}
+
+float UMeshDeformationAsyncAction::GetProgress() const
+{
+	return Progress;
+}
+
+void UMeshDeformationAsyncAction::BeginDestroy()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	Super::BeginDestroy();
+}
+
+bool UMeshDeformationAsyncAction::Initialize(
+	UMeshDeformationComponent *InMeshDeformationComponent, float TimeBudgetMs, const TCHAR *NodeNameForWarning)
+{
+	TargetComponent = InMeshDeformationComponent;
+	TimeBudget = FMath::Max(TimeBudgetMs, 0.0f)/1000.0f;
+
+	if (!TargetComponent)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("%s: No MeshDeformationComponent provided"), NodeNameForWarning);
+		return false;
+	}
+
+	RegisterWithGameInstance(TargetComponent);
+
+	// The work is prepared against the geometry as it is now, so anything deferred has to be applied first.
+	UMeshDeformationComponent *FlushedComponent;
+	TargetComponent->FlushDeferredOperations(FlushedComponent);
+
+	if (!TargetComponent->MeshGeometry)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("%s: No meshGeometry loaded"), NodeNameForWarning);
+		return false;
+	}
+
+	Geometry = TargetComponent->MeshGeometry;
+	VertexCount = Geometry->GetTotalVertexCount();
+	return true;
+}
+
+bool UMeshDeformationAsyncAction::CheckGeometryUnchanged() const
+{
+	if (!TargetComponent||TargetComponent->IsPendingKill()||TargetComponent->MeshGeometry!=Geometry)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("%s: The component's geometry was replaced, cancelling"), *GetClass()->GetName());
+		return false;
+	}
+
+	if (Geometry->GetTotalVertexCount()!=VertexCount)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("%s: The geometry changed size, cancelling"), *GetClass()->GetName());
+		return false;
+	}
+
+	return true;
+}
+
+bool UMeshDeformationAsyncAction::Step(double Deadline, bool &bOutCompleted)
+{
+	if (!CheckGeometryUnchanged())
+	{
+		return false;
+	}
+
+	// Always do at least one batch so a zero budget still makes progress.
+	while (NextVertex<VertexCount)
+	{
+		const int32 EndVertex = FMath::Min(NextVertex+VerticesPerBatch, VertexCount);
+		if (VertexRangeFunction && !VertexRangeFunction(NextVertex, EndVertex))
+		{
+			return false;
+		}
+		NextVertex = EndVertex;
+		Progress = float(NextVertex)/float(VertexCount);
+
+		if (FPlatformTime::Seconds()>=Deadline)
+		{
+			break;
+		}
+	}
+
+	bOutCompleted = NextVertex>=VertexCount;
+	return true;
+}
+
+void UMeshDeformationAsyncAction::BroadcastProgress()
+{
+}
+
+void UMeshDeformationAsyncAction::BroadcastCompleted()
+{
+}
+
+void UMeshDeformationAsyncAction::BroadcastCancelled()
+{
+}
+
+bool UMeshDeformationAsyncAction::Tick(float DeltaTime)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_AsyncActionTick);
+
+	if (bCancelRequested)
+	{
+		Finish(false);
+		return false;
+	}
+
+	bool bCompleted = false;
+	if (!Step(FPlatformTime::Seconds()+TimeBudget, bCompleted))
+	{
+		Finish(false);
+		return false;
+	}
+
+	if (bCompleted)
+	{
+		Progress = 1.0f;
+		Finish(true);
+		return false;
+	}
+
+	BroadcastProgress();
+	return true;
+}
+
+void UMeshDeformationAsyncAction::Finish(bool bCompleted)
+{
+	// This is only called before we're added to the ticker or from Tick, which removes us by
+	// returning false.
+	TickerHandle.Reset();
+	VertexRangeFunction.Reset();
+
+	if (bCompleted)
+	{
+		BroadcastCompleted();
+	}
+	else
+	{
+		BroadcastCancelled();
+	}
+
+	SetReadyToDestroy();
+}
+
+void UMeshDeformerAsyncAction::BroadcastProgress()
+{
+	OnProgress.Broadcast(TargetComponent, Progress);
+}
+
+void UMeshDeformerAsyncAction::BroadcastCompleted()
+{
+	OnCompleted.Broadcast(TargetComponent, Progress);
+}
+
+void UMeshDeformerAsyncAction::BroadcastCancelled()
+{
+	OnCancelled.Broadcast(TargetComponent, Progress);
+}
+
+UProjectAsyncAction *UProjectAsyncAction::ProjectAsync(
+	UMeshDeformationComponent *MeshDeformationComponent,
+	UObject *WorldContextObject,
+	FTransform Transform,
+	TArray <AActor *> IgnoredActors,
+	FVector Projection /*= FVector(0, 0, -100)*/,
+	float HeightAdjust /*= 0*/,
+	bool bTraceComplex /*= true*/,
+	ECollisionChannel CollisionChannel /*= ECC_WorldStatic*/,
+	USelectionSet *Selection /*= nullptr*/,
+	float TimeBudgetMs /*= 2.0f*/)
+{
+	UProjectAsyncAction *Action = NewObject<UProjectAsyncAction>();
+	if (!Action->Initialize(MeshDeformationComponent, TimeBudgetMs, TEXT("ProjectAsync")))
+	{
+		return Action;
+	}
+
+	FMeshProjection PreparedProjection;
+	if (!Action->Geometry->PrepareProject(
+		PreparedProjection, WorldContextObject, Transform, IgnoredActors, Projection, HeightAdjust,
+		bTraceComplex, CollisionChannel, Selection))
+	{
+		Action->Geometry = nullptr;
+		return Action;
+	}
+
+	Action->SelectionSet = Selection;
+	Action->SetProjection(PreparedProjection);
+	return Action;
+}
+
+UProjectAsyncAction *UProjectAsyncAction::ProjectDownAsync(
+	UMeshDeformationComponent *MeshDeformationComponent,
+	UObject *WorldContextObject,
+	FTransform Transform,
+	TArray <AActor *> IgnoredActors,
+	float ProjectionLength /*= 100*/,
+	float HeightAdjust /*= 0*/,
+	bool bTraceComplex /*= true*/,
+	ECollisionChannel CollisionChannel /*= ECC_WorldStatic*/,
+	USelectionSet *Selection /*= nullptr*/,
+	float TimeBudgetMs /*= 2.0f*/)
+{
+	UProjectAsyncAction *Action = NewObject<UProjectAsyncAction>();
+	if (!Action->Initialize(MeshDeformationComponent, TimeBudgetMs, TEXT("ProjectDownAsync")))
+	{
+		return Action;
+	}
+
+	FMeshProjection PreparedProjection;
+	if (!Action->Geometry->PrepareProjectDown(
+		PreparedProjection, WorldContextObject, Transform, IgnoredActors, ProjectionLength, HeightAdjust,
+		bTraceComplex, CollisionChannel, Selection))
+	{
+		Action->Geometry = nullptr;
+		return Action;
+	}
+
+	Action->SelectionSet = Selection;
+	Action->SetProjection(PreparedProjection);
+	return Action;
+}
+
+void UProjectAsyncAction::SetProjection(const FMeshProjection &Projection)
+{
+	UMeshGeometry *ProjectedGeometry = Geometry;
+	USelectionSet *Selection = SelectionSet;
+	VertexRangeFunction = [ProjectedGeometry, Selection, Projection](int32 StartVertex, int32 EndVertex)
+	{
+		// This logs and leaves the vertices alone if the world has gone, which also stops the work.
+		ProjectedGeometry->ProjectVertexRange(Projection, Selection, StartVertex, EndVertex);
+		return Projection.World.IsValid();
+	};
+}
+
+URebuildNormalsAsyncAction *URebuildNormalsAsyncAction::RebuildNormalsAsync(
+	UMeshDeformationComponent *MeshDeformationComponent)
+{
+	URebuildNormalsAsyncAction *Action = NewObject<URebuildNormalsAsyncAction>();
+	if (Action->Initialize(MeshDeformationComponent, 0.0f, TEXT("RebuildNormalsAsync")))
+	{
+		Action->StartRebuild();
+	}
+	return Action;
+}
+
+void URebuildNormalsAsyncAction::BeginDestroy()
+{
+	if (Rebuild.IsValid())
+	{
+		Rebuild.Wait();
+	}
+
+	Super::BeginDestroy();
+}
+
+bool URebuildNormalsAsyncAction::Step(double Deadline, bool &bOutCompleted)
+{
+	if (!Rebuild.IsReady())
+	{
+		return true;
+	}
+	Rebuild = TFuture<void>();
+
+	if (!CheckGeometryUnchanged())
+	{
+		return false;
+	}
+
+	// The normals are for the positions as they were when the copy was made.
+	if (Geometry->GetGeneration()==SourceGeneration)
+	{
+		Geometry->SwapGeometry(*WorkingCopy);
+		bOutCompleted = true;
+		return true;
+	}
+
+	if (RebuildCount<MaxNormalsRebuilds)
+	{
+		StartRebuild();
+		return true;
+	}
+
+	// The geometry is being deformed faster than the normals can be rebuilt, so rather than
+	// never finishing the latest normals are put on the current positions.
+	if (!TakeNormalsFromWorkingCopy())
+	{
+		return false;
+	}
+	bNormalsStale = true;
+	bOutCompleted = true;
+	return true;
+}
+
+bool URebuildNormalsAsyncAction::AreNormalsStale() const
+{
+	return bNormalsStale;
+}
+
+bool URebuildNormalsAsyncAction::TakeNormalsFromWorkingCopy()
+{
+	bool bSameLayout = Geometry->Sections.Num()==WorkingCopy->Sections.Num();
+	for (int32 SectionIndex = 0; bSameLayout && SectionIndex<Geometry->Sections.Num(); ++SectionIndex)
+	{
+		bSameLayout = Geometry->Sections[SectionIndex].Vertices.Num()==WorkingCopy->Sections[SectionIndex].Vertices.Num();
+	}
+	if (!bSameLayout)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("RebuildNormalsAsync: The geometry's sections changed while the normals were rebuilt"));
+		return false;
+	}
+
+	for (int32 SectionIndex = 0; SectionIndex<Geometry->Sections.Num(); ++SectionIndex)
+	{
+		FSectionGeometry &Section = Geometry->Sections[SectionIndex];
+		FSectionGeometry &RebuiltSection = WorkingCopy->Sections[SectionIndex];
+		Swap(Section.Normals, RebuiltSection.Normals);
+		Swap(Section.GetMutableTangents(false), RebuiltSection.GetMutableTangents());
+	}
+	Geometry->MarkGeometryChanged(ESectionChanges::Normals|ESectionChanges::Tangents);
+	return true;
+}
+
+void URebuildNormalsAsyncAction::StartRebuild()
+{
+	if (!WorkingCopy)
+	{
+		WorkingCopy = NewObject<UMeshGeometry>(this);
+	}
+	WorkingCopy->CopyGeometryFrom(*Geometry);
+	SourceGeneration = Geometry->GetGeneration();
+	++RebuildCount;
+
+	UMeshGeometry *Copy = WorkingCopy;
+	Rebuild = Async(EAsyncExecution::TaskGraph, [Copy]()
+	{
+		Copy->RebuildNormals();
+	});
+}
+
+USaveToStaticMeshAsyncAction *USaveToStaticMeshAsyncAction::SaveToStaticMeshAsync(
+	UMeshDeformationComponent *MeshDeformationComponent,
+	UStaticMesh *StaticMesh,
+	TArray<UMaterialInterface *> Materials)
+{
+	USaveToStaticMeshAsyncAction *Action = NewObject<USaveToStaticMeshAsyncAction>();
+	if (!Action->Initialize(MeshDeformationComponent, 0.0f, TEXT("SaveToStaticMeshAsync")))
+	{
+		return Action;
+	}
+
+	// The queue takes a copy of the geometry, so it can be changed as soon as this returns.
+	if (!Action->Geometry->QueueSaveToStaticMesh(
+		StaticMesh, Materials,
+		FOnStaticMeshBuilt::CreateUObject(Action, &USaveToStaticMeshAsyncAction::OnStaticMeshBuilt)))
+	{
+		Action->Geometry = nullptr;
+	}
+	return Action;
+}
+
+bool USaveToStaticMeshAsyncAction::Step(double Deadline, bool &bOutCompleted)
+{
+	bOutCompleted = bBuildFinished;
+	return !bBuildFinished||bBuildSucceeded;
+}
+
+void USaveToStaticMeshAsyncAction::OnStaticMeshBuilt(UStaticMesh *BuiltStaticMesh)
+{
+	bBuildFinished = true;
+	bBuildSucceeded = BuiltStaticMesh!=nullptr;
+}
+
+USelectNearSplineAsyncAction *USelectNearSplineAsyncAction::SelectNearSplineAsync(
+	UMeshDeformationComponent *MeshDeformationComponent,
+	USplineComponent *Spline,
+	float InnerRadius /*= 0*/,
+	float OuterRadius /*= 100*/,
+	float TimeBudgetMs /*= 2.0f*/)
+{
+	USelectNearSplineAsyncAction *Action = NewObject<USelectNearSplineAsyncAction>();
+	if (!Action->Initialize(MeshDeformationComponent, TimeBudgetMs, TEXT("SelectNearSplineAsync")))
+	{
+		return Action;
+	}
+
+	if (!Spline)
+	{
+		UE_LOG(MDTLog, Error, TEXT("SelectNearSplineAsync: No spline provided"));
+		Action->Geometry = nullptr;
+		return Action;
+	}
+
+	USelectionSet *Selection = NewObject<USelectionSet>(Action->Geometry);
+	if (!Selection)
+	{
+		UE_LOG(MDTLog, Error, TEXT("SelectNearSplineAsync: Cannot create new SelectionSet"));
+		Action->Geometry = nullptr;
+		return Action;
+	}
+	Selection->CreateSelectionSet(Action->VertexCount);
+	Action->SelectionSet = Selection;
+
+	// Get the actor's local->world transform- we're going to need it for the spline.
+	AActor *Owner = MeshDeformationComponent->GetOwner();
+	const FTransform ActorTransform = Owner ? Owner->GetTransform() : FTransform::Identity;
+
+	UMeshGeometry *SelectedGeometry = Action->Geometry;
+	TWeakObjectPtr<USplineComponent> WeakSpline = Spline;
+	Action->VertexRangeFunction = [SelectedGeometry, Selection, WeakSpline, ActorTransform, InnerRadius, OuterRadius](
+		int32 StartVertex, int32 EndVertex)
+	{
+		USplineComponent *SplineComponent = WeakSpline.Get();
+		if (!SplineComponent)
+		{
+			UE_LOG(MDTLog, Warning, TEXT("SelectNearSplineAsync: The spline no longer exists, cancelling"));
+			return false;
+		}
+
+		SelectedGeometry->SelectNearSplineRange(
+			Selection, SplineComponent, ActorTransform, InnerRadius, OuterRadius, StartVertex, EndVertex
+		);
+		return true;
+	};
+	return Action;
+}
+
+void USelectNearSplineAsyncAction::BroadcastProgress()
+{
+	OnProgress.Broadcast(SelectionSet, Progress);
+}
+
+void USelectNearSplineAsyncAction::BroadcastCompleted()
+{
+	OnCompleted.Broadcast(SelectionSet, Progress);
+}
+
+void USelectNearSplineAsyncAction::BroadcastCancelled()
+{
+	OnCancelled.Broadcast(SelectionSet, Progress);
+}
@@ -0,0 +1,323 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "Async/ParallelFor.h"
+#include "Engine/StaticMesh.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/GarbageCollection.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectHash.h"
+#include "MeshDeformationRecipe.h"
+#include "MeshGeometry.h"
+#include "StaticMeshBuildQueue.h"
+
+#include "MeshDeformationBatchCommandlet.h"
+
+namespace
+{
+	/// The number of meshes loaded, deformed, and built before their memory is reclaimed,
+	/// if -BatchSize isn't given
+	const int32 DefaultBatchSize = 32;
+
+	/// The progress and timings for one mesh in the batch
+	struct FBatchJob
+	{
+		FString SourceName;
+		FString SourceFolder;
+		FString OutputPackageName;
+		FString OutputAssetName;
+		int32 VertexCount = 0;
+		int32 TriangleCount = 0;
+		double LoadSeconds = 0.0;
+		double DeformSeconds = 0.0;
+		UStaticMesh *BuiltMesh = nullptr;
+		bool bLoaded = false;
+		bool bSaved = false;
+	};
+}
+
+UMeshDeformationBatchCommandlet::UMeshDeformationBatchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Apply a MeshDeformationRecipe to many StaticMeshes and save the results");
+	HelpUsage = TEXT("-run=MeshDeformationBatch -Recipe=<Class> -Meshes=<Mesh,Mesh> -MeshList=<File> -OutputPath=</Game/Path> -Report=<File> -BatchSize=<Count>");
+}
+
+int32 UMeshDeformationBatchCommandlet::Main(const FString &Params)
+{
+	const double BatchStartTime = FPlatformTime::Seconds();
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	// Get the recipe.
+	const FString *RecipeClassName = ParamValues.Find(TEXT("Recipe"));
+	UClass *RecipeClass = RecipeClassName ? LoadClass<UMeshDeformationRecipe>(nullptr, **RecipeClassName) : nullptr;
+	if (!RecipeClass)
+	{
+		UE_LOG(MDTLog, Error, TEXT("MeshDeformationBatch: Need a valid -Recipe=<Class>"));
+		return 1;
+	}
+	Recipe = NewObject<UMeshDeformationRecipe>(this, RecipeClass);
+
+	// Gather the meshes from the command line and list file.
+	TArray<FString> MeshNames;
+	if (const FString *MeshesParam = ParamValues.Find(TEXT("Meshes")))
+	{
+		MeshesParam->ParseIntoArray(MeshNames, TEXT(","), true);
+	}
+	if (const FString *MeshListParam = ParamValues.Find(TEXT("MeshList")))
+	{
+		TArray<FString> MeshListLines;
+		if (!FFileHelper::LoadFileToStringArray(MeshListLines, **MeshListParam))
+		{
+			UE_LOG(MDTLog, Error, TEXT("MeshDeformationBatch: Cannot read mesh list '%s'"), **MeshListParam);
+			return 1;
+		}
+		for (const FString &Line:MeshListLines)
+		{
+			const FString MeshName = Line.TrimStartAndEnd();
+			if (!MeshName.IsEmpty())
+			{
+				MeshNames.Add(MeshName);
+			}
+		}
+	}
+	if (MeshNames.Num()==0)
+	{
+		UE_LOG(MDTLog, Error, TEXT("MeshDeformationBatch: No meshes provided, use -Meshes or -MeshList"));
+		return 1;
+	}
+
+	const FString *OutputPathParam = ParamValues.Find(TEXT("OutputPath"));
+	const FString OutputPath = OutputPathParam ? *OutputPathParam : FString(TEXT("/Game/Deformed"));
+	const FString *ReportParam = ParamValues.Find(TEXT("Report"));
+	const FString ReportFilename = ReportParam ?
+		*ReportParam :
+		FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MeshDeformationBatch.json"));
+
+	const FString *BatchSizeParam = ParamValues.Find(TEXT("BatchSize"));
+	const int32 BatchSize = BatchSizeParam ? FMath::Max(FCString::Atoi(**BatchSizeParam), 1) : DefaultBatchSize;
+
+	// Work out every output name before loading anything.  The meshes keep their folders
+	// relative to the deepest folder they all share, so meshes with the same name in different
+	// folders don't overwrite each other.
+	TArray<FBatchJob> Jobs;
+	for (const FString &MeshName:MeshNames)
+	{
+		const FString PackageName = FPackageName::ObjectPathToPackageName(MeshName);
+		FBatchJob &Job = Jobs.AddDefaulted_GetRef();
+		Job.SourceName = MeshName;
+		Job.SourceFolder = FPackageName::GetLongPackagePath(PackageName);
+		Job.OutputAssetName = MeshName.Contains(TEXT(".")) ?
+			FPackageName::ObjectPathToObjectName(MeshName) :
+			FPackageName::GetShortName(PackageName);
+	}
+
+	FString SourceRoot = Jobs.Num()>0 ? Jobs[0].SourceFolder : FString();
+	for (const FBatchJob &Job:Jobs)
+	{
+		while (!SourceRoot.IsEmpty() && Job.SourceFolder!=SourceRoot && !Job.SourceFolder.StartsWith(SourceRoot+TEXT("/")))
+		{
+			SourceRoot = FPackageName::GetLongPackagePath(SourceRoot);
+		}
+	}
+	TSet<FString> OutputPackageNames;
+	for (int32 JobIndex = 0; JobIndex<Jobs.Num(); ++JobIndex)
+	{
+		FBatchJob &Job = Jobs[JobIndex];
+		const FString RelativeFolder = Job.SourceFolder.RightChop(SourceRoot.Len());
+		Job.OutputPackageName = (OutputPath+RelativeFolder)/Job.OutputAssetName;
+
+		// The same mesh listed twice would still collide, and the build queue would merge them.
+		bool bAlreadyQueued = false;
+		OutputPackageNames.Add(Job.OutputPackageName, &bAlreadyQueued);
+		if (bAlreadyQueued)
+		{
+			UE_LOG(MDTLog, Error, TEXT("MeshDeformationBatch: '%s' is listed more than once"), *Job.SourceName);
+			Jobs.RemoveAt(JobIndex);
+			--JobIndex;
+		}
+	}
+
+	// Native recipes are applied to every mesh in a batch at once, Blueprint recipes one at a
+	// time on the game thread.
+	const bool bApplyConcurrently = Recipe->CanApplyConcurrently();
+
+	// The meshes are processed a batch at a time, so only one batch of meshes and geometry is
+	// in memory however many meshes there are.
+	double LoadSeconds = 0.0;
+	double DeformSeconds = 0.0;
+	double BuildSeconds = 0.0;
+	double SaveSeconds = 0.0;
+	int32 FailedCount = MeshNames.Num()-Jobs.Num();
+	for (int32 BatchStart = 0; BatchStart<Jobs.Num(); BatchStart += BatchSize)
+	{
+		const int32 BatchEnd = FMath::Min(BatchStart+BatchSize, Jobs.Num());
+
+		// Loading has to happen on the game thread.
+		const double LoadStartTime = FPlatformTime::Seconds();
+		TArray<FBatchJob *> LoadedJobs;
+		for (int32 JobIndex = BatchStart; JobIndex<BatchEnd; ++JobIndex)
+		{
+			FBatchJob &Job = Jobs[JobIndex];
+			const double MeshStartTime = FPlatformTime::Seconds();
+			UStaticMesh *StaticMesh = LoadObject<UStaticMesh>(nullptr, *Job.SourceName);
+			UMeshGeometry *MeshGeometry = NewObject<UMeshGeometry>(this);
+			if (!StaticMesh||!MeshGeometry->LoadFromStaticMesh(StaticMesh))
+			{
+				UE_LOG(MDTLog, Error, TEXT("MeshDeformationBatch: Cannot load StaticMesh '%s'"), *Job.SourceName);
+				++FailedCount;
+				continue;
+			}
+
+			Job.bLoaded = true;
+			Job.LoadSeconds = FPlatformTime::Seconds()-MeshStartTime;
+			LoadedJobs.Add(&Job);
+			SourceMeshes.Add(StaticMesh);
+			Geometries.Add(MeshGeometry);
+		}
+		LoadSeconds += FPlatformTime::Seconds()-LoadStartTime;
+
+		// Deform the batch.  Each deformer splits large meshes across the worker threads too.
+		const double DeformStartTime = FPlatformTime::Seconds();
+		ParallelFor(LoadedJobs.Num(), [&](int32 LoadedIndex)
+		{
+			FBatchJob &Job = *LoadedJobs[LoadedIndex];
+			UMeshGeometry *MeshGeometry = Geometries[LoadedIndex];
+			const double MeshStartTime = FPlatformTime::Seconds();
+			if (bApplyConcurrently)
+			{
+				FGCScopeGuard GCGuard;
+				Recipe->Apply_Implementation(MeshGeometry);
+			}
+			else
+			{
+				Recipe->Apply(MeshGeometry);
+			}
+			Job.DeformSeconds = FPlatformTime::Seconds()-MeshStartTime;
+			Job.VertexCount = MeshGeometry->GetTotalVertexCount();
+			Job.TriangleCount = MeshGeometry->GetTotalTriangleCount();
+		}, !bApplyConcurrently);
+
+		// Objects created on the worker threads, such as the recipe's SelectionSets, carry the
+		// Async flag, which the garbage collector treats as reachable.  They're all within the
+		// geometry.
+		if (bApplyConcurrently)
+		{
+			for (UMeshGeometry *MeshGeometry:Geometries)
+			{
+				ForEachObjectWithOuter(MeshGeometry, [](UObject *Object)
+				{
+					Object->ClearInternalFlags(EInternalObjectFlags::Async);
+				}, true);
+			}
+		}
+		DeformSeconds += FPlatformTime::Seconds()-DeformStartTime;
+
+		// Build the new meshes, with the RawMesh for each prepared on the workers.
+		const double BuildStartTime = FPlatformTime::Seconds();
+		for (int32 LoadedIndex = 0; LoadedIndex<LoadedJobs.Num(); ++LoadedIndex)
+		{
+			FBatchJob &Job = *LoadedJobs[LoadedIndex];
+			TArray<UMaterialInterface *> Materials;
+			for (const FStaticMaterial &StaticMaterial:SourceMeshes[LoadedIndex]->StaticMaterials)
+			{
+				Materials.Add(StaticMaterial.MaterialInterface);
+			}
+
+			FStaticMeshBuildQueue::Get().QueueBuild(
+				Job.OutputPackageName, Job.OutputAssetName, Geometries[LoadedIndex]->Sections, Materials,
+				FOnStaticMeshBuilt::CreateLambda([&Job](UStaticMesh *BuiltMesh) { Job.BuiltMesh = BuiltMesh; })
+			);
+		}
+		FStaticMeshBuildQueue::Get().Flush();
+		BuildSeconds += FPlatformTime::Seconds()-BuildStartTime;
+
+		// Write the assets.
+		const double SaveStartTime = FPlatformTime::Seconds();
+		for (FBatchJob *Job:LoadedJobs)
+		{
+			if (Job->BuiltMesh)
+			{
+				UPackage *Package = Job->BuiltMesh->GetOutermost();
+				const FString Filename = FPackageName::LongPackageNameToFilename(
+					Package->GetName(), FPackageName::GetAssetPackageExtension()
+				);
+				Job->bSaved = UPackage::SavePackage(
+					Package, Job->BuiltMesh, RF_Public|RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError
+				);
+			}
+			Job->BuiltMesh = nullptr;
+
+			if (!Job->bSaved)
+			{
+				UE_LOG(MDTLog, Error, TEXT("MeshDeformationBatch: Failed to save '%s'"), *Job->OutputPackageName);
+				++FailedCount;
+			}
+		}
+		SaveSeconds += FPlatformTime::Seconds()-SaveStartTime;
+
+		// Let go of the batch.  The saved meshes are standalone, so they're only collected
+		// without any keep flags.
+		SourceMeshes.Reset();
+		Geometries.Reset();
+		CollectGarbage(RF_NoFlags);
+	}
+
+	// Write the report.
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("recipe"), RecipeClass->GetPathName());
+	Report->SetBoolField(TEXT("concurrent"), bApplyConcurrently);
+	Report->SetNumberField(TEXT("batchSize"), BatchSize);
+	Report->SetNumberField(TEXT("requested"), MeshNames.Num());
+	Report->SetNumberField(TEXT("failed"), FailedCount);
+	Report->SetNumberField(TEXT("loadSeconds"), LoadSeconds);
+	Report->SetNumberField(TEXT("deformSeconds"), DeformSeconds);
+	Report->SetNumberField(TEXT("buildSeconds"), BuildSeconds);
+	Report->SetNumberField(TEXT("saveSeconds"), SaveSeconds);
+	Report->SetNumberField(TEXT("totalSeconds"), FPlatformTime::Seconds()-BatchStartTime);
+
+	TArray<TSharedPtr<FJsonValue>> MeshReports;
+	for (const FBatchJob &Job:Jobs)
+	{
+		if (!Job.bLoaded)
+		{
+			continue;
+		}
+
+		TSharedRef<FJsonObject> MeshReport = MakeShared<FJsonObject>();
+		MeshReport->SetStringField(TEXT("source"), Job.SourceName);
+		MeshReport->SetStringField(TEXT("output"), Job.OutputPackageName);
+		MeshReport->SetNumberField(TEXT("vertices"), Job.VertexCount);
+		MeshReport->SetNumberField(TEXT("triangles"), Job.TriangleCount);
+		MeshReport->SetNumberField(TEXT("loadSeconds"), Job.LoadSeconds);
+		MeshReport->SetNumberField(TEXT("deformSeconds"), Job.DeformSeconds);
+		MeshReport->SetBoolField(TEXT("saved"), Job.bSaved);
+		MeshReports.Add(MakeShared<FJsonValueObject>(MeshReport));
+	}
+	Report->SetArrayField(TEXT("meshes"), MeshReports);
+
+	FString ReportText;
+	FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&ReportText));
+	if (!FFileHelper::SaveStringToFile(ReportText, *ReportFilename))
+	{
+		UE_LOG(MDTLog, Error, TEXT("MeshDeformationBatch: Cannot write report '%s'"), *ReportFilename);
+		return 1;
+	}
+
+	UE_LOG(
+		MDTLog, Display, TEXT("MeshDeformationBatch: Processed %d meshes (%d failed) in %.2fs, report in %s"),
+		MeshNames.Num(), FailedCount, FPlatformTime::Seconds()-BatchStartTime, *ReportFilename
+	);
+	return FailedCount>0 ? 1 : 0;
+}
@@ -0,0 +1,331 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "Components/SplineComponent.h"
+#include "Curves/CurveFloat.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Developer/RawMesh/Public/RawMesh.h"
+#include "ProceduralMeshComponent.h"
+#include "AllocationCounter.h"
+#include "MeshGeometry.h"
+#include "SelectionSet.h"
+#include "SelectionSetBPLibrary.h"
+
+#include "MeshDeformationBenchmarkCommandlet.h"
+
+namespace
+{
+	/// One operation to time, returning the SelectionSet it created (if any) so its size
+	/// can be reported
+	struct FBenchmark
+	{
+		const TCHAR *Name;
+		const TCHAR *Category;
+		TFunction<USelectionSet *()> Run;
+	};
+
+	/// Fill a MeshGeometry with a gently rippled square grid with at least VertexCount
+	/// vertices, with every attribute filled so the save paths have everything to copy.
+	void BuildGrid(UMeshGeometry *MeshGeometry, int32 VertexCount)
+	{
+		const int32 Side = FMath::Max(2, FMath::CeilToInt(FMath::Sqrt((float)VertexCount)));
+		const int32 NumVertices = Side*Side;
+		const float Spacing = 10.0f;
+
+		MeshGeometry->Sections.Empty(1);
+		FSectionGeometry &Section = MeshGeometry->Sections.AddDefaulted_GetRef();
+		Section.Vertices.SetNumUninitialized(NumVertices);
+		Section.Normals.SetNumUninitialized(NumVertices);
+		TArray<FVector2D> &UVs = Section.GetMutableUVs(false);
+		TArray<FProcMeshTangent> &Tangents = Section.GetMutableTangents(false);
+		TArray<FLinearColor> &VertexColors = Section.GetMutableVertexColors(false);
+		UVs.SetNumUninitialized(NumVertices);
+		Tangents.Init(FProcMeshTangent(1.0f, 0.0f, 0.0f), NumVertices);
+		VertexColors.Init(FLinearColor::White, NumVertices);
+
+		for (int32 Y = 0; Y<Side; ++Y)
+		{
+			for (int32 X = 0; X<Side; ++X)
+			{
+				const int32 Index = Y*Side+X;
+				Section.Vertices[Index] = FVector(X*Spacing, Y*Spacing, FMath::Sin(X*0.1f)*FMath::Cos(Y*0.1f)*Spacing);
+				Section.Normals[Index] = FVector::UpVector;
+				UVs[Index] = FVector2D((float)X/(Side-1), (float)Y/(Side-1));
+			}
+		}
+
+		TArray<int32> &Triangles = Section.GetMutableTriangles(false);
+		Triangles.Reset((Side-1)*(Side-1)*6);
+		for (int32 Y = 0; Y<Side-1; ++Y)
+		{
+			for (int32 X = 0; X<Side-1; ++X)
+			{
+				const int32 Index = Y*Side+X;
+				Triangles.Add(Index);
+				Triangles.Add(Index+Side);
+				Triangles.Add(Index+1);
+				Triangles.Add(Index+1);
+				Triangles.Add(Index+Side);
+				Triangles.Add(Index+Side+1);
+			}
+		}
+
+		MeshGeometry->Sections[0].ShareAttributes();
+		MeshGeometry->RefreshCachedCounts();
+	}
+}
+
+UMeshDeformationBenchmarkCommandlet::UMeshDeformationBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	HelpDescription = TEXT("Time every MeshGeometry and SelectionSet operation against synthetic meshes");
+	HelpUsage = TEXT("-run=MeshDeformationBenchmark -Sizes=<Count,Count> -Iterations=<Count> -Filter=<Text> -Output=<File>");
+}
+
+int32 UMeshDeformationBenchmarkCommandlet::Main(const FString &Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	TArray<int32> Sizes = {1000, 10000, 100000, 1000000, 10000000};
+	if (const FString *SizesParam = ParamValues.Find(TEXT("Sizes")))
+	{
+		TArray<FString> SizeStrings;
+		SizesParam->ParseIntoArray(SizeStrings, TEXT(","), true);
+		Sizes.Reset();
+		for (const FString &SizeString:SizeStrings)
+		{
+			Sizes.Add(FCString::Atoi(*SizeString));
+		}
+	}
+	const FString *IterationsParam = ParamValues.Find(TEXT("Iterations"));
+	const int32 Iterations = FMath::Max(1, IterationsParam ? FCString::Atoi(**IterationsParam) : 3);
+	const FString *FilterParam = ParamValues.Find(TEXT("Filter"));
+	const FString Filter = FilterParam ? *FilterParam : FString();
+	const FString *OutputParam = ParamValues.Find(TEXT("Output"));
+	const FString OutputFilename = OutputParam ?
+		*OutputParam :
+		FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MeshDeformationBenchmark.json"));
+
+	// The fixtures which don't depend on the mesh size.
+	Spline = NewObject<USplineComponent>(this);
+	Spline->SetSplinePoints(
+		{FVector::ZeroVector, FVector(1000, 500, 0), FVector(2000, 0, 250)},
+		ESplineCoordinateSpace::Local
+	);
+	Curve = NewObject<UCurveFloat>(this);
+	Curve->FloatCurve.AddKey(0.0f, 0.0f);
+	Curve->FloatCurve.AddKey(0.5f, 1.0f);
+	Curve->FloatCurve.AddKey(1.0f, 0.25f);
+	ProceduralMeshComponent = NewObject<UProceduralMeshComponent>(this);
+	FRandomStream RandomStream(1337);
+
+	// Every benchmark, each run against a fresh copy of the mesh.
+	const TArray<FBenchmark> Benchmarks = {
+		// Selectors
+		{TEXT("SelectAll"), TEXT("Selector"), [&]() { return Geometry->SelectAll(); }},
+		{TEXT("SelectByNoise"), TEXT("Selector"), [&]() { return Geometry->SelectByNoise(FTransform::Identity); }},
+		{TEXT("SelectByNormal"), TEXT("Selector"), [&]() { return Geometry->SelectByNormal(); }},
+		{TEXT("SelectBySection"), TEXT("Selector"), [&]() { return Geometry->SelectBySection(0); }},
+		{TEXT("SelectByVertexRange"), TEXT("Selector"), [&]() { return Geometry->SelectByVertexRange(0, Geometry->GetTotalVertexCount(), 2); }},
+		{TEXT("SelectInVolume"), TEXT("Selector"), [&]() { return Geometry->SelectInVolume(FVector(0, 0, -100), FVector(5000, 5000, 100)); }},
+		{TEXT("SelectLinear"), TEXT("Selector"), [&]() { return Geometry->SelectLinear(FVector::ZeroVector, FVector(5000, 5000, 0)); }},
+		{TEXT("SelectNear"), TEXT("Selector"), [&]() { return Geometry->SelectNear(FVector(1000, 1000, 0), 100, 2000); }},
+		{TEXT("SelectNearInto"), TEXT("Selector"), [&]() { return Geometry->SelectNearInto(FVector(1000, 1000, 0), 100, 2000, ReusedSelection); }},
+		{TEXT("SelectNearSmall"), TEXT("Selector"), [&]() { return Geometry->SelectNear(FVector(100, 100, 0), 0, 100); }},
+		{TEXT("SelectNearLine"), TEXT("Selector"), [&]() { return Geometry->SelectNearLine(FVector::ZeroVector, FVector(5000, 0, 0), 100, 2000); }},
+		{TEXT("SelectNearSpline"), TEXT("Selector"), [&]() { return Geometry->SelectNearSpline(Spline, FTransform::Identity, 100, 2000); }},
+
+		// Deformers
+		{TEXT("FitToSpline"), TEXT("MeshGeometry"), [&]() { Geometry->FitToSpline(Spline, 0, 1, 1, Curve, nullptr, SelectionA); return nullptr; }},
+		{TEXT("FlipTextureUV"), TEXT("MeshGeometry"), [&]() { Geometry->FlipTextureUV(true, true, SelectionA); return nullptr; }},
+		{TEXT("Inflate"), TEXT("MeshGeometry"), [&]() { Geometry->Inflate(10, SelectionA); return nullptr; }},
+		{TEXT("Jitter"), TEXT("MeshGeometry"), [&]() { Geometry->Jitter(RandomStream, FVector(-1), FVector(1), SelectionA); return nullptr; }},
+		{TEXT("Lerp"), TEXT("MeshGeometry"), [&]() { Geometry->Lerp(TargetGeometry, 0.5f, SelectionA); return nullptr; }},
+		{TEXT("LerpVector"), TEXT("MeshGeometry"), [&]() { Geometry->LerpVector(FVector(0, 0, 500), 0.5f, SelectionA); return nullptr; }},
+		{TEXT("MoveTowards"), TEXT("MeshGeometry"), [&]() { Geometry->MoveTowards(FVector(0, 0, 500), 10, true, SelectionA); return nullptr; }},
+		{TEXT("Rotate"), TEXT("MeshGeometry"), [&]() { Geometry->Rotate(FRotator(10, 20, 30), FVector::ZeroVector, SelectionA); return nullptr; }},
+		{TEXT("RotateAroundAxis"), TEXT("MeshGeometry"), [&]() { Geometry->RotateAroundAxis(FVector::ZeroVector, FVector::UpVector, 45, SelectionA); return nullptr; }},
+		{TEXT("Scale"), TEXT("MeshGeometry"), [&]() { Geometry->Scale(FVector(1, 2, 3), FVector::ZeroVector, SelectionA); return nullptr; }},
+		{TEXT("ScaleAlongAxis"), TEXT("MeshGeometry"), [&]() { Geometry->ScaleAlongAxis(FVector::ZeroVector, FVector::UpVector, 2, SelectionA); return nullptr; }},
+		{TEXT("Spherize"), TEXT("MeshGeometry"), [&]() { Geometry->Spherize(1000, 1, FVector::ZeroVector, SelectionA); return nullptr; }},
+		{TEXT("Transform"), TEXT("MeshGeometry"), [&]() { Geometry->Transform(FTransform(FRotator(10, 0, 0), FVector(1, 2, 3)), FVector::ZeroVector, SelectionA); return nullptr; }},
+		{TEXT("TransformUV"), TEXT("MeshGeometry"), [&]() { Geometry->TransformUV(FTransform(FRotator(0, 45, 0)), FVector2D(0.5f, 0.5f), SelectionA); return nullptr; }},
+		{TEXT("Translate"), TEXT("MeshGeometry"), [&]() { Geometry->Translate(FVector(1, 2, 3), SelectionA); return nullptr; }},
+		{TEXT("TranslateMask"), TEXT("MeshGeometry"), [&]() { Geometry->Translate(FVector(1, 2, 3), MaskSelection); return nullptr; }},
+		{TEXT("TranslateSparse"), TEXT("MeshGeometry"), [&]() { Geometry->Translate(FVector(1, 2, 3), SparseSelection); return nullptr; }},
+		{TEXT("RebuildNormals"), TEXT("MeshGeometry"), [&]() { Geometry->RebuildNormals(); return nullptr; }},
+		{TEXT("GetBoundingBox"), TEXT("MeshGeometry"), [&]() { Geometry->MarkGeometryChanged(ESectionChanges::None); Geometry->GetBoundingBox(); return nullptr; }},
+		{TEXT("GetRadius"), TEXT("MeshGeometry"), [&]() { Geometry->MarkGeometryChanged(ESectionChanges::None); Geometry->GetRadius(); return nullptr; }},
+		{TEXT("Clone"), TEXT("MeshGeometry"), [&]() { Geometry->Clone(); return nullptr; }},
+
+		// SelectionSetBPLibrary
+		{TEXT("AddFloatToSelectionSet"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::AddFloatToSelectionSet(SelectionA, 0.5f); }},
+		{TEXT("AddSelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::AddSelectionSets(SelectionA, SelectionB); }},
+		{TEXT("AndSelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::AndSelectionSets(MaskSelection, SparseSelection); }},
+		{TEXT("Clamp"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::Clamp(SelectionA, 0.25f, 0.75f); }},
+		{TEXT("CountSelected"), TEXT("SelectionSetBPLibrary"), [&]() { USelectionSetBPLibrary::CountSelected(MaskSelection); return nullptr; }},
+		{TEXT("DivideFloatBySelectionSet"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::DivideFloatBySelectionSet(2, SelectionB); }},
+		{TEXT("DivideSelectionSetByFloat"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::DivideSelectionSetByFloat(SelectionA, 2); }},
+		{TEXT("DivideSelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::DivideSelectionSets(SelectionA, SelectionB); }},
+		{TEXT("Ease"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::Ease(SelectionA, EEasingFunc::EaseInOut); }},
+		{TEXT("LerpSelectionSetWithFloat"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::LerpSelectionSetWithFloat(SelectionA, 1, 0.5f); }},
+		{TEXT("LerpSelectionSetsWithFloat"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::LerpSelectionSetsWithFloat(SelectionA, SelectionB, 0.5f); }},
+		{TEXT("LerpSelectionSetsWithSelectionSet"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::LerpSelectionSetsWithSelectionSet(SelectionA, SelectionB, SelectionA); }},
+		{TEXT("MaxSelectionSetAgainstFloat"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::MaxSelectionSetAgainstFloat(SelectionA, 0.5f); }},
+		{TEXT("MaxSelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::MaxSelectionSets(SelectionA, SelectionB); }},
+		{TEXT("MinSelectionSetAgainstFloat"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::MinSelectionSetAgainstFloat(SelectionA, 0.5f); }},
+		{TEXT("MinSelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::MinSelectionSets(SelectionA, SelectionB); }},
+		{TEXT("MultiplySelctionSetByFloat"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::MultiplySelctionSetByFloat(SelectionA, 2); }},
+		{TEXT("MultiplySelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::MultiplySelectionSets(SelectionA, SelectionB); }},
+		{TEXT("NotSelectionSet"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::NotSelectionSet(MaskSelection); }},
+		{TEXT("OneMinus"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::OneMinus(SelectionA); }},
+		{TEXT("OrSelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::OrSelectionSets(MaskSelection, SparseSelection); }},
+		{TEXT("Power"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::Power(SelectionA, 2.5f); }},
+		{TEXT("Randomize"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::Randomize(SelectionA, RandomStream); }},
+		{TEXT("RemapToCurve"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::RemapToCurve(SelectionA, Curve); }},
+		{TEXT("RemapToRange"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::RemapToRange(SelectionA, 0.25f, 0.75f); }},
+		{TEXT("RemapPeriodic"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::RemapPeriodic(SelectionA); }},
+		{TEXT("Set"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::Set(SelectionA, 0.5f); }},
+		{TEXT("StoreInto"), TEXT("SelectionSetBPLibrary"), [&]()
+			{
+				return USelectionSetBPLibrary::StoreInto(
+					USelectionSetBPLibrary::MultiplySelectionSets(USelectionSetBPLibrary::OneMinus(SelectionA), SelectionB),
+					ReusedSelection
+				);
+			}
+		},
+		{TEXT("SubtractFloatFromSelectionSet"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::SubtractFloatFromSelectionSet(SelectionA, 0.5f); }},
+		{TEXT("SubtractSelectionSetFromFloat"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::SubtractSelectionSetFromFloat(1, SelectionA); }},
+		{TEXT("SubtractSelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::SubtractSelectionSets(SelectionA, SelectionB); }},
+		{TEXT("XorSelectionSets"), TEXT("SelectionSetBPLibrary"), [&]() { return USelectionSetBPLibrary::XorSelectionSets(MaskSelection, SelectionA); }},
+
+		// Save paths.  The StaticMesh path is timed up to the RawMesh, the asset build
+		// itself is engine code.
+		{TEXT("SaveToProceduralMeshComponent"), TEXT("Save"), [&]() { Geometry->SaveToProceduralMeshComponent(ProceduralMeshComponent, false); return nullptr; }},
+		{TEXT("SaveToProceduralMeshComponentChanges"), TEXT("Save"), [&]()
+			{
+				Geometry->SaveToProceduralMeshComponent(ProceduralMeshComponent, false);
+				Geometry->Translate(FVector(1, 0, 0), nullptr);
+				Geometry->SaveToProceduralMeshComponent(ProceduralMeshComponent, false, true);
+				return nullptr;
+			}
+		},
+		{TEXT("SaveToStaticMeshRawMesh"), TEXT("Save"), [&]() { FRawMesh RawMesh; Geometry->BuildRawMesh(RawMesh); return nullptr; }},
+	};
+
+	IConsoleVariable *ParallelChunkSize = IConsoleManager::Get().FindConsoleVariable(TEXT("mdt.ParallelChunkSize"));
+
+	TArray<TSharedPtr<FJsonValue>> Results;
+	for (const int32 Size:Sizes)
+	{
+		SourceGeometry = NewObject<UMeshGeometry>(this);
+		BuildGrid(SourceGeometry, Size);
+		const int32 VertexCount = SourceGeometry->GetTotalVertexCount();
+
+		TargetGeometry = SourceGeometry->Clone();
+		TargetGeometry->Spherize(1000);
+		Geometry = SourceGeometry->Clone();
+		SelectionA = Geometry->SelectLinear(FVector::ZeroVector, FVector(VertexCount, VertexCount, 0));
+		SelectionB = USelectionSetBPLibrary::AddFloatToSelectionSet(Geometry->SelectByNoise(FTransform::Identity), 1.0f);
+		ReusedSelection = Geometry->SelectAll();
+		SparseSelection = Geometry->SelectNear(FVector(100, 100, 0), 0, 100);
+		MaskSelection = Geometry->SelectInVolume(FVector(0, 0, -100), FVector(VertexCount/2, VertexCount, 100));
+
+		UE_LOG(MDTLog, Display, TEXT("MeshDeformationBenchmark: %d vertices"), VertexCount);
+
+		for (const FBenchmark &Benchmark:Benchmarks)
+		{
+			if (!Filter.IsEmpty() && !FString(Benchmark.Name).Contains(Filter))
+			{
+				continue;
+			}
+
+			double TotalSeconds = 0.0;
+			double MinSeconds = MAX_dbl;
+			int64 ResultBytes = 0;
+			for (int32 Iteration = 0; Iteration<Iterations; ++Iteration)
+			{
+				Geometry->LoadFromMeshGeometry(SourceGeometry);
+
+				const double StartTime = FPlatformTime::Seconds();
+				USelectionSet *Result = Benchmark.Run();
+				if (Result)
+				{
+					// Lazy math is only done when the weights are read, so that's part of the time.
+					Result->EvaluateExpression();
+				}
+				const double Seconds = FPlatformTime::Seconds()-StartTime;
+
+				TotalSeconds += Seconds;
+				MinSeconds = FMath::Min(MinSeconds, Seconds);
+				ResultBytes = Result ? Result->GetAllocatedSize() : 0;
+			}
+
+			// One more run, which isn't timed, counts the allocations so counting them doesn't
+			// slow down the timed runs.  Only this thread's allocations are counted, so the run is
+			// kept on it rather than split across the task threads.
+			Geometry->LoadFromMeshGeometry(SourceGeometry);
+			const int32 TimedChunkSize = ParallelChunkSize->GetInt();
+			ParallelChunkSize->Set(0, ECVF_SetByCode);
+			int64 AllocationCount = 0;
+			int64 BytesAllocated = 0;
+			{
+				FScopedAllocationCounter AllocationCounter;
+				if (USelectionSet *Result = Benchmark.Run())
+				{
+					Result->EvaluateExpression();
+				}
+				AllocationCount = AllocationCounter.GetAllocationCount();
+				BytesAllocated = AllocationCounter.GetBytesAllocated();
+			}
+			ParallelChunkSize->Set(TimedChunkSize, ECVF_SetByCode);
+
+			TSharedRef<FJsonObject> BenchmarkResult = MakeShared<FJsonObject>();
+			BenchmarkResult->SetStringField(TEXT("name"), Benchmark.Name);
+			BenchmarkResult->SetStringField(TEXT("category"), Benchmark.Category);
+			BenchmarkResult->SetNumberField(TEXT("vertices"), VertexCount);
+			BenchmarkResult->SetNumberField(TEXT("iterations"), Iterations);
+			BenchmarkResult->SetNumberField(TEXT("minSeconds"), MinSeconds);
+			BenchmarkResult->SetNumberField(TEXT("meanSeconds"), TotalSeconds/Iterations);
+			BenchmarkResult->SetNumberField(TEXT("verticesPerSecond"), MinSeconds>0.0 ? VertexCount/MinSeconds : 0.0);
+			BenchmarkResult->SetNumberField(TEXT("allocations"), (double)AllocationCount);
+			BenchmarkResult->SetNumberField(TEXT("bytesAllocated"), (double)BytesAllocated);
+			BenchmarkResult->SetNumberField(TEXT("resultBytes"), (double)ResultBytes);
+			Results.Add(MakeShared<FJsonValueObject>(BenchmarkResult));
+
+			UE_LOG(
+				MDTLog, Display, TEXT("MeshDeformationBenchmark: %-40s %10.3fms %14.0f verts/s"),
+				Benchmark.Name, MinSeconds*1000.0, MinSeconds>0.0 ? VertexCount/MinSeconds : 0.0
+			);
+
+			// Don't let the SelectionSets from one benchmark pile up into the next.
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+	}
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("iterations"), Iterations);
+	Report->SetNumberField(TEXT("parallelChunkSize"), ParallelChunkSize->GetInt());
+	Report->SetArrayField(TEXT("results"), Results);
+
+	FString ReportText;
+	FJsonSerializer::Serialize(Report, TJsonWriterFactory<>::Create(&ReportText));
+	if (!FFileHelper::SaveStringToFile(ReportText, *OutputFilename))
+	{
+		UE_LOG(MDTLog, Error, TEXT("MeshDeformationBenchmark: Cannot write results '%s'"), *OutputFilename);
+		return 1;
+	}
+
+	UE_LOG(MDTLog, Display, TEXT("MeshDeformationBenchmark: Results in %s"), *OutputFilename);
+	return 0;
+}
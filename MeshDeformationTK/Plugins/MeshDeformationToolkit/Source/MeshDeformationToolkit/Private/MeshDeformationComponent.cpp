@@ -1,22 +1,393 @@
 // (c)2017 Paul Golds, released under MIT License.
 
 #include "MeshDeformationToolkit.h"
+#include "Async/Async.h"
+#include "Engine/Engine.h"
 #include "MeshGeometry.h"
+#include "MeshDeformationOperation.h"
+#include "MeshDeformationSubsystem.h"
+#include "ProceduralMeshComponent.h"
+#include "Utility.h"
 #include "MeshDeformationComponent.h"
 
+DECLARE_CYCLE_STAT(TEXT("ApplyDeferredOperations"), STAT_MDT_ApplyDeferredOperations, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("AsyncEvaluation"), STAT_MDT_AsyncEvaluation, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("EvaluateOperationStack"), STAT_MDT_EvaluateOperationStack, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("FinishAsyncEvaluation"), STAT_MDT_FinishAsyncEvaluation, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("StartAsyncEvaluation"), STAT_MDT_StartAsyncEvaluation, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("StepTimeSlicedEvaluation"), STAT_MDT_StepTimeSlicedEvaluation, STATGROUP_MeshDeformationToolkit);
 
 // Sets default values for this component's properties
 UMeshDeformationComponent::UMeshDeformationComponent()
 {
-	// This component can never tick, it doesn't update itself.
-	PrimaryComponentTick.bCanEverTick = false;
+	// This component only ticks while an asynchronous evaluation is running, to pick up the result.
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UMeshDeformationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (Evaluation.IsValid() && Evaluation.IsReady())
+	{
+		FinishAsyncEvaluation();
+	}
+
+	// Start the next evaluation if another save was requested while this one was running.
+	if (!IsEvaluationRunning())
+	{
+		if (bEvaluationRequested && MeshGeometry)
+		{
+			StartAsyncEvaluation();
+		}
+		else
+		{
+			bEvaluationRequested = false;
+			SetComponentTickEnabled(false);
+		}
+	}
+}
+
+void UMeshDeformationComponent::BeginDestroy()
+{
+	// The worker writes to BackBuffer, so it has to finish before that can be destroyed.
+	if (Evaluation.IsValid())
+	{
+		Evaluation.Wait();
+	}
+
+	Super::BeginDestroy();
 }
 
 UMeshGeometry * UMeshDeformationComponent::CloneMeshGeometry()
 {
+	ApplyDeferredOperations();
 	return this->MeshGeometry->Clone();
 }
 
+void UMeshDeformationComponent::FlushDeferredOperations(UMeshDeformationComponent *&MeshDeformationComponent)
+{
+	MeshDeformationComponent = this;
+	ApplyDeferredOperations();
+}
+
+namespace
+{
+	/// Whether two transforms in a row can be folded into one, which is only exact when every
+	/// vertex gets either all of both or none of either.  A weighted transform blends its result
+	/// with the original position, and blending twice isn't the same as blending the product.
+	///
+	/// \param PreviousSelection	The copy of the SelectionSet the previous transform uses, if any
+	/// \param Selection			The SelectionSet the next transform uses, if any
+	bool CanFoldAffineOperations(const USelectionSet *PreviousSelection, const USelectionSet *Selection)
+	{
+		if (!PreviousSelection||!Selection)
+		{
+			return !PreviousSelection && !Selection;
+		}
+		return PreviousSelection->IsMask() && Selection->IsMask() &&
+			PreviousSelection->Size()==Selection->Size() &&
+			PreviousSelection->GetMaskWords()==Selection->GetMaskWords();
+	}
+}
+
+void UMeshDeformationComponent::DeferAffineOperation(const FMatrix &Matrix, USelectionSet *Selection)
+{
+	// Fold the transform into the previous one if they apply to the same vertices in full.
+	// UE4 matrices transform row vectors so the new matrix goes on the right.
+	if (DeferredOperations.Num()>0 && CanFoldAffineOperations(DeferredOperations.Last().Selection, Selection))
+	{
+		FDeferredAffineOperation &PreviousOperation = DeferredOperations.Last();
+		PreviousOperation.Matrix = PreviousOperation.Matrix * Matrix;
+		return;
+	}
+
+	// The operation keeps its own copy of the SelectionSet, so changing the set before the
+	// operations are applied doesn't change the result.
+	FDeferredAffineOperation &Operation = DeferredOperations.AddDefaulted_GetRef();
+	Operation.Matrix = Matrix;
+	Operation.Selection = CopyRecordedSelection(Selection);
+}
+
+void UMeshDeformationComponent::ApplyDeferredOperations()
+{
+	// The recorded operations follow on from the running evaluation's result.  If the geometry
+	// has been reloaded since it started, as it is when each frame starts by loading the
+	// undeformed mesh, then the result isn't needed here and there's no need to wait for it.
+	if (MeshGeometry && MeshGeometry==EvaluationSource.Get())
+	{
+		FinishAsyncEvaluation();
+	}
+
+	if (DeferredOperations.Num()==0 && RecordedOperations.Num()==0)
+	{
+		return;
+	}
+
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_ApplyDeferredOperations);
+
+	// Take the operations before applying them, the lists are cleared whether or not there's
+	// geometry to apply them to.  The deferred operations always follow the recorded ones, and
+	// their copies of SelectionSets are in *RecordedSelections* too.
+	TArray<FRecordedOperation> Operations = MoveTemp(RecordedOperations);
+	TArray<USelectionSet *> Selections = MoveTemp(RecordedSelections);
+	TArray<FDeferredAffineOperation> AffineOperations = MoveTemp(DeferredOperations);
+	RecordedOperations.Reset();
+	RecordedSelections.Reset();
+	DeferredOperations.Reset();
+
+	if (!MeshGeometry)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("FlushDeferredOperations: No meshGeometry loaded"));
+	}
+	else
+	{
+		for (const FRecordedOperation &Operation:Operations)
+		{
+			Operation(MeshGeometry);
+		}
+		for (const FDeferredAffineOperation &Operation:AffineOperations)
+		{
+			MeshGeometry->ApplyMatrix(Operation.Matrix, Operation.Selection);
+		}
+	}
+	ReleaseRecordedSelections(Selections);
+}
+
+bool UMeshDeformationComponent::IsEvaluatingAsync() const
+{
+	return IsEvaluationRunning()||bEvaluationRequested;
+}
+
+bool UMeshDeformationComponent::StepTimeSlicedEvaluation(int32 MaxVertexCount, int32 &VertexCount)
+{
+	VertexCount = 0;
+	if (!bTimeSlicedEvaluationRunning)
+	{
+		return true;
+	}
+
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_StepTimeSlicedEvaluation);
+
+	if (NextSlicedOperation<SlicedOperations.Num())
+	{
+		const int32 TotalVertexCount = BackBuffer->GetTotalVertexCount();
+		const int32 EndVertex = SlicedVertexCursor+FMath::Min(FMath::Max(MaxVertexCount, 1), TotalVertexCount-SlicedVertexCursor);
+
+		BackBuffer->SetVertexRange(SlicedVertexCursor, EndVertex);
+		SlicedOperations[NextSlicedOperation](BackBuffer);
+		const bool bUsedVertexRange = BackBuffer->ClearVertexRange();
+
+		// An operation which didn't use the range has already been applied to every vertex.
+		if (bUsedVertexRange && EndVertex<TotalVertexCount)
+		{
+			VertexCount = EndVertex-SlicedVertexCursor;
+			SlicedVertexCursor = EndVertex;
+		}
+		else
+		{
+			VertexCount = bUsedVertexRange ? EndVertex-SlicedVertexCursor : TotalVertexCount;
+			SlicedVertexCursor = 0;
+			++NextSlicedOperation;
+		}
+	}
+	if (NextSlicedOperation<SlicedOperations.Num())
+	{
+		return false;
+	}
+
+	FinishAsyncEvaluation();
+	return true;
+}
+
+bool UMeshDeformationComponent::IsEvaluationRunning() const
+{
+	return Evaluation.IsValid()||bTimeSlicedEvaluationRunning;
+}
+
+bool UMeshDeformationComponent::RecordOperation(USelectionSet *Selection, FWeightedOperation Operation)
+{
+	if (!bEvaluateAsync)
+	{
+		return false;
+	}
+
+	RecordDeferredOperations();
+	USelectionSet *RecordedSelection = CopyRecordedSelection(Selection);
+	RecordedOperations.Add([RecordedSelection, Operation = MoveTemp(Operation)](UMeshGeometry *Geometry)
+	{
+		Operation(Geometry, RecordedSelection);
+	});
+	return true;
+}
+
+void UMeshDeformationComponent::RecordDeferredOperations()
+{
+	if (DeferredOperations.Num()==0)
+	{
+		return;
+	}
+
+	// The operations already hold copies of their SelectionSets.
+	RecordedOperations.Add([Operations = MoveTemp(DeferredOperations)](UMeshGeometry *Geometry)
+	{
+		for (const FDeferredAffineOperation &Operation:Operations)
+		{
+			Geometry->ApplyMatrix(Operation.Matrix, Operation.Selection);
+		}
+	});
+	DeferredOperations.Reset();
+}
+
+USelectionSet * UMeshDeformationComponent::CopyRecordedSelection(USelectionSet *Selection)
+{
+	if (!Selection)
+	{
+		return nullptr;
+	}
+
+	// A lazy SelectionSet is evaluated into the copy, so the evaluation only ever reads weights.
+	USelectionSet *Copy = SpareSelections.Num()>0 ? SpareSelections.Pop(false) : NewObject<USelectionSet>(this);
+	Copy->CopyFrom(*Selection);
+	RecordedSelections.Add(Copy);
+	return Copy;
+}
+
+void UMeshDeformationComponent::ReleaseRecordedSelections(TArray<USelectionSet *> &Selections)
+{
+	// The weights go back to the pool, only the objects are kept.
+	for (USelectionSet *Selection:Selections)
+	{
+		Selection->Empty();
+	}
+	SpareSelections.Append(Selections);
+	Selections.Reset();
+}
+
+void UMeshDeformationComponent::StartAsyncEvaluation()
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_StartAsyncEvaluation);
+
+	check(!IsEvaluationRunning());
+	bEvaluationRequested = false;
+
+	// Copying the geometry has to happen here, as the game thread could change it while the
+	// worker is running.
+	if (!BackBuffer)
+	{
+		BackBuffer = NewObject<UMeshGeometry>(this);
+	}
+	BackBuffer->CopyGeometryFrom(*MeshGeometry);
+	EvaluationSource = MeshGeometry;
+	EvaluationSourceGeneration = MeshGeometry->GetGeneration();
+
+	// The worker takes the recorded operations, and the copies of the SelectionSets they use
+	// are kept until it's finished.
+	RecordDeferredOperations();
+	EvaluatingSelections = MoveTemp(RecordedSelections);
+	RecordedSelections.Reset();
+
+	UMeshDeformationSubsystem *Subsystem =
+		bTimeSliceEvaluation && GEngine ? GEngine->GetEngineSubsystem<UMeshDeformationSubsystem>() : nullptr;
+	if (Subsystem)
+	{
+		// The subsystem runs the operations a step at a time on the game thread.
+		SlicedOperations = MoveTemp(RecordedOperations);
+		NextSlicedOperation = 0;
+		SlicedVertexCursor = 0;
+		bTimeSlicedEvaluationRunning = true;
+		Subsystem->QueueEvaluation(this);
+	}
+	else
+	{
+		UMeshGeometry *Target = BackBuffer;
+		Evaluation = Async(EAsyncExecution::TaskGraph, [Target, Operations = MoveTemp(RecordedOperations)]()
+		{
+			MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_AsyncEvaluation);
+			for (const FRecordedOperation &Operation:Operations)
+			{
+				Operation(Target);
+			}
+		});
+	}
+	RecordedOperations.Reset();
+
+	SetComponentTickEnabled(true);
+}
+
+void UMeshDeformationComponent::FinishAsyncEvaluation()
+{
+	if (!IsEvaluationRunning())
+	{
+		return;
+	}
+
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_FinishAsyncEvaluation);
+
+	if (Evaluation.IsValid())
+	{
+		Evaluation.Wait();
+		Evaluation = TFuture<void>();
+	}
+
+	// Anything the subsystem hasn't got to yet is run now, as the result is needed straight away,
+	// starting with the rest of an operation which has been partly applied.
+	if (NextSlicedOperation<SlicedOperations.Num() && SlicedVertexCursor>0)
+	{
+		BackBuffer->SetVertexRange(SlicedVertexCursor, MAX_int32);
+		SlicedOperations[NextSlicedOperation++](BackBuffer);
+		BackBuffer->ClearVertexRange();
+	}
+	while (NextSlicedOperation<SlicedOperations.Num())
+	{
+		SlicedOperations[NextSlicedOperation++](BackBuffer);
+	}
+	SlicedOperations.Reset();
+	NextSlicedOperation = 0;
+	SlicedVertexCursor = 0;
+	bTimeSlicedEvaluationRunning = false;
+	ReleaseRecordedSelections(EvaluatingSelections);
+
+	// If the geometry was loaded or changed while the worker was running, as it is when each
+	// frame starts by loading the undeformed mesh, then the result can't be swapped in.  It's
+	// still the latest complete frame so it's saved from the back buffer instead.
+	UMeshGeometry *Result = BackBuffer;
+	if (MeshGeometry && MeshGeometry==EvaluationSource.Get() && MeshGeometry->GetGeneration()==EvaluationSourceGeneration)
+	{
+		MeshGeometry->SwapGeometry(*BackBuffer);
+		Result = MeshGeometry;
+	}
+
+	UProceduralMeshComponent *ProceduralMeshComponent = AsyncSaveTarget.Get();
+	if (!ProceduralMeshComponent)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("FinishAsyncEvaluation: ProceduralMeshComponent no longer exists"));
+		return;
+	}
+	SaveGeometryToProceduralMeshComponent(
+		Result, ProceduralMeshComponent, bAsyncSaveCreateCollision, AsyncSaveMaterials, bAsyncSaveOnlyUpdateChanges
+	);
+}
+
+bool UMeshDeformationComponent::SaveGeometryToProceduralMeshComponent(
+	UMeshGeometry *Geometry, UProceduralMeshComponent *ProceduralMeshComponent, bool bCreateCollision,
+	const TArray<UMaterialInterface *> &Materials, bool bOnlyUpdateChanges)
+{
+	bool bSuccess = Geometry->SaveToProceduralMeshComponent(
+		ProceduralMeshComponent, bCreateCollision, bOnlyUpdateChanges
+	);
+	if (!bSuccess) {
+		return bSuccess;
+	}
+
+	for (int MaterialIndex = 0; MaterialIndex < Materials.Num(); ++MaterialIndex) {
+		ProceduralMeshComponent->SetMaterial(MaterialIndex, Materials[MaterialIndex]);
+	}
+
+	return bSuccess;
+}
+
 void UMeshDeformationComponent::Project(
 	UMeshDeformationComponent *&MeshDeformationComponent,
 	UObject* WorldContextObject,
@@ -36,6 +407,8 @@ void UMeshDeformationComponent::Project(
 		return;
 	}
 
+	ApplyDeferredOperations();
+
 	MeshGeometry->Project(
 		WorldContextObject, Transform, IgnoredActors, Projection, HeightAdjust, bTraceComplex,
 		CollisionChannel, Selection
@@ -61,6 +434,8 @@ void UMeshDeformationComponent::ProjectDown(
 		return;
 	}
 
+	ApplyDeferredOperations();
+
 	MeshGeometry->ProjectDown(
 		WorldContextObject, Transform, IgnoredActors, ProjectionLength, HeightAdjust,
 		bTraceComplex, CollisionChannel, Selection
@@ -85,6 +460,8 @@ void UMeshDeformationComponent::FitToSpline(
 		UE_LOG(MDTLog, Warning, TEXT("FitToSpline: No meshGeometry loaded"));
 		return;
 	}
+
+	ApplyDeferredOperations();
 	MeshGeometry->FitToSpline(
 		SplineComponent, StartPosition, EndPosition, MeshScale, ProfileCurve, SectionProfileCurve, Selection
 	);
@@ -103,16 +480,24 @@ void UMeshDeformationComponent::FlipTextureUV(
 		UE_LOG(MDTLog, Warning, TEXT("FlipTextureUV: No meshGeometry loaded"));
 		return;
 	}
+
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->FlipTextureUV(bFlipU, bFlipV, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
 	MeshGeometry->FlipTextureUV(bFlipU, bFlipV, Selection);
 }
 
-FBox UMeshDeformationComponent::GetBoundingBox() const
+FBox UMeshDeformationComponent::GetBoundingBox()
 {
 	if (!MeshGeometry)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("GetBoundingBox: No meshGeometry loaded"));
 		return FBox();
 	}
+
+	ApplyDeferredOperations();
 	return MeshGeometry->GetBoundingBox();
 }
 
@@ -171,6 +556,12 @@ void UMeshDeformationComponent::RebuildNormals(UMeshDeformationComponent *&MeshD
 		return;
 	}
 
+	if (RecordOperation(nullptr, [=](UMeshGeometry *Geometry, USelectionSet *) { Geometry->RebuildNormals(); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
+
 	MeshGeometry->RebuildNormals();
 }
 
@@ -187,6 +578,12 @@ void UMeshDeformationComponent::Inflate(UMeshDeformationComponent *&MeshDeformat
 		UE_LOG(MDTLog, Warning, TEXT("Spherize: No meshGeometry loaded"));
 		return;
 	}
+
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->Inflate(Offset, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
 	MeshGeometry->Inflate(Offset, Selection);
 }
 
@@ -203,6 +600,8 @@ void UMeshDeformationComponent::Jitter(
 		UE_LOG(MDTLog, Warning, TEXT("Jitter: No meshGeometry loaded"));
 		return;
 	}
+
+	ApplyDeferredOperations();
 	MeshGeometry->Jitter(fRandomStream, Min, Max, selection);
 }
 
@@ -214,13 +613,15 @@ void UMeshDeformationComponent::Lerp(
 {
 	MeshDeformationComponent = this;
 
-	UE_LOG(MDTLog, Warning, TEXT("IN MESH LERP"))
+	UE_LOG(MDTLog, Verbose, TEXT("IN MESH LERP"));
 	if (!MeshGeometry)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("Lerp: No meshGeometry loaded"));
 		return;
 	}
 
+	ApplyDeferredOperations();
+
 	if (!TargetMeshDeformationComponent)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("Lerp: No TargetMeshDeformationComponent"));
@@ -232,6 +633,7 @@ void UMeshDeformationComponent::Lerp(
 		UE_LOG(MDTLog, Warning, TEXT("Lerp: TargetMeshDeformationComponent has no geometry"));
 		return;
 	}
+	TargetMeshDeformationComponent->ApplyDeferredOperations();
 
 	MeshGeometry->Lerp(
 		TargetMeshDeformationComponent->MeshGeometry,
@@ -254,6 +656,12 @@ void UMeshDeformationComponent::LerpVector(
 		return;
 	}
 
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->LerpVector(Position, Alpha, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
+
 	MeshGeometry->LerpVector(Position, Alpha, Selection);
 }
 
@@ -270,6 +678,12 @@ void UMeshDeformationComponent::MoveTowards(
 		return;
 	}
 
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->MoveTowards(Position, Distance, bLimitAtPosition, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
+
 	MeshGeometry->MoveTowards(Position, Distance, bLimitAtPosition, Selection);
 }
 
@@ -279,6 +693,17 @@ bool UMeshDeformationComponent::LoadFromMeshDeformationComponent(
 {
 	MeshDeformationComponent = this;
 
+	if (!SourceMeshDeformationComponent)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("LoadFromMeshDeformationComponent: No SourceMeshDeformationComponent"));
+		return false;
+	}
+
+	// Anything deferred was for the geometry we're about to replace.
+	DeferredOperations.Empty();
+	RecordedOperations.Empty();
+	ReleaseRecordedSelections(RecordedSelections);
+
 	MeshGeometry = NewObject<UMeshGeometry>(this);
 	if (!MeshGeometry)
 	{
@@ -286,6 +711,8 @@ bool UMeshDeformationComponent::LoadFromMeshDeformationComponent(
 		return false;
 	}
 
+	SourceMeshDeformationComponent->ApplyDeferredOperations();
+
 	bool bSuccess = MeshGeometry->LoadFromMeshGeometry(SourceMeshDeformationComponent->MeshGeometry);
 	if (!bSuccess)
 	{
@@ -301,6 +728,11 @@ bool UMeshDeformationComponent::LoadFromMeshGeometry(
 {
 	MeshDeformationComponent = this;
 
+	// Anything deferred was for the geometry we're about to replace.
+	DeferredOperations.Empty();
+	RecordedOperations.Empty();
+	ReleaseRecordedSelections(RecordedSelections);
+
 	MeshGeometry = NewObject<UMeshGeometry>(this);
 	if (!MeshGeometry)
 	{
@@ -308,7 +740,8 @@ bool UMeshDeformationComponent::LoadFromMeshGeometry(
 		return false;
 	}
 
-	bool bSuccess = MeshGeometry->LoadFromMeshGeometry(SourceMeshGeometry);	if (!bSuccess)
+	bool bSuccess = MeshGeometry->LoadFromMeshGeometry(SourceMeshGeometry);
+	if (!bSuccess)
 	{
 		MeshGeometry = nullptr;
 	}
@@ -323,6 +756,11 @@ bool UMeshDeformationComponent::LoadFromStaticMesh(
 {
 	MeshDeformationComponent = this;
 
+	// Anything deferred was for the geometry we're about to replace.
+	DeferredOperations.Empty();
+	RecordedOperations.Empty();
+	ReleaseRecordedSelections(RecordedSelections);
+
 	MeshGeometry = NewObject<UMeshGeometry>(this);
 	if (!MeshGeometry)
 	{
@@ -338,6 +776,157 @@ bool UMeshDeformationComponent::LoadFromStaticMesh(
 	return bSuccess;
 }
 
+void UMeshDeformationComponent::SetRestPose(UMeshDeformationComponent *&MeshDeformationComponent)
+{
+	MeshDeformationComponent = this;
+
+	if (!MeshGeometry)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("SetRestPose: No meshGeometry loaded"));
+		return;
+	}
+
+	ApplyDeferredOperations();
+
+	if (!RestPose)
+	{
+		RestPose = NewObject<UMeshGeometry>(this);
+	}
+	RestPose->CopyGeometryFrom(*MeshGeometry);
+}
+
+bool UMeshDeformationComponent::HasRestPose() const
+{
+	return RestPose!=nullptr;
+}
+
+UMeshDeformationOperation * UMeshDeformationComponent::AddOperation(TSubclassOf<UMeshDeformationOperation> OperationClass)
+{
+	if (!OperationClass)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("AddOperation: No OperationClass provided"));
+		return nullptr;
+	}
+
+	UMeshDeformationOperation *Operation = NewObject<UMeshDeformationOperation>(this, OperationClass);
+	OperationStack.Add(Operation);
+	return Operation;
+}
+
+void UMeshDeformationComponent::EvaluateOperationStack(UMeshDeformationComponent *&MeshDeformationComponent)
+{
+	MeshDeformationComponent = this;
+
+	if (!RestPose)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("EvaluateOperationStack: No rest pose set"));
+		return;
+	}
+
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_EvaluateOperationStack);
+
+	// Anything deferred was for the geometry we're about to reset.  Reset rather than Empty so
+	// the lists don't reallocate if they're used again.
+	DeferredOperations.Reset();
+	RecordedOperations.Reset();
+	ReleaseRecordedSelections(RecordedSelections);
+
+	if (!bMemoizeOperationStack)
+	{
+		MemoizedCheckpoint = nullptr;
+		MemoizedCheckpointOperationCount = 0;
+		MemoizedHashes.Empty();
+	}
+
+	// Find the first operation which has to be applied again- the first whose hash, which
+	// includes those of every operation before it and the rest pose, has changed.
+	int32 FirstChangedOperation = 0;
+	if (bMemoizeOperationStack)
+	{
+		uint32 Hash = HashCombine(GetTypeHash(RestPose), RestPose->GetGeneration());
+		for (; FirstChangedOperation<OperationStack.Num(); ++FirstChangedOperation)
+		{
+			const UMeshDeformationOperation *Operation = OperationStack[FirstChangedOperation];
+			if (Operation && !Operation->CanMemoize())
+			{
+				break;
+			}
+			Hash = HashCombine(Hash, Operation ? Operation->GetInputHash() : 0);
+			if (!MemoizedHashes.IsValidIndex(FirstChangedOperation) || MemoizedHashes[FirstChangedOperation]!=Hash)
+			{
+				break;
+			}
+		}
+
+		// If nothing has changed, including the geometry itself, then there's nothing to do.
+		if (FirstChangedOperation==OperationStack.Num() && FirstChangedOperation==MemoizedHashes.Num() &&
+			MeshGeometry && MeshGeometry->GetGeneration()==MemoizedGeneration)
+		{
+			return;
+		}
+	}
+
+	// Start from the checkpoint if none of the operations before it have changed, otherwise
+	// it's out of date and everything is applied again from the rest pose.
+	const bool bFromCheckpoint = MemoizedCheckpoint && MemoizedCheckpointOperationCount>0 &&
+		MemoizedCheckpointOperationCount<=FirstChangedOperation;
+	const int32 FirstAppliedOperation = bFromCheckpoint ? MemoizedCheckpointOperationCount : 0;
+	if (!bFromCheckpoint)
+	{
+		MemoizedCheckpointOperationCount = 0;
+	}
+	if (bMemoizeOperationStack)
+	{
+		MemoizedHashes.SetNum(FirstAppliedOperation);
+	}
+
+	if (!MeshGeometry)
+	{
+		MeshGeometry = NewObject<UMeshGeometry>(this);
+	}
+	MeshGeometry->ResetToGeometry(bFromCheckpoint ? *MemoizedCheckpoint : *RestPose);
+
+	bool bMemoizing = bMemoizeOperationStack;
+	uint32 Hash = bMemoizing && FirstAppliedOperation>0 ? MemoizedHashes.Last() :
+		HashCombine(GetTypeHash(RestPose), RestPose->GetGeneration());
+	for (int32 OperationIndex = FirstAppliedOperation; OperationIndex<OperationStack.Num(); ++OperationIndex)
+	{
+		UMeshDeformationOperation *Operation = OperationStack[OperationIndex];
+		if (Operation && Operation->bEnabled)
+		{
+			Operation->Apply(MeshGeometry);
+		}
+
+		// Once an operation can't be memoized nothing after it can be either.
+		bMemoizing = bMemoizing && (!Operation || Operation->CanMemoize());
+		if (!bMemoizing)
+		{
+			continue;
+		}
+
+		Hash = HashCombine(Hash, Operation ? Operation->GetInputHash() : 0);
+		MemoizedHashes.Add(Hash);
+
+		// Checkpoint the result of the last unchanged operation, as the next change is most
+		// likely to be to the same operation.  The buffers from the last checkpoint are reused.
+		if (OperationIndex+1==FirstChangedOperation)
+		{
+			if (!MemoizedCheckpoint)
+			{
+				MemoizedCheckpoint = NewObject<UMeshGeometry>(this);
+			}
+			MeshGeometry->ShareAttributes();
+			MemoizedCheckpoint->ResetToGeometry(*MeshGeometry);
+			MemoizedCheckpointOperationCount = FirstChangedOperation;
+		}
+	}
+
+	if (bMemoizeOperationStack)
+	{
+		MemoizedGeneration = MeshGeometry->GetGeneration();
+	}
+}
+
 
 void UMeshDeformationComponent::Rotate(UMeshDeformationComponent *&MeshDeformationComponent, FRotator Rotation/*= FRotator::ZeroRotator*/, FVector CenterOfRotation /*= FVector::ZeroVector*/, USelectionSet *Selection /*=nullptr*/)
 {
@@ -347,6 +936,16 @@ void UMeshDeformationComponent::Rotate(UMeshDeformationComponent *&MeshDeformati
 		UE_LOG(MDTLog, Warning, TEXT("Rotate: No meshGeometry loaded"));
 		return;
 	}
+	if (bDeferAffineOperations)
+	{
+		DeferAffineOperation(Utility::MatrixAboutCenter(FRotationMatrix(Rotation), CenterOfRotation), Selection);
+		return;
+	}
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->Rotate(Rotation, CenterOfRotation, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
 	MeshGeometry->Rotate(Rotation, CenterOfRotation, Selection);
 
 }
@@ -360,6 +959,12 @@ void UMeshDeformationComponent::RotateAroundAxis(UMeshDeformationComponent *&Mes
 		UE_LOG(MDTLog, Warning, TEXT("Spherize: No meshGeometry loaded"));
 		return;
 	}
+
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->RotateAroundAxis(CenterOfRotation, Axis, AngleInDegrees, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
 	MeshGeometry->RotateAroundAxis(CenterOfRotation, Axis, AngleInDegrees, Selection);
 }
 
@@ -367,7 +972,8 @@ bool UMeshDeformationComponent::SaveToProceduralMeshComponent(
 	UMeshDeformationComponent *&MeshDeformationComponent,
 	UProceduralMeshComponent *ProceduralMeshComponent,
 	bool bCreateCollision,
-	TArray <UMaterialInterface *> Materials
+	TArray <UMaterialInterface *> Materials,
+	bool bOnlyUpdateChanges /*= false*/
 	)
 {
 	MeshDeformationComponent = this;
@@ -378,16 +984,36 @@ bool UMeshDeformationComponent::SaveToProceduralMeshComponent(
 		return false;
 	}
 
-	bool bSuccess = MeshGeometry->SaveToProceduralMeshComponent(ProceduralMeshComponent, bCreateCollision);
-	if (!bSuccess) {
-		return bSuccess;
+	if (bEvaluateAsync)
+	{
+		if (!ProceduralMeshComponent)
+		{
+			UE_LOG(MDTLog, Warning, TEXT("SaveToProceduralMeshComponent: No ProceduralMeshComponent provided"));
+			return false;
+		}
+
+		// Each evaluation saves with the most recent arguments.  If one is running the next
+		// starts when it finishes, taking every operation recorded in the meantime.
+		AsyncSaveTarget = ProceduralMeshComponent;
+		AsyncSaveMaterials = Materials;
+		bAsyncSaveCreateCollision = bCreateCollision;
+		bAsyncSaveOnlyUpdateChanges = bOnlyUpdateChanges;
+		if (IsEvaluationRunning())
+		{
+			bEvaluationRequested = true;
+		}
+		else
+		{
+			StartAsyncEvaluation();
+		}
+		return true;
 	}
 
-	for (int MaterialIndex = 0; MaterialIndex < Materials.Num(); ++MaterialIndex) {
-		ProceduralMeshComponent->SetMaterial(MaterialIndex, Materials[MaterialIndex]);
-	}
+	ApplyDeferredOperations();
 
-	return bSuccess;
+	return SaveGeometryToProceduralMeshComponent(
+		MeshGeometry, ProceduralMeshComponent, bCreateCollision, Materials, bOnlyUpdateChanges
+	);
 }
 
 bool UMeshDeformationComponent::SaveToStaticMesh(
@@ -403,6 +1029,8 @@ bool UMeshDeformationComponent::SaveToStaticMesh(
 		UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: No meshGeometry loaded"));
 		return false;
 	}
+
+	ApplyDeferredOperations();
 	return MeshGeometry->SaveToStaticMesh(StaticMesh, ProceduralMeshComponent, Materials);
 }
 
@@ -414,10 +1042,25 @@ void UMeshDeformationComponent::Scale(UMeshDeformationComponent *&MeshDeformatio
 		UE_LOG(MDTLog, Warning, TEXT("Scale: No meshGeometry loaded"));
 		return;
 	}
+	if (bDeferAffineOperations)
+	{
+		DeferAffineOperation(Utility::MatrixAboutCenter(FScaleMatrix(Scale3d), CenterOfScale), Selection);
+		return;
+	}
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->Scale(Scale3d, CenterOfScale, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
 	MeshGeometry->Scale(Scale3d, CenterOfScale, Selection);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectAll() const
+{
+	return SelectAllInto();
+}
+
+USelectionSet * UMeshDeformationComponent::SelectAllInto(USelectionSet *Into /*= nullptr*/) const
 {
 	if (!MeshGeometry)
 	{
@@ -425,10 +1068,31 @@ USelectionSet * UMeshDeformationComponent::SelectAll() const
 		return nullptr;
 	}
 
-	return MeshGeometry->SelectAll();
+	return MeshGeometry->SelectAllInto(Into);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectByNoise(
+	FTransform Transform,
+	int32 Seed /*= 1337*/,
+	float Frequency /*= 0.01*/,
+	ENoiseInterpolation NoiseInterpolation /*= ENoiseInterpolation::Quintic*/,
+	ENoiseType NoiseType /*= ENoiseType::Simplex*/,
+	uint8 FractalOctaves /*= 3*/,
+	float FractalLacunarity /*= 2.0*/,
+	float FractalGain /*= 0.5*/,
+	EFractalType FractalType /*= EFractalType::FBM*/,
+	ECellularDistanceFunction CellularDistanceFunction /*= ECellularDistanceFunction::Euclidian*/
+)
+{
+	return SelectByNoiseInto(
+		Transform,
+		Seed, Frequency, NoiseInterpolation, NoiseType,
+		FractalOctaves, FractalLacunarity, FractalGain, FractalType,
+		CellularDistanceFunction
+	);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectByNoiseInto(
 	FTransform Transform /* AutoCreateRefTerm */,
 	int32 Seed /*= 1337*/,
 	float Frequency /*= 0.01*/,
@@ -438,25 +1102,37 @@ USelectionSet * UMeshDeformationComponent::SelectByNoise(
 	float FractalLacunarity /*= 2.0*/,
 	float FractalGain /*= 0.5*/,
 	EFractalType FractalType /*= EFractalType::FBM*/,
-	ECellularDistanceFunction CellularDistanceFunction /*= ECellularDistanceFunction::Euclidian*/
-) const
+	ECellularDistanceFunction CellularDistanceFunction /*= ECellularDistanceFunction::Euclidian*/,
+	USelectionSet *Into /*= nullptr*/
+)
 {
 	if (!MeshGeometry)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("SelectByNoise: No meshGeometry loaded"));
 		return nullptr;
 	}
-	return MeshGeometry->SelectByNoise(
+
+	ApplyDeferredOperations();
+	return MeshGeometry->SelectByNoiseInto(
 		Transform,
 		Seed, Frequency, NoiseInterpolation, NoiseType,
 		FractalOctaves, FractalLacunarity, FractalGain, FractalType,
-		CellularDistanceFunction
+		CellularDistanceFunction, Into
 	);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectByNormal(
+	FVector Facing /*= FVector::UpVector*/,
+	float InnerRadiusInDegrees /*= 0*/,
+	float OuterRadiusInDegrees /*= 30.0f*/
+)
+{
+	return SelectByNormalInto(Facing, InnerRadiusInDegrees, OuterRadiusInDegrees);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectByNormalInto(
 	FVector Facing /*= FVector::UpVector*/, float InnerRadiusInDegrees /*= 0*/,
-	float OuterRadiusInDegrees /*= 30.0f*/) const
+	float OuterRadiusInDegrees /*= 30.0f*/, USelectionSet *Into /*= nullptr*/)
 {
 	if (!MeshGeometry)
 	{
@@ -464,62 +1140,110 @@ USelectionSet * UMeshDeformationComponent::SelectByNormal(
 		return nullptr;
 	}
 
-	return MeshGeometry->SelectByNormal(Facing, InnerRadiusInDegrees, OuterRadiusInDegrees);
+	ApplyDeferredOperations();
+
+	return MeshGeometry->SelectByNormalInto(Facing, InnerRadiusInDegrees, OuterRadiusInDegrees, Into);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectByVertexRange(
 	int32 RangeStart,
 	int32 RangeEnd,
 	int32 RangeStep /*= 1*/,
-	int32 SectionIndex /*= 0 */)
+	int32 SectionIndex /*= 0*/
+)
+{
+	return SelectByVertexRangeInto(RangeStart, RangeEnd, RangeStep, SectionIndex);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectByVertexRangeInto(
+	int32 RangeStart,
+	int32 RangeEnd,
+	int32 RangeStep /*= 1*/,
+	int32 SectionIndex /*= 0 */,
+	USelectionSet *Into /*= nullptr*/)
 {
 	if (!MeshGeometry)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("SelectByVertexRange: No meshGeometry loaded"));
 		return nullptr;
 	}
-	return MeshGeometry->SelectByVertexRange(RangeStart, RangeEnd, RangeStep, SectionIndex);
+
+	ApplyDeferredOperations();
+	return MeshGeometry->SelectByVertexRangeInto(RangeStart, RangeEnd, RangeStep, SectionIndex, Into);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectBySection(int32 SectionIndex) const
+{
+	return SelectBySectionInto(SectionIndex);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectBySectionInto(int32 SectionIndex, USelectionSet *Into /*= nullptr*/) const
 {
 	if (!MeshGeometry)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("SelectBySection: No meshGeometry loaded"));
 		return nullptr;
 	}
-	return MeshGeometry->SelectBySection(SectionIndex);
+
+	return MeshGeometry->SelectBySectionInto(SectionIndex, Into);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectByTexture(
-	UTexture2D *Texture2D, ETextureChannel TextureChannel /*= ETextureChannel::Red*/
-) const
+	UTexture2D *Texture2D,
+	ETextureChannel TextureChannel /*= ETextureChannel::Red*/
+)
+{
+	return SelectByTextureInto(Texture2D, TextureChannel);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectByTextureInto(
+	UTexture2D *Texture2D, ETextureChannel TextureChannel /*= ETextureChannel::Red*/, USelectionSet *Into /*= nullptr*/
+)
 {
 	if (!MeshGeometry)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("SelectByTexture: No meshGeometry loaded"));
 		return nullptr;
 	}
-	return MeshGeometry->SelectByTexture(Texture2D, TextureChannel);
+
+	ApplyDeferredOperations();
+	return MeshGeometry->SelectByTextureInto(Texture2D, TextureChannel, Into);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectInVolume(FVector CornerA, FVector CornerB)
+{
+	return SelectInVolumeInto(CornerA, CornerB);
 }
 
-USelectionSet * UMeshDeformationComponent::SelectInVolume(
-	FVector CornerA, FVector CornerB
-) const
+USelectionSet * UMeshDeformationComponent::SelectInVolumeInto(
+	FVector CornerA, FVector CornerB, USelectionSet *Into /*= nullptr*/
+)
 {
 	if (!MeshGeometry)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("SelectByVolume: No meshGeometry loaded"));
 		return nullptr;
 	}
-	return MeshGeometry->SelectInVolume(CornerA, CornerB);
+
+	ApplyDeferredOperations();
+	return MeshGeometry->SelectInVolumeInto(CornerA, CornerB, Into);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectNear(
 	FVector Center /*= FVector::ZeroVector*/,
 	float InnerRadius /*= 0*/,
 	float OuterRadius /*= 100*/
-) const
+)
+{
+	return SelectNearInto(Center, InnerRadius, OuterRadius);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectNearInto(
+	FVector Center /*= FVector::ZeroVector*/,
+	float InnerRadius /*= 0*/,
+	float OuterRadius /*= 100*/,
+	USelectionSet *Into /*= nullptr*/
+)
 {
 	if (!MeshGeometry)
 	{
@@ -527,14 +1251,26 @@ USelectionSet * UMeshDeformationComponent::SelectNear(
 		return nullptr;
 	}
 
-	return MeshGeometry->SelectNear(Center, InnerRadius, OuterRadius);
+	ApplyDeferredOperations();
+
+	return MeshGeometry->SelectNearInto(Center, InnerRadius, OuterRadius, Into);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectNearSpline(
-	USplineComponent *Spline, 
+	USplineComponent *Spline,
 	float InnerRadius /*= 0*/,
 	float OuterRadius /*= 100*/
-) const
+)
+{
+	return SelectNearSplineInto(Spline, InnerRadius, OuterRadius);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectNearSplineInto(
+	USplineComponent *Spline, 
+	float InnerRadius /*= 0*/,
+	float OuterRadius /*= 100*/,
+	USelectionSet *Into /*= nullptr*/
+)
 {
 	if (!MeshGeometry)
 	{
@@ -542,19 +1278,33 @@ USelectionSet * UMeshDeformationComponent::SelectNearSpline(
 		return nullptr;
 	}
 
+	ApplyDeferredOperations();
+
 	// Get the actor's local->world transform- we're going to need it for the spline.
 	FTransform ActorTransform = this->GetOwner()->GetTransform();
 
-	return MeshGeometry->SelectNearSpline(Spline, ActorTransform, InnerRadius, OuterRadius);
+	return MeshGeometry->SelectNearSplineInto(Spline, ActorTransform, InnerRadius, OuterRadius, Into);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectNearLine(
+	FVector LineStart,
+	FVector LineEnd,
+	float InnerRadius /*= 0*/,
+	float OuterRadius /*= 100*/,
+	bool bLineIsInfinite /*= false*/
+)
+{
+	return SelectNearLineInto(LineStart, LineEnd, InnerRadius, OuterRadius, bLineIsInfinite);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectNearLineInto(
 	FVector LineStart,
 	FVector LineEnd,
 	float InnerRadius /*=0*/,
 	float OuterRadius/*= 100*/,
-	bool bLineIsInfinite/* = false */
-) const
+	bool bLineIsInfinite/* = false */,
+	USelectionSet *Into /*= nullptr*/
+)
 {
 	if (!MeshGeometry)
 	{
@@ -562,14 +1312,27 @@ USelectionSet * UMeshDeformationComponent::SelectNearLine(
 		return nullptr;
 	}
 
-	return MeshGeometry->SelectNearLine(LineStart, LineEnd, InnerRadius, OuterRadius, bLineIsInfinite);
+	ApplyDeferredOperations();
+
+	return MeshGeometry->SelectNearLineInto(LineStart, LineEnd, InnerRadius, OuterRadius, bLineIsInfinite, Into);
 }
 
 USelectionSet * UMeshDeformationComponent::SelectLinear(
+	FVector LineStart,
+	FVector LineEnd,
+	bool bReverse /*= false*/,
+	bool bLimitToLine /*= false*/
+)
+{
+	return SelectLinearInto(LineStart, LineEnd, bReverse, bLimitToLine);
+}
+
+USelectionSet * UMeshDeformationComponent::SelectLinearInto(
 	FVector LineStart,
 	FVector LineEnd, 
 	bool bReverse /*= false*/,
-	bool bLimitToLine /*= false*/) const
+	bool bLimitToLine /*= false*/,
+	USelectionSet *Into /*= nullptr*/)
 {
 	if (!MeshGeometry)
 	{
@@ -577,7 +1340,9 @@ USelectionSet * UMeshDeformationComponent::SelectLinear(
 		return nullptr;
 	}
 
-	return MeshGeometry->SelectLinear(LineStart, LineEnd, bReverse, bLimitToLine);
+	ApplyDeferredOperations();
+
+	return MeshGeometry->SelectLinearInto(LineStart, LineEnd, bReverse, bLimitToLine, Into);
 }
 
 void UMeshDeformationComponent::Spherize(
@@ -594,6 +1359,12 @@ void UMeshDeformationComponent::Spherize(
 		return;
 	}
 
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->Spherize(SphereRadius, FilterStrength, SphereCenter, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
+
 	MeshGeometry->Spherize(SphereRadius, FilterStrength, SphereCenter, Selection);
 }
 
@@ -609,6 +1380,16 @@ void UMeshDeformationComponent::Transform(
 		UE_LOG(MDTLog, Warning, TEXT("Transform: No meshGeometry loaded"));
 		return;
 	}
+	if (bDeferAffineOperations)
+	{
+		DeferAffineOperation(Utility::MatrixAboutCenter(Transform.ToMatrixWithScale(), CenterOfTransform), Selection);
+		return;
+	}
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->Transform(Transform, CenterOfTransform, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
 
 	MeshGeometry->Transform(Transform, CenterOfTransform, Selection);
 }
@@ -622,6 +1403,12 @@ void UMeshDeformationComponent::TransformUV(UMeshDeformationComponent *&MeshDefo
 		return;
 	}
 
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->TransformUV(Transform, CenterOfTransform, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
+
 	MeshGeometry->TransformUV(Transform, CenterOfTransform, Selection);
 }
 
@@ -636,6 +1423,16 @@ void UMeshDeformationComponent::Translate(
 		UE_LOG(MDTLog, Warning, TEXT("Translate: No meshGeometry loaded"));
 		return;
 	}
+	if (bDeferAffineOperations)
+	{
+		DeferAffineOperation(FTranslationMatrix(Delta), Selection);
+		return;
+	}
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->Translate(Delta, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
 
 	MeshGeometry->Translate(Delta, Selection);
 }
@@ -654,5 +1451,11 @@ void UMeshDeformationComponent::ScaleAlongAxis(
 		return;
 	}
 
+	if (RecordOperation(Selection, [=](UMeshGeometry *Geometry, USelectionSet *RecordedSelection) { Geometry->ScaleAlongAxis(CenterOfScale, Axis, Scale, RecordedSelection); }))
+	{
+		return;
+	}
+	ApplyDeferredOperations();
+
 	MeshGeometry->ScaleAlongAxis(CenterOfScale, Axis, Scale, Selection);
 }
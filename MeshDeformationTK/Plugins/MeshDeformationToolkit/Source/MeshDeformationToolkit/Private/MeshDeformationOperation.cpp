@@ -0,0 +1,205 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "MeshGeometry.h"
+#include "SelectionSet.h"
+#include "UObject/UnrealType.h"
+
+#include "MeshDeformationOperation.h"
+
+void UMeshDeformationOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	// The default operation leaves the mesh as it is.
+}
+
+uint32 UMeshDeformationOperation::GetInputHash() const
+{
+	uint32 Hash = GetTypeHash(GetClass());
+	FString ValueText;
+
+	for (TFieldIterator<UProperty> PropertyIt(GetClass()); PropertyIt; ++PropertyIt)
+	{
+		const UProperty *Property = *PropertyIt;
+
+		// Only the properties which can be set are inputs, anything else is internal state
+		// such as a selection's output.
+		const bool bIsInput = Property->HasAnyPropertyFlags(CPF_Edit)||
+			(Property->HasAnyPropertyFlags(CPF_BlueprintVisible) && !Property->HasAnyPropertyFlags(CPF_BlueprintReadOnly));
+		if (!bIsInput)
+		{
+			continue;
+		}
+
+		for (int32 ArrayIndex = 0; ArrayIndex<Property->ArrayDim; ++ArrayIndex)
+		{
+			const void *Value = Property->ContainerPtrToValuePtr<void>(this, ArrayIndex);
+
+			// Numbers, names, and the like hash their values directly, only the properties
+			// without a hash, such as most structs, are hashed by their text.
+			const UObjectPropertyBase *ObjectProperty = Cast<UObjectPropertyBase>(Property);
+			if (!ObjectProperty)
+			{
+				if (Property->HasAnyPropertyFlags(CPF_HasGetValueTypeHash))
+				{
+					Hash = HashCombine(Hash, Property->GetValueTypeHash(Value));
+					continue;
+				}
+				ValueText.Reset();
+				Property->ExportTextItem(ValueText, Value, nullptr, nullptr, PPF_None);
+				Hash = FCrc::StrCrc32(*ValueText, Hash);
+				continue;
+			}
+
+			const UObject *Object = ObjectProperty->GetObjectPropertyValue(Value);
+			Hash = HashCombine(Hash, GetTypeHash(Object));
+			if (const USelectionSet *SelectionSet = Cast<USelectionSet>(Object))
+			{
+				// This is kept by the SelectionSet until its weights change.
+				Hash = HashCombine(Hash, SelectionSet->GetContentHash());
+			}
+			else if (const UMeshGeometry *MeshGeometry = Cast<UMeshGeometry>(Object))
+			{
+				Hash = HashCombine(Hash, MeshGeometry->GetGeneration());
+			}
+		}
+	}
+
+	return Hash;
+}
+
+bool UMeshDeformationOperation::CanMemoize() const
+{
+	// Blueprint graphs can read anything, not just their properties.
+	return !GetClass()->HasAnyClassFlags(CLASS_CompiledFromBlueprint);
+}
+
+void UMeshTranslateOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->Translate(Delta, Selection);
+}
+
+void UMeshRotateOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->Rotate(Rotation, CenterOfRotation, Selection);
+}
+
+void UMeshScaleOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->Scale(Scale3d, CenterOfScale, Selection);
+}
+
+void UMeshTransformOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->Transform(Transform, CenterOfTransform, Selection);
+}
+
+void UMeshRotateAroundAxisOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->RotateAroundAxis(CenterOfRotation, Axis, AngleInDegrees, Selection);
+}
+
+void UMeshScaleAlongAxisOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->ScaleAlongAxis(CenterOfScale, Axis, Scale, Selection);
+}
+
+void UMeshSpherizeOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->Spherize(SphereRadius, FilterStrength, SphereCenter, Selection);
+}
+
+void UMeshInflateOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->Inflate(Offset, Selection);
+}
+
+void UMeshLerpOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	if (!TargetMeshGeometry)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("LerpOperation: No TargetMeshGeometry"));
+		return;
+	}
+
+	MeshGeometry->Lerp(TargetMeshGeometry, Alpha, Selection);
+}
+
+void UMeshLerpVectorOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->LerpVector(Position, Alpha, Selection);
+}
+
+void UMeshMoveTowardsOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	MeshGeometry->MoveTowards(Position, Distance, bLimitAtPosition, Selection);
+}
+
+USelectionSet * UMeshSelectOperation::GetOutput()
+{
+	if (!Output)
+	{
+		Output = NewObject<USelectionSet>(this);
+	}
+	return Output;
+}
+
+void UMeshSelectOperation::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	// The result is written into the same SelectionSet each time so the operations using it
+	// don't need updating, and its weights are reused.
+	USelectionSet *Target = GetOutput();
+	if (!Select(MeshGeometry, Target))
+	{
+		Target->Empty();
+		return;
+	}
+
+	if (Selection)
+	{
+		if (Selection->Size()!=Target->Size())
+		{
+			UE_LOG(MDTLog, Warning, TEXT("SelectOperation: Selection is a different size from the geometry"));
+			return;
+		}
+		// Read the selection a block at a time, so a sparse selection or mask stays as it is.
+		TArray<float> &TargetWeights = Target->GetMutableWeights();
+		float SelectionWeights[USelectionSet::WeightBlockSize];
+		for (int32 Start = 0; Start<TargetWeights.Num(); Start += USelectionSet::WeightBlockSize)
+		{
+			const int32 Count = FMath::Min<int32>(USelectionSet::WeightBlockSize, TargetWeights.Num()-Start);
+			Selection->CopyWeights(Start, Count, SelectionWeights);
+			for (int32 BlockIndex = 0; BlockIndex<Count; ++BlockIndex)
+			{
+				TargetWeights[Start+BlockIndex] *= SelectionWeights[BlockIndex];
+			}
+		}
+	}
+}
+
+USelectionSet * UMeshSelectNearOperation::Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const
+{
+	return MeshGeometry->SelectNearInto(Center, InnerRadius, OuterRadius, Into);
+}
+
+USelectionSet * UMeshSelectLinearOperation::Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const
+{
+	return MeshGeometry->SelectLinearInto(LineStart, LineEnd, bReverse, bLimitToLine, Into);
+}
+
+USelectionSet * UMeshSelectByNormalOperation::Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const
+{
+	return MeshGeometry->SelectByNormalInto(Facing, InnerRadiusInDegrees, OuterRadiusInDegrees, Into);
+}
+
+USelectionSet * UMeshSelectInVolumeOperation::Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const
+{
+	return MeshGeometry->SelectInVolumeInto(CornerA, CornerB, Into);
+}
+
+USelectionSet * UMeshSelectByNoiseOperation::Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const
+{
+	return MeshGeometry->SelectByNoiseInto(
+		Transform, Seed, Frequency, NoiseInterpolation, NoiseType, FractalOctaves,
+		FractalLacunarity, FractalGain, FractalType, CellularDistanceFunction, Into
+	);
+}
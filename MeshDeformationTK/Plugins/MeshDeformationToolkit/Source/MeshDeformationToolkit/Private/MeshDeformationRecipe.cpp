@@ -0,0 +1,16 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+
+#include "MeshDeformationRecipe.h"
+
+void UMeshDeformationRecipe::Apply_Implementation(UMeshGeometry *MeshGeometry)
+{
+	// The default recipe leaves the mesh as it is.
+}
+
+bool UMeshDeformationRecipe::CanApplyConcurrently() const
+{
+	// Blueprint graphs can only be run on the game thread.
+	return !GetClass()->HasAnyClassFlags(CLASS_CompiledFromBlueprint);
+}
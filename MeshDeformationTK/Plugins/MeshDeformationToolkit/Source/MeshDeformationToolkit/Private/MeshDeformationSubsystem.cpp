@@ -0,0 +1,132 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "MeshDeformationComponent.h"
+
+#include "MeshDeformationSubsystem.h"
+
+static TAutoConsoleVariable<float> CVarTimeSliceBudgetMs(
+	TEXT("mdt.TimeSliceBudgetMs"),
+	2.0f,
+	TEXT("The time in milliseconds to spend each frame on MeshDeformationComponents with bTimeSliceEvaluation set.\n")
+	TEXT("0 or less finishes every queued evaluation each frame."),
+	ECVF_Default
+);
+
+DECLARE_CYCLE_STAT(TEXT("MeshDeformationSubsystem Tick"), STAT_MDT_SubsystemTick, STATGROUP_MeshDeformationToolkit);
+
+/// The fewest vertices a step deforms, so there's always some progress and each measurement
+/// of the time per vertex isn't swamped by the cost of the step itself
+static const int32 MinStepVertexCount = 1024;
+
+void UMeshDeformationSubsystem::Initialize(FSubsystemCollectionBase &Collection)
+{
+	Super::Initialize(Collection);
+
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &UMeshDeformationSubsystem::Tick)
+	);
+}
+
+void UMeshDeformationSubsystem::Deinitialize()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	Queue.Empty();
+
+	Super::Deinitialize();
+}
+
+void UMeshDeformationSubsystem::QueueEvaluation(UMeshDeformationComponent *MeshDeformationComponent)
+{
+	if (MeshDeformationComponent)
+	{
+		Queue.AddUnique(MeshDeformationComponent);
+	}
+}
+
+int32 UMeshDeformationSubsystem::GetNumQueuedComponents() const
+{
+	return Queue.Num();
+}
+
+void UMeshDeformationSubsystem::Flush()
+{
+	while (RunNextStep(MAX_int32))
+	{
+	}
+}
+
+bool UMeshDeformationSubsystem::Tick(float DeltaTime)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SubsystemTick);
+
+	const double Budget = CVarTimeSliceBudgetMs.GetValueOnGameThread()/1000.0;
+	if (Budget<=0.0)
+	{
+		Flush();
+		return true;
+	}
+
+	const double Deadline = FPlatformTime::Seconds()+Budget;
+	bool bRanAnyStep = false;
+	while (Queue.Num()>0)
+	{
+		const double RemainingTime = Deadline-FPlatformTime::Seconds();
+		if (bRanAnyStep && RemainingTime<=0.0)
+		{
+			break;
+		}
+
+		// Deform as many vertices as are expected to fit in the time left.
+		int32 MaxVertexCount = MinStepVertexCount;
+		if (SecondsPerVertex>0.0)
+		{
+			const double FittingVertexCount = RemainingTime/SecondsPerVertex;
+			MaxVertexCount = FittingVertexCount<MAX_int32 ? FMath::Max((int32)FittingVertexCount, MinStepVertexCount) : MAX_int32;
+		}
+
+		RunNextStep(MaxVertexCount);
+		bRanAnyStep = true;
+	}
+
+	return true;
+}
+
+bool UMeshDeformationSubsystem::RunNextStep(int32 MaxVertexCount)
+{
+	// Drop any components which have been destroyed.
+	while (Queue.Num()>0 && !Queue[0].IsValid())
+	{
+		Queue.RemoveAt(0);
+	}
+	if (Queue.Num()==0)
+	{
+		return false;
+	}
+
+	UMeshDeformationComponent *Component = Queue[0].Get();
+
+	int32 VertexCount = 0;
+	const double StartTime = FPlatformTime::Seconds();
+	const bool bFinished = Component->StepTimeSlicedEvaluation(MaxVertexCount, VertexCount);
+	const double StepTime = FPlatformTime::Seconds()-StartTime;
+
+	// Blend each measurement in so one unusually cheap or expensive operation doesn't throw the
+	// estimate off.
+	if (VertexCount>0)
+	{
+		const double MeasuredSecondsPerVertex = StepTime/VertexCount;
+		SecondsPerVertex = SecondsPerVertex>0.0 ?
+			FMath::Lerp(SecondsPerVertex, MeasuredSecondsPerVertex, 0.25) :
+			MeasuredSecondsPerVertex;
+	}
+
+	if (bFinished)
+	{
+		Queue.RemoveAt(0);
+	}
+	return true;
+}
@@ -1,12 +1,17 @@
 // Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
 
 #include "MeshDeformationToolkit.h"
+#include "StaticMeshBuildQueue.h"
 
 #define LOCTEXT_NAMESPACE "FMeshDeformationToolkitModule"
 
 // The logger for all messages
 DEFINE_LOG_CATEGORY(MDTLog);
 
+DEFINE_STAT(STAT_MDTVerticesProcessed);
+DEFINE_STAT(STAT_MDTSelectionSetsAllocated);
+DEFINE_STAT(STAT_MDTBytesCopied);
+
 void FMeshDeformationToolkitModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
@@ -16,6 +21,7 @@ void FMeshDeformationToolkitModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FStaticMeshBuildQueue::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
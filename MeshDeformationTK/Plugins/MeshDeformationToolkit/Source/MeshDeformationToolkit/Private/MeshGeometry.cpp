@@ -7,16 +7,479 @@
 #include "SelectionSet.h"
 #include "FastNoise.h"
 #include "Utility.h"
+#include "DeformationCore.h"
+#include "VertexKernels.h"
 #include "Developer/RawMesh/Public/RawMesh.h" // The structure for building static meshes
-#include "Runtime/AssetRegistry/Public/AssetRegistryModule.h" // Allows registering new static meshes
+#include "Async/ParallelFor.h"
+#include "Algo/BinarySearch.h"
+#include "HAL/IConsoleManager.h"
 
 #include "MeshGeometry.h"
 #include "Engine.h" // GEngine
 
+static TAutoConsoleVariable<int32> CVarParallelChunkSize(
+	TEXT("mdt.ParallelChunkSize"),
+	16384,
+	TEXT("The number of vertices in each chunk of work when MeshGeometry deformers run in parallel.\n")
+	TEXT("Meshes with no more vertices than this are deformed on the calling thread, 0 or less disables parallel deformation."),
+	ECVF_Default
+);
+
+DECLARE_CYCLE_STAT(TEXT("ApplyMatrix"), STAT_MDT_ApplyMatrix, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("BuildRawMesh"), STAT_MDT_BuildRawMesh, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Clone"), STAT_MDT_Clone, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("CopyGeometryFrom"), STAT_MDT_CopyGeometryFrom, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("FitToSpline"), STAT_MDT_FitToSpline, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("FlipTextureUV"), STAT_MDT_FlipTextureUV, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("GetBoundingBox"), STAT_MDT_GetBoundingBox, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("GetRadius"), STAT_MDT_GetRadius, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Inflate"), STAT_MDT_Inflate, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Jitter"), STAT_MDT_Jitter, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Lerp"), STAT_MDT_Lerp, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("LerpVector"), STAT_MDT_LerpVector, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("LoadFromMeshGeometry"), STAT_MDT_LoadFromMeshGeometry, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("LoadFromStaticMesh"), STAT_MDT_LoadFromStaticMesh, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("MoveTowards"), STAT_MDT_MoveTowards, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Project"), STAT_MDT_Project, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("ProjectDown"), STAT_MDT_ProjectDown, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("ProjectVertexRange"), STAT_MDT_ProjectVertexRange, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("QueueSaveToStaticMesh"), STAT_MDT_QueueSaveToStaticMesh, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("RebuildNormals"), STAT_MDT_RebuildNormals, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("ResetToGeometry"), STAT_MDT_ResetToGeometry, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Rotate"), STAT_MDT_Rotate, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("RotateAroundAxis"), STAT_MDT_RotateAroundAxis, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SaveToProceduralMeshComponent"), STAT_MDT_SaveToProceduralMeshComponent, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Scale"), STAT_MDT_Scale, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("ScaleAlongAxis"), STAT_MDT_ScaleAlongAxis, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectAll"), STAT_MDT_SelectAll, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectByNoise"), STAT_MDT_SelectByNoise, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectByNormal"), STAT_MDT_SelectByNormal, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectBySection"), STAT_MDT_SelectBySection, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectByTexture"), STAT_MDT_SelectByTexture, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectByVertexRange"), STAT_MDT_SelectByVertexRange, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectInVolume"), STAT_MDT_SelectInVolume, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectLinear"), STAT_MDT_SelectLinear, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectNear"), STAT_MDT_SelectNear, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectNearLine"), STAT_MDT_SelectNearLine, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectNearSpline"), STAT_MDT_SelectNearSpline, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("SelectNearSplineRange"), STAT_MDT_SelectNearSplineRange, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Spherize"), STAT_MDT_Spherize, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Transform"), STAT_MDT_Transform, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("TransformUV"), STAT_MDT_TransformUV, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("Translate"), STAT_MDT_Translate, STATGROUP_MeshDeformationToolkit);
+
+namespace
+{
+	/// A contiguous run of vertices within a single section, the unit of work for ForEachVertexChunk
+	struct FVertexChunk
+	{
+		int32 SectionIndex;
+		int32 StartVertex;
+		int32 EndVertex;
+		int32 FirstWeightIndex;
+	};
+
+	/// A contiguous run of triangles within a single section, the unit of work for BuildRawMesh
+	struct FTriangleChunk
+	{
+		int32 SectionIndex;
+		int32 StartTriangle;
+		int32 EndTriangle;
+		int32 FirstFace;
+		int32 VertexBase;
+	};
+
+	/// The size of a section's per-vertex data which is never shared, for the bytes copied stat
+	uint32 GetUnsharedDataSize(const FSectionGeometry &Section)
+	{
+		return Section.Vertices.Num()*sizeof(FVector)+Section.Normals.Num()*sizeof(FVector);
+	}
+
+	/// The size of all of a section's data, for the bytes copied stat
+	uint32 GetDataSize(const FSectionGeometry &Section)
+	{
+		return GetUnsharedDataSize(Section)+
+			Section.GetTriangles().Num()*sizeof(int32)+
+			Section.GetUVs().Num()*sizeof(FVector2D)+
+			Section.GetTangents().Num()*sizeof(FProcMeshTangent)+
+			Section.GetVertexColors().Num()*sizeof(FLinearColor);
+	}
+
+	static_assert(sizeof(FVector)==sizeof(DeformationCore::Float3), "DeformationCore::Float3 must match FVector's layout");
+
+	/// View a run of vertices or normals as DeformationCore positions, which share FVector's layout
+	DeformationCore::Float3 *ToCore(FVector *Vectors)
+	{
+		return reinterpret_cast<DeformationCore::Float3 *>(Vectors);
+	}
+
+	const DeformationCore::Float3 *ToCore(const FVector *Vectors)
+	{
+		return reinterpret_cast<const DeformationCore::Float3 *>(Vectors);
+	}
+
+	DeformationCore::Float3 ToCore(const FVector &Vector)
+	{
+		return {Vector.X, Vector.Y, Vector.Z};
+	}
+
+	/// Return the index of the first bit from Index up to End in a mask which is set, or clear
+	/// if bSet is false, or End if there isn't one.  Whole words are skipped at a time.
+	int32 FindMaskBit(const uint32 *MaskWords, int32 Index, int32 End, bool bSet)
+	{
+		while (Index<End)
+		{
+			const int32 WordStart = Index&~31;
+			const uint32 Word = (bSet ? MaskWords[Index/32] : ~MaskWords[Index/32])&(~0u<<(Index-WordStart));
+			if (Word)
+			{
+				return FMath::Min(End, WordStart+(int32)FMath::CountTrailingZeros(Word));
+			}
+			Index = WordStart+32;
+		}
+		return End;
+	}
+
+	/// The number given to the last save to each ProceduralMeshComponent, so a geometry can tell
+	/// whether anything else has saved to a component since it did.  Only used on the game thread.
+	TMap<TWeakObjectPtr<UProceduralMeshComponent>, uint32> ComponentSaveNumbers;
+	uint32 NextSaveNumber = 1;
+
+	/// Whether any of a run of weights are non-zero, ie whether a deformer can change those vertices
+	bool HasAnyWeight(const float *Weights, int32 Count)
+	{
+		for (int32 Index = 0; Index<Count; ++Index)
+		{
+			if (Weights[Index]!=0.0f)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Whether any of a run of a SelectionSet's weights are non-zero, without converting a sparse
+	/// SelectionSet or a mask to full weights.  No SelectionSet counts as every weight being 1.0.
+	bool HasAnyWeight(USelectionSet *Selection, int32 FirstWeightIndex, int32 Count)
+	{
+		if (!Selection)
+		{
+			return Count>0;
+		}
+
+		Selection->EvaluateExpression();
+		const int32 EndWeightIndex = FirstWeightIndex+Count;
+		if (Selection->IsMask())
+		{
+			return FindMaskBit(Selection->GetMaskWords().GetData(), FirstWeightIndex, EndWeightIndex, true)<EndWeightIndex;
+		}
+		if (Selection->IsSparse())
+		{
+			const TArray<int32> &SparseIndices = Selection->GetSparseIndices();
+			const int32 EntryIndex = Algo::LowerBound(SparseIndices, FirstWeightIndex);
+			return EntryIndex<SparseIndices.Num() && SparseIndices[EntryIndex]<EndWeightIndex;
+		}
+		return HasAnyWeight(Selection->GetWeights().GetData()+FirstWeightIndex, Count);
+	}
+}
+
 UMeshGeometry::UMeshGeometry()
 {
 	// Create empty data sets.
 	Sections = TArray<FSectionGeometry>();
+	RefreshCachedCounts();
+}
+
+void UMeshGeometry::PostLoad()
+{
+	Super::PostLoad();
+	RefreshCachedCounts();
+}
+
+void UMeshGeometry::Serialize(FArchive &Ar)
+{
+	if (Ar.IsSaving())
+	{
+		for (FSectionGeometry &Section:this->Sections)
+		{
+			Section.UnshareAttributes();
+		}
+	}
+	Super::Serialize(Ar);
+}
+
+TArray<FSectionGeometry> UMeshGeometry::GetSections() const
+{
+	TArray<FSectionGeometry> UnsharedSections = this->Sections;
+	for (FSectionGeometry &Section:UnsharedSections)
+	{
+		Section.UnshareAttributes();
+		INC_DWORD_STAT_BY(STAT_MDTBytesCopied, GetDataSize(Section));
+	}
+	return UnsharedSections;
+}
+
+template <typename ChunkFunctionType>
+void UMeshGeometry::ForEachVertexChunk(ESectionChanges Changes, ChunkFunctionType ChunkFunction, bool bSplittable)
+{
+	const int32 ChunkSize = CVarParallelChunkSize.GetValueOnAnyThread();
+
+	// Split the part of each section within the vertex range into chunks of at most ChunkSize
+	// vertices, recording where each chunk's weights start so the chunks can be run in any order.
+	TArray<FVertexChunk, TInlineAllocator<16>> Chunks;
+	int32 NextWeightIndex = 0;
+	int32 VisitedVertexCount = 0;
+	for (int32 SectionIndex = 0; SectionIndex<Sections.Num(); ++SectionIndex)
+	{
+		const int32 SectionVertexCount = Sections[SectionIndex].Vertices.Num();
+		const int32 FirstVertex = FMath::Clamp(VertexRangeStart-NextWeightIndex, 0, SectionVertexCount);
+		const int32 LastVertex = FMath::Clamp(VertexRangeEnd-NextWeightIndex, 0, SectionVertexCount);
+		const int32 Step = ChunkSize>0 ? ChunkSize : FMath::Max(SectionVertexCount, 1);
+		for (int32 StartVertex = FirstVertex; StartVertex<LastVertex; StartVertex += Step)
+		{
+			const int32 EndVertex = FMath::Min(StartVertex+Step, LastVertex);
+			Chunks.Add({SectionIndex, StartVertex, EndVertex, NextWeightIndex+StartVertex});
+		}
+		VisitedVertexCount += FMath::Max(LastVertex-FirstVertex, 0);
+		NextWeightIndex += SectionVertexCount;
+	}
+	bVertexRangeUsed = true;
+
+	// Small meshes aren't worth the cost of waking the task threads.
+	const bool bRunSingleThreaded = !bSplittable||ChunkSize<=0||VisitedVertexCount<=ChunkSize;
+
+	// Each chunk only writes its own entry, the sections are marked afterwards as several chunks
+	// can share a section.
+	TArray<bool, TInlineAllocator<16>> ChunkChanged;
+	ChunkChanged.SetNumZeroed(Chunks.Num());
+
+	ParallelFor(Chunks.Num(), [&](int32 ChunkIndex)
+	{
+		const FVertexChunk &Chunk = Chunks[ChunkIndex];
+		ChunkChanged[ChunkIndex] =
+			ChunkFunction(Sections[Chunk.SectionIndex], Chunk.StartVertex, Chunk.EndVertex, Chunk.FirstWeightIndex);
+	}, bRunSingleThreaded);
+
+	bool bAnyChanged = false;
+	for (int32 ChunkIndex = 0; ChunkIndex<Chunks.Num(); ++ChunkIndex)
+	{
+		if (ChunkChanged[ChunkIndex])
+		{
+			SectionChanges[Chunks[ChunkIndex].SectionIndex] |= Changes;
+			bAnyChanged = true;
+		}
+	}
+
+	if (bAnyChanged)
+	{
+		// The sections are already marked, this just bumps the generation.
+		MarkGeometryChanged(ESectionChanges::None);
+	}
+}
+
+template <typename VertexFunctionType>
+void UMeshGeometry::ForEachVertex(
+	USelectionSet *Selection, ESectionChanges Changes, VertexFunctionType VertexFunction, bool bSplittable)
+{
+	if (Selection)
+	{
+		// Evaluate a lazy selection here, as the chunks can run on other threads.
+		Selection->EvaluateExpression();
+	}
+
+	if (Selection && Selection->IsMask())
+	{
+		const uint32 *MaskWords = Selection->GetMaskWords().GetData();
+
+		// Only the vertices with their bits set are visited, all with a weight of 1.0.
+		ForEachVertexChunk(Changes, [&](FSectionGeometry &Section, int32 StartVertex, int32 EndVertex, int32 FirstWeightIndex)
+		{
+			const int32 EndWeightIndex = FirstWeightIndex+EndVertex-StartVertex;
+			int32 WeightIndex = FindMaskBit(MaskWords, FirstWeightIndex, EndWeightIndex, true);
+			if (WeightIndex>=EndWeightIndex)
+			{
+				return false;
+			}
+
+			for (; WeightIndex<EndWeightIndex; WeightIndex = FindMaskBit(MaskWords, WeightIndex+1, EndWeightIndex, true))
+			{
+				VertexFunction(Section, StartVertex+WeightIndex-FirstWeightIndex, 1.0f);
+			}
+			return true;
+		}, bSplittable);
+		return;
+	}
+
+	if (Selection && Selection->IsSparse())
+	{
+		const TArray<int32> &SparseIndices = Selection->GetSparseIndices();
+		const TArray<float> &SparseWeights = Selection->GetSparseWeights();
+
+		// Only the vertices with non-zero weights are visited.
+		ForEachVertexChunk(Changes, [&](FSectionGeometry &Section, int32 StartVertex, int32 EndVertex, int32 FirstWeightIndex)
+		{
+			const int32 EndWeightIndex = FirstWeightIndex+EndVertex-StartVertex;
+			int32 EntryIndex = Algo::LowerBound(SparseIndices, FirstWeightIndex);
+			if (EntryIndex>=SparseIndices.Num() || SparseIndices[EntryIndex]>=EndWeightIndex)
+			{
+				return false;
+			}
+
+			for (; EntryIndex<SparseIndices.Num() && SparseIndices[EntryIndex]<EndWeightIndex; ++EntryIndex)
+			{
+				VertexFunction(Section, StartVertex+SparseIndices[EntryIndex]-FirstWeightIndex, SparseWeights[EntryIndex]);
+			}
+			return true;
+		}, bSplittable);
+		return;
+	}
+
+	const float *Weights = Selection ? Selection->GetWeights().GetData() : nullptr;
+
+	ForEachVertexChunk(Changes, [&](FSectionGeometry &Section, int32 StartVertex, int32 EndVertex, int32 FirstWeightIndex)
+	{
+		// A zero weight leaves a vertex where it is, so skip chunks outside the selection.
+		if (Weights && !HasAnyWeight(Weights+FirstWeightIndex, EndVertex-StartVertex))
+		{
+			return false;
+		}
+
+		for (int32 VertexIndex = StartVertex; VertexIndex<EndVertex; ++VertexIndex)
+		{
+			const float Weight = Weights ? Weights[FirstWeightIndex+VertexIndex-StartVertex] : 1.0f;
+			VertexFunction(Section, VertexIndex, Weight);
+		}
+		return true;
+	}, bSplittable);
+}
+
+template <typename RunFunctionType>
+void UMeshGeometry::ForEachVertexRun(USelectionSet *Selection, ESectionChanges Changes, RunFunctionType RunFunction)
+{
+	if (Selection)
+	{
+		// Evaluate a lazy selection here, as the chunks can run on other threads.
+		Selection->EvaluateExpression();
+	}
+
+	if (Selection && Selection->IsMask())
+	{
+		const uint32 *MaskWords = Selection->GetMaskWords().GetData();
+
+		// Each run of set bits is passed on with no weights, ie a weight of 1.0 for each vertex.
+		ForEachVertexChunk(Changes, [&](FSectionGeometry &Section, int32 StartVertex, int32 EndVertex, int32 FirstWeightIndex)
+		{
+			const int32 EndWeightIndex = FirstWeightIndex+EndVertex-StartVertex;
+			int32 RunStart = FindMaskBit(MaskWords, FirstWeightIndex, EndWeightIndex, true);
+			if (RunStart>=EndWeightIndex)
+			{
+				return false;
+			}
+
+			while (RunStart<EndWeightIndex)
+			{
+				const int32 RunEnd = FindMaskBit(MaskWords, RunStart, EndWeightIndex, false);
+				RunFunction(Section, StartVertex+RunStart-FirstWeightIndex, RunEnd-RunStart, nullptr);
+				RunStart = FindMaskBit(MaskWords, RunEnd, EndWeightIndex, true);
+			}
+			return true;
+		});
+		return;
+	}
+
+	if (Selection && Selection->IsSparse())
+	{
+		const TArray<int32> &SparseIndices = Selection->GetSparseIndices();
+		const TArray<float> &SparseWeights = Selection->GetSparseWeights();
+
+		// Consecutive indices have their weights next to each other too, so each run of them is
+		// passed on as one run of vertices.
+		ForEachVertexChunk(Changes, [&](FSectionGeometry &Section, int32 StartVertex, int32 EndVertex, int32 FirstWeightIndex)
+		{
+			const int32 EndWeightIndex = FirstWeightIndex+EndVertex-StartVertex;
+			int32 EntryIndex = Algo::LowerBound(SparseIndices, FirstWeightIndex);
+			if (EntryIndex>=SparseIndices.Num() || SparseIndices[EntryIndex]>=EndWeightIndex)
+			{
+				return false;
+			}
+
+			while (EntryIndex<SparseIndices.Num() && SparseIndices[EntryIndex]<EndWeightIndex)
+			{
+				int32 RunEnd = EntryIndex+1;
+				while (RunEnd<SparseIndices.Num() && SparseIndices[RunEnd]==SparseIndices[RunEnd-1]+1 &&
+					SparseIndices[RunEnd]<EndWeightIndex)
+				{
+					++RunEnd;
+				}
+
+				RunFunction(
+					Section, StartVertex+SparseIndices[EntryIndex]-FirstWeightIndex, RunEnd-EntryIndex,
+					SparseWeights.GetData()+EntryIndex
+				);
+				EntryIndex = RunEnd;
+			}
+			return true;
+		});
+		return;
+	}
+
+	const float *Weights = Selection ? Selection->GetWeights().GetData() : nullptr;
+
+	ForEachVertexChunk(Changes, [&](FSectionGeometry &Section, int32 StartVertex, int32 EndVertex, int32 FirstWeightIndex)
+	{
+		const int32 Count = EndVertex-StartVertex;
+		if (Weights && !HasAnyWeight(Weights+FirstWeightIndex, Count))
+		{
+			return false;
+		}
+
+		RunFunction(Section, StartVertex, Count, Weights ? Weights+FirstWeightIndex : nullptr);
+		return true;
+	});
+}
+
+template <typename RunFunctionType>
+USelectionSet *UMeshGeometry::SelectByRuns(
+	USelectionSet *Into, FString NodeNameForWarning, bool bBinary, RunFunctionType RunFunction)
+{
+	USelectionSet *NewSelectionSet = USelectionSet::CreateAndCheckValid(GetTotalVertexCount(), this, NodeNameForWarning, Into);
+	if (!NewSelectionSet)
+	{
+		return nullptr;
+	}
+
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// The blocks are filled in order, so each one starts in the section the last one ended in
+	// or a later one.
+	int32 SectionIndex = 0;
+	auto FillBlock = [&](int32 Start, int32 Count, float *Weights)
+	{
+		const int32 End = Start+Count;
+		while (Start<End)
+		{
+			while (SectionVertexOffsets[SectionIndex+1]<=Start)
+			{
+				++SectionIndex;
+			}
+
+			const int32 SectionStart = SectionVertexOffsets[SectionIndex];
+			const int32 RunCount = FMath::Min(End, SectionVertexOffsets[SectionIndex+1])-Start;
+			RunFunction(SectionIndex, Start-SectionStart, RunCount, Weights);
+			Start += RunCount;
+			Weights += RunCount;
+		}
+	};
+
+	if (bBinary)
+	{
+		NewSelectionSet->SetMaskByBlock(GetTotalVertexCount(), FillBlock);
+	}
+	else
+	{
+		NewSelectionSet->SetWeightsByBlock(GetTotalVertexCount(), FillBlock);
+	}
+	return NewSelectionSet;
 }
 
 void UMeshGeometry::Project(
@@ -29,10 +492,57 @@ void UMeshGeometry::Project(
 	ECollisionChannel CollisionChannel /*= ECC_WorldStatic*/,
 	USelectionSet *Selection /*= nullptr */
 ) {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Project);
+
+	FMeshProjection PreparedProjection;
+	if (!PrepareProject(
+		PreparedProjection, WorldContextObject, Transform, IgnoredActors, Projection, HeightAdjust,
+		bTraceComplex, CollisionChannel, Selection))
+	{
+		return;
+	}
+
+	ProjectVertexRange(PreparedProjection, Selection, 0, GetTotalVertexCount());
+}
+
+void UMeshGeometry::ProjectDown(
+	UObject* WorldContextObject, 
+	FTransform Transform,
+	TArray <AActor *> IgnoredActors /*= nullptr*/,
+	float ProjectionLength /*= 100*/,
+	float HeightAdjust /*= 0*/,
+	bool bTraceComplex /*= true*/,
+	ECollisionChannel CollisionChannel /*= ECC_WorldStatic*/,
+	USelectionSet *Selection /*= nullptr */)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_ProjectDown);
+
+	FMeshProjection PreparedProjection;
+	if (!PrepareProjectDown(
+		PreparedProjection, WorldContextObject, Transform, IgnoredActors, ProjectionLength, HeightAdjust,
+		bTraceComplex, CollisionChannel, Selection))
+	{
+		return;
+	}
+
+	ProjectVertexRange(PreparedProjection, Selection, 0, GetTotalVertexCount());
+}
+
+bool UMeshGeometry::PrepareProject(
+	FMeshProjection &OutProjection,
+	UObject *WorldContextObject,
+	FTransform Transform,
+	const TArray<AActor *> &IgnoredActors,
+	FVector Projection,
+	float HeightAdjust,
+	bool bTraceComplex,
+	ECollisionChannel CollisionChannel,
+	USelectionSet *Selection) const
+{
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Project")))
 	{
-		return;
+		return false;
 	}
 
 	// Get the world content we're operating in
@@ -40,90 +550,51 @@ void UMeshGeometry::Project(
 	if (!World)
 	{
 		UE_LOG(MDTLog, Error, TEXT("Project: Cannot access game world"));
-		return;
+		return false;
 	}
 
 	// Prepare the trace query parameters
 	const FName TraceTag("ProjectTraceTag");
-	FCollisionQueryParams TraceQueryParams = FCollisionQueryParams();
-	TraceQueryParams.TraceTag = TraceTag;
-	TraceQueryParams.bTraceComplex = bTraceComplex;
-	TraceQueryParams.AddIgnoredActors(IgnoredActors);
+	OutProjection.TraceQueryParams = FCollisionQueryParams();
+	OutProjection.TraceQueryParams.TraceTag = TraceTag;
+	OutProjection.TraceQueryParams.bTraceComplex = bTraceComplex;
+	OutProjection.TraceQueryParams.AddIgnoredActors(IgnoredActors);
+
+	OutProjection.World = World;
+	OutProjection.Transform = Transform;
+	OutProjection.CollisionChannel = CollisionChannel;
+	OutProjection.Projection = Projection;
+	OutProjection.HeightAdjust = HeightAdjust;
+	OutProjection.bProjectDown = false;
 
 	// Convert the projection into local space as we'll need it for the projection
 	// calculations and don't want to do it per-vert.  Also calculate the normalized
 	// version and store that.
 	const FVector ProjectionInLS = Transform.InverseTransformVector(Projection);
-	const FVector ProjectionNormalInLS = ProjectionInLS.GetSafeNormal();
+	OutProjection.ProjectionNormalInLS = ProjectionInLS.GetSafeNormal();
 
-	// Get the distance to the base plane
+	// Get the distance to the base plane.  This has to be done up front as it depends on
+	// every vertex, which will have moved by the time a later range is projected.
 	const float DistanceToBasePlane = MiniumProjectionPlaneDistance(-ProjectionInLS);
-	const FVector PointOnBasePlane = Projection.GetSafeNormal() * DistanceToBasePlane;
-	const FVector PointOnBasePlaneLS = ProjectionNormalInLS * DistanceToBasePlane;
-
-	// Iterate over the sections, and the vertices in the sections.
-	int32 NextWeightIndex = 0;
-	for (auto &Section : this->Sections)
-	{
-		for (auto &Vertex : Section.Vertices)
-		{
-			// Scale the Projection vector according to the selectionSet, giving varying strength projections, all in World Space
-			const FVector ScaledProjection = Projection * (Selection ? Selection->Weights[NextWeightIndex++] : 1.0f);
-
-			// Compute the start/end positions of the trace
-			const FVector TraceStart = Transform.TransformPosition(Vertex);
-			const FVector TraceEnd = Transform.TransformPosition(
-				Utility::NearestPointOnPlane(
-					Vertex,
-					PointOnBasePlaneLS + ScaledProjection.Size() *ProjectionNormalInLS,
-					ProjectionNormalInLS
-				)
-			);
-
-			// Do the actual trace
-			FHitResult HitResult;
-			bool bHitSuccess = World->LineTraceSingleByChannel(
-				HitResult,
-				TraceStart, TraceEnd,
-				CollisionChannel, TraceQueryParams, FCollisionResponseParams()
-			);
-
-			// Position the vertex based on whether we had a hit or not.
-			if (HitResult.bBlockingHit) {
-				// Calculate the offset for the vertex- it's based on the distance to the
-				// base plane.
-				const float DistanceFromVertexToBasePlane =
-					FVector::PointPlaneDist(Vertex, PointOnBasePlaneLS, ProjectionNormalInLS);
-				const float HitProjectionHeight =
-					DistanceFromVertexToBasePlane - HeightAdjust;
-
-				Vertex = 
-					Transform.InverseTransformPosition(
-						HitResult.ImpactPoint
-					) + ProjectionNormalInLS * HitProjectionHeight;
-			}
-			else {
-				// No collision- just add the projection to the vertex.
-				Vertex = Vertex + Transform.InverseTransformVector(ScaledProjection);;
-			}
-		}
-	}
+	OutProjection.PointOnBasePlaneLS = OutProjection.ProjectionNormalInLS * DistanceToBasePlane;
+	return true;
 }
 
-void UMeshGeometry::ProjectDown(
-	UObject* WorldContextObject, 
+bool UMeshGeometry::PrepareProjectDown(
+	FMeshProjection &OutProjection,
+	UObject *WorldContextObject,
 	FTransform Transform,
-	TArray <AActor *> IgnoredActors /*= nullptr*/,
-	float ProjectionLength /*= 100*/,
-	float HeightAdjust /*= 0*/,
-	bool bTraceComplex /*= true*/,
-	ECollisionChannel CollisionChannel /*= ECC_WorldStatic*/,
-	USelectionSet *Selection /*= nullptr */)
+	const TArray<AActor *> &IgnoredActors,
+	float ProjectionLength,
+	float HeightAdjust,
+	bool bTraceComplex,
+	ECollisionChannel CollisionChannel,
+	USelectionSet *Selection) const
 {
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("ProjectDown")))
 	{
-		return;
+		return false;
 	}
 
 	// Get the world content we're operating in
@@ -131,54 +602,111 @@ void UMeshGeometry::ProjectDown(
 	if (!World)
 	{
 		UE_LOG(MDTLog, Error, TEXT("ProjectDown: Cannot access game world"));
-		return;
+		return false;
 	}
 
 	// Prepare the trace query parameters
 	const FName TraceTag("ProjectDownTraceTag");
-	FCollisionQueryParams TraceQueryParams = FCollisionQueryParams();
-	TraceQueryParams.TraceTag = TraceTag;
-	TraceQueryParams.bTraceComplex = bTraceComplex;
-	TraceQueryParams.AddIgnoredActors(IgnoredActors);
+	OutProjection.TraceQueryParams = FCollisionQueryParams();
+	OutProjection.TraceQueryParams.TraceTag = TraceTag;
+	OutProjection.TraceQueryParams.bTraceComplex = bTraceComplex;
+	OutProjection.TraceQueryParams.AddIgnoredActors(IgnoredActors);
+
+	OutProjection.World = World;
+	OutProjection.Transform = Transform;
+	OutProjection.CollisionChannel = CollisionChannel;
+	OutProjection.Projection = FVector(0, 0, -ProjectionLength);
+	OutProjection.HeightAdjust = HeightAdjust;
+	OutProjection.bProjectDown = true;
+	return true;
+}
 
-	// Calculate the projection vector.
-	const FVector Projection = FVector(0, 0, -ProjectionLength);
+void UMeshGeometry::ProjectVertexRange(
+	const FMeshProjection &Projection, USelectionSet *Selection, int32 StartVertex, int32 EndVertex)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_ProjectVertexRange);
 
-	// Iterate over the sections, and the vertices in the sections.
-	int32 NextWeightIndex = 0;
-	for (auto &Section : this->Sections)
+	UWorld *World = Projection.World.Get();
+	if (!World)
 	{
-		for (auto &Vertex : Section.Vertices)
+		UE_LOG(MDTLog, Error, TEXT("ProjectVertexRange: Game world no longer exists"));
+		return;
+	}
+
+	StartVertex = FMath::Max(StartVertex, 0);
+	EndVertex = FMath::Min(EndVertex, GetTotalVertexCount());
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, FMath::Max(EndVertex-StartVertex, 0));
+
+	const FTransform &Transform = Projection.Transform;
+
+	// Iterate over the sections which overlap the range, and the vertices in them.
+	for (int32 SectionIndex = 0; SectionIndex<Sections.Num(); ++SectionIndex)
+	{
+		const int32 SectionStart = SectionVertexOffsets[SectionIndex];
+		const int32 FirstVertex = FMath::Max(StartVertex, SectionStart)-SectionStart;
+		const int32 LastVertex = FMath::Min(EndVertex, SectionVertexOffsets[SectionIndex+1])-SectionStart;
+		if (FirstVertex>=LastVertex)
 		{
+			continue;
+		}
+
+		TArray<FVector> &Vertices = Sections[SectionIndex].Vertices;
+		for (int32 VertexIndex = FirstVertex; VertexIndex<LastVertex; ++VertexIndex)
+		{
+			FVector &Vertex = Vertices[VertexIndex];
+
 			// Scale the Projection vector according to the selectionSet, giving varying strength projections, all in World Space
-			const FVector ScaledProjection = Projection * (Selection ? Selection->Weights[NextWeightIndex++] : 1.0f);
+			const FVector ScaledProjection =
+				Projection.Projection * (Selection ? Selection->GetWeight(SectionStart+VertexIndex) : 1.0f);
 
 			// Compute the start/end positions of the trace
 			const FVector TraceStart = Transform.TransformPosition(Vertex);
-			const FVector TraceEnd =
-				Transform.TransformPosition(FVector(Vertex.X, Vertex.Y, 0)) + ScaledProjection;
+			const FVector TraceEnd = Projection.bProjectDown ?
+				Transform.TransformPosition(FVector(Vertex.X, Vertex.Y, 0)) + ScaledProjection :
+				Transform.TransformPosition(
+					Utility::NearestPointOnPlane(
+						Vertex,
+						Projection.PointOnBasePlaneLS + ScaledProjection.Size() * Projection.ProjectionNormalInLS,
+						Projection.ProjectionNormalInLS
+					)
+				);
 
 			// Do the actual trace
 			FHitResult HitResult;
-			bool bHitSuccess = World->LineTraceSingleByChannel(
+			World->LineTraceSingleByChannel(
 				HitResult,
 				TraceStart, TraceEnd,
-				CollisionChannel, TraceQueryParams, FCollisionResponseParams()
+				Projection.CollisionChannel, Projection.TraceQueryParams, FCollisionResponseParams()
 			);
 
 			// Position the vertex based on whether we had a hit or not.
-			if (HitResult.bBlockingHit) {
+			if (HitResult.bBlockingHit && Projection.bProjectDown) {
 				// Add the original .Z and heightAdjust to the hit result for the final collision output.
 				Vertex =
 					Transform.InverseTransformPosition(
 						HitResult.ImpactPoint
-					) + FVector(0,0,Vertex.Z + HeightAdjust);
+					) + FVector(0,0,Vertex.Z + Projection.HeightAdjust);
+			}
+			else if (HitResult.bBlockingHit) {
+				// Calculate the offset for the vertex- it's based on the distance to the
+				// base plane.
+				const float DistanceFromVertexToBasePlane =
+					FVector::PointPlaneDist(Vertex, Projection.PointOnBasePlaneLS, Projection.ProjectionNormalInLS);
+				const float HitProjectionHeight =
+					DistanceFromVertexToBasePlane - Projection.HeightAdjust;
+
+				Vertex = 
+					Transform.InverseTransformPosition(
+						HitResult.ImpactPoint
+					) + Projection.ProjectionNormalInLS * HitProjectionHeight;
 			}
 			else {
 				// No collision- just add the projection to the vertex.
-				Vertex = Vertex + Transform.InverseTransformVector(ScaledProjection);;
+				Vertex = Vertex + Transform.InverseTransformVector(ScaledProjection);
 			}
 		}
+
+		MarkGeometryChanged(ESectionChanges::Positions, SectionIndex);
 	}
 }
 
@@ -192,6 +720,8 @@ void UMeshGeometry::FitToSpline(
 	USelectionSet *Selection /*= nullptr*/
 )
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_FitToSpline);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("FitToSpline")))
 	{
@@ -204,6 +734,8 @@ void UMeshGeometry::FitToSpline(
 		return;
 	}
 
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Get the length of the spline
 	const float SplineLength = SplineComponent->GetSplineLength();
 
@@ -218,63 +750,59 @@ void UMeshGeometry::FitToSpline(
 	const FVector2D RangePosition = FVector2D(StartPosition, EndPosition);
 	const FVector2D FullSplineRange = FVector2D(0.0f, SplineLength);
 
-	// Iterate over the sections, and the vertices in the sections.
-	int32 NextVertexIndex = 0;
-	for (auto &Section:this->Sections)
+	// Get the ranges of the profile curves up front, they're the same for every vertex.
+	FVector2D ProfileCurveRange = FVector2D::ZeroVector;
+	if (ProfileCurve)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			// Remap the X position into the StartPosition/EndPosition range, then multiply by SplineLength to get a value we
-			// can use for lookup.
-			const float DistanceAlongSpline = FMath::GetMappedRangeValueClamped(RangeX, RangePosition, Vertex.X) * SplineLength;
-
-			// If we have either profile curve we now need to find the position at a given point.  For efficiency
-			//   we can combine this with MeshScale.
-			float CombinedMeshScale = MeshScale;
-			if (ProfileCurve)
-			{
-				// Get the range of the curve
-				float ProfileCurveMin;
-				float ProfileCurveMax;
-				ProfileCurve->GetTimeRange(ProfileCurveMin, ProfileCurveMax);
-				FVector2D ProfileCurveRange = FVector2D(ProfileCurveMin, ProfileCurveMax);
-
-				const float PositionAlongCurve =
-					FMath::GetMappedRangeValueClamped(FullSplineRange, ProfileCurveRange, DistanceAlongSpline);
-				CombinedMeshScale = CombinedMeshScale * ProfileCurve->GetFloatValue(PositionAlongCurve);
-			}
-			if (SectionProfileCurve)
-			{
-				// Get the range of the curve
-				float SectionCurveMin;
-				float SectionCurveMax;
-				SectionProfileCurve->GetTimeRange(SectionCurveMin, SectionCurveMax);
-				FVector2D SectionProfileCurveRange = FVector2D(SectionCurveMin, SectionCurveMax);
-
-				const float PositionAlongCurve =
-					FMath::GetMappedRangeValueClamped(RangeX, SectionProfileCurveRange, Vertex.X);
-				CombinedMeshScale = CombinedMeshScale * SectionProfileCurve->GetFloatValue(PositionAlongCurve);
-			}
+		ProfileCurve->GetTimeRange(ProfileCurveRange.X, ProfileCurveRange.Y);
+	}
+	FVector2D SectionProfileCurveRange = FVector2D::ZeroVector;
+	if (SectionProfileCurve)
+	{
+		SectionProfileCurve->GetTimeRange(SectionProfileCurveRange.X, SectionProfileCurveRange.Y);
+	}
 
-			// Get all of the splines's details at the distance we've converted X to- stick to local space
-			const FVector Location = SplineComponent->GetLocationAtDistanceAlongSpline(
-				DistanceAlongSpline, ESplineCoordinateSpace::Local
-			);
-			const FVector RightVector = SplineComponent->GetRightVectorAtDistanceAlongSpline(
-				DistanceAlongSpline, ESplineCoordinateSpace::Local
-			);
-			const FVector UpVector = SplineComponent->GetUpVectorAtDistanceAlongSpline(
-				DistanceAlongSpline, ESplineCoordinateSpace::Local
-			);
+	// Iterate over all of the vertices.  The spline and curves are UObjects so this stays on the
+	// calling thread.
+	ForEachVertex(Selection, ESectionChanges::Positions, [&](FSectionGeometry &Section, int32 VertexIndex, float Weight)
+	{
+		FVector &Vertex = Section.Vertices[VertexIndex];
 
-			// Now we have the details we can use them to compute the final location that we need to use
-			FVector SplineVertexPosition = Location+(RightVector * Vertex.Y * CombinedMeshScale)+(UpVector * Vertex.Z * CombinedMeshScale);
-			Vertex = FMath::Lerp(
-				Vertex, SplineVertexPosition,
-				Selection ? Selection->Weights[NextVertexIndex++] : 1.0f
-			);
+		// Remap the X position into the StartPosition/EndPosition range, then multiply by SplineLength to get a value we
+		// can use for lookup.
+		const float DistanceAlongSpline = FMath::GetMappedRangeValueClamped(RangeX, RangePosition, Vertex.X) * SplineLength;
+
+		// If we have either profile curve we now need to find the position at a given point.  For efficiency
+		//   we can combine this with MeshScale.
+		float CombinedMeshScale = MeshScale;
+		if (ProfileCurve)
+		{
+			const float PositionAlongCurve =
+				FMath::GetMappedRangeValueClamped(FullSplineRange, ProfileCurveRange, DistanceAlongSpline);
+			CombinedMeshScale = CombinedMeshScale * ProfileCurve->GetFloatValue(PositionAlongCurve);
 		}
-	}
+		if (SectionProfileCurve)
+		{
+			const float PositionAlongCurve =
+				FMath::GetMappedRangeValueClamped(RangeX, SectionProfileCurveRange, Vertex.X);
+			CombinedMeshScale = CombinedMeshScale * SectionProfileCurve->GetFloatValue(PositionAlongCurve);
+		}
+
+		// Get all of the splines's details at the distance we've converted X to- stick to local space
+		const FVector Location = SplineComponent->GetLocationAtDistanceAlongSpline(
+			DistanceAlongSpline, ESplineCoordinateSpace::Local
+		);
+		const FVector RightVector = SplineComponent->GetRightVectorAtDistanceAlongSpline(
+			DistanceAlongSpline, ESplineCoordinateSpace::Local
+		);
+		const FVector UpVector = SplineComponent->GetUpVectorAtDistanceAlongSpline(
+			DistanceAlongSpline, ESplineCoordinateSpace::Local
+		);
+
+		// Now we have the details we can use them to compute the final location that we need to use
+		FVector SplineVertexPosition = Location+(RightVector * Vertex.Y * CombinedMeshScale)+(UpVector * Vertex.Z * CombinedMeshScale);
+		Vertex = FMath::Lerp(Vertex, SplineVertexPosition, Weight);
+	}, false);
 }
 
 void UMeshGeometry::FlipTextureUV(
@@ -282,21 +810,42 @@ void UMeshGeometry::FlipTextureUV(
 	bool bFlipV /*= false*/,
 	USelectionSet *Selection /*= nullptr*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_FlipTextureUV);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("FlipTextureUV")))
 	{
 		return;
 	}
 
+	// Leave the UVs shared if nothing would change.
+	if (!bFlipU && !bFlipV)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Iterate over the sections, and the uvs in the sections.
 	int32 NextWeightIndex = 0;
+	bool bAnyChanged = false;
 	for (auto &Section:this->Sections)
 	{
-		for (auto &UV:Section.UVs)
+		// Sections outside the selection keep sharing their UVs.
+		const int32 SectionUVCount = Section.GetUVs().Num();
+		if (!HasAnyWeight(Selection, NextWeightIndex, SectionUVCount))
+		{
+			NextWeightIndex += SectionUVCount;
+			continue;
+		}
+		SectionChanges[(int32)(&Section-this->Sections.GetData())] |= ESectionChanges::UVs;
+		bAnyChanged = true;
+
+		for (auto &UV:Section.GetMutableUVs())
 		{
 			// Obtain the next weighting and check if it's >=0.5
 			const bool bShouldFlip =
-				Selection ? Selection->Weights[NextWeightIndex++]>=0.5 : true;
+				Selection ? Selection->IsSelected(NextWeightIndex++) : true;
 
 			// If we're meant to be flipping then flip the correct channels.
 			if (bShouldFlip)
@@ -309,6 +858,133 @@ void UMeshGeometry::FlipTextureUV(
 		}
 	}
 
+	if (bAnyChanged)
+	{
+		// The sections are already marked, this just bumps the generation.
+		MarkGeometryChanged(ESectionChanges::None);
+	}
+}
+
+void UMeshGeometry::BuildRawMesh(FRawMesh &RawMesh) const
+{
+	BuildRawMesh(this->Sections, RawMesh);
+}
+
+void UMeshGeometry::BuildRawMesh(const TArray<FSectionGeometry> &Sections, FRawMesh &RawMesh)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_BuildRawMesh);
+
+	RawMesh.Empty();
+
+	// Work out where each section's vertices and faces go in the combined buffers, and split
+	// the faces into chunks which can be filled in any order.
+	const int32 ChunkSize = CVarParallelChunkSize.GetValueOnAnyThread();
+	TArray<FTriangleChunk, TInlineAllocator<16>> Chunks;
+	int32 TotalVertexCount = 0;
+	int32 TotalFaceCount = 0;
+	for (int32 SectionIndex = 0; SectionIndex<Sections.Num(); ++SectionIndex)
+	{
+		const FSectionGeometry &Section = Sections[SectionIndex];
+		const int32 SectionFaceCount = Section.Vertices.Num()>0 ? Section.GetTriangles().Num()/3 : 0;
+		const int32 Step = ChunkSize>0 ? FMath::Max(ChunkSize/3, 1) : FMath::Max(SectionFaceCount, 1);
+		for (int32 StartTriangle = 0; StartTriangle<SectionFaceCount; StartTriangle += Step)
+		{
+			const int32 EndTriangle = FMath::Min(StartTriangle+Step, SectionFaceCount);
+			Chunks.Add({SectionIndex, StartTriangle, EndTriangle, TotalFaceCount+StartTriangle, TotalVertexCount});
+		}
+		TotalVertexCount += Section.Vertices.Num();
+		TotalFaceCount += SectionFaceCount;
+	}
+	const int32 TotalWedgeCount = TotalFaceCount*3;
+
+	// Positions are a straight copy of each section in turn.
+	RawMesh.VertexPositions.Reserve(TotalVertexCount);
+	for (const FSectionGeometry &Section:Sections)
+	{
+		RawMesh.VertexPositions.Append(Section.Vertices);
+	}
+
+	RawMesh.WedgeIndices.SetNumUninitialized(TotalWedgeCount);
+	RawMesh.WedgeTangentX.SetNumUninitialized(TotalWedgeCount);
+	RawMesh.WedgeTangentY.SetNumUninitialized(TotalWedgeCount);
+	RawMesh.WedgeTangentZ.SetNumUninitialized(TotalWedgeCount);
+	RawMesh.WedgeTexCoords[0].SetNumUninitialized(TotalWedgeCount);
+	RawMesh.WedgeColors.SetNumUninitialized(TotalWedgeCount);
+	RawMesh.FaceMaterialIndices.SetNumUninitialized(TotalFaceCount);
+	RawMesh.FaceSmoothingMasks.SetNumUninitialized(TotalFaceCount);
+	INC_DWORD_STAT_BY(
+		STAT_MDTBytesCopied,
+		TotalVertexCount*sizeof(FVector)+
+		TotalWedgeCount*(sizeof(uint32)+3*sizeof(FVector)+sizeof(FVector2D)+sizeof(FColor))
+	);
+
+	const bool bRunSingleThreaded = ChunkSize<=0||TotalWedgeCount<=ChunkSize;
+
+	ParallelFor(Chunks.Num(), [&](int32 ChunkIndex)
+	{
+		const FTriangleChunk &Chunk = Chunks[ChunkIndex];
+		const FSectionGeometry &Section = Sections[Chunk.SectionIndex];
+		const TArray<int32> &Triangles = Section.GetTriangles();
+		const TArray<FVector2D> &UVs = Section.GetUVs();
+		const TArray<FLinearColor> &VertexColors = Section.GetVertexColors();
+		const TArray<FProcMeshTangent> &Tangents = Section.GetTangents();
+		const int32 NumVertices = Section.Vertices.Num();
+
+		// Missing attributes get the same defaults as a PMC section would give them.
+		const bool bHasNormals = Section.Normals.Num()==NumVertices;
+		const bool bHasTangents = Tangents.Num()==NumVertices;
+		const bool bHasUVs = UVs.Num()==NumVertices;
+		const bool bHasColors = VertexColors.Num()==NumVertices;
+
+		for (int32 TriangleIndex = Chunk.StartTriangle; TriangleIndex<Chunk.EndTriangle; ++TriangleIndex)
+		{
+			const int32 FaceIndex = Chunk.FirstFace+TriangleIndex-Chunk.StartTriangle;
+			RawMesh.FaceMaterialIndices[FaceIndex] = Chunk.SectionIndex;
+			RawMesh.FaceSmoothingMasks[FaceIndex] = 0; // Assume this is ignored as bRecomputeNormals is false
+
+			for (int32 Corner = 0; Corner<3; ++Corner)
+			{
+				const int32 WedgeIndex = FaceIndex*3+Corner;
+				const int32 Index = FMath::Clamp(Triangles[TriangleIndex*3+Corner], 0, NumVertices-1);
+
+				const FProcMeshTangent Tangent = bHasTangents ? Tangents[Index] : FProcMeshTangent();
+				const FVector TangentX = Tangent.TangentX;
+				const FVector TangentZ = bHasNormals ? Section.Normals[Index] : FVector(0, 0, 1);
+				const FVector TangentY = (TangentX ^ TangentZ).GetSafeNormal() * (Tangent.bFlipTangentY ? -1.f : 1.f);
+
+				RawMesh.WedgeIndices[WedgeIndex] = Index+Chunk.VertexBase;
+				RawMesh.WedgeTangentX[WedgeIndex] = TangentX;
+				RawMesh.WedgeTangentY[WedgeIndex] = TangentY;
+				RawMesh.WedgeTangentZ[WedgeIndex] = TangentZ;
+				RawMesh.WedgeTexCoords[0][WedgeIndex] = bHasUVs ? UVs[Index] : FVector2D::ZeroVector;
+				RawMesh.WedgeColors[WedgeIndex] = bHasColors ? VertexColors[Index].ToFColor(false) : FColor::White;
+			}
+		}
+	}, bRunSingleThreaded);
+}
+
+void UMeshGeometry::ApplyMatrix(const FMatrix &Matrix, USelectionSet *Selection /*= nullptr*/)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_ApplyMatrix);
+
+	// Check selectionSet size- log and abort if there's a problem. 
+	if (!SelectionSetIsRightSize(Selection, TEXT("ApplyMatrix")))
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	ApplyMatrixUnchecked(Matrix, Selection);
+}
+
+void UMeshGeometry::ApplyMatrixUnchecked(const FMatrix &Matrix, USelectionSet *Selection)
+{
+	// Each chunk is a contiguous run of vertices so it can go straight to the kernel.
+	ForEachVertexRun(Selection, ESectionChanges::Positions, [&](FSectionGeometry &Section, int32 StartVertex, int32 Count, const float *Weights)
+	{
+		VertexKernels::TransformPositions(Section.Vertices.GetData()+StartVertex, Count, Matrix, Weights);
+	});
 }
 
 bool UMeshGeometry::CheckGeometryIsValid(FString NodeNameForWarning) const
@@ -323,7 +999,7 @@ bool UMeshGeometry::CheckGeometryIsValid(FString NodeNameForWarning) const
 
 	// Iterate over the sections
 	int32 NextSectionIndex = 0;
-	for (auto Section:this->Sections)
+	for (const FSectionGeometry &Section:this->Sections)
 	{
 		// Each section should contain at least three vertices.
 		const int32 SectionVertexCount = Section.Vertices.Num();
@@ -338,7 +1014,7 @@ bool UMeshGeometry::CheckGeometryIsValid(FString NodeNameForWarning) const
 		}
 
 		// Each section should contain at least one triangle
-		const int32 TrianglePointNum = Section.Triangles.Num();
+		const int32 TrianglePointNum = Section.GetTriangles().Num();
 		if (TrianglePointNum<3)
 		{
 			UE_LOG(
@@ -381,6 +1057,8 @@ bool UMeshGeometry::CheckGeometryIsValid(FString NodeNameForWarning) const
 
 UMeshGeometry * UMeshGeometry::Clone() const
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Clone);
+
 	// Create a new MeshGeo with the same outer objec7t as us.
 	UMeshGeometry *NewMeshGeo = NewObject<UMeshGeometry>(this->GetOuter());
 	if (!NewMeshGeo)
@@ -396,6 +1074,15 @@ UMeshGeometry * UMeshGeometry::Clone() const
 
 FBox UMeshGeometry::GetBoundingBox() const
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_GetBoundingBox);
+
+	// Nothing's changed since we last looked- return the previous result.
+	if (BoundingBoxGeneration==Generation)
+	{
+		return CachedBoundingBox;
+	}
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Track the two corners of the bounding box
 	FVector Min = FVector::ZeroVector;
 	FVector Max = FVector::ZeroVector;
@@ -405,21 +1092,15 @@ FBox UMeshGeometry::GetBoundingBox() const
 	bool bHaveProcessedFirstVector = false;
 
 	// Iterate over the sections, and the vertices in the sections.
-	int32 NextSelectionIndex = 0;
-	for (auto &Section:this->Sections)
+	for (const FSectionGeometry &Section:this->Sections)
 	{
-		for (auto &Vertex:Section.Vertices)
+		for (const FVector &Vertex:Section.Vertices)
 		{
 			if (bHaveProcessedFirstVector)
 			{
 				// Do the comparison of both min/max.
-				Min.X = FMath::Min(Min.X, Vertex.X);
-				Min.Y = FMath::Min(Min.Y, Vertex.Y);
-				Min.Z = FMath::Min(Min.Z, Vertex.Z);
-
-				Max.X = FMath::Max(Max.X, Vertex.X);
-				Max.Y = FMath::Max(Max.Y, Vertex.Y);
-				Max.Z = FMath::Max(Max.Z, Vertex.Z);
+				Min = Min.ComponentMin(Vertex);
+				Max = Max.ComponentMax(Vertex);
 			}
 			else
 			{
@@ -432,31 +1113,35 @@ FBox UMeshGeometry::GetBoundingBox() const
 	}
 
 	// Build a bounding box from the result
-	return FBox(Min, Max);
+	CachedBoundingBox = FBox(Min, Max);
+	BoundingBoxGeneration = Generation;
+	return CachedBoundingBox;
 }
 
 float UMeshGeometry::GetRadius() const
 {
-	// This is the radius so far
-	float Radius;
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_GetRadius);
 
-	// When we hit the first vertex we'll need to set both Min and Max
-	//  to it as we'll have no comparison
-	bool bHaveProcessedFirstVector = false;
+	// Nothing's changed since we last looked- return the previous result.
+	if (RadiusGeneration==Generation)
+	{
+		return CachedRadius;
+	}
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
 
-	// Iterate over the sections, and the vertices in the sections.
-	for (auto &Section : this->Sections)
+	// Track the largest squared distance and only take the square root once at the end.
+	float RadiusSquared = 0.0f;
+	for (const FSectionGeometry &Section:this->Sections)
 	{
-		for (auto &Vertex : Section.Vertices)
+		for (const FVector &Vertex:Section.Vertices)
 		{
-			Radius = bHaveProcessedFirstVector ?
-				FMath::Max(Radius, Vertex.Size()) :
-				Vertex.Size();
+			RadiusSquared = FMath::Max(RadiusSquared, Vertex.SizeSquared());
 		}
-		bHaveProcessedFirstVector = true;
 	}
 
-	return Radius;
+	CachedRadius = FMath::Sqrt(RadiusSquared);
+	RadiusGeneration = Generation;
+	return CachedRadius;
 }
 
 FString UMeshGeometry::GetSummary() const
@@ -474,57 +1159,235 @@ int32 UMeshGeometry::GetSectionCount() const
 
 int32 UMeshGeometry::GetTotalTriangleCount() const
 {
-	int32 TotalTriangleCount = 0;
-	for (auto Section:this->Sections)
+	return TotalTriangleCount;
+}
+
+int32 UMeshGeometry::GetTotalVertexCount() const
+{
+	// The final offset is the total.
+	return SectionVertexOffsets.Num()>0 ? SectionVertexOffsets.Last() : 0;
+}
+
+void UMeshGeometry::MarkGeometryChanged(ESectionChanges Changes /*= ESectionChanges::All*/, int32 SectionIndex /*= INDEX_NONE*/)
+{
+	// Skip 0 on wrap-around, it's reserved for 'never cached'.
+	Generation = (Generation==MAX_uint32) ? 1 : Generation+1;
+
+	if (SectionIndex==INDEX_NONE)
+	{
+		for (ESectionChanges &Changed:SectionChanges)
+		{
+			Changed |= Changes;
+		}
+	}
+	else if (SectionChanges.IsValidIndex(SectionIndex))
 	{
-		TotalTriangleCount += Section.Triangles.Num();
+		SectionChanges[SectionIndex] |= Changes;
 	}
-	return TotalTriangleCount/3; // 3pts per triangle
 }
 
-int32 UMeshGeometry::GetTotalVertexCount() const
+ESectionChanges UMeshGeometry::GetSectionChanges(int32 SectionIndex) const
+{
+	return SectionChanges.IsValidIndex(SectionIndex) ? SectionChanges[SectionIndex] : ESectionChanges::All;
+}
+
+uint32 UMeshGeometry::GetGeneration() const
+{
+	return Generation;
+}
+
+void UMeshGeometry::SetVertexRange(int32 StartVertex, int32 EndVertex)
+{
+	VertexRangeStart = StartVertex;
+	VertexRangeEnd = EndVertex;
+	bVertexRangeUsed = false;
+}
+
+bool UMeshGeometry::ClearVertexRange()
+{
+	const bool bWasUsed = bVertexRangeUsed;
+	SetVertexRange(0, MAX_int32);
+	return bWasUsed;
+}
+
+void UMeshGeometry::CopyGeometryFrom(const UMeshGeometry &SourceMeshGeometry)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_CopyGeometryFrom);
+
+	// As with LoadFromMeshGeometry the copy's attributes are shared, so once the source holds
+	// shared attributes too only the vertices and normals are copied.
+	this->Sections = SourceMeshGeometry.Sections;
+	for (FSectionGeometry &Section:this->Sections)
+	{
+		Section.ShareAttributes();
+		INC_DWORD_STAT_BY(STAT_MDTBytesCopied, GetUnsharedDataSize(Section));
+	}
+
+	// The layout is the same as the source's so its counts and changes still apply.
+	SectionVertexOffsets = SourceMeshGeometry.SectionVertexOffsets;
+	TotalTriangleCount = SourceMeshGeometry.TotalTriangleCount;
+	SectionChanges = SourceMeshGeometry.SectionChanges;
+	LastSavedComponent = SourceMeshGeometry.LastSavedComponent;
+	LastSaveNumber = SourceMeshGeometry.LastSaveNumber;
+	bLastSavedWithCollision = SourceMeshGeometry.bLastSavedWithCollision;
+	MarkGeometryChanged(ESectionChanges::None);
+}
+
+void UMeshGeometry::SwapGeometry(UMeshGeometry &OtherMeshGeometry)
+{
+	Swap(this->Sections, OtherMeshGeometry.Sections);
+	Swap(SectionVertexOffsets, OtherMeshGeometry.SectionVertexOffsets);
+	Swap(TotalTriangleCount, OtherMeshGeometry.TotalTriangleCount);
+	Swap(SectionChanges, OtherMeshGeometry.SectionChanges);
+	Swap(LastSavedComponent, OtherMeshGeometry.LastSavedComponent);
+	Swap(LastSaveNumber, OtherMeshGeometry.LastSaveNumber);
+	Swap(bLastSavedWithCollision, OtherMeshGeometry.bLastSavedWithCollision);
+
+	// Both geometries have changed, this just bumps the generations.
+	MarkGeometryChanged(ESectionChanges::None);
+	OtherMeshGeometry.MarkGeometryChanged(ESectionChanges::None);
+}
+
+void UMeshGeometry::ResetToGeometry(const UMeshGeometry &SourceMeshGeometry)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_ResetToGeometry);
+
+	// The buffers can only be reused if every section has the same number of vertices.
+	bool bSameLayout = this->Sections.Num()==SourceMeshGeometry.Sections.Num();
+	for (int32 SectionIndex = 0; bSameLayout && SectionIndex<this->Sections.Num(); ++SectionIndex)
+	{
+		bSameLayout = this->Sections[SectionIndex].Vertices.Num()==SourceMeshGeometry.Sections[SectionIndex].Vertices.Num();
+	}
+	if (!bSameLayout)
+	{
+		LoadFromMeshGeometry(&SourceMeshGeometry);
+		return;
+	}
+
+	for (int32 SectionIndex = 0; SectionIndex<this->Sections.Num(); ++SectionIndex)
+	{
+		FSectionGeometry &Section = this->Sections[SectionIndex];
+		const FSectionGeometry &SourceSection = SourceMeshGeometry.Sections[SectionIndex];
+		ESectionChanges Changes = ESectionChanges::None;
+
+		// Comparing is much cheaper than sending unchanged sections on to the
+		// ProceduralMeshComponent, and the operations often leave sections alone.
+		if (Section.Vertices!=SourceSection.Vertices)
+		{
+			Section.Vertices.Reset();
+			Section.Vertices.Append(SourceSection.Vertices);
+			INC_DWORD_STAT_BY(STAT_MDTBytesCopied, Section.Vertices.Num()*sizeof(FVector));
+			Changes |= ESectionChanges::Positions;
+		}
+		if (Section.Normals!=SourceSection.Normals)
+		{
+			Section.Normals.Reset();
+			Section.Normals.Append(SourceSection.Normals);
+			INC_DWORD_STAT_BY(STAT_MDTBytesCopied, Section.Normals.Num()*sizeof(FVector));
+			Changes |= ESectionChanges::Normals;
+		}
+
+		const ESectionAttributes ChangedAttributes = Section.ShareAttributesWith(SourceSection);
+		if (EnumHasAnyFlags(ChangedAttributes, ESectionAttributes::Triangles))
+		{
+			Changes |= ESectionChanges::Topology;
+		}
+		if (EnumHasAnyFlags(ChangedAttributes, ESectionAttributes::UVs))
+		{
+			Changes |= ESectionChanges::UVs;
+		}
+		if (EnumHasAnyFlags(ChangedAttributes, ESectionAttributes::Tangents))
+		{
+			Changes |= ESectionChanges::Tangents;
+		}
+		if (EnumHasAnyFlags(ChangedAttributes, ESectionAttributes::VertexColors))
+		{
+			Changes |= ESectionChanges::VertexColors;
+		}
+
+		if (Changes!=ESectionChanges::None)
+		{
+			MarkGeometryChanged(Changes, SectionIndex);
+		}
+	}
+}
+
+void UMeshGeometry::ShareAttributes()
+{
+	for (FSectionGeometry &Section:this->Sections)
+	{
+		Section.ShareAttributes();
+	}
+}
+
+void UMeshGeometry::RefreshCachedCounts()
 {
+	// If the layout has changed then so has everything derived from it, and every section will
+	// need rebuilding on the next save.
+	SectionChanges.Init(ESectionChanges::All, Sections.Num());
+	MarkGeometryChanged();
+
+	SectionVertexOffsets.SetNumUninitialized(Sections.Num()+1);
+
 	int32 TotalVertexCount = 0;
-	for (auto Section:this->Sections)
+	int32 TotalTriangleIndexCount = 0;
+	for (int32 SectionIndex = 0; SectionIndex<Sections.Num(); ++SectionIndex)
 	{
+		const FSectionGeometry &Section = Sections[SectionIndex];
+		SectionVertexOffsets[SectionIndex] = TotalVertexCount;
 		TotalVertexCount += Section.Vertices.Num();
+		TotalTriangleIndexCount += Section.GetTriangles().Num();
+	}
+	SectionVertexOffsets[Sections.Num()] = TotalVertexCount;
+	TotalTriangleCount = TotalTriangleIndexCount/3; // 3pts per triangle
+}
+
+int32 UMeshGeometry::GetSectionVertexOffset(int32 SectionIndex) const
+{
+	if (SectionIndex<0||SectionIndex>=SectionVertexOffsets.Num())
+	{
+		return INDEX_NONE;
 	}
-	return TotalVertexCount;
+	return SectionVertexOffsets[SectionIndex];
 }
 
 void UMeshGeometry::Inflate(float Offset /*= 0.0f*/, USelectionSet *Selection /*= nullptr*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Inflate);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Jitter")))
 	{
 		return;
 	}
 
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Shouldn't need to check normals- MeshGeometry shouldn't allow that the be different
 
-	// Iterate over the sections, and the the vertices in the sections.
-	// As we need normals to we'll use an index-based for loop here for verts.
-	for (auto &Section:this->Sections)
+	// Iterate over all of the vertices, the weight comes from the vertex's index across the
+	// whole mesh rather than within its section.
+	ForEachVertexRun(Selection, ESectionChanges::Positions, [&](FSectionGeometry &Section, int32 StartVertex, int32 Count, const float *Weights)
 	{
-		for (int32 VertexIndex = 0; VertexIndex<Section.Vertices.Num(); ++VertexIndex)
-		{
-			Section.Vertices[VertexIndex] = FMath::Lerp(
-				Section.Vertices[VertexIndex],
-				Section.Vertices[VertexIndex]+(Section.Normals[VertexIndex]*Offset),
-				Selection ? Selection->Weights[VertexIndex] : 1.0f
-			);
-		}
-	}
+		DeformationCore::Inflate(
+			ToCore(Section.Vertices.GetData()+StartVertex), ToCore(Section.Normals.GetData()+StartVertex),
+			Count, Offset, Weights
+		);
+	});
 }
 
 void UMeshGeometry::Jitter(FRandomStream &RandomStream, FVector Min, FVector Max, USelectionSet *Selection /*=nullptr*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Jitter);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Jitter")))
 	{
 		return;
 	}
 
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Iterate over the sections, and the the vertices in the sections.
 	int32 NextWeightIndex = 0;
 
@@ -541,17 +1404,19 @@ void UMeshGeometry::Jitter(FRandomStream &RandomStream, FVector Min, FVector Max
 			Vertex = FMath::Lerp(
 				Vertex,
 				Vertex+RandomJitter,
-				Selection ? Selection->Weights[NextWeightIndex++] : 1.0f
+				Selection ? Selection->GetWeight(NextWeightIndex++) : 1.0f
 			);
 		}
 	}
+
+	MarkGeometryChanged(ESectionChanges::Positions);
 }
 
 void UMeshGeometry::Lerp(UMeshGeometry *TargetMeshGeometry, float Alpha /*= 0.0f*/, USelectionSet *Selection /*= nullptr*/)
 {
-	UE_LOG(
-		MDTLog, Warning, TEXT("Performing LERP")
-	);
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Lerp);
+
+	UE_LOG(MDTLog, Verbose, TEXT("Performing LERP"));
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Lerp")))
 	{
@@ -571,9 +1436,6 @@ void UMeshGeometry::Lerp(UMeshGeometry *TargetMeshGeometry, float Alpha /*= 0.0f
 		return;
 	}
 
-	// Iterate over the sections, and the vertices in the sections.  Do it by index so we
-	// can access the same data from TargetMeshGeometry
-	int32 NextWeightIndex = 0;
 	for (int32 SectionIndex = 0; SectionIndex<this->Sections.Num(); SectionIndex++)
 	{
 		if (this->Sections[SectionIndex].Vertices.Num()!=TargetMeshGeometry->Sections[SectionIndex].Vertices.Num())
@@ -584,90 +1446,69 @@ void UMeshGeometry::Lerp(UMeshGeometry *TargetMeshGeometry, float Alpha /*= 0.0f
 			);
 			return;
 		}
+	}
 
-		for (int32 VertexIndex = 0; VertexIndex<this->Sections[SectionIndex].Vertices.Num(); ++VertexIndex)
-		{
-			// Get the existing data from the two components.
-			FVector VertexFromThis = this->Sections[SectionIndex].Vertices[VertexIndex];
-			FVector VertexFromTarget = TargetMeshGeometry->Sections[SectionIndex].Vertices[VertexIndex];
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// Blend the vertices and normals with the same ones from TargetMeshGeometry, finding the
+	// section by its position in the array.
+	ForEachVertex(Selection, ESectionChanges::Positions|ESectionChanges::Normals, [&](FSectionGeometry &Section, int32 VertexIndex, float Weight)
+	{
+		const FSectionGeometry &TargetSection = TargetMeshGeometry->Sections[(int32)(&Section-this->Sections.GetData())];
+		const float VertexAlpha = Alpha*Weight;
 
-			FVector NormalFromThis = this->Sections[SectionIndex].Normals[VertexIndex];
-			FVector NormalFromTarget = TargetMeshGeometry->Sections[SectionIndex].Normals[VertexIndex];
+		Section.Vertices[VertexIndex] = FMath::Lerp(Section.Vertices[VertexIndex], TargetSection.Vertices[VertexIndex], VertexAlpha);
 
-			// Blend the vertices
-			this->Sections[SectionIndex].Vertices[VertexIndex] = FMath::Lerp(
-				VertexFromThis, VertexFromTarget,
-				Alpha * (Selection ? Selection->Weights[NextWeightIndex++] : 1.0f)
-			);
-			
-			// Blend the normals and renormalize the result
-			this->Sections[SectionIndex].Normals[VertexIndex] = 
-				FMath::Lerp(
-					NormalFromThis, NormalFromTarget,
-					Alpha * (Selection ? Selection->Weights[NextWeightIndex++] : 1.0f)
-				).GetSafeNormal();
-		}
-	}
+		// Blend the normals and renormalize the result
+		Section.Normals[VertexIndex] =
+			FMath::Lerp(Section.Normals[VertexIndex], TargetSection.Normals[VertexIndex], VertexAlpha).GetSafeNormal();
+	});
 }
 
 void UMeshGeometry::LerpVector(FVector Position, float Alpha /*= 0.0*/, USelectionSet *Selection /*= nullptr*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_LerpVector);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Lerp")))
 	{
 		return;
 	}
 
-	// Iterate over the sections, and the vertices in the sections.
-	int32 NextVertexIndex = 0;
-	for (auto &Section:this->Sections)
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// Iterate over all of the vertices.
+	ForEachVertexRun(Selection, ESectionChanges::Positions, [&](FSectionGeometry &Section, int32 StartVertex, int32 Count, const float *Weights)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			Vertex = FMath::Lerp(
-				Vertex,
-				Position,
-				Alpha * (Selection ? Selection->Weights[NextVertexIndex++] : 1.0f)
-			);
-		}
-	}
+		DeformationCore::LerpTowards(ToCore(Section.Vertices.GetData()+StartVertex), Count, ToCore(Position), Alpha, Weights);
+	});
 }
 
 void UMeshGeometry::MoveTowards(FVector Position, float Distance, bool bLimitAtPosition, USelectionSet *Selection /*= nullptr */)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_MoveTowards);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("MoveTowards")))
 	{
 		return;
 	}
 
-	// Iterate over the sections, and the vertices in the sections.
-	int32 NextVertexIndex = 0;
-	for (auto &Section:this->Sections)
-	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			// Calculate the actual distance including the SelectionSet strength.
-			float AdjustedDistance = Distance * (Selection ? Selection->Weights[NextVertexIndex++] : 1.0f);
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
 
-			// If we're moving 'past' the position and are limited then stop there, otherwise move
-			// the point
-			if (bLimitAtPosition && AdjustedDistance>=FVector::Distance(Vertex, Position))
-			{
-				// We're not allowed to move through the Position so move to it.
-				Vertex = Position;
-			}
-			else
-			{
-				// Move the vertex the correct distance
-				Vertex = Vertex+(AdjustedDistance * (Position-Vertex).GetSafeNormal());
-			}
-		}
-	}
+	// Iterate over all of the vertices.
+	ForEachVertexRun(Selection, ESectionChanges::Positions, [&](FSectionGeometry &Section, int32 StartVertex, int32 Count, const float *Weights)
+	{
+		DeformationCore::MoveTowards(
+			ToCore(Section.Vertices.GetData()+StartVertex), Count, ToCore(Position), Distance, bLimitAtPosition, Weights
+		);
+	});
 }
 
 bool UMeshGeometry::LoadFromMeshGeometry(const UMeshGeometry *SourceMeshGeometry)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_LoadFromMeshGeometry);
+
 	// If there's no source geometry we have nothing to do..
 	if (!SourceMeshGeometry)
 	{
@@ -675,20 +1516,23 @@ bool UMeshGeometry::LoadFromMeshGeometry(const UMeshGeometry *SourceMeshGeometry
 		return false;
 	}
 
-	// Clear any existing geometry.
-	this->Sections.Empty();
+	// Clear any existing geometry, keeping room for the new sections.
+	this->Sections.Empty(SourceMeshGeometry->Sections.Num());
 
-	// Iterate over the sections
-
-	for (auto &SourceMeshSection : SourceMeshGeometry->Sections)
+	// Iterate over the sections, copying each straight into place.  Any shared attributes are
+	// shared with the source rather than copied, and anything the source holds itself is
+	// moved into a shared buffer so that clones of this geometry can share it too.
+	for (const FSectionGeometry &SourceMeshSection : SourceMeshGeometry->Sections)
 	{
-		// Create the geometry for the section
-		FSectionGeometry NewSectionGeometry = FSectionGeometry(SourceMeshSection);
-
-		// Add the finished struct to the mesh's section list
-		this->Sections.Emplace(NewSectionGeometry);
+		FSectionGeometry &NewSection = this->Sections.Emplace_GetRef(SourceMeshSection);
+		NewSection.ShareAttributes();
+		INC_DWORD_STAT_BY(STAT_MDTBytesCopied, GetUnsharedDataSize(NewSection));
 	}
 
+	// The section layout has changed so rebuild the counts.
+	RefreshCachedCounts();
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Warn if the mesh doesn't look valid.  For now return it anyway but at least let
 	// them know..
 	CheckGeometryIsValid(TEXT("LoadFromMeshGeometry"));
@@ -699,6 +1543,8 @@ bool UMeshGeometry::LoadFromMeshGeometry(const UMeshGeometry *SourceMeshGeometry
 
 bool UMeshGeometry::LoadFromStaticMesh(UStaticMesh *StaticMesh, int32 LOD /*= 0*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_LoadFromStaticMesh);
+
 	// If there's no static mesh we have nothing to do..
 	if (!StaticMesh)
 	{
@@ -706,15 +1552,15 @@ bool UMeshGeometry::LoadFromStaticMesh(UStaticMesh *StaticMesh, int32 LOD /*= 0*
 		return false;
 	}
 
-	// Clear any existing geometry.
-	this->Sections.Empty();
+	// Clear any existing geometry, keeping room for the new sections.
+	const int32 NumSections = StaticMesh->GetNumSections(LOD);
+	this->Sections.Empty(NumSections);
 
 	// Iterate over the sections
-	const int32 NumSections = StaticMesh->GetNumSections(LOD);
 	for (int SectionIndex = 0; SectionIndex<NumSections; ++SectionIndex)
 	{
-		// Create the geometry for the section
-		FSectionGeometry SectionGeometry;
+		// Create the geometry for the section directly in the mesh's section list
+		FSectionGeometry &SectionGeometry = this->Sections.AddDefaulted_GetRef();
 
 		// Copy the static mesh's geometry for the section to the struct.
 		UKismetProceduralMeshLibrary::GetSectionFromStaticMesh(
@@ -726,10 +1572,15 @@ bool UMeshGeometry::LoadFromStaticMesh(UStaticMesh *StaticMesh, int32 LOD /*= 0*
 		// Load vertex colors with default values for as many vertices as needed
 		SectionGeometry.VertexColors.InsertDefaulted(0, SectionGeometry.Vertices.Num());
 
-		// Add the finished struct to the mesh's section list
-		this->Sections.Emplace(SectionGeometry);
+		// Move the attributes the deformers don't change into a shared buffer so that clones
+		// don't need to copy them.
+		SectionGeometry.ShareAttributes();
 	}
 
+	// The section layout has changed so rebuild the counts.
+	RefreshCachedCounts();
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Warn if the mesh doesn't look valid.  For now return it anyway but at least let
 	// them know..
 	CheckGeometryIsValid(TEXT("LoadFromStaticMesh"));
@@ -743,25 +1594,18 @@ void UMeshGeometry::Rotate(
 	FVector CenterOfRotation /*= FVector::ZeroVector*/,
 	USelectionSet *Selection)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Rotate);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Rotate")))
 	{
 		return;
 	}
 
-	// Iterate over the sections, and the the vertices in the sections.
-	int32 NextWeightIndex = 0;
-	for (auto &Section:this->Sections)
-	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			Vertex = FMath::Lerp(
-				Vertex,
-				CenterOfRotation+Rotation.RotateVector(Vertex-CenterOfRotation),
-				Selection ? Selection->Weights[NextWeightIndex++] : 1.0f
-			);
-		}
-	}
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// Rotation about a point is a single affine matrix.
+	ApplyMatrixUnchecked(Utility::MatrixAboutCenter(FRotationMatrix(Rotation), CenterOfRotation), Selection);
 }
 
 void UMeshGeometry::RotateAroundAxis(
@@ -769,6 +1613,8 @@ void UMeshGeometry::RotateAroundAxis(
 	FVector Axis /*= FVector::UpVector*/, float AngleInDegrees /*= 0.0f*/,
 	USelectionSet *Selection /*= nullptr*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_RotateAroundAxis);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Jitter")))
 	{
@@ -783,30 +1629,25 @@ void UMeshGeometry::RotateAroundAxis(
 		return;
 	}
 
-	// Iterate over the sections, and the vertices in the sections.
-	int32 NextWeightIndex = 0;
-	for (auto &Section:this->Sections)
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// Iterate over all of the vertices, in parallel for large meshes.
+	ForEachVertexRun(Selection, ESectionChanges::Positions, [&](FSectionGeometry &Section, int32 StartVertex, int32 Count, const float *Weights)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			FVector ClosestPointOnLine = FMath::ClosestPointOnInfiniteLine(
-				CenterOfRotation, CenterOfRotation+Axis, Vertex
-			);
-			FVector OffsetFromClosestPoint = Vertex-ClosestPointOnLine;
-			float ScaledRotation = FMath::Lerp(
-				0.0f, AngleInDegrees,
-				Selection ? Selection->Weights[NextWeightIndex++] : 1.0f
-			);
-			FVector RotatedOffset = OffsetFromClosestPoint.RotateAngleAxis(ScaledRotation, NormalizedAxis);
-			Vertex = ClosestPointOnLine+RotatedOffset;
-		}
-	}
+		DeformationCore::RotateAroundAxis(
+			ToCore(Section.Vertices.GetData()+StartVertex), Count,
+			ToCore(CenterOfRotation), ToCore(Axis), ToCore(NormalizedAxis), AngleInDegrees, Weights
+		);
+	});
 }
 
 bool UMeshGeometry::SaveToProceduralMeshComponent(
 	UProceduralMeshComponent *ProceduralMeshComponent,
-	bool bCreateCollision)
+	bool bCreateCollision,
+	bool bOnlyUpdateChanges /*= false*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SaveToProceduralMeshComponent);
+
 	// If there's no PMC we have nothing to do..
 	if (!ProceduralMeshComponent)
 	{
@@ -814,19 +1655,112 @@ bool UMeshGeometry::SaveToProceduralMeshComponent(
 		return false;
 	}
 
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// We can only send the changes if the PMC still holds what we last saved to it, which it
+	// doesn't if any other geometry (such as an async evaluation's back buffer) has saved to it since.
+	uint32 *FoundSaveNumber = ComponentSaveNumbers.Find(ProceduralMeshComponent);
+	if (!FoundSaveNumber)
+	{
+		// Drop any components which have been destroyed before adding a new one, so the map
+		// doesn't keep growing.
+		for (auto It = ComponentSaveNumbers.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		FoundSaveNumber = &ComponentSaveNumbers.Add(ProceduralMeshComponent, 0);
+	}
+	uint32 &ComponentSaveNumber = *FoundSaveNumber;
+	const bool bCanUpdateChanges =
+		bOnlyUpdateChanges &&
+		LastSavedComponent.Get()==ProceduralMeshComponent &&
+		LastSaveNumber==ComponentSaveNumber &&
+		bLastSavedWithCollision==bCreateCollision &&
+		ProceduralMeshComponent->GetNumSections()==Sections.Num();
+
+	LastSavedComponent = ProceduralMeshComponent;
+	LastSaveNumber = NextSaveNumber++;
+	ComponentSaveNumber = LastSaveNumber;
+	bLastSavedWithCollision = bCreateCollision;
+
+	if (bCanUpdateChanges)
+	{
+		static const TArray<FVector> NoVectors;
+		static const TArray<FVector2D> NoUVs;
+		static const TArray<FLinearColor> NoColors;
+		static const TArray<FProcMeshTangent> NoTangents;
+
+		for (int32 SectionIndex = 0; SectionIndex<Sections.Num(); ++SectionIndex)
+		{
+			const ESectionChanges Changes = SectionChanges[SectionIndex];
+			const FSectionGeometry &Section = Sections[SectionIndex];
+			if (Changes==ESectionChanges::None)
+			{
+				continue;
+			}
+
+			if (EnumHasAnyFlags(Changes, ESectionChanges::Topology))
+			{
+				// The triangles have changed so the section has to be created again.
+				INC_DWORD_STAT_BY(STAT_MDTBytesCopied, GetDataSize(Section));
+				ProceduralMeshComponent->CreateMeshSection_LinearColor(
+					SectionIndex,
+					Section.Vertices, Section.GetTriangles(), Section.Normals,
+					Section.GetUVs(), Section.GetVertexColors(), Section.GetTangents(),
+					bCreateCollision
+				);
+			}
+			else
+			{
+				// The PMC leaves any attribute it's passed an empty array for as it is, and
+				// only updates positions when there's the same number as it already has.
+				const TArray<FVector> &Positions =
+					EnumHasAnyFlags(Changes, ESectionChanges::Positions) ? Section.Vertices : NoVectors;
+				const TArray<FVector> &Normals =
+					EnumHasAnyFlags(Changes, ESectionChanges::Normals) ? Section.Normals : NoVectors;
+				const TArray<FVector2D> &UVs =
+					EnumHasAnyFlags(Changes, ESectionChanges::UVs) ? Section.GetUVs() : NoUVs;
+				const TArray<FLinearColor> &VertexColors =
+					EnumHasAnyFlags(Changes, ESectionChanges::VertexColors) ? Section.GetVertexColors() : NoColors;
+				const TArray<FProcMeshTangent> &Tangents =
+					EnumHasAnyFlags(Changes, ESectionChanges::Tangents) ? Section.GetTangents() : NoTangents;
+
+				INC_DWORD_STAT_BY(
+					STAT_MDTBytesCopied,
+					(Positions.Num()+Normals.Num())*sizeof(FVector)+UVs.Num()*sizeof(FVector2D)+
+					VertexColors.Num()*sizeof(FLinearColor)+Tangents.Num()*sizeof(FProcMeshTangent)
+				);
+				ProceduralMeshComponent->UpdateMeshSection_LinearColor(
+					SectionIndex, Positions, Normals, UVs, VertexColors, Tangents
+				);
+			}
+			SectionChanges[SectionIndex] = ESectionChanges::None;
+		}
+		return true;
+	}
+
+	// Everything is being sent, so the PMC is now up to date.
+	SectionChanges.Init(ESectionChanges::None, Sections.Num());
 
 	// Clear the geometry
 	ProceduralMeshComponent->ClearAllMeshSections();
 
-	// Iterate over the mesh sections, creating a PMC MeshSection for each one.
-	int32 NextSectionIndex = 0;
-	for (auto section:this->Sections)
+	// Iterate over the mesh sections, creating a PMC MeshSection for each one.  The PMC converts
+	// straight from our arrays into its own vertex buffer, so they're passed by reference rather
+	// than building an FProcMeshSection here which SetProcMeshSection would then copy again.
+	for (int32 SectionIndex = 0; SectionIndex<Sections.Num(); ++SectionIndex)
 	{
+		const FSectionGeometry &Section = Sections[SectionIndex];
+		INC_DWORD_STAT_BY(STAT_MDTBytesCopied, GetDataSize(Section));
+
 		// Create the PMC section with the StaticMesh's data.
 		ProceduralMeshComponent->CreateMeshSection_LinearColor(
-			NextSectionIndex++,
-			section.Vertices, section.Triangles, section.Normals,
-			section.UVs, section.VertexColors, section.Tangents,
+			SectionIndex,
+			Section.Vertices, Section.GetTriangles(), Section.Normals,
+			Section.GetUVs(), Section.GetVertexColors(), Section.GetTangents(),
 			bCreateCollision
 		);
 	}
@@ -838,6 +1772,16 @@ bool UMeshGeometry::SaveToStaticMesh(
 	UProceduralMeshComponent *ProceduralMeshComponent,
 	TArray<UMaterialInterface *> Materials)
 {
+	return QueueSaveToStaticMesh(StaticMesh, Materials);
+}
+
+bool UMeshGeometry::QueueSaveToStaticMesh(
+	UStaticMesh *StaticMesh,
+	const TArray<UMaterialInterface *> &Materials,
+	FOnStaticMeshBuilt OnBuilt /*= FOnStaticMeshBuilt()*/)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_QueueSaveToStaticMesh);
+
 	// This will only work in the editor..
 #if !WITH_EDITOR
 	UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Cannot run outside of editor"));
@@ -858,7 +1802,6 @@ bool UMeshGeometry::SaveToStaticMesh(
 		UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Cannot access name of Static Mesh"));
 		return false;
 	}
-	const FName StaticMeshName = FName(*StaticMeshAssetReference.ToString());
 
 	// Get the package name and asset name from the reference
 	const FString PackageName = StaticMeshAssetReference.GetLongPackageName();
@@ -873,137 +1816,22 @@ bool UMeshGeometry::SaveToStaticMesh(
 		);
 		return false;
 	}
-	// We now have the name
-	UE_LOG(
-		MDTLog, Warning, TEXT("SaveToStaticMesh: Static mesh packagename=%s, assetname=%s"),
-		*PackageName, *AssetName);
-
-	// Check that we're not trying to update this too often using timer.
-	// TODO: There should be a cleaner way to do this..
-	static TMap<FString, double> StartTimesByName = TMap<FString, double>();
-	const FString TimerName = StaticMeshAssetReference.ToString();
-	const double StartTime = FPlatformTime::Seconds();
-	const double RequiredTimeSinceLastBuild = 0.1f;	// In seconds.
-	const double MinimumLastRebuildTime = StartTime-RequiredTimeSinceLastBuild;
-	UE_LOG(
-		MDTLog, Warning, TEXT("SaveToStaticMesh: Building at time=%f"),
-		StartTime
-	);
-	if (StartTimesByName.Contains(TimerName) && StartTimesByName[TimerName]>MinimumLastRebuildTime)
-	{
-		UE_LOG(
-			MDTLog, Warning, TEXT("SaveToStaticMesh: Rebuilt too recently, cannot rebuild again yet")
-		);
-		return false;
-	}
-	StartTimesByName.Emplace(TimerName, StartTime);
-
-	// Save the object to the PMC
-	this->SaveToProceduralMeshComponent(ProceduralMeshComponent, true);
-
-	// Build the raw mesh data based on
-	// https://github.com/EpicGames/UnrealEngine/blob/f794321ffcad597c6232bc706304c0c9b4e154b2/Engine/Plugins/Runtime/ProceduralMeshComponent/Source/ProceduralMeshComponentEditor/Private/ProceduralMeshComponentDetails.cpp
-	FRawMesh RawMesh;
-	const int32 NumSections = ProceduralMeshComponent->GetNumSections();
-	int32 VertexBase = 0;
-	for (int32 SectionIdx = 0; SectionIdx<NumSections; SectionIdx++)
-	{
-		FProcMeshSection* ProcSection = ProceduralMeshComponent->GetProcMeshSection(SectionIdx);
-
-		// Copy verts
-		for (FProcMeshVertex& Vert:ProcSection->ProcVertexBuffer)
-		{
-			RawMesh.VertexPositions.Add(Vert.Position);
-		}
-
-		// Copy 'wedge' info
-		int32 NumIndices = ProcSection->ProcIndexBuffer.Num();
-		for (int32 IndexIdx = 0; IndexIdx<NumIndices; IndexIdx++)
-		{
-			int32 Index = ProcSection->ProcIndexBuffer[IndexIdx];
-
-			RawMesh.WedgeIndices.Add(Index+VertexBase);
-
-			FProcMeshVertex& ProcVertex = ProcSection->ProcVertexBuffer[Index];
-
-			FVector TangentX = ProcVertex.Tangent.TangentX;
-			FVector TangentZ = ProcVertex.Normal;
-			FVector TangentY = (TangentX ^ TangentZ).GetSafeNormal() * (ProcVertex.Tangent.bFlipTangentY ? -1.f : 1.f);
-
-			RawMesh.WedgeTangentX.Add(TangentX);
-			RawMesh.WedgeTangentY.Add(TangentY);
-			RawMesh.WedgeTangentZ.Add(TangentZ);
-
-			RawMesh.WedgeTexCoords[0].Add(ProcVertex.UV0);
-			RawMesh.WedgeColors.Add(ProcVertex.Color);
-		}
-
-		// copy face info
-		int32 NumTris = NumIndices/3;
-		for (int32 TriIdx = 0; TriIdx<NumTris; TriIdx++)
-		{
-			RawMesh.FaceMaterialIndices.Add(SectionIdx);
-			RawMesh.FaceSmoothingMasks.Add(0); // Assume this is ignored as bRecomputeNormals is false
-		}
-
-		// Update offset for creating one big index/vertex buffer
-		VertexBase += ProcSection->ProcVertexBuffer.Num();
-	}
-
-	UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Built RawData"));
 
-	//  Check we got valid data
-	if (RawMesh.VertexPositions.Num()<3||RawMesh.WedgeIndices.Num()<3)
+	//  Check we have valid data
+	if (GetTotalVertexCount()<3||TotalTriangleCount<1)
 	{
 		UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Mesh data not valid, need at least 3 vertices"));
 		return false;
 	}
 
-	// Create the static mesh resource
-	UPackage *Package = CreatePackage(nullptr, *PackageName);
-	UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Now have new package"));
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
 
-	UStaticMesh *NewStaticMesh = NewObject<UStaticMesh>(
-		Package, FName(*AssetName), RF_Public|RF_Standalone
-		);
-	//UStaticMesh *staticMesh = NewObject<UStaticMesh>(
-	//	package, staticMeshName, RF_Public|RF_Standalone
-	//	);
-	UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Now have new UStaticMesh"));
-	NewStaticMesh->InitResources();
-	NewStaticMesh->LightingGuid = FGuid::NewGuid();
-
-	UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Now have new SM"));
-
-	// Add the data to the static mesh
-	FStaticMeshSourceModel* SourceModel = new (NewStaticMesh->SourceModels) FStaticMeshSourceModel();
-	SourceModel->BuildSettings.bRecomputeNormals = false;
-	SourceModel->BuildSettings.bRecomputeTangents = false;
-	SourceModel->BuildSettings.bRemoveDegenerates = false;
-	SourceModel->BuildSettings.bUseHighPrecisionTangentBasis = false;
-	SourceModel->BuildSettings.bUseFullPrecisionUVs = false;
-	SourceModel->BuildSettings.bGenerateLightmapUVs = true;
-	SourceModel->BuildSettings.SrcLightmapIndex = 0;
-	SourceModel->BuildSettings.DstLightmapIndex = 1;
-	SourceModel->RawMeshBulkData->SaveRawMesh(RawMesh);
-	UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Added data to StaticMesh"));
-
-	// Copy materials
-	for (auto &material:Materials)
-	{
-		NewStaticMesh->StaticMaterials.Add(FStaticMaterial(material));
-	}
-
-	//Set the Imported version before calling the build
-	NewStaticMesh->ImportVersion = EImportStaticMeshVersion::LastVersion;
-
-	// Build mesh from source
-	NewStaticMesh->Build(false);
-	NewStaticMesh->PostEditChange();
-
-	// Notify asset registry of new asset
-	FAssetRegistryModule::AssetCreated(NewStaticMesh);
-	UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Asset created"));
+	// Hand a copy of the geometry to the queue, which merges repeated saves to the same mesh.
+	for (const FSectionGeometry &Section:this->Sections)
+	{
+		INC_DWORD_STAT_BY(STAT_MDTBytesCopied, GetUnsharedDataSize(Section));
+	}
+	FStaticMeshBuildQueue::Get().QueueBuild(PackageName, AssetName, this->Sections, Materials, OnBuilt);
 	return true;
 }
 
@@ -1012,25 +1840,18 @@ void UMeshGeometry::Scale(
 	FVector CenterOfScale /*= FVector::ZeroVector*/,
 	USelectionSet *Selection /*= nullptr*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Scale);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Scale")))
-	{
-		return;
-	}
-
-	// Iterate over the sections, and the the vertices in the sections.
-	int32 NextWeightIndex = 0;
-	for (auto &Section:this->Sections)
-	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			Vertex = FMath::Lerp(
-				Vertex,
-				CenterOfScale+(Vertex-CenterOfScale) * Scale3d,
-				Selection ? Selection->Weights[NextWeightIndex++] : 1.0f
-			);
-		}
+	{
+		return;
 	}
+
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// Scaling about a point is a single affine matrix.
+	ApplyMatrixUnchecked(Utility::MatrixAboutCenter(FScaleMatrix(Scale3d), CenterOfScale), Selection);
 }
 
 void UMeshGeometry::ScaleAlongAxis(
@@ -1039,6 +1860,8 @@ void UMeshGeometry::ScaleAlongAxis(
 	float Scale /*= 1.0f*/,
 	USelectionSet *Selection /*= nullptr*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_ScaleAlongAxis);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Jitter")))
 	{
@@ -1051,33 +1874,58 @@ void UMeshGeometry::ScaleAlongAxis(
 		return;
 	}
 
-	// Iterate over the sections, and the the vertices in the sections.
-	int32 NextWeightIndex = 0;
-	for (auto &Section:this->Sections)
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// Iterate over all of the vertices, in parallel for large meshes.
+	ForEachVertexRun(Selection, ESectionChanges::Positions, [&](FSectionGeometry &Section, int32 StartVertex, int32 Count, const float *Weights)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			FVector ClosestPointOnLine = FMath::ClosestPointOnInfiniteLine(CenterOfScale, CenterOfScale+Axis, Vertex);
-			FVector OffsetFromClosestPoint = Vertex-ClosestPointOnLine;
-			FVector ScaledPointOnLine = Scale * (ClosestPointOnLine-CenterOfScale)+CenterOfScale;
-			Vertex = FMath::Lerp(Vertex, ScaledPointOnLine+OffsetFromClosestPoint, Selection ? Selection->Weights[NextWeightIndex++] : 1.0f);
-		}
-	}
+		DeformationCore::ScaleAlongAxis(
+			ToCore(Section.Vertices.GetData()+StartVertex), Count, ToCore(CenterOfScale), ToCore(Axis), Scale, Weights
+		);
+	});
+}
+
+USelectionSet * UMeshGeometry::SelectAll()
+{
+	return SelectAllInto();
 }
 
-USelectionSet *UMeshGeometry::SelectAll()
+USelectionSet *UMeshGeometry::SelectAllInto(USelectionSet *Into /*= nullptr*/)
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectAll);
+
+	USelectionSet *NewSelectionSet = USelectionSet::CreateAndCheckValid(GetTotalVertexCount(), this, TEXT("SelectAll"), Into);
 	if (!NewSelectionSet)
 	{
-		UE_LOG(MDTLog, Error, TEXT("SelectAll: Cannot create new SelectionSet"));
+		return nullptr;
 	}
-	NewSelectionSet->CreateSelectionSet(this->GetTotalVertexCount());
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
 	NewSelectionSet->SetAllWeights(1.0f);
 	return NewSelectionSet;
 }
 
 USelectionSet * UMeshGeometry::SelectByNoise(
+	FTransform Transform,
+	int32 Seed /*= 1337*/,
+	float Frequency /*= 0.01*/,
+	ENoiseInterpolation NoiseInterpolation /*= ENoiseInterpolation::Quintic*/,
+	ENoiseType NoiseType /*= ENoiseType::Simplex*/,
+	uint8 FractalOctaves /*= 3*/,
+	float FractalLacunarity /*= 2.0*/,
+	float FractalGain /*= 0.5*/,
+	EFractalType FractalType /*= EFractalType::FBM*/,
+	ECellularDistanceFunction CellularDistanceFunction /*= ECellularDistanceFunction::Euclidian*/
+)
+{
+	return SelectByNoiseInto(
+		Transform,
+		Seed, Frequency, NoiseInterpolation, NoiseType,
+		FractalOctaves, FractalLacunarity, FractalGain, FractalType,
+		CellularDistanceFunction
+	);
+}
+
+USelectionSet * UMeshGeometry::SelectByNoiseInto(
 	FTransform Transform /* AutoCreateRefTerm */,
 	int32 Seed /*= 1337*/,
 	float Frequency /*= 0.01*/,
@@ -1087,15 +1935,19 @@ USelectionSet * UMeshGeometry::SelectByNoise(
 	float FractalLacunarity /*= 2.0*/,
 	float FractalGain /*= 0.5*/,
 	EFractalType FractalType /*= EFractalType::FBM*/,
-	ECellularDistanceFunction CellularDistanceFunction /*= ECellularDistanceFunction::Euclidian*/
+	ECellularDistanceFunction CellularDistanceFunction /*= ECellularDistanceFunction::Euclidian*/,
+	USelectionSet *Into /*= nullptr*/
 )
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectByNoise);
+
+	USelectionSet *NewSelectionSet = USelectionSet::CreateAndCheckValid(GetTotalVertexCount(), this, TEXT("SelectByNoise"), Into);
 	if (!NewSelectionSet)
 	{
-		UE_LOG(MDTLog, Error, TEXT("SelectAll: Cannot create new SelectionSet"));
+		return nullptr;
 	}
 
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
 
 	// Set up all of the noise details from the parameters provided
 	FastNoise Noise;
@@ -1112,14 +1964,14 @@ USelectionSet * UMeshGeometry::SelectByNoise(
 	///noise.SetPositionWarpAmp(PositionWarpAmp);
 
 	// Iterate over the sections, and the vertices in each section.
+	float *Weight = NewSelectionSet->GetMutableWeights().GetData();
 	for (auto &Section:this->Sections)
 	{
 		for (auto &Vertex:Section.Vertices)
 		{
 			// Apply the noise transform to the vertex and use the transformed vertex for the noise generation
 			const FVector TransformedVertex = Transform.TransformPosition(Vertex);
-			float NoiseValue = Noise.GetNoise(TransformedVertex.X, TransformedVertex.Y, TransformedVertex.Z);
-			NewSelectionSet->Weights.Emplace(NoiseValue);
+			*Weight++ = Noise.GetNoise(TransformedVertex.X, TransformedVertex.Y, TransformedVertex.Z);
 		}
 	}
 
@@ -1128,35 +1980,32 @@ USelectionSet * UMeshGeometry::SelectByNoise(
 
 USelectionSet * UMeshGeometry::SelectBySection(int32 SectionIndex)
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
-	if (!NewSelectionSet)
-	{
-		UE_LOG(MDTLog, Error, TEXT("SelectBySection: Cannot create new SelectionSet"));
-	}
+	return SelectBySectionInto(SectionIndex);
+}
 
-	// Iterate over the sections, and the vertices in each section
-	int32 CurrentSectionIndex = 0;
-	for (auto &Section:this->Sections)
+USelectionSet * UMeshGeometry::SelectBySectionInto(int32 SectionIndex, USelectionSet *Into /*= nullptr*/)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectBySection);
+
+	// Only the section's own run of weights is set, the rest are zero.
+	return SelectByRuns(Into, TEXT("SelectBySection"), true, [&](int32 RunSectionIndex, int32 StartVertex, int32 Count, float *Weights)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			// Add a new weight- 1.0 if section indices match, 0.0 otherwise.
-			NewSelectionSet->Weights.Emplace(SectionIndex==CurrentSectionIndex ? 1.0f : 0.0f);
-		}
-		// Increment the current section index, we've finished with this section
-		CurrentSectionIndex++;
-	}
+		DeformationCore::Set(RunSectionIndex==SectionIndex ? 1.0f : 0.0f, Count, Weights);
+	});
+}
 
-	return NewSelectionSet;
+USelectionSet * UMeshGeometry::SelectByTexture(
+	UTexture2D *Texture2D,
+	ETextureChannel TextureChannel /*= ETextureChannel::Red*/
+)
+{
+	return SelectByTextureInto(Texture2D, TextureChannel);
 }
 
-USelectionSet * UMeshGeometry::SelectByTexture(UTexture2D *Texture2D, ETextureChannel TextureChannel /*=ETextureChannel::Red*/)
+USelectionSet * UMeshGeometry::SelectByTextureInto(
+	UTexture2D *Texture2D, ETextureChannel TextureChannel /*=ETextureChannel::Red*/, USelectionSet *Into /*= nullptr*/)
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
-	if (!NewSelectionSet)
-	{
-		UE_LOG(MDTLog, Error, TEXT("SelectByTexture: Cannot create new SelectionSet"));
-	}
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectByTexture);
 
 	// Check we have a texture and that it's in the right format
 	if (!Texture2D)
@@ -1201,15 +2050,24 @@ USelectionSet * UMeshGeometry::SelectByTexture(UTexture2D *Texture2D, ETextureCh
 	}
 	UE_LOG(MDTLog, Log, TEXT("SelectByTexture: Texture LOCKED"));
 
+	USelectionSet *NewSelectionSet = USelectionSet::CreateAndCheckValid(GetTotalVertexCount(), this, TEXT("SelectByTexture"), Into);
+	if (!NewSelectionSet)
+	{
+		BulkData->Unlock();
+		return nullptr;
+	}
+
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
 
 	// Prepare arrays of colors and grayscale settings- we can use the correct one later
 	FColor *ColorArray = static_cast<FColor*>(LockedBulkData);
 	uint8 *GrayscaleArray = static_cast<uint8*>(LockedBulkData);
 
 	// Iterate over the sections, and the vertices in each section.
-	for (auto &Section:this->Sections)
+	float *Weight = NewSelectionSet->GetMutableWeights().GetData();
+	for (const FSectionGeometry &Section:this->Sections)
 	{
-		for (auto &UV:Section.UVs)
+		for (const FVector2D &UV:Section.GetUVs())
 		{
 			// Convert our UV to a texture index in pixels
 			int32 TextureX = (int32)FMath::RoundHalfFromZero(UV.X * TextureWidth);
@@ -1225,8 +2083,7 @@ USelectionSet * UMeshGeometry::SelectByTexture(UTexture2D *Texture2D, ETextureCh
 			// We now have things different based on grayscale vs color
 			if (Texture2D->GetPixelFormat() == PF_G8) {
 				// Grayscale- simple return ignoring texture channel
-				float weight = (float)GrayscaleArray[ArrayIndex] / 256.0f;
-				NewSelectionSet->Weights.Emplace(weight);
+				*Weight = (float)GrayscaleArray[ArrayIndex] / 256.0f;
 			}
 			else {
 				// Get the color and access the correct channel.
@@ -1235,19 +2092,20 @@ USelectionSet * UMeshGeometry::SelectByTexture(UTexture2D *Texture2D, ETextureCh
 				switch (TextureChannel)
 				{
 				case ETextureChannel::Red:
-					NewSelectionSet->Weights.Emplace(Color.R);
+					*Weight = Color.R;
 					break;
 				case ETextureChannel::Green:
-					NewSelectionSet->Weights.Emplace(Color.G);
+					*Weight = Color.G;
 					break;
 				case ETextureChannel::Blue:
-					NewSelectionSet->Weights.Emplace(Color.B);
+					*Weight = Color.B;
 					break;
 				case ETextureChannel::Alpha:
-					NewSelectionSet->Weights.Emplace(Color.A);
+					*Weight = Color.A;
 					break;
 				}
 			}
+			++Weight;
 		}
 	}
 
@@ -1259,16 +2117,30 @@ USelectionSet * UMeshGeometry::SelectByTexture(UTexture2D *Texture2D, ETextureCh
 }
 
 USelectionSet * UMeshGeometry::SelectByNormal(
+	FVector Facing /*= FVector::UpVector*/,
+	float InnerRadiusInDegrees /*= 0*/,
+	float OuterRadiusInDegrees /*= 30.0f*/
+)
+{
+	return SelectByNormalInto(Facing, InnerRadiusInDegrees, OuterRadiusInDegrees);
+}
+
+USelectionSet * UMeshGeometry::SelectByNormalInto(
 	FVector Normal /*= FVector::UpVector*/,
 	float InnerRadiusInDegrees /*= 0*/,
-	float OuterRadiusInDegrees /*= 30.0f*/)
+	float OuterRadiusInDegrees /*= 30.0f*/,
+	USelectionSet *Into /*= nullptr*/)
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectByNormal);
+
+	USelectionSet *NewSelectionSet = USelectionSet::CreateAndCheckValid(GetTotalVertexCount(), this, TEXT("SelectFacing"), Into);
 	if (!NewSelectionSet)
 	{
-		UE_LOG(MDTLog, Error, TEXT("SelectFacing: Cannot create new SelectionSet"));
+		return nullptr;
 	}
 
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Normalize the facing vector.
 	if (!Normal.Normalize())
 	{
@@ -1280,6 +2152,7 @@ USelectionSet * UMeshGeometry::SelectByNormal(
 	float SelectionRadius = OuterRadiusInDegrees-InnerRadiusInDegrees;
 
 	// Iterate over the sections, and the the normals in the sections.
+	float *Weight = NewSelectionSet->GetMutableWeights().GetData();
 	for (auto &Section:this->Sections)
 	{
 		for (auto VertexNormal:Section.Normals)
@@ -1289,14 +2162,14 @@ USelectionSet * UMeshGeometry::SelectByNormal(
 			if (NormalizedVertexNormal.IsNearlyZero(0.01f))
 			{
 				UE_LOG(MDTLog, Warning, TEXT("SelectFacing: Cannot normalize normal vector"));
-				NewSelectionSet->Weights.Emplace(0);
+				*Weight++ = 0.0f;
 			}
 			else
 			{
 				// Calculate the dot product between the normal and the Facing.
 				const float AngleToNormal = FMath::RadiansToDegrees(FMath::Acos(FVector::DotProduct(VertexNormal, Normal)));
 				const float AngleBias = 1.0f-FMath::Clamp((AngleToNormal-InnerRadiusInDegrees)/SelectionRadius, 0.0f, 1.0f);
-				NewSelectionSet->Weights.Emplace(AngleBias);
+				*Weight++ = AngleBias;
 			}
 		}
 	}
@@ -1307,76 +2180,54 @@ USelectionSet * UMeshGeometry::SelectByNormal(
 USelectionSet * UMeshGeometry::SelectByVertexRange(
 	int32 RangeStart,
 	int32 RangeEnd,
-	int32 RangeStep, /*= 1*/
-	int32 SectionIndex /* =0*/
+	int32 RangeStep /*= 1*/,
+	int32 SectionIndex /*= 0*/
 )
 {
+	return SelectByVertexRangeInto(RangeStart, RangeEnd, RangeStep, SectionIndex);
+}
 
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
-	if (!NewSelectionSet)
-	{
-		UE_LOG(MDTLog, Error, TEXT("SelectBySection: Cannot create new SelectionSet"));
-	}
+USelectionSet * UMeshGeometry::SelectByVertexRangeInto(
+	int32 RangeStart,
+	int32 RangeEnd,
+	int32 RangeStep, /*= 1*/
+	int32 SectionIndex, /* =0*/
+	USelectionSet *Into /*= nullptr*/
+)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectByVertexRange);
 
-	// Iterate over the sections, and the vertices in each section
-	int32 CurrentSectionIndex = 0;
-	for (auto &Section:this->Sections)
+	return SelectByRuns(Into, TEXT("SelectByVertexRange"), true, [&](int32 RunSectionIndex, int32 StartVertex, int32 Count, float *Weights)
 	{
-		int CurrentVertexIndex = 0;
-		for (auto &Vertex:Section.Vertices)
+		for (int32 VertexIndex = StartVertex; VertexIndex<StartVertex+Count; ++VertexIndex)
 		{
 			// Work out if this is part of the range or not.
-			bool bIsInRange =
-				(CurrentSectionIndex==SectionIndex)&&	// Right section
-				(CurrentVertexIndex>=RangeStart)&& // At or beyond start of range
-				(CurrentVertexIndex<=RangeEnd)&& // At or before end of range
-				((CurrentVertexIndex-RangeStart)%RangeStep==0); // Step is right
+			const bool bIsInRange =
+				(RunSectionIndex==SectionIndex)&&	// Right section
+				(VertexIndex>=RangeStart)&& // At or beyond start of range
+				(VertexIndex<=RangeEnd)&& // At or before end of range
+				((VertexIndex-RangeStart)%RangeStep==0); // Step is right
 
-			// Add a new weight- 1.0 if section indices match, 0.0 otherwise.
-			NewSelectionSet->Weights.Emplace(bIsInRange ? 1.0f : 0.0f);
-
-			// Increment the current vertex index, we've finished with this section
-			CurrentVertexIndex++;
+			*Weights++ = bIsInRange ? 1.0f : 0.0f;
 		}
-		// Increment the current section index, we've finished with this section
-		CurrentSectionIndex++;
-	}
-
-	return NewSelectionSet;
+	});
 }
 
-USelectionSet *UMeshGeometry::SelectInVolume(FVector CornerA, FVector CornerB)
+USelectionSet * UMeshGeometry::SelectInVolume(FVector CornerA, FVector CornerB)
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
-	if (!NewSelectionSet)
-	{
-		UE_LOG(MDTLog, Error, TEXT("SelectInVolume: Cannot create new SelectionSet"));
-	}
+	return SelectInVolumeInto(CornerA, CornerB);
+}
 
-	// Get the minimum/maximum of X, Y, and Z from the corner vectors so we can check
-	const float MinX = FMath::Min(CornerA.X, CornerB.X);
-	const float MaxX = FMath::Max(CornerA.X, CornerB.X);
-	const float MinY = FMath::Min(CornerA.Y, CornerB.Y);
-	const float MaxY = FMath::Max(CornerA.Y, CornerB.Y);
-	const float MinZ = FMath::Min(CornerA.Z, CornerB.Z);
-	const float MaxZ = FMath::Max(CornerA.Z, CornerB.Z);
+USelectionSet *UMeshGeometry::SelectInVolumeInto(FVector CornerA, FVector CornerB, USelectionSet *Into /*= nullptr*/)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectInVolume);
 
-	// Iterate over the sections, and the vertices in each section
-	for (auto &Section:this->Sections)
+	return SelectByRuns(Into, TEXT("SelectInVolume"), true, [&](int32 SectionIndex, int32 StartVertex, int32 Count, float *Weights)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			// We only need to know if the vertex is between min/max inclusive.
-			const bool bVertexInVolume =
-				(Vertex.X>=MinX)&&(Vertex.X<=MaxX)&&
-				(Vertex.Y>=MinY)&&(Vertex.Y<=MaxY)&&
-				(Vertex.Z>=MinZ)&&(Vertex.Z<=MaxZ);
-			// Add a new weighting based on whether it's insider or outside
-			NewSelectionSet->Weights.Emplace(bVertexInVolume ? 1.0f : 0.0f);
-		}
-	}
-
-	return NewSelectionSet;
+		DeformationCore::SelectInVolume(
+			ToCore(Sections[SectionIndex].Vertices.GetData()+StartVertex), Count, ToCore(CornerA), ToCore(CornerB), Weights
+		);
+	});
 }
 
 
@@ -1384,13 +2235,20 @@ USelectionSet * UMeshGeometry::SelectLinear(
 	FVector LineStart,
 	FVector LineEnd,
 	bool bReverse /*= false*/,
-	bool bLimitToLine /*= false*/)
+	bool bLimitToLine /*= false*/
+)
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
-	if (!NewSelectionSet)
-	{
-		UE_LOG(MDTLog, Error, TEXT("SelectLinear: Cannot create new SelectionSet"));
-	}
+	return SelectLinearInto(LineStart, LineEnd, bReverse, bLimitToLine);
+}
+
+USelectionSet * UMeshGeometry::SelectLinearInto(
+	FVector LineStart,
+	FVector LineEnd,
+	bool bReverse /*= false*/,
+	bool bLimitToLine /*= false*/,
+	USelectionSet *Into /*= nullptr*/)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectLinear);
 
 	// Do the reverse if needed..
 	if (bReverse)
@@ -1408,127 +2266,147 @@ USelectionSet * UMeshGeometry::SelectLinear(
 		return nullptr;
 	}
 
-	// Iterate over the sections, and the vertices in each section
-	for (auto &Section:this->Sections)
+	return SelectByRuns(Into, TEXT("SelectLinear"), false, [&](int32 SectionIndex, int32 StartVertex, int32 Count, float *Weights)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			// Get the nearest point on the line
-			const FVector NearestPointOnLine = FMath::ClosestPointOnLine(LineStart, LineEnd, Vertex);
-
-			// If we've hit one of the end points then return the limits
-			if (NearestPointOnLine==LineEnd)
-			{
-				NewSelectionSet->Weights.Emplace(bLimitToLine ? 0.0f : 1.0f);
-			}
-			else if (NearestPointOnLine==LineStart)
-			{
-				NewSelectionSet->Weights.Emplace(0.0f);
-			}
-			else
-			{
-				// Get the distance to the two start point- it's the ratio we're after.
-				float DistanceToLineStart = (NearestPointOnLine-LineStart).Size();
-				NewSelectionSet->Weights.Emplace(DistanceToLineStart/LineLength);
-			}
-		}
-	}
-
-	return NewSelectionSet;
+		DeformationCore::SelectLinear(
+			ToCore(Sections[SectionIndex].Vertices.GetData()+StartVertex), Count,
+			ToCore(LineStart), ToCore(LineEnd), bLimitToLine, Weights
+		);
+	});
 }
 
 USelectionSet * UMeshGeometry::SelectNear(
+	FVector Center /*= FVector::ZeroVector*/,
+	float InnerRadius /*= 0*/,
+	float OuterRadius /*= 100*/
+)
+{
+	return SelectNearInto(Center, InnerRadius, OuterRadius);
+}
+
+USelectionSet * UMeshGeometry::SelectNearInto(
 	FVector Center /*=FVector::ZeroVector*/,
 	float InnerRadius/*=0*/,
-	float OuterRadius/*=100*/)
+	float OuterRadius/*=100*/,
+	USelectionSet *Into /*= nullptr*/)
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
-	if (!NewSelectionSet)
-	{
-		UE_LOG(MDTLog, Error, TEXT("SelectNear: Cannot create new SelectionSet"));
-	}
-
-	// Calculate the selection radius- we need it for falloff
-	const float SelectionRadius = OuterRadius-InnerRadius;
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectNear);
 
-	// Iterate over the sections, and the vertices in each section.
-	for (auto &Section:this->Sections)
+	return SelectByRuns(Into, TEXT("SelectNear"), false, [&](int32 SectionIndex, int32 StartVertex, int32 Count, float *Weights)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			const float DistanceFromCenter = (Vertex-Center).Size();
-			// Apply bias to map distance to 0-1 based on innerRadius and outerRadius
-			const float DistanceBias = 1.0f-FMath::Clamp((DistanceFromCenter-InnerRadius)/SelectionRadius, 0.0f, 1.0f);
-			NewSelectionSet->Weights.Emplace(DistanceBias);
-		}
-	}
-
-	return NewSelectionSet;
+		DeformationCore::SelectNear(
+			ToCore(Sections[SectionIndex].Vertices.GetData()+StartVertex), Count, ToCore(Center), InnerRadius, OuterRadius, Weights
+		);
+	});
 }
 
 USelectionSet * UMeshGeometry::SelectNearLine(
+	FVector LineStart,
+	FVector LineEnd,
+	float InnerRadius /*= 0*/,
+	float OuterRadius /*= 100*/,
+	bool bLineIsInfinite /*= false*/
+)
+{
+	return SelectNearLineInto(LineStart, LineEnd, InnerRadius, OuterRadius, bLineIsInfinite);
+}
+
+USelectionSet * UMeshGeometry::SelectNearLineInto(
 	FVector LineStart,
 	FVector LineEnd,
 	float InnerRadius /*=0*/,
 	float OuterRadius/*= 100*/,
-	bool bLineIsInfinite/* = false */)
+	bool bLineIsInfinite/* = false */,
+	USelectionSet *Into /*= nullptr*/)
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
-	if (!NewSelectionSet)
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectNearLine);
+
+	return SelectByRuns(Into, TEXT("SelectNearLine"), false, [&](int32 SectionIndex, int32 StartVertex, int32 Count, float *Weights)
 	{
-		UE_LOG(MDTLog, Error, TEXT("SelectNearLine: Cannot create new SelectionSet"));
-	}
+		DeformationCore::SelectNearLine(
+			ToCore(Sections[SectionIndex].Vertices.GetData()+StartVertex), Count,
+			ToCore(LineStart), ToCore(LineEnd), InnerRadius, OuterRadius, bLineIsInfinite, Weights
+		);
+	});
+}
 
-	// Calculate the selection radius- we need it for falloff
-	const float SelectionRadius = OuterRadius-InnerRadius;
+USelectionSet * UMeshGeometry::SelectNearSpline(
+	USplineComponent *Spline,
+	FTransform Transform,
+	float InnerRadius /*= 0*/,
+	float OuterRadius /*= 100*/
+)
+{
+	return SelectNearSplineInto(Spline, Transform, InnerRadius, OuterRadius);
+}
 
-	// Iterate over the sections, and the vertices in each section.
-	for (auto &Section:this->Sections)
+USelectionSet * UMeshGeometry::SelectNearSplineInto(
+	USplineComponent *Spline,
+	FTransform Transform,
+	float InnerRadius /*= 0*/,
+	float OuterRadius /*= 100*/,
+	USelectionSet *Into /*= nullptr*/)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectNearSpline);
+
+	if (!Spline)
 	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			// Get the distance from the line based on whether we're looking at an infinite line or not.
-			const FVector NearestPointOnLine = bLineIsInfinite ?
-				FMath::ClosestPointOnInfiniteLine(LineStart, LineEnd, Vertex) :
-				FMath::ClosestPointOnLine(LineStart, LineEnd, Vertex);
+		UE_LOG(MDTLog, Error, TEXT("SelectNearSpline: No spline provided"));
+		return nullptr;
+	}
 
-			// Apply bias to map distance to 0-1 based on innerRadius and outerRadius
-			const float DistanceToLine = (Vertex-NearestPointOnLine).Size();
-			const float DistanceBias = 1.0f-FMath::Clamp((DistanceToLine-InnerRadius)/SelectionRadius, 0.0f, 1.0f);
-			NewSelectionSet->Weights.Emplace(DistanceBias);
-		}
+	USelectionSet *NewSelectionSet = USelectionSet::CreateAndCheckValid(GetTotalVertexCount(), this, TEXT("SelectNearSpline"), Into);
+	if (!NewSelectionSet)
+	{
+		return nullptr;
 	}
 
+	SelectNearSplineRange(NewSelectionSet, Spline, Transform, InnerRadius, OuterRadius, 0, GetTotalVertexCount());
 	return NewSelectionSet;
 }
 
-USelectionSet * UMeshGeometry::SelectNearSpline(
+void UMeshGeometry::SelectNearSplineRange(
+	USelectionSet *Selection,
 	USplineComponent *Spline,
 	FTransform Transform,
-	float InnerRadius /*= 0*/,
-	float OuterRadius /*= 100*/)
+	float InnerRadius,
+	float OuterRadius,
+	int32 StartVertex,
+	int32 EndVertex) const
 {
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(this);
-	if (!NewSelectionSet)
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_SelectNearSplineRange);
+
+	if (!Spline)
 	{
-		UE_LOG(MDTLog, Error, TEXT("SelectNearSpline: Cannot create new SelectionSet"));
-		return nullptr;
+		UE_LOG(MDTLog, Error, TEXT("SelectNearSplineRange: No spline provided"));
+		return;
 	}
 
-	if (!Spline)
+	if (!SelectionSetIsRightSize(Selection, TEXT("SelectNearSplineRange")))
 	{
-		UE_LOG(MDTLog, Error, TEXT("SelectNearSpline: No spline provided"));
-		return nullptr;
+		return;
 	}
+	TArray<float> &Weights = Selection->GetMutableWeights();
+
+	StartVertex = FMath::Max(StartVertex, 0);
+	EndVertex = FMath::Min(EndVertex, GetTotalVertexCount());
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, FMath::Max(EndVertex-StartVertex, 0));
 
 	// Calculate the selection radius- we need it for falloff
 	const float SelectionRadius = OuterRadius-InnerRadius;
 
-	// Iterate over the sections, and the vertices in each section.
-	for (auto &Section:this->Sections)
+	// Iterate over the sections which overlap the range, and the vertices in them.
+	for (int32 SectionIndex = 0; SectionIndex<Sections.Num(); ++SectionIndex)
 	{
-		for (auto &Vertex:Section.Vertices)
+		const int32 SectionStart = SectionVertexOffsets[SectionIndex];
+		const int32 FirstVertex = FMath::Max(StartVertex, SectionStart)-SectionStart;
+		const int32 LastVertex = FMath::Min(EndVertex, SectionVertexOffsets[SectionIndex+1])-SectionStart;
+
+		const TArray<FVector> &Vertices = Sections[SectionIndex].Vertices;
+		for (int32 VertexIndex = FirstVertex; VertexIndex<LastVertex; ++VertexIndex)
 		{
+			const FVector &Vertex = Vertices[VertexIndex];
+
 			// Convert the vertex location to local space- and then get the nearest point on the spline in local space.
 			const FVector ClosestPointOnSpline = Spline->FindLocationClosestToWorldLocation(
 				Transform.TransformPosition(Vertex),
@@ -1537,14 +2415,12 @@ USelectionSet * UMeshGeometry::SelectNearSpline(
 			const float DistanceFromSpline = (Vertex-ClosestPointOnSpline).Size();
 			// Apply bias to map distance to 0-1 based on innerRadius and outerRadius
 			const float DistanceBias = 1.0f-FMath::Clamp((DistanceFromSpline-InnerRadius)/SelectionRadius, 0.0f, 1.0f);
-			NewSelectionSet->Weights.Emplace(DistanceBias);
+			Weights[SectionStart+VertexIndex] = DistanceBias;
 		}
 	}
-
-	return NewSelectionSet;
 }
 
-float UMeshGeometry::MiniumProjectionPlaneDistance(FVector Projection)
+float UMeshGeometry::MiniumProjectionPlaneDistance(FVector Projection) const
 {
 	// The projection needs to be normalized to act as plane
 	Projection = Projection.GetSafeNormal();
@@ -1552,15 +2428,24 @@ float UMeshGeometry::MiniumProjectionPlaneDistance(FVector Projection)
 		return 0;
 	}
 
-	// Get the radius and store it- we don't want to keep getting it
-	const float Radius = GetRadius();
+	// Throw away the cached distances if the geometry has changed, otherwise see if we've
+	// already done this direction.
+	if (ProjectionPlaneDistanceGeneration!=Generation)
+	{
+		CachedProjectionPlaneDistances.Reset();
+		ProjectionPlaneDistanceGeneration = Generation;
+	}
+	else if (const float *CachedDistance = CachedProjectionPlaneDistances.Find(Projection))
+	{
+		return *CachedDistance;
+	}
 
 	// Iterate over the sections, and the vertices in each section.
-	float FurthestPlane;
+	float FurthestPlane = 0.0f;
 	bool bHaveProcessedFirstVertex = false;
-	for (auto &Section : this->Sections)
+	for (const FSectionGeometry &Section : this->Sections)
 	{
-		for (auto &Vertex : Section.Vertices)
+		for (const FVector &Vertex : Section.Vertices)
 		{
 			// Get the nearest point from the origin to a plane with the
 			// supplied projection and passing through the vector.
@@ -1568,8 +2453,7 @@ float UMeshGeometry::MiniumProjectionPlaneDistance(FVector Projection)
 				Utility::NearestPointOnPlane(FVector::ZeroVector, Vertex, Projection);
 
 			// Check we're on the correct side of the plane
-			const FPlane Plane = FPlane(NearestPointOnVertexPlane, -Projection);
-			const bool bDotTestForPlaneSide = FVector::DotProduct(Vertex.GetSafeNormal(), -Projection.GetSafeNormal()) >=0;
+			const bool bDotTestForPlaneSide = FVector::DotProduct(Vertex.GetSafeNormal(), -Projection) >=0;
 			const float DistanceFromVertexToPlane = NearestPointOnVertexPlane.Size() * (bDotTestForPlaneSide ? 1 : -1);
 
 			// Update furthestPlane info
@@ -1580,22 +2464,29 @@ float UMeshGeometry::MiniumProjectionPlaneDistance(FVector Projection)
 			bHaveProcessedFirstVertex = true;
 		}
 	}
+
+	CachedProjectionPlaneDistances.Add(Projection, FurthestPlane);
 	return FurthestPlane;
 }
 
 void UMeshGeometry::RebuildNormals()
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_RebuildNormals);
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
 	// Iterate over the sections
 	for (auto &Section : this->Sections)
 	{
 		UKismetProceduralMeshLibrary::CalculateTangentsForMesh(
-			Section.Vertices, Section.Triangles, Section.UVs,	// These are inputs
-			Section.Normals, Section.Tangents					// These are outputs
+			Section.Vertices, Section.GetTriangles(), Section.GetUVs(),	// These are inputs
+			Section.Normals, Section.GetMutableTangents(false)			// These are outputs
 		);
 	}
+
+	MarkGeometryChanged(ESectionChanges::Normals|ESectionChanges::Tangents);
 }
 
-bool UMeshGeometry::SelectionSetIsRightSize(USelectionSet *Selection, FString NodeNameForWarning) const
+bool UMeshGeometry::SelectionSetIsRightSize(USelectionSet *Selection, const TCHAR *NodeNameForWarning) const
 {
 	// No selection set is fine...
 	if (!Selection)
@@ -1612,7 +2503,7 @@ bool UMeshGeometry::SelectionSetIsRightSize(USelectionSet *Selection, FString No
 	{
 		UE_LOG(
 			MDTLog, Warning, TEXT("%s: Selection set is the wrong size, %d weights in set for %d vertices in mesh"),
-			*NodeNameForWarning, SelectionSetSize, GeometrySize
+			NodeNameForWarning, SelectionSetSize, GeometrySize
 		);
 		return false;
 	}
@@ -1625,30 +2516,23 @@ void UMeshGeometry::Spherize(
 	FVector SphereCenter /*= FVector::ZeroVector*/,
 	USelectionSet *Selection)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Spherize);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Spherize")))
 	{
 		return;
 	}
 
-	// Iterate over the sections, and the the vertices in the sections.
-	int32 NextWeightIndex = 0;
-	for (auto &Section:this->Sections)
-	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			const FVector VertexRelativeToCenter = Vertex-SphereCenter;
-
-			// Calculate the required length- incorporating both the SphereRadius and Selection.
-			const float TargetVectorLength = FMath::Lerp(
-				VertexRelativeToCenter.Size(),
-				SphereRadius,
-				FilterStrength * (Selection ? Selection->Weights[NextWeightIndex++] : 1.0f)
-			);
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
 
-			Vertex = SphereCenter+(VertexRelativeToCenter.GetSafeNormal() * TargetVectorLength);
-		}
-	}
+	// Iterate over all of the vertices, in parallel for large meshes.
+	ForEachVertexRun(Selection, ESectionChanges::Positions, [&](FSectionGeometry &Section, int32 StartVertex, int32 Count, const float *Weights)
+	{
+		DeformationCore::Spherize(
+			ToCore(Section.Vertices.GetData()+StartVertex), Count, ToCore(SphereCenter), SphereRadius, FilterStrength, Weights
+		);
+	});
 }
 
 void UMeshGeometry::Transform(
@@ -1656,40 +2540,54 @@ void UMeshGeometry::Transform(
 	FVector CenterOfTransform /*= FVector::ZeroVector*/,
 	USelectionSet *Selection /*= nullptr*/)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Transform);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Transform")))
 	{
 		return;
 	}
 
-	// Iterate over the sections, and the the vertices in the sections.
-	int32 NextWeightIndex = 0;
-	for (auto &Section:this->Sections)
-	{
-		for (auto &Vertex:Section.Vertices)
-		{
-			Vertex = FMath::Lerp(
-				Vertex,
-				CenterOfTransform+Transform.TransformPosition(Vertex-CenterOfTransform),
-				Selection ? Selection->Weights[NextWeightIndex++] : 1.0f
-			);
-		}
-	}
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	// Convert to a matrix about the center, this keeps the Scale/Rotate/Translate order.
+	ApplyMatrixUnchecked(Utility::MatrixAboutCenter(Transform.ToMatrixWithScale(), CenterOfTransform), Selection);
 }
 
 void UMeshGeometry::TransformUV(FTransform Transform, FVector2D CenterOfTransform /*= FVector::ZeroVector*/, USelectionSet *Selection /*= nullptr */)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_TransformUV);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("TransformUV")))
 	{
 		return;
 	}
+
+	// Leave the UVs shared if nothing would change.
+	if (Transform.Equals(FTransform::Identity, 0.0f))
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
 	
 	// Iterate over the sections, and the the vertices in the sections.
 	int32 NextWeightIndex = 0;
+	bool bAnyChanged = false;
 	for (auto &Section:this->Sections)
 	{
-		for (auto &UV:Section.UVs)
+		// Sections outside the selection keep sharing their UVs.
+		const int32 SectionUVCount = Section.GetUVs().Num();
+		if (!HasAnyWeight(Selection, NextWeightIndex, SectionUVCount))
+		{
+			NextWeightIndex += SectionUVCount;
+			continue;
+		}
+		SectionChanges[(int32)(&Section-this->Sections.GetData())] |= ESectionChanges::UVs;
+		bAnyChanged = true;
+
+		for (auto &UV:Section.GetMutableUVs())
 		{
 			// Convert to FVectors to allow us to use FTransform on them
 			const FVector UVAsVector = FVector(UV.X, UV.Y, 0);
@@ -1700,34 +2598,32 @@ void UMeshGeometry::TransformUV(FTransform Transform, FVector2D CenterOfTransfor
 				CenterOfTransformAsVector+Transform.TransformPosition(
 					UVAsVector-CenterOfTransformAsVector
 				),
-				Selection ? Selection->Weights[NextWeightIndex++] : 1.0f
+				Selection ? Selection->GetWeight(NextWeightIndex++) : 1.0f
 			);
 			
 			// Cast back to Vector2D
 			UV = FVector2D(TransformedUVAsVector.X, TransformedUVAsVector.Y);
 		}
 	}
+
+	if (bAnyChanged)
+	{
+		// The sections are already marked, this just bumps the generation.
+		MarkGeometryChanged(ESectionChanges::None);
+	}
 }
 
 void UMeshGeometry::Translate(FVector Delta, USelectionSet *Selection)
 {
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_Translate);
+
 	// Check selectionSet size- log and abort if there's a problem. 
 	if (!SelectionSetIsRightSize(Selection, TEXT("Translate")))
 	{
 		return;
 	}
 
-	// Iterate over the sections, and the the vertices in the sections.
-	int32 nextSelectionIndex = 0;
-	for (auto &section:this->Sections)
-	{
-		for (auto &vertex:section.Vertices)
-		{
-			vertex = FMath::Lerp(
-				vertex,
-				vertex+Delta,
-				Selection ? Selection->Weights[nextSelectionIndex++] : 1.0f
-			);
-		}
-	}
+	INC_DWORD_STAT_BY(STAT_MDTVerticesProcessed, GetTotalVertexCount());
+
+	ApplyMatrixUnchecked(FTranslationMatrix(Delta), Selection);
 }
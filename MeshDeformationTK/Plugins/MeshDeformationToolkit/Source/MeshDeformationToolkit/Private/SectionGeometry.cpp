@@ -0,0 +1,113 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+
+#include "SectionGeometry.h"
+
+template <typename ElementType>
+TArray<ElementType> &FSectionGeometry::UnshareAttribute(
+	TArray<ElementType> &OwnArray,
+	TArray<ElementType> FSectionSharedAttributes::*SharedArray,
+	ESectionAttributes Attribute,
+	bool bKeepContents
+)
+{
+	if (!AreAttributesShared(Attribute))
+	{
+		return OwnArray;
+	}
+
+	if (bKeepContents)
+	{
+		if (SharedAttributes.IsUnique())
+		{
+			// Nobody else can see the buffer, so take the data rather than copying it.
+			FSectionSharedAttributes &UniqueSharedAttributes =
+				const_cast<FSectionSharedAttributes &>(*SharedAttributes);
+			OwnArray = MoveTemp(UniqueSharedAttributes.*SharedArray);
+		}
+		else
+		{
+			OwnArray = (*SharedAttributes).*SharedArray;
+		}
+	}
+	else
+	{
+		OwnArray.Reset();
+	}
+
+	// Drop the buffer once we're not using any of it.
+	SharedAttributeFlags &= ~Attribute;
+	if (SharedAttributeFlags==ESectionAttributes::None)
+	{
+		SharedAttributes.Reset();
+	}
+	return OwnArray;
+}
+
+void FSectionGeometry::ShareAttributes()
+{
+	// Nothing to do if everything's already shared.
+	if (SharedAttributeFlags==ESectionAttributes::All)
+	{
+		return;
+	}
+
+	// Build the new buffer from our own arrays, which we can move, and anything that's still in
+	// the old shared buffer.  That has to be copied unless we're the only section using it.
+	TSharedRef<FSectionSharedAttributes, ESPMode::ThreadSafe> NewSharedAttributes =
+		MakeShared<FSectionSharedAttributes, ESPMode::ThreadSafe>();
+	NewSharedAttributes->Triangles = MoveTemp(GetMutableTriangles());
+	NewSharedAttributes->UVs = MoveTemp(GetMutableUVs());
+	NewSharedAttributes->Tangents = MoveTemp(GetMutableTangents());
+	NewSharedAttributes->VertexColors = MoveTemp(GetMutableVertexColors());
+
+	SharedAttributes = NewSharedAttributes;
+	SharedAttributeFlags = ESectionAttributes::All;
+}
+
+void FSectionGeometry::UnshareAttributes()
+{
+	GetMutableTriangles();
+	GetMutableUVs();
+	GetMutableTangents();
+	GetMutableVertexColors();
+}
+
+ESectionAttributes FSectionGeometry::ShareAttributesWith(const FSectionGeometry &SourceSection)
+{
+	check(SourceSection.SharedAttributeFlags==ESectionAttributes::All);
+
+	// Anything we've taken our own copy of, or everything if we share a different buffer.
+	const ESectionAttributes ChangedAttributes = SharedAttributes==SourceSection.SharedAttributes ?
+		ESectionAttributes::All & ~SharedAttributeFlags : ESectionAttributes::All;
+
+	Triangles.Reset();
+	UVs.Reset();
+	Tangents.Reset();
+	VertexColors.Reset();
+
+	SharedAttributes = SourceSection.SharedAttributes;
+	SharedAttributeFlags = ESectionAttributes::All;
+	return ChangedAttributes;
+}
+
+TArray<int32> &FSectionGeometry::GetMutableTriangles(bool bKeepContents /*= true*/)
+{
+	return UnshareAttribute(Triangles, &FSectionSharedAttributes::Triangles, ESectionAttributes::Triangles, bKeepContents);
+}
+
+TArray<FVector2D> &FSectionGeometry::GetMutableUVs(bool bKeepContents /*= true*/)
+{
+	return UnshareAttribute(UVs, &FSectionSharedAttributes::UVs, ESectionAttributes::UVs, bKeepContents);
+}
+
+TArray<FProcMeshTangent> &FSectionGeometry::GetMutableTangents(bool bKeepContents /*= true*/)
+{
+	return UnshareAttribute(Tangents, &FSectionSharedAttributes::Tangents, ESectionAttributes::Tangents, bKeepContents);
+}
+
+TArray<FLinearColor> &FSectionGeometry::GetMutableVertexColors(bool bKeepContents /*= true*/)
+{
+	return UnshareAttribute(VertexColors, &FSectionSharedAttributes::VertexColors, ESectionAttributes::VertexColors, bKeepContents);
+}
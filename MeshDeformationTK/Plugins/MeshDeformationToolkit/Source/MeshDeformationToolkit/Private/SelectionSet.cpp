@@ -1,13 +1,334 @@
 // (c)2017 Paul Golds, released under MIT License.
 
 #include "MeshDeformationToolkit.h"
+#include "Algo/BinarySearch.h"
+#include "DeformationCore.h"
+#include "HAL/IConsoleManager.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "SelectionSet.h"
 
-USelectionSet * USelectionSet::CreateAndCheckValid(int32 RequiredSize, UObject *OuterObject, FString NodeNameForWarning)
+DECLARE_CYCLE_STAT(TEXT("EvaluateSelectionExpression"), STAT_MDT_EvaluateSelectionExpression, STATGROUP_MeshDeformationToolkit);
+DECLARE_DWORD_COUNTER_STAT(TEXT("SelectionSet weights reused"), STAT_MDTSelectionSetWeightsReused, STATGROUP_MeshDeformationToolkit);
+
+static TAutoConsoleVariable<float> CVarSparseSelectionDensity(
+	TEXT("mdt.SparseSelectionDensity"),
+	0.25f,
+	TEXT("The largest proportion of non-zero weights a SelectionSet is kept sparse with, storing only\n")
+	TEXT("those weights and their indices.  0 stores every SelectionSet in full."),
+	ECVF_Default);
+
+const int32 USelectionSet::WeightBlockSize;
+static_assert(USelectionSet::WeightBlockSize%32==0, "Blocks of weights must start on a mask word");
+
+namespace
+{
+	/// The most buffers of each size the pool keeps, which covers a few sets being created
+	/// and destroyed each frame for every mesh size in use.
+	const int32 MaxPooledBuffersPerSize = 8;
+
+	/// The most memory the pool keeps hold of
+	const SIZE_T MaxPooledBytes = 64*1024*1024;
+
+	/// Weight buffers from destroyed SelectionSets, by the number of weights they held.
+	/// Meshes keep their vertex counts, so a buffer is almost always reused at the same size.
+	struct FWeightPool
+	{
+		FCriticalSection Lock;
+		TMap<int32, TArray<TArray<float>>> BuffersBySize;
+		SIZE_T PooledBytes = 0;
+	};
+
+	FWeightPool &GetWeightPool()
+	{
+		static FWeightPool WeightPool;
+		return WeightPool;
+	}
+
+	/// Take a buffer able to hold *Size* weights from the pool, returning whether there was one
+	bool TakePooledWeights(int32 Size, TArray<float> &Weights)
+	{
+		FWeightPool &WeightPool = GetWeightPool();
+		FScopeLock ScopeLock(&WeightPool.Lock);
+
+		TArray<TArray<float>> *Buffers = WeightPool.BuffersBySize.Find(Size);
+		if (!Buffers || Buffers->Num()==0)
+		{
+			return false;
+		}
+		Weights = Buffers->Pop(false);
+		WeightPool.PooledBytes -= Weights.GetAllocatedSize();
+		INC_DWORD_STAT(STAT_MDTSelectionSetWeightsReused);
+		return true;
+	}
+
+	/// Put a buffer in the pool, or free it if the pool is full
+	void PoolWeights(TArray<float> &&Weights)
+	{
+		const int32 Size = Weights.Num();
+		const SIZE_T Bytes = Weights.GetAllocatedSize();
+		if (Size==0)
+		{
+			return;
+		}
+
+		FWeightPool &WeightPool = GetWeightPool();
+		FScopeLock ScopeLock(&WeightPool.Lock);
+
+		TArray<TArray<float>> &Buffers = WeightPool.BuffersBySize.FindOrAdd(Size);
+		if (Buffers.Num()>=MaxPooledBuffersPerSize || WeightPool.PooledBytes+Bytes>MaxPooledBytes)
+		{
+			return;
+		}
+		Buffers.Add(MoveTemp(Weights));
+		WeightPool.PooledBytes += Bytes;
+	}
+
+	/// The number of weights evaluated at a time.  Each node of an expression is applied to a
+	/// whole block before moving on to the next node, so the intermediate results stay in cache
+	/// and the DeformationCore loops can be vectorized.
+	const int32 ExpressionBlockSize = USelectionSet::WeightBlockSize;
+
+	/// The blocks of scratch space evaluating an expression needs.  The first input of each node
+	/// is evaluated straight into its output, and each further input into its own block.
+	int32 GetScratchBlockCount(const FSelectionExpression &Expression)
+	{
+		int32 BlockCount = 0;
+		for (int32 InputIndex = 0; InputIndex<Expression.Inputs.Num(); ++InputIndex)
+		{
+			BlockCount = FMath::Max(BlockCount, InputIndex+GetScratchBlockCount(*Expression.Inputs[InputIndex]));
+		}
+		return BlockCount;
+	}
+
+	/// Apply an easing function to each weight
+	template <typename EaseFunctionType>
+	void EaseWeights(const float *A, int32 Count, float *Out, EaseFunctionType EaseFunction)
+	{
+		for (int32 WeightIndex = 0; WeightIndex<Count; ++WeightIndex)
+		{
+			Out[WeightIndex] = EaseFunction(A[WeightIndex]);
+		}
+	}
+
+	void Ease(const float *A, EEasingFunc::Type EaseFunction, int32 Steps, float BlendExp, int32 Count, float *Out)
+	{
+		switch (EaseFunction)
+		{
+			case EEasingFunc::Step:
+				EaseWeights(A, Count, Out, [=](float Weight) { return FMath::InterpStep<float>(0.f, 1.f, Weight, Steps); });
+				break;
+			case EEasingFunc::SinusoidalIn:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpSinIn<float>(0.f, 1.f, Weight); });
+				break;
+			case EEasingFunc::SinusoidalOut:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpSinOut<float>(0.f, 1.f, Weight); });
+				break;
+			case EEasingFunc::SinusoidalInOut:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpSinInOut<float>(0.f, 1.f, Weight); });
+				break;
+			case EEasingFunc::EaseIn:
+				EaseWeights(A, Count, Out, [=](float Weight) { return FMath::InterpEaseIn<float>(0.f, 1.f, Weight, BlendExp); });
+				break;
+			case EEasingFunc::EaseOut:
+				EaseWeights(A, Count, Out, [=](float Weight) { return FMath::InterpEaseOut<float>(0.f, 1.f, Weight, BlendExp); });
+				break;
+			case EEasingFunc::EaseInOut:
+				EaseWeights(A, Count, Out, [=](float Weight) { return FMath::InterpEaseInOut<float>(0.f, 1.f, Weight, BlendExp); });
+				break;
+			case EEasingFunc::ExpoIn:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpExpoIn<float>(0.f, 1.f, Weight); });
+				break;
+			case EEasingFunc::ExpoOut:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpExpoOut<float>(0.f, 1.f, Weight); });
+				break;
+			case EEasingFunc::ExpoInOut:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpExpoInOut<float>(0.f, 1.f, Weight); });
+				break;
+			case EEasingFunc::CircularIn:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpCircularIn<float>(0.f, 1.f, Weight); });
+				break;
+			case EEasingFunc::CircularOut:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpCircularOut<float>(0.f, 1.f, Weight); });
+				break;
+			case EEasingFunc::CircularInOut:
+				EaseWeights(A, Count, Out, [](float Weight) { return FMath::InterpCircularInOut<float>(0.f, 1.f, Weight); });
+				break;
+			default:
+				// Do nothing: linear.
+				if (Out!=A)
+				{
+					FMemory::Memcpy(Out, A, Count*sizeof(float));
+				}
+				break;
+		}
+	}
+
+	void EvaluateBlock(const FSelectionExpression &Expression, int32 Start, int32 Count, float *Out, float *Scratch);
+
+	/// Evaluate one of a node's inputs, returning where its weights are.  SelectionSets are read
+	/// where they are, anything else, including sparse SelectionSets and masks, is evaluated
+	/// into *Buffer*.
+	const float *EvaluateInput(const FSelectionExpression &Input, int32 Start, int32 Count, float *Buffer, float *Scratch)
+	{
+		if (Input.Operator==ESelectionExpressionOperator::Weights && !Input.Source->IsSparse() && !Input.Source->IsMask())
+		{
+			return Input.Source->GetWeights().GetData()+Start;
+		}
+
+		EvaluateBlock(Input, Start, Count, Buffer, Scratch);
+		return Buffer;
+	}
+
+	/// Evaluate a block of weights from an expression
+	///
+	/// \param Expression		The expression to evaluate
+	/// \param Start			The index of the first weight in the block
+	/// \param Count			The number of weights in the block, at most *ExpressionBlockSize*
+	/// \param Out				Where to write the weights
+	/// \param Scratch			Space for the inputs, see *GetScratchBlockCount*
+	void EvaluateBlock(const FSelectionExpression &Expression, int32 Start, int32 Count, float *Out, float *Scratch)
+	{
+		const int32 InputCount = Expression.Inputs.Num();
+		const float *A = InputCount>0 ? EvaluateInput(*Expression.Inputs[0], Start, Count, Out, Scratch) : nullptr;
+		const float *B = InputCount>1 ?
+			EvaluateInput(*Expression.Inputs[1], Start, Count, Scratch, Scratch+ExpressionBlockSize) : nullptr;
+		const float *C = InputCount>2 ?
+			EvaluateInput(*Expression.Inputs[2], Start, Count, Scratch+ExpressionBlockSize, Scratch+2*ExpressionBlockSize) : nullptr;
+
+		const float ScalarA = Expression.ScalarA;
+		const float ScalarB = Expression.ScalarB;
+		switch (Expression.Operator)
+		{
+			case ESelectionExpressionOperator::Weights:
+				Expression.Source->CopyWeights(Start, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Set:
+				DeformationCore::Set(ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::AddScalar:
+				DeformationCore::AddScalar(A, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::SubtractScalar:
+				DeformationCore::SubtractScalar(A, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::SubtractFromScalar:
+				DeformationCore::SubtractFromScalar(ScalarA, A, Count, Out);
+				break;
+			case ESelectionExpressionOperator::MultiplyScalar:
+				DeformationCore::MultiplyScalar(A, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::DivideByScalar:
+				DeformationCore::DivideByScalar(A, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::DivideScalarBy:
+				DeformationCore::DivideScalarBy(ScalarA, A, Count, Out);
+				break;
+			case ESelectionExpressionOperator::MinScalar:
+				DeformationCore::MinScalar(A, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::MaxScalar:
+				DeformationCore::MaxScalar(A, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Clamp:
+				DeformationCore::Clamp(A, ScalarA, ScalarB, Count, Out);
+				break;
+			case ESelectionExpressionOperator::LerpToScalar:
+				DeformationCore::LerpToScalar(A, ScalarA, ScalarB, Count, Out);
+				break;
+			case ESelectionExpressionOperator::OneMinus:
+				DeformationCore::OneMinus(A, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Power:
+				DeformationCore::Power(A, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::RemapPeriodic:
+				DeformationCore::RemapPeriodic(A, Expression.IntegerA, Expression.IntegerB!=0, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Ease:
+				Ease(A, (EEasingFunc::Type)Expression.IntegerA, Expression.IntegerB, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Add:
+				DeformationCore::Add(A, B, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Subtract:
+				DeformationCore::Subtract(A, B, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Multiply:
+				DeformationCore::Multiply(A, B, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Divide:
+				DeformationCore::Divide(A, B, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Min:
+				DeformationCore::Min(A, B, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Max:
+				DeformationCore::Max(A, B, Count, Out);
+				break;
+			case ESelectionExpressionOperator::Lerp:
+				DeformationCore::Lerp(A, B, ScalarA, Count, Out);
+				break;
+			case ESelectionExpressionOperator::LerpByWeights:
+				DeformationCore::LerpByWeights(A, B, C, Count, Out);
+				break;
+		}
+	}
+
+	/// Evaluate a whole expression a block at a time into a SelectionSet, which is left sparse
+	/// if few enough of the results are non-zero
+	void EvaluateExpressionInto(const FSelectionExpression &Expression, int32 Size, USelectionSet &Out)
+	{
+		MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_EvaluateSelectionExpression);
+
+		// The scratch space is small enough for the stack in all but the deepest expressions.
+		TArray<float, TInlineAllocator<4*ExpressionBlockSize>> Scratch;
+		Scratch.SetNumUninitialized(GetScratchBlockCount(Expression)*ExpressionBlockSize);
+
+		Out.SetWeightsByBlock(Size, [&](int32 Start, int32 Count, float *BlockOut)
+		{
+			EvaluateBlock(Expression, Start, Count, BlockOut, Scratch.GetData());
+		});
+	}
+}
+
+void USelectionSet::PostInitProperties()
+{
+	Super::PostInitProperties();
+	if (!HasAnyFlags(RF_ClassDefaultObject))
+	{
+		INC_DWORD_STAT(STAT_MDTSelectionSetsAllocated);
+	}
+}
+
+void USelectionSet::BeginDestroy()
+{
+	ReleaseWeights();
+	DiscardUnpackedWeights();
+	Super::BeginDestroy();
+}
+
+void USelectionSet::Serialize(FArchive &Ar)
+{
+	if (Ar.IsSaving() && !Ar.IsObjectReferenceCollector())
+	{
+		EvaluateExpression();
+	}
+	else if (Ar.IsLoading())
+	{
+		// The loaded weights replace the current ones, so anything still to read those has to
+		// have them first.
+		DiscardExpression();
+		EvaluateLazyDependents();
+		DiscardUnpackedWeights();
+	}
+	Super::Serialize(Ar);
+}
+
+USelectionSet * USelectionSet::CreateAndCheckValid(
+	int32 RequiredSize, UObject *OuterObject, FString NodeNameForWarning, USelectionSet *Into /*= nullptr*/)
 {
 	// Create the results at the correct size and zero it.
-	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(OuterObject);
+	USelectionSet *NewSelectionSet = Into ? Into : NewObject<USelectionSet>(OuterObject);
 	if (!NewSelectionSet)
 	{
 		UE_LOG(MDTLog, Error, TEXT("%s: Cannot create new SelectionSet"), *NodeNameForWarning);
@@ -20,20 +341,415 @@ USelectionSet * USelectionSet::CreateAndCheckValid(int32 RequiredSize, UObject *
 	return NewSelectionSet;
 }
 
+USelectionSet * USelectionSet::CreateLazy(
+	ESelectionExpressionOperator Operator, const TArray<USelectionSet *, TInlineAllocator<3>> &Inputs,
+	float ScalarA /*= 0.0f*/, float ScalarB /*= 0.0f*/, int32 IntegerA /*= 0*/, int32 IntegerB /*= 0*/)
+{
+	check(Inputs.Num()>0);
+
+	USelectionSet *NewSelectionSet = NewObject<USelectionSet>(Inputs[0]->GetOuter());
+	if (!NewSelectionSet)
+	{
+		UE_LOG(MDTLog, Error, TEXT("CreateLazy: Cannot create new SelectionSet"));
+		return nullptr;
+	}
+
+	TSharedRef<FSelectionExpression> NewExpression = MakeShared<FSelectionExpression>();
+	NewExpression->Operator = Operator;
+	NewExpression->ScalarA = ScalarA;
+	NewExpression->ScalarB = ScalarB;
+	NewExpression->IntegerA = IntegerA;
+	NewExpression->IntegerB = IntegerB;
+
+	// Set only takes its size from its input, it doesn't read it.
+	if (Operator!=ESelectionExpressionOperator::Set)
+	{
+		for (USelectionSet *Input:Inputs)
+		{
+			if (Input->Expression.IsValid())
+			{
+				// Fold the input's expression into ours, so we read what it reads.
+				NewExpression->Inputs.Add(Input->Expression.ToSharedRef());
+				for (USelectionSet *Source:Input->ExpressionSources)
+				{
+					NewSelectionSet->ExpressionSources.AddUnique(Source);
+				}
+			}
+			else
+			{
+				TSharedRef<FSelectionExpression> SourceExpression = MakeShared<FSelectionExpression>();
+				SourceExpression->Source = Input;
+				NewExpression->Inputs.Add(SourceExpression);
+				NewSelectionSet->ExpressionSources.AddUnique(Input);
+			}
+		}
+		for (USelectionSet *Source:NewSelectionSet->ExpressionSources)
+		{
+			// Drop the dependents which have been evaluated or destroyed since, so a SelectionSet
+			// which is used every frame but never changed doesn't collect them.
+			Source->LazyDependents.RemoveAllSwap([](const TWeakObjectPtr<USelectionSet> &Dependent)
+			{
+				return !Dependent.IsValid() || !Dependent->IsLazy();
+			});
+			Source->LazyDependents.Add(NewSelectionSet);
+		}
+	}
+
+	NewSelectionSet->Expression = NewExpression;
+	NewSelectionSet->ExpressionSize = Inputs[0]->Size();
+	return NewSelectionSet;
+}
+
+void USelectionSet::PrepareToModifyWeights()
+{
+	MakeDense();
+	EvaluateLazyDependents();
+}
+
+void USelectionSet::EvaluateLazyDependents()
+{
+	// Every change to the weights comes through here first, apart from GetMutableWeights when
+	// there's nothing to evaluate.
+	++Revision;
+
+	// Anything which still needs our current weights has to read them before they change.
+	for (const TWeakObjectPtr<USelectionSet> &Dependent:LazyDependents)
+	{
+		if (USelectionSet *DependentSelectionSet = Dependent.Get())
+		{
+			DependentSelectionSet->EvaluateExpression();
+		}
+	}
+	LazyDependents.Empty();
+}
+
+void USelectionSet::MakeDense()
+{
+	EvaluateExpression();
+	if (Storage==ESelectionSetStorage::Weights)
+	{
+		return;
+	}
+
+	const ESelectionSetStorage PackedStorage = Storage;
+	Storage = ESelectionSetStorage::Weights;
+	if (bUnpackedWeightsValid)
+	{
+		// GetWeights has already unpacked them.
+		ReleaseWeights();
+		Weights = MoveTemp(UnpackedWeights);
+		bUnpackedWeightsValid = false;
+	}
+	else if (PackedStorage==ESelectionSetStorage::Mask)
+	{
+		SetNumWeightsUninitialized(PackedSize);
+		DeformationCore::UnpackMask(MaskWords.GetData(), 0, PackedSize, Weights.GetData());
+	}
+	else
+	{
+		SetNumWeightsUninitialized(PackedSize);
+		FMemory::Memzero(Weights.GetData(), PackedSize*sizeof(float));
+		for (int32 EntryIndex = 0; EntryIndex<SparseIndices.Num(); ++EntryIndex)
+		{
+			Weights[SparseIndices[EntryIndex]] = SparseWeights[EntryIndex];
+		}
+	}
+	SparseIndices.Empty();
+	SparseWeights.Empty();
+	MaskWords.Empty();
+}
+
+void USelectionSet::BeginSparseWeights(int32 Size)
+{
+	ReleaseWeights();
+	DiscardUnpackedWeights();
+	SparseIndices.Reset();
+	SparseWeights.Reset();
+	MaskWords.Empty();
+	PackedSize = Size;
+	Storage = ESelectionSetStorage::Sparse;
+
+	if (CVarSparseSelectionDensity.GetValueOnAnyThread()<=0.0f)
+	{
+		MakeDense();
+	}
+}
+
+void USelectionSet::AppendSparseWeights(int32 Start, int32 Count, const float *BlockWeights)
+{
+	for (int32 BlockIndex = 0; BlockIndex<Count; ++BlockIndex)
+	{
+		if (BlockWeights[BlockIndex]!=0.0f)
+		{
+			SparseIndices.Add(Start+BlockIndex);
+			SparseWeights.Add(BlockWeights[BlockIndex]);
+		}
+	}
+
+	// Once the indices cost more than they save, the rest of the blocks are written in full.
+	if (SparseIndices.Num()>PackedSize*CVarSparseSelectionDensity.GetValueOnAnyThread())
+	{
+		MakeDense();
+	}
+}
+
+TArray<uint32> &USelectionSet::CreateMask(int32 Size)
+{
+	DiscardExpression();
+	EvaluateLazyDependents();
+	ReleaseWeights();
+	DiscardUnpackedWeights();
+	SparseIndices.Empty();
+	SparseWeights.Empty();
+	PackedSize = Size;
+	Storage = ESelectionSetStorage::Mask;
+
+	MaskWords.Reset();
+	MaskWords.SetNumZeroed((Size+31)/32);
+	return MaskWords;
+}
+
+void USelectionSet::AppendMaskWeights(int32 Start, int32 Count, const float *BlockWeights)
+{
+	check(Start%32==0);
+	DeformationCore::PackMask(BlockWeights, 0.5f, Count, MaskWords.GetData()+Start/32);
+}
+
+void USelectionSet::DiscardPackedWeights()
+{
+	DiscardUnpackedWeights();
+	Storage = ESelectionSetStorage::Weights;
+	PackedSize = 0;
+	SparseIndices.Empty();
+	SparseWeights.Empty();
+	MaskWords.Empty();
+}
+
+void USelectionSet::EvaluateExpression()
+{
+	if (!Expression.IsValid())
+	{
+		return;
+	}
+
+	// Setting the weights discards the expression, so hold on to it until they're evaluated.
+	TSharedRef<const FSelectionExpression> EvaluatingExpression = Expression.ToSharedRef();
+	EvaluateExpressionInto(*EvaluatingExpression, ExpressionSize, *this);
+}
+
+void USelectionSet::DiscardExpression()
+{
+	Expression.Reset();
+	ExpressionSources.Empty();
+}
+
 void USelectionSet::CreateSelectionSet(int32 Size)
 {
-	this->Empty();
-	Weights.AddZeroed(Size);
+	DiscardExpression();
+	EvaluateLazyDependents();
+	DiscardPackedWeights();
+	SetNumWeightsUninitialized(Size);
+	FMemory::Memzero(Weights.GetData(), Size*sizeof(float));
 }
 
-void USelectionSet::Empty()
+void USelectionSet::CopyFrom(const USelectionSet &Source)
+{
+	if (&Source==this)
+	{
+		return;
+	}
+
+	DiscardExpression();
+	EvaluateLazyDependents();
+
+	// An expression which reads us has already been evaluated by EvaluateLazyDependents, as our
+	// weights can't be read and written at the same time.
+	if (Source.Expression.IsValid())
+	{
+		EvaluateExpressionInto(*Source.Expression, Source.ExpressionSize, *this);
+		return;
+	}
+
+	if (Source.Storage!=ESelectionSetStorage::Weights)
+	{
+		ReleaseWeights();
+		DiscardUnpackedWeights();
+		Storage = Source.Storage;
+		PackedSize = Source.PackedSize;
+		SparseIndices = Source.SparseIndices;
+		SparseWeights = Source.SparseWeights;
+		MaskWords = Source.MaskWords;
+		return;
+	}
+
+	DiscardPackedWeights();
+	SetNumWeightsUninitialized(Source.Weights.Num());
+	FMemory::Memcpy(Weights.GetData(), Source.Weights.GetData(), Source.Weights.Num()*sizeof(float));
+}
+
+void USelectionSet::SetNumWeightsUninitialized(int32 Size)
+{
+	if (Weights.Max()<Size)
+	{
+		ReleaseWeights();
+		if (!TakePooledWeights(Size, Weights))
+		{
+			Weights.Reserve(Size);
+		}
+	}
+	Weights.SetNumUninitialized(Size, false);
+}
+
+void USelectionSet::ReleaseWeights()
 {
+	PoolWeights(MoveTemp(Weights));
 	Weights.Empty();
 }
 
+void USelectionSet::Empty()
+{
+	DiscardExpression();
+	EvaluateLazyDependents();
+	DiscardPackedWeights();
+	ReleaseWeights();
+}
+
+float USelectionSet::GetWeight(int32 Index) const
+{
+	if (Expression.IsValid())
+	{
+		const_cast<USelectionSet *>(this)->EvaluateExpression();
+	}
+	if (Storage==ESelectionSetStorage::Mask)
+	{
+		return (MaskWords[Index/32]>>(Index%32))&1 ? 1.0f : 0.0f;
+	}
+	if (Storage==ESelectionSetStorage::Weights)
+	{
+		return Weights[Index];
+	}
+
+	const int32 EntryIndex = Algo::BinarySearch(SparseIndices, Index);
+	return EntryIndex==INDEX_NONE ? 0.0f : SparseWeights[EntryIndex];
+}
+
+bool USelectionSet::IsSelected(int32 Index) const
+{
+	if (Expression.IsValid())
+	{
+		const_cast<USelectionSet *>(this)->EvaluateExpression();
+	}
+	if (Storage==ESelectionSetStorage::Mask)
+	{
+		return ((MaskWords[Index/32]>>(Index%32))&1)!=0;
+	}
+	return GetWeight(Index)>=0.5f;
+}
+
+void USelectionSet::CopyWeights(int32 Start, int32 Count, float *Out) const
+{
+	if (Expression.IsValid())
+	{
+		const_cast<USelectionSet *>(this)->EvaluateExpression();
+	}
+	if (Storage==ESelectionSetStorage::Mask)
+	{
+		DeformationCore::UnpackMask(MaskWords.GetData(), Start, Count, Out);
+		return;
+	}
+	if (Storage==ESelectionSetStorage::Weights)
+	{
+		FMemory::Memcpy(Out, Weights.GetData()+Start, Count*sizeof(float));
+		return;
+	}
+
+	FMemory::Memzero(Out, Count*sizeof(float));
+	const int32 End = Start+Count;
+	for (int32 EntryIndex = Algo::LowerBound(SparseIndices, Start);
+		EntryIndex<SparseIndices.Num() && SparseIndices[EntryIndex]<End; ++EntryIndex)
+	{
+		Out[SparseIndices[EntryIndex]-Start] = SparseWeights[EntryIndex];
+	}
+}
+
+const uint32 *USelectionSet::GetMaskBlock(int32 Start, int32 Count, uint32 *Buffer) const
+{
+	check(Start%32==0 && Count<=WeightBlockSize);
+	if (Expression.IsValid())
+	{
+		const_cast<USelectionSet *>(this)->EvaluateExpression();
+	}
+	if (Storage==ESelectionSetStorage::Mask)
+	{
+		return MaskWords.GetData()+Start/32;
+	}
+
+	float BlockWeights[WeightBlockSize];
+	CopyWeights(Start, Count, BlockWeights);
+	DeformationCore::PackMask(BlockWeights, 0.5f, Count, Buffer);
+	return Buffer;
+}
+
+const TArray<float> &USelectionSet::GetUnpackedWeights() const
+{
+	FScopeLock ScopeLock(&UnpackedWeightsLock);
+	if (!bUnpackedWeightsValid)
+	{
+		UnpackedWeights.SetNumUninitialized(PackedSize);
+		CopyWeights(0, PackedSize, UnpackedWeights.GetData());
+		bUnpackedWeightsValid = true;
+	}
+	return UnpackedWeights;
+}
+
+void USelectionSet::DiscardUnpackedWeights()
+{
+	UnpackedWeights.Empty();
+	bUnpackedWeightsValid = false;
+}
+
+uint32 USelectionSet::GetContentHash() const
+{
+	if (Expression.IsValid())
+	{
+		const_cast<USelectionSet *>(this)->EvaluateExpression();
+	}
+	if (bContentHashValid && ContentHashRevision==Revision)
+	{
+		return ContentHash;
+	}
+
+	// Sparse weights and masks are hashed as they are, rather than expanding them to every weight.
+	uint32 Hash = GetTypeHash(Size());
+	if (Storage==ESelectionSetStorage::Mask)
+	{
+		Hash = FCrc::MemCrc32(MaskWords.GetData(), MaskWords.Num()*sizeof(uint32), Hash);
+	}
+	else if (Storage==ESelectionSetStorage::Sparse)
+	{
+		Hash = FCrc::MemCrc32(SparseIndices.GetData(), SparseIndices.Num()*sizeof(int32), Hash);
+		Hash = FCrc::MemCrc32(SparseWeights.GetData(), SparseWeights.Num()*sizeof(float), Hash);
+	}
+	else
+	{
+		Hash = FCrc::MemCrc32(Weights.GetData(), Weights.Num()*sizeof(float), Hash);
+	}
+
+	ContentHash = Hash;
+	ContentHashRevision = Revision;
+	bContentHashValid = true;
+	return ContentHash;
+}
+
+SIZE_T USelectionSet::GetAllocatedSize() const
+{
+	return Weights.GetAllocatedSize()+SparseIndices.GetAllocatedSize()+SparseWeights.GetAllocatedSize()+
+		MaskWords.GetAllocatedSize()+UnpackedWeights.GetAllocatedSize();
+}
+
 USelectionSet *USelectionSet::RandomizeWeights(FRandomStream &RandomStream, float Min /*= 0*/, float Max /*= 1*/)
 {
-	for (auto &Weight:Weights)
+	for (auto &Weight:GetMutableWeights())
 	{
 		Weight = RandomStream.FRandRange(Min, Max);
 	}
@@ -42,7 +758,7 @@ USelectionSet *USelectionSet::RandomizeWeights(FRandomStream &RandomStream, floa
 
 USelectionSet *USelectionSet::SetAllWeights(float Value)
 {
-	for (auto &Weight:Weights)
+	for (auto &Weight:GetMutableWeights())
 	{
 		Weight = Value;
 	}
@@ -51,5 +767,25 @@ USelectionSet *USelectionSet::SetAllWeights(float Value)
 
 int32 USelectionSet::Size() const
 {
-	return Weights.Num();
+	if (Expression.IsValid())
+	{
+		return ExpressionSize;
+	}
+	return Storage==ESelectionSetStorage::Weights ? Weights.Num() : PackedSize;
+}
+
+TArray<float> USelectionSet::K2_GetWeights() const
+{
+	// Blueprint gets its own copy anyway, so sparse weights and masks are copied straight out
+	// rather than keeping a full copy of them here too.
+	TArray<float> Result;
+	Result.SetNumUninitialized(Size());
+	CopyWeights(0, Result.Num(), Result.GetData());
+	return Result;
+}
+
+void USelectionSet::K2_SetWeights(const TArray<float> &NewWeights)
+{
+	DiscardExpression();
+	GetMutableWeights() = NewWeights;
 }
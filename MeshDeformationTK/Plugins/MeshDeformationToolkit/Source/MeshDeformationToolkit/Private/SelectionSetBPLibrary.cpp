@@ -1,9 +1,50 @@
 // (c)2017 Paul Golds, released under MIT License.
 
 #include "MeshDeformationToolkit.h"
+#include "DeformationCore.h"
 #include "SelectionSet.h"
 #include "SelectionSetBPLibrary.h"
 
+namespace
+{
+	/// Combine the masks of one or two SelectionSets into a new mask a block at a time, see
+	/// *USelectionSet::GetMaskBlock* for how anything which isn't a mask is read.
+	///
+	/// Masks are cheap enough to combine a word at a time that, unlike the arithmetic nodes,
+	/// the result is calculated straight away.
+	///
+	/// \param A				The first SelectionSet
+	/// \param B				The second SelectionSet, or nullptr for operations with one input
+	/// \param NodeName			The name of the calling node to report problems with
+	/// \param Combine			Called as Combine(WordsA, WordsB, Count, Out) for each block
+	template <typename CombineFunctionType>
+	USelectionSet *CombineMasks(USelectionSet *A, USelectionSet *B, const TCHAR *NodeName, CombineFunctionType Combine)
+	{
+		USelectionSet *Result = NewObject<USelectionSet>(A->GetOuter());
+		if (!Result)
+		{
+			UE_LOG(MDTLog, Error, TEXT("%s: Cannot create new SelectionSet"), NodeName);
+			return nullptr;
+		}
+
+		const int32 Size = A->Size();
+		uint32 *ResultWords = Result->CreateMask(Size).GetData();
+
+		const int32 BlockWordCount = USelectionSet::WeightBlockSize/32;
+		uint32 BufferA[BlockWordCount];
+		uint32 BufferB[BlockWordCount];
+		for (int32 Start = 0; Start<Size; Start += USelectionSet::WeightBlockSize)
+		{
+			const int32 Count = FMath::Min<int32>(USelectionSet::WeightBlockSize, Size-Start);
+			const uint32 *WordsA = A->GetMaskBlock(Start, Count, BufferA);
+			const uint32 *WordsB = B ? B->GetMaskBlock(Start, Count, BufferB) : nullptr;
+			Combine(WordsA, WordsB, Count, ResultWords+Start/32);
+		}
+
+		return Result;
+	}
+}
+
 USelectionSet * USelectionSetBPLibrary::AddFloatToSelectionSet(USelectionSet *Value, float Float/*=0*/)
 {
 	// Need a SelectionSet
@@ -13,20 +54,7 @@ USelectionSet * USelectionSetBPLibrary::AddFloatToSelectionSet(USelectionSet *Va
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Value->Size(), Value->GetOuter(), TEXT("AddFloatToSelectionSet")
-	);
-	if (!Result) {
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Value->Size(); WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = Value->Weights[WeightIndex]+Float;
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::AddScalar, {Value}, Float);
 }
 
 USelectionSet *USelectionSetBPLibrary::AddSelectionSets(USelectionSet *A, USelectionSet *B)
@@ -37,22 +65,21 @@ USelectionSet *USelectionSetBPLibrary::AddSelectionSets(USelectionSet *A, USelec
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = A->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, A->GetOuter(), TEXT("AddSelectionSets")
-	);
-	if (!Result)
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Add, {A, B});
+}
+
+USelectionSet *USelectionSetBPLibrary::AndSelectionSets(USelectionSet *A, USelectionSet *B)
+{
+	// Need both provided and same size
+	if (!Utility::HaveTwoSelectionSetsOfSameSize(A, B, "AndSelectionSets"))
 	{
 		return nullptr;
 	}
 
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
+	return CombineMasks(A, B, TEXT("AndSelectionSets"), [](const uint32 *WordsA, const uint32 *WordsB, int32 Count, uint32 *Out)
 	{
-		Result->Weights[WeightIndex] = A->Weights[WeightIndex]+B->Weights[WeightIndex];
-	}
-
-	return Result;
+		DeformationCore::AndMask(WordsA, WordsB, Count, Out);
+	});
 }
 
 USelectionSet * USelectionSetBPLibrary::Clamp(USelectionSet *Value, float Min/*=0*/, float Max/*=1*/)
@@ -64,21 +91,27 @@ USelectionSet * USelectionSetBPLibrary::Clamp(USelectionSet *Value, float Min/*=
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("Clamp"));
-	if (!Result)
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Clamp, {Value}, Min, Max);
+}
+
+int32 USelectionSetBPLibrary::CountSelected(USelectionSet *Value)
+{
+	// Need a SelectionSet
+	if (!Value)
 	{
-		return nullptr;
+		UE_LOG(MDTLog, Warning, TEXT("CountSelected: Need a SelectionSet"));
+		return 0;
 	}
 
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
+	const int32 Size = Value->Size();
+	uint32 Buffer[USelectionSet::WeightBlockSize/32];
+	int32 SelectedCount = 0;
+	for (int32 Start = 0; Start<Size; Start += USelectionSet::WeightBlockSize)
 	{
-		Result->Weights[WeightIndex] = FMath::Clamp(Value->Weights[WeightIndex], Min, Max);
+		const int32 Count = FMath::Min<int32>(USelectionSet::WeightBlockSize, Size-Start);
+		SelectedCount += DeformationCore::CountMask(Value->GetMaskBlock(Start, Count, Buffer), Count);
 	}
-
-	return Result;
+	return SelectedCount;
 }
 
 
@@ -91,30 +124,7 @@ USelectionSet * USelectionSetBPLibrary::DivideFloatBySelectionSet(float Float /*
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("DivideFloatBySelectionSet"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-	
-	// Set the minimum threshold for division
-	const float ZeroThreshold = 0.01;
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		// We need to make sure the weight is not zero to avoid divide by zero so
-		// we'll set it to 'near zero' if it is.
-		float Weight = Value->Weights[WeightIndex];
-		if (FMath::Abs(Weight)<ZeroThreshold)
-		{
-			Weight = Weight<0 ? -ZeroThreshold : ZeroThreshold;
-		}
-		Result->Weights[WeightIndex] = Float/Weight;
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::DivideScalarBy, {Value}, Float);
 }
 
 USelectionSet * USelectionSetBPLibrary::DivideSelectionSetByFloat(USelectionSet *Value, float Float /*= 1*/)
@@ -133,21 +143,7 @@ USelectionSet * USelectionSetBPLibrary::DivideSelectionSetByFloat(USelectionSet
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("DivideSelectionSetByFloat"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = Value->Weights[WeightIndex]/Float;
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::DivideByScalar, {Value}, Float);
 }
 
 USelectionSet * USelectionSetBPLibrary::DivideSelectionSets(USelectionSet *A, USelectionSet *B)
@@ -158,21 +154,7 @@ USelectionSet * USelectionSetBPLibrary::DivideSelectionSets(USelectionSet *A, US
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = A->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, A->GetOuter(), TEXT("DivideSelectionSets"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = A->Weights[WeightIndex]/B->Weights[WeightIndex];
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Divide, {A, B});
 }
 
 USelectionSet * USelectionSetBPLibrary::Ease(
@@ -188,66 +170,7 @@ USelectionSet * USelectionSetBPLibrary::Ease(
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("Ease"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-	// TODO: This can be more efficient with lambdas.
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		switch (EaseFunction)
-		{
-			case EEasingFunc::Step:
-				Result->Weights[WeightIndex] = FMath::InterpStep<float>(0.f, 1.f, Value->Weights[WeightIndex], Steps);
-				break;
-			case EEasingFunc::SinusoidalIn:
-				Result->Weights[WeightIndex] = FMath::InterpSinIn<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			case EEasingFunc::SinusoidalOut:
-				Result->Weights[WeightIndex] = FMath::InterpSinOut<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			case EEasingFunc::SinusoidalInOut:
-				Result->Weights[WeightIndex] = FMath::InterpSinInOut<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			case EEasingFunc::EaseIn:
-				Result->Weights[WeightIndex] = FMath::InterpEaseIn<float>(0.f, 1.f, Value->Weights[WeightIndex], BlendExp);
-				break;
-			case EEasingFunc::EaseOut:
-				Result->Weights[WeightIndex] = FMath::InterpEaseOut<float>(0.f, 1.f, Value->Weights[WeightIndex], BlendExp);
-				break;
-			case EEasingFunc::EaseInOut:
-				Result->Weights[WeightIndex] = FMath::InterpEaseInOut<float>(0.f, 1.f, Value->Weights[WeightIndex], BlendExp);
-				break;
-			case EEasingFunc::ExpoIn:
-				Result->Weights[WeightIndex] = FMath::InterpExpoIn<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			case EEasingFunc::ExpoOut:
-				Result->Weights[WeightIndex] = FMath::InterpExpoOut<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			case EEasingFunc::ExpoInOut:
-				Result->Weights[WeightIndex] = FMath::InterpExpoInOut<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			case EEasingFunc::CircularIn:
-				Result->Weights[WeightIndex] = FMath::InterpCircularIn<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			case EEasingFunc::CircularOut:
-				Result->Weights[WeightIndex] = FMath::InterpCircularOut<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			case EEasingFunc::CircularInOut:
-				Result->Weights[WeightIndex] = FMath::InterpCircularInOut<float>(0.f, 1.f, Value->Weights[WeightIndex]);
-				break;
-			default:
-				// Do nothing: linear.
-				Result->Weights[WeightIndex] = Value->Weights[WeightIndex];
-				break;
-		}
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Ease, {Value}, BlendExp, 0.0f, (int32)EaseFunction, Steps);
 }
 // Note: The BP name and C++ names of this function are different as UFUNCTION() doesn't allow overloading
 USelectionSet * USelectionSetBPLibrary::LerpSelectionSetsWithFloat(USelectionSet *A, USelectionSet *B, float Alpha/*=0*/)
@@ -258,21 +181,7 @@ USelectionSet * USelectionSetBPLibrary::LerpSelectionSetsWithFloat(USelectionSet
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = A->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, A->GetOuter(), TEXT("LerpSelectionSets"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = FMath::Lerp(A->Weights[WeightIndex], B->Weights[WeightIndex], Alpha);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Lerp, {A, B}, Alpha);
 }
 
 // Note: The BP name and C++ names of this function are different as UFUNCTION() doesn't allow overloading
@@ -284,21 +193,7 @@ USelectionSet * USelectionSetBPLibrary::LerpSelectionSetsWithSelectionSet(USelec
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = A->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, A->GetOuter(), TEXT("LerpSelectionSets"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = FMath::Lerp(A->Weights[WeightIndex], B->Weights[WeightIndex], Alpha->Weights[WeightIndex]);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::LerpByWeights, {A, B, Alpha});
 
 }
 
@@ -311,21 +206,7 @@ USelectionSet * USelectionSetBPLibrary::LerpSelectionSetWithFloat(USelectionSet
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("LerpSelectionSetWithFloat"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = FMath::Lerp(Value->Weights[WeightIndex], Float, Alpha);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::LerpToScalar, {Value}, Float, Alpha);
 }
 
 USelectionSet * USelectionSetBPLibrary::MaxSelectionSetAgainstFloat(USelectionSet *Value, float Float)
@@ -337,22 +218,7 @@ USelectionSet * USelectionSetBPLibrary::MaxSelectionSetAgainstFloat(USelectionSe
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("MaxSelectionSetAgainstFloat"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		//result->weights[i] = Value->weights[i] > Float ? Value->weights[i] : Float;
-		Result->Weights[WeightIndex] = FMath::Max(Value->Weights[WeightIndex], Float);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::MaxScalar, {Value}, Float);
 }
 
 USelectionSet * USelectionSetBPLibrary::MaxSelectionSets(USelectionSet *A, USelectionSet *B)
@@ -363,21 +229,7 @@ USelectionSet * USelectionSetBPLibrary::MaxSelectionSets(USelectionSet *A, USele
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = A->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, A->GetOuter(), TEXT("MaxSelectionSets"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = FMath::Max(A->Weights[WeightIndex], B->Weights[WeightIndex]);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Max, {A, B});
 }
 
 USelectionSet * USelectionSetBPLibrary::MinSelectionSetAgainstFloat(USelectionSet *Value, float Float)
@@ -389,21 +241,7 @@ USelectionSet * USelectionSetBPLibrary::MinSelectionSetAgainstFloat(USelectionSe
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("MinSelectionSetAgainstFloat"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = FMath::Min(Value->Weights[WeightIndex], Float);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::MinScalar, {Value}, Float);
 }
 
 USelectionSet * USelectionSetBPLibrary::MinSelectionSets(USelectionSet *A, USelectionSet *B)
@@ -414,21 +252,7 @@ USelectionSet * USelectionSetBPLibrary::MinSelectionSets(USelectionSet *A, USele
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = A->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, A->GetOuter(), TEXT("MinSelectionSets"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = FMath::Min(A->Weights[WeightIndex], B->Weights[WeightIndex]);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Min, {A, B});
 }
 
 USelectionSet * USelectionSetBPLibrary::MultiplySelctionSetByFloat(USelectionSet *Value, float Float/*=1*/)
@@ -440,21 +264,7 @@ USelectionSet * USelectionSetBPLibrary::MultiplySelctionSetByFloat(USelectionSet
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("MultiplySelectionSetByFloat"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = Value->Weights[WeightIndex]*Float;
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::MultiplyScalar, {Value}, Float);
 }
 
 USelectionSet * USelectionSetBPLibrary::MultiplySelectionSets(USelectionSet *A, USelectionSet *B)
@@ -465,21 +275,22 @@ USelectionSet * USelectionSetBPLibrary::MultiplySelectionSets(USelectionSet *A,
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = A->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, A->GetOuter(), TEXT("MultiplySelectionSets"));
-	if (!Result)
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Multiply, {A, B});
+}
+
+USelectionSet *USelectionSetBPLibrary::NotSelectionSet(USelectionSet *Value)
+{
+	// Need a SelectionSet
+	if (!Value)
 	{
+		UE_LOG(MDTLog, Warning, TEXT("NotSelectionSet: Need a SelectionSet"));
 		return nullptr;
 	}
 
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
+	return CombineMasks(Value, nullptr, TEXT("NotSelectionSet"), [](const uint32 *WordsA, const uint32 *WordsB, int32 Count, uint32 *Out)
 	{
-		Result->Weights[WeightIndex] = A->Weights[WeightIndex]*B->Weights[WeightIndex];
-	}
-
-	return Result;
+		DeformationCore::NotMask(WordsA, Count, Out);
+	});
 }
 
 USelectionSet * USelectionSetBPLibrary::OneMinus(USelectionSet *Value)
@@ -491,21 +302,21 @@ USelectionSet * USelectionSetBPLibrary::OneMinus(USelectionSet *Value)
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("OneMinus"));
-	if (!Result)
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::OneMinus, {Value});
+}
+
+USelectionSet *USelectionSetBPLibrary::OrSelectionSets(USelectionSet *A, USelectionSet *B)
+{
+	// Need both provided and same size
+	if (!Utility::HaveTwoSelectionSetsOfSameSize(A, B, "OrSelectionSets"))
 	{
 		return nullptr;
 	}
 
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
+	return CombineMasks(A, B, TEXT("OrSelectionSets"), [](const uint32 *WordsA, const uint32 *WordsB, int32 Count, uint32 *Out)
 	{
-		Result->Weights[WeightIndex] = 1.0f-Value->Weights[WeightIndex];
-	}
-
-	return Result;
+		DeformationCore::OrMask(WordsA, WordsB, Count, Out);
+	});
 }
 
 
@@ -518,21 +329,7 @@ USelectionSet * USelectionSetBPLibrary::Power(USelectionSet *Value, float Exp)
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("Power"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = FMath::Pow(Value->Weights[WeightIndex], Exp);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Power, {Value}, Exp);
 }
 
 USelectionSet * USelectionSetBPLibrary::Randomize(USelectionSet *Value, FRandomStream &RandomStream, float Min/*=0*/, float Max/*=1*/)
@@ -553,9 +350,10 @@ USelectionSet * USelectionSetBPLibrary::Randomize(USelectionSet *Value, FRandomS
 		return nullptr;
 	}
 
+	TArray<float> &ResultWeights = Result->GetMutableWeights();
 	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
 	{
-		Result->Weights[WeightIndex] = RandomStream.FRandRange(Min, Max);
+		ResultWeights[WeightIndex] = RandomStream.FRandRange(Min, Max);
 	}
 
 	return Result;
@@ -590,10 +388,13 @@ USelectionSet * USelectionSetBPLibrary::RemapToCurve(USelectionSet *Value, UCurv
 		return nullptr;
 	}
 
-	// Apply the curve mapping
+	// Apply the curve mapping, reading the weights straight into the result so a sparse
+	// SelectionSet or mask doesn't need a full copy of its own.
+	TArray<float> &ResultWeights = Result->GetMutableWeights();
+	Value->CopyWeights(0, Size, ResultWeights.GetData());
 	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
 	{
-		Result->Weights[WeightIndex] = Curve->GetFloatValue(Value->Weights[WeightIndex]*CurveTimeEnd);
+		ResultWeights[WeightIndex] = Curve->GetFloatValue(ResultWeights[WeightIndex]*CurveTimeEnd);
 	}
 
 	return Result;
@@ -613,15 +414,6 @@ USelectionSet * USelectionSetBPLibrary::RemapToRange(USelectionSet *Value, float
 		return nullptr;
 	}
 
-	// Find the current minimum and maximum.
-	float CurrentMinimum = Value->Weights[0];
-	float CurrentMaximum = Value->Weights[0];
-	for (int32 WeightIndex = 1; WeightIndex<Value->Size(); WeightIndex++)
-	{
-		CurrentMinimum = FMath::Min(CurrentMinimum, Value->Weights[WeightIndex]);
-		CurrentMaximum = FMath::Max(CurrentMaximum, Value->Weights[WeightIndex]);
-	}
-
 	// Create a zeroed SelectionSet to store results, sized correctly for performance
 	const int32 Size = Value->Size();
 	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
@@ -631,18 +423,11 @@ USelectionSet * USelectionSetBPLibrary::RemapToRange(USelectionSet *Value, float
 		return nullptr;
 	}
 
-	// Check if all values are the same- if so just return a flat result equal to Min.
-	if (CurrentMinimum==CurrentMaximum)
-	{
-		return Set(Result, Min);
-	}
-
-	// Perform the remapping
-	float Scale = (Max-Min)/(CurrentMaximum-CurrentMinimum);
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = (Value->Weights[WeightIndex]-CurrentMinimum) * Scale+Min;
-	}
+	// Perform the remapping in place in the result, if all values are the same this gives a
+	// flat result equal to Min.
+	float *ResultWeights = Result->GetMutableWeights().GetData();
+	Value->CopyWeights(0, Size, ResultWeights);
+	DeformationCore::RemapToRange(ResultWeights, Min, Max, Size, ResultWeights);
 
 	return Result;
 }
@@ -658,27 +443,7 @@ USelectionSet * USelectionSetBPLibrary::RemapPeriodic(
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("RemapPeriodic"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	// Perform the remap
-	for (int32 WeightIndex=0; WeightIndex<Size; WeightIndex++) {
-		const float ScaledValue = Value->Weights[WeightIndex] *NumberOfRepeats;
-		const bool bIsOdd = (FPlatformMath::FloorToInt(ScaledValue) % 2) ==1;
-		const bool bShouldInvert = bIncludeReversals && bIsOdd;
-	
-		Result->Weights[WeightIndex] = bShouldInvert ?
-			1.0f-FMath::Fmod(ScaledValue, 1.0f) :
-			FMath::Fmod(ScaledValue, 1.0f);
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::RemapPeriodic, {Value}, 0.0f, 0.0f, NumberOfRepeats, bIncludeReversals ? 1 : 0);
 }
 
 USelectionSet * USelectionSetBPLibrary::Set(USelectionSet *Value, float Float/*=0*/)
@@ -690,21 +455,26 @@ USelectionSet * USelectionSetBPLibrary::Set(USelectionSet *Value, float Float/*=
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("Set"));
-	if (!Result)
+	// Value just provides the size.
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Set, {Value}, Float);
+}
+
+USelectionSet * USelectionSetBPLibrary::StoreInto(USelectionSet *Value, USelectionSet *Into)
+{
+	// Need a SelectionSet to store and one to store it in
+	if (!Value)
 	{
+		UE_LOG(MDTLog, Warning, TEXT("StoreInto: Need a SelectionSet to store"));
 		return nullptr;
 	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
+	if (!Into)
 	{
-		Result->Weights[WeightIndex] = Float;
+		UE_LOG(MDTLog, Warning, TEXT("StoreInto: Need a SelectionSet to store into"));
+		return nullptr;
 	}
 
-	return Result;
+	Into->CopyFrom(*Value);
+	return Into;
 }
 
 USelectionSet * USelectionSetBPLibrary::SubtractFloatFromSelectionSet(USelectionSet *Value, float Float/*=0*/)
@@ -716,21 +486,7 @@ USelectionSet * USelectionSetBPLibrary::SubtractFloatFromSelectionSet(USelection
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("SubtractFloatFromSelectionSet"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = Value->Weights[WeightIndex]-Float;
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::SubtractScalar, {Value}, Float);
 }
 
 USelectionSet * USelectionSetBPLibrary::SubtractSelectionSetFromFloat(float Float, USelectionSet *Value)
@@ -742,21 +498,7 @@ USelectionSet * USelectionSetBPLibrary::SubtractSelectionSetFromFloat(float Floa
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = Value->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, Value->GetOuter(), TEXT("SubtractSelectionSetFromFloat"));
-	if (!Result)
-	{
-		return nullptr;
-	}
-
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
-	{
-		Result->Weights[WeightIndex] = Float-Value->Weights[WeightIndex];
-	}
-
-	return Result;
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::SubtractFromScalar, {Value}, Float);
 }
 
 USelectionSet * USelectionSetBPLibrary::SubtractSelectionSets(USelectionSet *A, USelectionSet *B)
@@ -767,19 +509,19 @@ USelectionSet * USelectionSetBPLibrary::SubtractSelectionSets(USelectionSet *A,
 		return nullptr;
 	}
 
-	// Create a zeroed SelectionSet to store results, sized correctly for performance
-	const int32 Size = A->Size();
-	USelectionSet *Result = USelectionSet::CreateAndCheckValid(
-		Size, A->GetOuter(), TEXT("SubtractSelectionSets"));
-	if (!Result)
+	return USelectionSet::CreateLazy(ESelectionExpressionOperator::Subtract, {A, B});
+}
+
+USelectionSet *USelectionSetBPLibrary::XorSelectionSets(USelectionSet *A, USelectionSet *B)
+{
+	// Need both provided and same size
+	if (!Utility::HaveTwoSelectionSetsOfSameSize(A, B, "XorSelectionSets"))
 	{
 		return nullptr;
 	}
 
-	for (int32 WeightIndex = 0; WeightIndex<Size; WeightIndex++)
+	return CombineMasks(A, B, TEXT("XorSelectionSets"), [](const uint32 *WordsA, const uint32 *WordsB, int32 Count, uint32 *Out)
 	{
-		Result->Weights[WeightIndex] = A->Weights[WeightIndex]-B->Weights[WeightIndex];
-	}
-
-	return Result;
-}
\ No newline at end of file
+		DeformationCore::XorMask(WordsA, WordsB, Count, Out);
+	});
+}
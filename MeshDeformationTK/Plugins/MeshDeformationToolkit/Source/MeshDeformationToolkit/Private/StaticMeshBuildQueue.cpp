@@ -0,0 +1,222 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "Engine/StaticMesh.h"
+#include "Developer/RawMesh/Public/RawMesh.h" // The structure for building static meshes
+#include "Runtime/AssetRegistry/Public/AssetRegistryModule.h" // Allows registering new static meshes
+#include "MeshGeometry.h"
+
+#include "StaticMeshBuildQueue.h"
+
+DECLARE_CYCLE_STAT(TEXT("StaticMeshBuildQueue Tick"), STAT_MDT_StaticMeshBuildQueueTick, STATGROUP_MeshDeformationToolkit);
+DECLARE_CYCLE_STAT(TEXT("StaticMeshBuildQueue FinishBuild"), STAT_MDT_FinishBuild, STATGROUP_MeshDeformationToolkit);
+
+TUniquePtr<FStaticMeshBuildQueue> FStaticMeshBuildQueue::Instance;
+
+FStaticMeshBuildQueue &FStaticMeshBuildQueue::Get()
+{
+	if (!Instance.IsValid())
+	{
+		Instance = TUniquePtr<FStaticMeshBuildQueue>(new FStaticMeshBuildQueue());
+	}
+	return *Instance;
+}
+
+void FStaticMeshBuildQueue::Shutdown()
+{
+	Instance.Reset();
+}
+
+FStaticMeshBuildQueue::FStaticMeshBuildQueue()
+{
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FStaticMeshBuildQueue::Tick)
+	);
+}
+
+FStaticMeshBuildQueue::~FStaticMeshBuildQueue()
+{
+	// Any workers still running own their copy of the geometry, so they can safely finish
+	// after we've gone.
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+}
+
+void FStaticMeshBuildQueue::QueueBuild(
+	const FString &PackageName,
+	const FString &AssetName,
+	const TArray<FSectionGeometry> &Sections,
+	const TArray<UMaterialInterface *> &Materials,
+	FOnStaticMeshBuilt OnBuilt /*= FOnStaticMeshBuilt()*/)
+{
+	// Replace the geometry of any build which hasn't finished, if the worker's already
+	// preparing the old geometry its result will be thrown away.
+	FPendingBuild &Build = PendingBuilds.FindOrAdd(PackageName);
+	Build.AssetName = AssetName;
+	Build.Sections = Sections;
+	Build.Materials = Materials;
+	Build.Callbacks.Add(OnBuilt);
+	++Build.Revision;
+
+	UE_LOG(
+		MDTLog, Log, TEXT("SaveToStaticMesh: Queued build of %s (revision %u)"),
+		*PackageName, Build.Revision
+	);
+}
+
+void FStaticMeshBuildQueue::Flush()
+{
+	while (PendingBuilds.Num()>0)
+	{
+		const int32 NumBuildsBefore = PendingBuilds.Num();
+		Tick(0.0f);
+
+		// Don't spin while the workers are preparing.
+		if (PendingBuilds.Num()==NumBuildsBefore)
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+	}
+}
+
+bool FStaticMeshBuildQueue::IsBuildPending(const FString &PackageName) const
+{
+	return PendingBuilds.Contains(PackageName);
+}
+
+int32 FStaticMeshBuildQueue::GetNumPendingBuilds() const
+{
+	return PendingBuilds.Num();
+}
+
+void FStaticMeshBuildQueue::AddReferencedObjects(FReferenceCollector &Collector)
+{
+	for (auto &PendingBuild:PendingBuilds)
+	{
+		Collector.AddReferencedObjects(PendingBuild.Value.Materials);
+	}
+}
+
+bool FStaticMeshBuildQueue::Tick(float DeltaTime)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_StaticMeshBuildQueueTick);
+
+	// The builds finished this tick.  The delegates are called once we've finished with
+	// PendingBuilds as they may well queue another build.
+	TArray<TPair<FString, FPendingBuild>> FinishedBuilds;
+	TArray<UStaticMesh *> FinishedMeshes;
+
+	for (auto It = PendingBuilds.CreateIterator(); It; ++It)
+	{
+		FPendingBuild &Build = It.Value();
+
+		// Start preparing the latest geometry if the worker's idle.
+		if (!Build.PreparedRawMesh.IsValid())
+		{
+			Build.PreparingRevision = Build.Revision;
+			Build.PreparedRawMesh = Async(
+				EAsyncExecution::ThreadPool,
+				[Sections = MoveTemp(Build.Sections)]()
+				{
+					TSharedPtr<FRawMesh, ESPMode::ThreadSafe> RawMesh = MakeShared<FRawMesh, ESPMode::ThreadSafe>();
+					UMeshGeometry::BuildRawMesh(Sections, *RawMesh);
+					return RawMesh;
+				}
+			);
+			Build.Sections.Reset();
+			continue;
+		}
+
+		// Building the StaticMesh stalls the game thread, so only do one per tick.
+		if (!Build.PreparedRawMesh.IsReady()||FinishedBuilds.Num()>0)
+		{
+			continue;
+		}
+
+		TSharedPtr<FRawMesh, ESPMode::ThreadSafe> RawMesh = Build.PreparedRawMesh.Get();
+		Build.PreparedRawMesh = TFuture<TSharedPtr<FRawMesh, ESPMode::ThreadSafe>>();
+
+		// If newer geometry has arrived then this result is stale, the next tick will start
+		// preparing the latest.
+		if (Build.PreparingRevision!=Build.Revision)
+		{
+			continue;
+		}
+
+		FinishedMeshes.Add(FinishBuild(It.Key(), Build, *RawMesh));
+		FinishedBuilds.Emplace(It.Key(), MoveTemp(Build));
+		It.RemoveCurrent();
+	}
+
+	for (int32 FinishedIndex = 0; FinishedIndex<FinishedBuilds.Num(); ++FinishedIndex)
+	{
+		UStaticMesh *StaticMesh = FinishedMeshes[FinishedIndex];
+		for (const FOnStaticMeshBuilt &Callback:FinishedBuilds[FinishedIndex].Value.Callbacks)
+		{
+			Callback.ExecuteIfBound(StaticMesh);
+		}
+		OnBuildComplete.Broadcast(FinishedBuilds[FinishedIndex].Key, StaticMesh);
+	}
+
+	// Keep ticking.
+	return true;
+}
+
+UStaticMesh *FStaticMeshBuildQueue::FinishBuild(
+	const FString &PackageName,
+	const FPendingBuild &Build,
+	FRawMesh &RawMesh)
+{
+	MDT_SCOPE_CYCLE_COUNTER(STAT_MDT_FinishBuild);
+
+#if WITH_EDITOR
+	//  Check we got valid data
+	if (RawMesh.VertexPositions.Num()<3||RawMesh.WedgeIndices.Num()<3)
+	{
+		UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Mesh data not valid, need at least 3 vertices"));
+		return nullptr;
+	}
+
+	// Create the static mesh resource
+	UPackage *Package = CreatePackage(nullptr, *PackageName);
+	UStaticMesh *NewStaticMesh = NewObject<UStaticMesh>(
+		Package, FName(*Build.AssetName), RF_Public|RF_Standalone
+		);
+	NewStaticMesh->InitResources();
+	NewStaticMesh->LightingGuid = FGuid::NewGuid();
+
+	// Add the data to the static mesh
+	FStaticMeshSourceModel* SourceModel = new (NewStaticMesh->SourceModels) FStaticMeshSourceModel();
+	SourceModel->BuildSettings.bRecomputeNormals = false;
+	SourceModel->BuildSettings.bRecomputeTangents = false;
+	SourceModel->BuildSettings.bRemoveDegenerates = false;
+	SourceModel->BuildSettings.bUseHighPrecisionTangentBasis = false;
+	SourceModel->BuildSettings.bUseFullPrecisionUVs = false;
+	SourceModel->BuildSettings.bGenerateLightmapUVs = true;
+	SourceModel->BuildSettings.SrcLightmapIndex = 0;
+	SourceModel->BuildSettings.DstLightmapIndex = 1;
+	SourceModel->RawMeshBulkData->SaveRawMesh(RawMesh);
+
+	// Copy materials
+	for (auto &material:Build.Materials)
+	{
+		NewStaticMesh->StaticMaterials.Add(FStaticMaterial(material));
+	}
+
+	//Set the Imported version before calling the build
+	NewStaticMesh->ImportVersion = EImportStaticMeshVersion::LastVersion;
+
+	// Build mesh from source
+	NewStaticMesh->Build(false);
+	NewStaticMesh->PostEditChange();
+
+	// Notify asset registry of new asset
+	FAssetRegistryModule::AssetCreated(NewStaticMesh);
+	UE_LOG(MDTLog, Log, TEXT("SaveToStaticMesh: Built %s (revision %u)"), *PackageName, Build.Revision);
+	return NewStaticMesh;
+#else
+	UE_LOG(MDTLog, Warning, TEXT("SaveToStaticMesh: Cannot run outside of editor"));
+	return nullptr;
+#endif
+}
@@ -0,0 +1,210 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "Misc/AutomationTest.h"
+#include "DeformationCore.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	static_assert(sizeof(DeformationCore::Float3)==sizeof(FVector), "Float3 must be laid out as FVector");
+
+	/// Positions scattered around the origin, at least a few dozen so the tests cover more than
+	/// a trivial run
+	TArray<FVector> CreateTestPositions()
+	{
+		TArray<FVector> Positions;
+		for (int32 Index = 0; Index<67; ++Index)
+		{
+			Positions.Add(FVector(FMath::Sin(Index*0.7f)*120.0f, FMath::Cos(Index*1.3f)*80.0f, Index*3.0f-100.0f));
+		}
+		return Positions;
+	}
+
+	/// A weight for each position, including 0.0 and 1.0
+	TArray<float> CreateTestWeights(int32 Count)
+	{
+		TArray<float> Weights;
+		for (int32 Index = 0; Index<Count; ++Index)
+		{
+			Weights.Add((Index%5)*0.25f);
+		}
+		return Weights;
+	}
+
+	DeformationCore::Float3 *ToCore(FVector *Vectors)
+	{
+		return reinterpret_cast<DeformationCore::Float3 *>(Vectors);
+	}
+
+	DeformationCore::Float3 ToCore(const FVector &Vector)
+	{
+		return {Vector.X, Vector.Y, Vector.Z};
+	}
+
+	/// Check each position against the expected one, to within a small tolerance as the core
+	/// doesn't use the engine's math.
+	void TestSamePositions(FAutomationTestBase &Test, const TCHAR *What, const TArray<FVector> &Actual, const TArray<FVector> &Expected)
+	{
+		for (int32 Index = 0; Index<Expected.Num(); ++Index)
+		{
+			if (!Actual[Index].Equals(Expected[Index], 1.e-3f))
+			{
+				Test.AddError(FString::Printf(TEXT("%s: position %d is %s, expected %s"),
+					What, Index, *Actual[Index].ToString(), *Expected[Index].ToString()));
+				return;
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeformationCoreDeformersTest, "MeshDeformationToolkit.DeformationCore.Deformers",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FDeformationCoreDeformersTest::RunTest(const FString &Parameters)
+{
+	const TArray<FVector> Positions = CreateTestPositions();
+	const TArray<float> Weights = CreateTestWeights(Positions.Num());
+	const FVector Center(10.0f, -20.0f, 5.0f);
+	const FVector Axis(1.0f, 2.0f, 0.5f);
+
+	// Each deformer is compared with the same deformation done with the engine's math.
+	{
+		TArray<FVector> Actual = Positions, Expected = Positions;
+		DeformationCore::RotateAroundAxis(
+			ToCore(Actual.GetData()), Actual.Num(), ToCore(Center), ToCore(Axis), ToCore(Axis.GetSafeNormal()), 60.0f,
+			Weights.GetData());
+		for (int32 Index = 0; Index<Expected.Num(); ++Index)
+		{
+			const FVector ClosestPointOnLine = FMath::ClosestPointOnInfiniteLine(Center, Center+Axis, Expected[Index]);
+			Expected[Index] = ClosestPointOnLine+
+				(Expected[Index]-ClosestPointOnLine).RotateAngleAxis(60.0f*Weights[Index], Axis.GetSafeNormal());
+		}
+		TestSamePositions(*this, TEXT("RotateAroundAxis"), Actual, Expected);
+	}
+	{
+		TArray<FVector> Actual = Positions, Expected = Positions;
+		DeformationCore::LerpTowards(ToCore(Actual.GetData()), Actual.Num(), ToCore(Center), 0.4f, Weights.GetData());
+		for (int32 Index = 0; Index<Expected.Num(); ++Index)
+		{
+			Expected[Index] = FMath::Lerp(Expected[Index], Center, 0.4f*Weights[Index]);
+		}
+		TestSamePositions(*this, TEXT("LerpTowards"), Actual, Expected);
+	}
+	{
+		TArray<FVector> Actual = Positions, Expected = Positions;
+		TArray<FVector> Normals;
+		for (const FVector &Position:Positions)
+		{
+			Normals.Add(Position.GetSafeNormal());
+		}
+		DeformationCore::Inflate(
+			ToCore(Actual.GetData()), reinterpret_cast<const DeformationCore::Float3 *>(Normals.GetData()), Actual.Num(),
+			7.0f, nullptr);
+		for (int32 Index = 0; Index<Expected.Num(); ++Index)
+		{
+			Expected[Index] += Normals[Index]*7.0f;
+		}
+		TestSamePositions(*this, TEXT("Inflate"), Actual, Expected);
+	}
+	{
+		TArray<FVector> Actual = Positions, Expected = Positions;
+		DeformationCore::Spherize(ToCore(Actual.GetData()), Actual.Num(), ToCore(Center), 50.0f, 0.8f, Weights.GetData());
+		for (int32 Index = 0; Index<Expected.Num(); ++Index)
+		{
+			const FVector RelativeToCenter = Expected[Index]-Center;
+			Expected[Index] = Center+
+				RelativeToCenter.GetSafeNormal()*FMath::Lerp(RelativeToCenter.Size(), 50.0f, 0.8f*Weights[Index]);
+		}
+		TestSamePositions(*this, TEXT("Spherize"), Actual, Expected);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeformationCoreWeightsTest, "MeshDeformationToolkit.DeformationCore.Weights",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FDeformationCoreWeightsTest::RunTest(const FString &Parameters)
+{
+	TArray<FVector> Positions = CreateTestPositions();
+	TArray<float> Out;
+	Out.SetNumUninitialized(Positions.Num());
+
+	const FVector Center(0.0f, 0.0f, 0.0f);
+	DeformationCore::SelectNear(ToCore(Positions.GetData()), Positions.Num(), ToCore(Center), 50.0f, 150.0f, Out.GetData());
+	for (int32 Index = 0; Index<Positions.Num(); ++Index)
+	{
+		const float Distance = Positions[Index].Size();
+		const float Expected = Distance<=50.0f ? 1.0f : Distance>=150.0f ? 0.0f : 1.0f-(Distance-50.0f)/100.0f;
+		if (!FMath::IsNearlyEqual(Out[Index], Expected, 1.e-4f))
+		{
+			AddError(FString::Printf(TEXT("SelectNear: weight %d is %f, expected %f"), Index, Out[Index], Expected));
+			break;
+		}
+	}
+
+	// The volume includes its faces.
+	const TArray<FVector> Corners = {FVector(-10.0f, -10.0f, -10.0f), FVector(10.0f, 10.0f, 10.0f), FVector(10.0f, 0.0f, 10.01f)};
+	TArray<float> InVolume;
+	InVolume.SetNumUninitialized(Corners.Num());
+	DeformationCore::SelectInVolume(
+		reinterpret_cast<const DeformationCore::Float3 *>(Corners.GetData()), Corners.Num(),
+		ToCore(FVector(10.0f, 10.0f, 10.0f)), ToCore(FVector(-10.0f, -10.0f, -10.0f)), InVolume.GetData());
+	TestEqual(TEXT("SelectInVolume on the minimum corner"), InVolume[0], 1.0f);
+	TestEqual(TEXT("SelectInVolume on the maximum corner"), InVolume[1], 1.0f);
+	TestEqual(TEXT("SelectInVolume just outside"), InVolume[2], 0.0f);
+
+	// The weight functions may write over their input.
+	TArray<float> Weights = CreateTestWeights(Positions.Num());
+	DeformationCore::RemapToRange(Weights.GetData(), 2.0f, 4.0f, Weights.Num(), Weights.GetData());
+	TestEqual(TEXT("RemapToRange minimum"), FMath::Min(Weights), 2.0f);
+	TestEqual(TEXT("RemapToRange maximum"), FMath::Max(Weights), 4.0f);
+
+	DeformationCore::Set(0.5f, Weights.Num(), Weights.GetData());
+	DeformationCore::RemapToRange(Weights.GetData(), 2.0f, 4.0f, Weights.Num(), Weights.GetData());
+	TestEqual(TEXT("RemapToRange of a flat input"), FMath::Max(Weights), 2.0f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDeformationCoreMasksTest, "MeshDeformationToolkit.DeformationCore.Masks",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FDeformationCoreMasksTest::RunTest(const FString &Parameters)
+{
+	// A partial last word, to check the bits past the last weight stay clear.
+	const int32 Count = 100;
+	const int32 WordCount = (Count+31)/32;
+	TArray<float> Weights = CreateTestWeights(Count);
+
+	TArray<uint32> Mask, NotMask;
+	Mask.SetNumUninitialized(WordCount);
+	NotMask.SetNumUninitialized(WordCount);
+	DeformationCore::PackMask(Weights.GetData(), 0.5f, Count, Mask.GetData());
+	DeformationCore::NotMask(Mask.GetData(), Count, NotMask.GetData());
+
+	int32 ExpectedCount = 0;
+	for (const float Weight:Weights)
+	{
+		ExpectedCount += Weight>=0.5f ? 1 : 0;
+	}
+	TestEqual(TEXT("CountMask"), DeformationCore::CountMask(Mask.GetData(), Count), ExpectedCount);
+	TestEqual(TEXT("CountMask of NotMask"), DeformationCore::CountMask(NotMask.GetData(), Count), Count-ExpectedCount);
+	TestTrue(TEXT("NotMask clears the bits past the end"), NotMask.Last()>>(Count%32)==0);
+
+	// Unpacking from part way through a word matches the weights it was packed from.
+	TArray<float> Unpacked;
+	Unpacked.SetNumUninitialized(Count-37);
+	DeformationCore::UnpackMask(Mask.GetData(), 37, Unpacked.Num(), Unpacked.GetData());
+	for (int32 Index = 0; Index<Unpacked.Num(); ++Index)
+	{
+		if (Unpacked[Index]!=(Weights[37+Index]>=0.5f ? 1.0f : 0.0f))
+		{
+			AddError(FString::Printf(TEXT("UnpackMask: weight %d is %f"), 37+Index, Unpacked[Index]));
+			break;
+		}
+	}
+	return true;
+}
+
+#endif
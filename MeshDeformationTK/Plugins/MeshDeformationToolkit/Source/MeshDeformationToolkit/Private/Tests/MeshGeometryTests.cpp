@@ -0,0 +1,386 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Developer/RawMesh/Public/RawMesh.h"
+#include "AllocationCounter.h"
+#include "MeshGeometry.h"
+#include "SelectionSet.h"
+#include "Utility.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/// Small enough that every section is split into several chunks, and chunks end part way
+	/// through a section.  None are multiples of four, so the chunks don't start on the same
+	/// boundaries as the vectorized kernels' groups of four.
+	const TArray<int32> TestChunkSizes = {1, 7, 333, 1001};
+
+	/// Fill a MeshGeometry with several rippled square grids of different sizes, so the chunks
+	/// cross section boundaries.
+	void BuildTestGrids(UMeshGeometry *MeshGeometry)
+	{
+		const TArray<int32> Sides = {37, 64, 23};
+		const float Spacing = 10.0f;
+
+		MeshGeometry->Sections.Empty(Sides.Num());
+		for (int32 SectionIndex = 0; SectionIndex<Sides.Num(); ++SectionIndex)
+		{
+			const int32 Side = Sides[SectionIndex];
+			FSectionGeometry &Section = MeshGeometry->Sections.AddDefaulted_GetRef();
+			Section.Vertices.SetNumUninitialized(Side*Side);
+			Section.Normals.SetNumUninitialized(Side*Side);
+			TArray<FVector2D> &UVs = Section.GetMutableUVs(false);
+			UVs.SetNumUninitialized(Side*Side);
+			Section.GetMutableTangents(false).Init(FProcMeshTangent(1.0f, 0.0f, 0.0f), Side*Side);
+
+			for (int32 Y = 0; Y<Side; ++Y)
+			{
+				for (int32 X = 0; X<Side; ++X)
+				{
+					const int32 Index = Y*Side+X;
+					Section.Vertices[Index] = FVector(
+						X*Spacing, Y*Spacing, FMath::Sin(X*0.1f)*FMath::Cos(Y*0.1f)*Spacing+SectionIndex*100.0f);
+					Section.Normals[Index] = FVector(FMath::Sin(X*0.2f), FMath::Cos(Y*0.2f), 1.0f).GetSafeNormal();
+					UVs[Index] = FVector2D((float)X/(Side-1), (float)Y/(Side-1));
+				}
+			}
+
+			TArray<int32> &Triangles = Section.GetMutableTriangles(false);
+			for (int32 Y = 0; Y<Side-1; ++Y)
+			{
+				for (int32 X = 0; X<Side-1; ++X)
+				{
+					const int32 Index = Y*Side+X;
+					Triangles.Append({Index, Index+Side, Index+1, Index+1, Index+Side, Index+Side+1});
+				}
+			}
+		}
+
+		MeshGeometry->RefreshCachedCounts();
+	}
+
+	/// Check that two geometries have exactly the same vertices and normals.
+	///
+	/// \return *True* if they match
+	bool TestSameGeometry(FAutomationTestBase &Test, const FString &What, const UMeshGeometry *Actual, const UMeshGeometry *Expected)
+	{
+		for (int32 SectionIndex = 0; SectionIndex<Expected->Sections.Num(); ++SectionIndex)
+		{
+			const FSectionGeometry &ActualSection = Actual->Sections[SectionIndex];
+			const FSectionGeometry &ExpectedSection = Expected->Sections[SectionIndex];
+			for (int32 VertexIndex = 0; VertexIndex<ExpectedSection.Vertices.Num(); ++VertexIndex)
+			{
+				if (ActualSection.Vertices[VertexIndex]!=ExpectedSection.Vertices[VertexIndex] ||
+					ActualSection.Normals[VertexIndex]!=ExpectedSection.Normals[VertexIndex])
+				{
+					Test.AddError(FString::Printf(TEXT("%s: section %d vertex %d is %s, expected %s"),
+						*What, SectionIndex, VertexIndex,
+						*ActualSection.Vertices[VertexIndex].ToString(), *ExpectedSection.Vertices[VertexIndex].ToString()));
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/// Create a selection made of runs of vertices, which straddle the chunk boundaries and the
+	/// section boundaries.
+	///
+	/// \param Size				The number of weights
+	/// \param bMask			If true create a mask of runs of 50 in every 97 vertices, otherwise
+	///							a sparse selection of varied weights in runs of 30 in every 211
+	USelectionSet *CreateRunsSelection(int32 Size, bool bMask)
+	{
+		USelectionSet *Selection = NewObject<USelectionSet>(GetTransientPackage());
+		if (bMask)
+		{
+			Selection->SetMaskByBlock(Size, [](int32 Start, int32 Count, float *Out)
+			{
+				for (int32 BlockIndex = 0; BlockIndex<Count; ++BlockIndex)
+				{
+					Out[BlockIndex] = (Start+BlockIndex)%97<50 ? 1.0f : 0.0f;
+				}
+			});
+		}
+		else
+		{
+			Selection->SetWeightsByBlock(Size, [](int32 Start, int32 Count, float *Out)
+			{
+				for (int32 BlockIndex = 0; BlockIndex<Count; ++BlockIndex)
+				{
+					const int32 Index = Start+BlockIndex;
+					Out[BlockIndex] = Index%211<30 ? 0.2f+0.1f*(Index%7) : 0.0f;
+				}
+			});
+		}
+		return Selection;
+	}
+
+	/// Apply a matrix the way the deformers did before they were vectorized, one vertex at a
+	/// time with FMath::Lerp.  Vertices with a weight of 1.0 from a mask or no selection are
+	/// transformed without the blend, and those with a weight of 0.0 are left as they are.
+	void ApplyMatrixReference(UMeshGeometry *MeshGeometry, const FMatrix &Matrix, const USelectionSet *Selection)
+	{
+		TArray<float> Weights;
+		if (Selection)
+		{
+			Weights.SetNumUninitialized(Selection->Size());
+			Selection->CopyWeights(0, Selection->Size(), Weights.GetData());
+		}
+		const bool bBlend = Selection && !Selection->IsMask();
+
+		int32 NextWeightIndex = 0;
+		for (FSectionGeometry &Section:MeshGeometry->Sections)
+		{
+			for (FVector &Vertex:Section.Vertices)
+			{
+				const float Weight = Selection ? Weights[NextWeightIndex++] : 1.0f;
+				if (Weight==0.0f)
+				{
+					continue;
+				}
+				Vertex = bBlend ? FMath::Lerp(Vertex, Matrix.TransformPosition(Vertex), Weight) : Matrix.TransformPosition(Vertex);
+			}
+		}
+	}
+
+	/// A deformer to compare, applied to the geometry with the SelectionSet passed in
+	struct FTestDeformer
+	{
+		const TCHAR *Name;
+		TFunction<void(UMeshGeometry *, USelectionSet *)> Apply;
+	};
+
+	/// An affine deformer to compare, and the matrix it should apply
+	struct FTestAffineDeformer
+	{
+		const TCHAR *Name;
+		FMatrix Matrix;
+		TFunction<void(UMeshGeometry *, USelectionSet *)> Apply;
+	};
+
+	/// A SelectionSet to run each deformer with
+	struct FTestSelection
+	{
+		const TCHAR *Name;
+		USelectionSet *Selection;
+	};
+
+	/// Sets *mdt.ParallelChunkSize* for as long as this is in scope.
+	class FScopedParallelChunkSize
+	{
+	public:
+		explicit FScopedParallelChunkSize(int32 ChunkSize)
+			: Variable(IConsoleManager::Get().FindConsoleVariable(TEXT("mdt.ParallelChunkSize")))
+		{
+			check(Variable);
+			PreviousChunkSize = Variable->GetInt();
+			Variable->Set(ChunkSize, ECVF_SetByCode);
+		}
+
+		~FScopedParallelChunkSize()
+		{
+			Variable->Set(PreviousChunkSize, ECVF_SetByCode);
+		}
+
+	private:
+		IConsoleVariable *Variable;
+		int32 PreviousChunkSize;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshGeometryParallelMatchesSerialTest, "MeshDeformationToolkit.MeshGeometry.ParallelMatchesSerial",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FMeshGeometryParallelMatchesSerialTest::RunTest(const FString &Parameters)
+{
+	UMeshGeometry *Base = NewObject<UMeshGeometry>(GetTransientPackage());
+	BuildTestGrids(Base);
+	UMeshGeometry *Target = Base->Clone();
+	Target->Translate(FVector(5.0f, -3.0f, 20.0f), nullptr);
+
+	// Each deformer is run with no selection, full weights, sparse weights, and masks,
+	// including runs which cross the chunk boundaries.
+	const FVector Center = Base->GetBoundingBox().GetCenter();
+	const FVector Extent = Base->GetBoundingBox().GetExtent();
+	const FTestSelection Selections[] = {
+		{TEXT("no selection"), nullptr},
+		{TEXT("linear"), Base->SelectLinear(Center-Extent, Center+Extent)},
+		{TEXT("near"), Base->SelectNear(Center, 0.0f, Extent.Size()*0.1f)},
+		{TEXT("in volume"), Base->SelectInVolume(Center-Extent*0.3f, Center+Extent*0.3f)},
+		{TEXT("sparse runs"), CreateRunsSelection(Base->GetTotalVertexCount(), false)},
+		{TEXT("mask runs"), CreateRunsSelection(Base->GetTotalVertexCount(), true)},
+	};
+	TestTrue(TEXT("Near selection is sparse"), Selections[2].Selection->IsSparse());
+	TestTrue(TEXT("In volume selection is a mask"), Selections[3].Selection->IsMask());
+	TestTrue(TEXT("Sparse runs selection is sparse"), Selections[4].Selection->IsSparse());
+	TestTrue(TEXT("Mask runs selection is a mask"), Selections[5].Selection->IsMask());
+
+	const FTestDeformer Deformers[] = {
+		{TEXT("Translate"), [](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Translate(FVector(1.0f, 2.0f, 3.0f), Selection); }},
+		{TEXT("Rotate"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Rotate(FRotator(10.0f, 20.0f, 30.0f), Center, Selection); }},
+		{TEXT("Scale"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Scale(FVector(1.5f, 0.5f, 2.0f), Center, Selection); }},
+		{TEXT("Transform"), [&](UMeshGeometry *Geometry, USelectionSet *Selection)
+			{
+				Geometry->Transform(FTransform(FRotator(5.0f, 0.0f, 15.0f), FVector(3.0f, 0.0f, 1.0f), FVector(1.2f)), Center, Selection);
+			}},
+		{TEXT("RotateAroundAxis"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->RotateAroundAxis(Center, FVector(1.0f, 1.0f, 0.0f), 45.0f, Selection); }},
+		{TEXT("ScaleAlongAxis"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->ScaleAlongAxis(Center, FVector(0.0f, 1.0f, 1.0f), 1.7f, Selection); }},
+		{TEXT("Spherize"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Spherize(Extent.Size()*0.5f, 0.6f, Center, Selection); }},
+		{TEXT("Inflate"), [](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Inflate(4.0f, Selection); }},
+		{TEXT("MoveTowards"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->MoveTowards(Center, 25.0f, true, Selection); }},
+		{TEXT("LerpVector"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->LerpVector(Center, 0.3f, Selection); }},
+		{TEXT("Lerp"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Lerp(Target, 0.4f, Selection); }},
+	};
+
+	for (const FTestDeformer &Deformer:Deformers)
+	{
+		for (const FTestSelection &Selection:Selections)
+		{
+			UMeshGeometry *Serial = Base->Clone();
+			{
+				FScopedParallelChunkSize ChunkSize(0);
+				Deformer.Apply(Serial, Selection.Selection);
+			}
+			for (const int32 TestChunkSize:TestChunkSizes)
+			{
+				UMeshGeometry *Parallel = Base->Clone();
+				{
+					FScopedParallelChunkSize ChunkSize(TestChunkSize);
+					Deformer.Apply(Parallel, Selection.Selection);
+				}
+				TestSameGeometry(
+					*this, FString::Printf(TEXT("%s with %s in chunks of %d"), Deformer.Name, Selection.Name, TestChunkSize),
+					Parallel, Serial);
+			}
+		}
+	}
+
+	// The raw mesh is built a chunk of triangles at a time too.
+	FRawMesh SerialRawMesh, ParallelRawMesh;
+	{
+		FScopedParallelChunkSize ChunkSize(0);
+		Base->BuildRawMesh(SerialRawMesh);
+	}
+	{
+		FScopedParallelChunkSize ChunkSize(TestChunkSizes.Last());
+		Base->BuildRawMesh(ParallelRawMesh);
+	}
+	TestTrue(TEXT("BuildRawMesh vertex positions"), ParallelRawMesh.VertexPositions==SerialRawMesh.VertexPositions);
+	TestTrue(TEXT("BuildRawMesh wedge indices"), ParallelRawMesh.WedgeIndices==SerialRawMesh.WedgeIndices);
+	TestTrue(TEXT("BuildRawMesh wedge normals"), ParallelRawMesh.WedgeTangentZ==SerialRawMesh.WedgeTangentZ);
+	TestTrue(TEXT("BuildRawMesh wedge UVs"), ParallelRawMesh.WedgeTexCoords[0]==SerialRawMesh.WedgeTexCoords[0]);
+	TestTrue(TEXT("BuildRawMesh face materials"), ParallelRawMesh.FaceMaterialIndices==SerialRawMesh.FaceMaterialIndices);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshGeometryAffineMatchesReferenceTest, "MeshDeformationToolkit.MeshGeometry.AffineMatchesReference",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FMeshGeometryAffineMatchesReferenceTest::RunTest(const FString &Parameters)
+{
+	UMeshGeometry *Base = NewObject<UMeshGeometry>(GetTransientPackage());
+	BuildTestGrids(Base);
+
+	const FVector Center = Base->GetBoundingBox().GetCenter();
+	const FVector Extent = Base->GetBoundingBox().GetExtent();
+	const FTestSelection Selections[] = {
+		{TEXT("no selection"), nullptr},
+		{TEXT("linear"), Base->SelectLinear(Center-Extent, Center+Extent)},
+		{TEXT("sparse runs"), CreateRunsSelection(Base->GetTotalVertexCount(), false)},
+		{TEXT("mask runs"), CreateRunsSelection(Base->GetTotalVertexCount(), true)},
+	};
+
+	const FRotator Rotation(10.0f, 20.0f, 30.0f);
+	const FVector Scale(1.5f, 0.5f, 2.0f);
+	const FTransform Transform(FRotator(5.0f, 0.0f, 15.0f), FVector(3.0f, 0.0f, 1.0f), FVector(1.2f));
+	const FVector Delta(1.0f, 2.0f, 3.0f);
+	const FTestAffineDeformer Deformers[] = {
+		{TEXT("Rotate"), Utility::MatrixAboutCenter(FRotationMatrix(Rotation), Center),
+			[&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Rotate(Rotation, Center, Selection); }},
+		{TEXT("Scale"), Utility::MatrixAboutCenter(FScaleMatrix(Scale), Center),
+			[&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Scale(Scale, Center, Selection); }},
+		{TEXT("Transform"), Utility::MatrixAboutCenter(Transform.ToMatrixWithScale(), Center),
+			[&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Transform(Transform, Center, Selection); }},
+		{TEXT("Translate"), FTranslationMatrix(Delta),
+			[&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Translate(Delta, Selection); }},
+	};
+
+	// Whichever chunk or group of four a vertex falls in, it gets the scalar result exactly.
+	TArray<int32> ChunkSizes = TestChunkSizes;
+	ChunkSizes.Insert(0, 0);
+	for (const FTestAffineDeformer &Deformer:Deformers)
+	{
+		for (const FTestSelection &Selection:Selections)
+		{
+			UMeshGeometry *Expected = Base->Clone();
+			ApplyMatrixReference(Expected, Deformer.Matrix, Selection.Selection);
+
+			for (const int32 TestChunkSize:ChunkSizes)
+			{
+				UMeshGeometry *Actual = Base->Clone();
+				{
+					FScopedParallelChunkSize ChunkSize(TestChunkSize);
+					Deformer.Apply(Actual, Selection.Selection);
+				}
+				TestSameGeometry(
+					*this, FString::Printf(TEXT("%s with %s in chunks of %d"), Deformer.Name, Selection.Name, TestChunkSize),
+					Actual, Expected);
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMeshGeometryNoSteadyStateAllocationsTest, "MeshDeformationToolkit.MeshGeometry.NoSteadyStateAllocations",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FMeshGeometryNoSteadyStateAllocationsTest::RunTest(const FString &Parameters)
+{
+	UMeshGeometry *Geometry = NewObject<UMeshGeometry>(GetTransientPackage());
+	BuildTestGrids(Geometry);
+
+	const FVector Center = Geometry->GetBoundingBox().GetCenter();
+	const FVector Extent = Geometry->GetBoundingBox().GetExtent();
+	const FTestSelection Selections[] = {
+		{TEXT("no selection"), nullptr},
+		{TEXT("linear"), Geometry->SelectLinear(Center-Extent, Center+Extent)},
+		{TEXT("sparse runs"), CreateRunsSelection(Geometry->GetTotalVertexCount(), false)},
+		{TEXT("mask runs"), CreateRunsSelection(Geometry->GetTotalVertexCount(), true)},
+	};
+
+	const FTestDeformer Deformers[] = {
+		{TEXT("Translate"), [](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Translate(FVector(1.0f, 2.0f, 3.0f), Selection); }},
+		{TEXT("Rotate"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Rotate(FRotator(10.0f, 20.0f, 30.0f), Center, Selection); }},
+		{TEXT("Scale"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Scale(FVector(1.01f, 0.99f, 1.0f), Center, Selection); }},
+		{TEXT("RotateAroundAxis"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->RotateAroundAxis(Center, FVector(1.0f, 1.0f, 0.0f), 45.0f, Selection); }},
+		{TEXT("Spherize"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Spherize(Extent.Size()*0.5f, 0.6f, Center, Selection); }},
+		{TEXT("Inflate"), [](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->Inflate(4.0f, Selection); }},
+		{TEXT("LerpVector"), [&](UMeshGeometry *Geometry, USelectionSet *Selection) { Geometry->LerpVector(Center, 0.3f, Selection); }},
+	};
+
+	// The counter only sees this thread, so everything is kept on it.  The first run of each
+	// deformer is left uncounted so one-off work, such as unsharing the sections, isn't included.
+	FScopedParallelChunkSize ChunkSize(0);
+	for (const FTestDeformer &Deformer:Deformers)
+	{
+		for (const FTestSelection &Selection:Selections)
+		{
+			Deformer.Apply(Geometry, Selection.Selection);
+
+			int64 AllocationCount = 0;
+			{
+				FScopedAllocationCounter AllocationCounter;
+				Deformer.Apply(Geometry, Selection.Selection);
+				AllocationCount = AllocationCounter.GetAllocationCount();
+			}
+			TestEqual(*FString::Printf(TEXT("Allocations by %s with %s"), Deformer.Name, Selection.Name), AllocationCount, (int64)0);
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,173 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/ObjectReader.h"
+#include "Serialization/ObjectWriter.h"
+#include "SelectionSet.h"
+#include "SelectionSetBPLibrary.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/// More than one block of weights, with a partial block at the end
+	const int32 TestSelectionSize = 2*USelectionSet::WeightBlockSize+100;
+
+	/// Create a SelectionSet with its weights set by the function provided.
+	///
+	/// \param WeightAt			Called as WeightAt(Index) for each weight
+	template <typename WeightFunctionType>
+	USelectionSet *CreateTestSelectionSet(WeightFunctionType WeightAt)
+	{
+		USelectionSet *SelectionSet = USelectionSet::CreateAndCheckValid(
+			TestSelectionSize, GetTransientPackage(), TEXT("SelectionSetTests"));
+		TArray<float> &Weights = SelectionSet->GetMutableWeights();
+		for (int32 Index = 0; Index<Weights.Num(); ++Index)
+		{
+			Weights[Index] = WeightAt(Index);
+		}
+		return SelectionSet;
+	}
+
+	/// Save a SelectionSet and load it into a new one.
+	USelectionSet *RoundTrip(USelectionSet *SelectionSet)
+	{
+		TArray<uint8> Bytes;
+		FObjectWriter Writer(SelectionSet, Bytes);
+
+		USelectionSet *Loaded = NewObject<USelectionSet>(GetTransientPackage());
+		FObjectReader Reader(Loaded, Bytes);
+		return Loaded;
+	}
+
+	/// Check that two SelectionSets have the same weights, whatever form they're held in.
+	void TestSameWeights(FAutomationTestBase &Test, const TCHAR *What, const USelectionSet *Actual, const USelectionSet *Expected)
+	{
+		if (!Test.TestEqual(FString::Printf(TEXT("%s size"), What), Actual->Size(), Expected->Size()))
+		{
+			return;
+		}
+
+		TArray<float> ActualWeights, ExpectedWeights;
+		ActualWeights.SetNumUninitialized(Actual->Size());
+		ExpectedWeights.SetNumUninitialized(Expected->Size());
+		Actual->CopyWeights(0, Actual->Size(), ActualWeights.GetData());
+		Expected->CopyWeights(0, Expected->Size(), ExpectedWeights.GetData());
+		for (int32 Index = 0; Index<ActualWeights.Num(); ++Index)
+		{
+			if (ActualWeights[Index]!=ExpectedWeights[Index])
+			{
+				Test.AddError(FString::Printf(TEXT("%s: weight %d is %f, expected %f"),
+					What, Index, ActualWeights[Index], ExpectedWeights[Index]));
+				return;
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSelectionSetLazyRoundTripTest, "MeshDeformationToolkit.SelectionSet.LazyRoundTrip",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FSelectionSetLazyRoundTripTest::RunTest(const FString &Parameters)
+{
+	USelectionSet *Input = CreateTestSelectionSet([](int32 Index) { return (Index%7)/7.0f; });
+	USelectionSet *Lazy = USelectionSetBPLibrary::MultiplySelctionSetByFloat(Input, 0.5f);
+	TestTrue(TEXT("Lazy before saving"), Lazy->IsLazy());
+
+	USelectionSet *Loaded = RoundTrip(Lazy);
+	TestFalse(TEXT("Lazy after loading"), Loaded->IsLazy());
+
+	// Saving evaluates the expression in place, so what was written is Lazy's own weights.
+	TestFalse(TEXT("Lazy after saving"), Lazy->IsLazy());
+	TestSameWeights(*this, TEXT("Lazy"), Loaded, Lazy);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSelectionSetSparseRoundTripTest, "MeshDeformationToolkit.SelectionSet.SparseRoundTrip",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FSelectionSetSparseRoundTripTest::RunTest(const FString &Parameters)
+{
+	USelectionSet *Sparse = NewObject<USelectionSet>(GetTransientPackage());
+	Sparse->SetWeightsByBlock(TestSelectionSize, [](int32 Start, int32 Count, float *Out)
+	{
+		for (int32 BlockIndex = 0; BlockIndex<Count; ++BlockIndex)
+		{
+			const int32 Index = Start+BlockIndex;
+			Out[BlockIndex] = Index%50==0 ? 0.25f+(Index%3)*0.25f : 0.0f;
+		}
+	});
+	TestTrue(TEXT("Sparse before saving"), Sparse->IsSparse());
+
+	// Reading every weight mustn't convert it to the full weights.
+	const TArray<float> ExpectedWeights = Sparse->GetWeights();
+	TestTrue(TEXT("Sparse after GetWeights"), Sparse->IsSparse());
+
+	USelectionSet *Loaded = RoundTrip(Sparse);
+	TestTrue(TEXT("Sparse after loading"), Loaded->IsSparse());
+	TestSameWeights(*this, TEXT("Sparse"), Loaded, Sparse);
+	TestTrue(TEXT("Sparse GetWeights after loading"), Loaded->GetWeights()==ExpectedWeights);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSelectionSetMaskRoundTripTest, "MeshDeformationToolkit.SelectionSet.MaskRoundTrip",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FSelectionSetMaskRoundTripTest::RunTest(const FString &Parameters)
+{
+	USelectionSet *Mask = NewObject<USelectionSet>(GetTransientPackage());
+	Mask->SetMaskByBlock(TestSelectionSize, [](int32 Start, int32 Count, float *Out)
+	{
+		for (int32 BlockIndex = 0; BlockIndex<Count; ++BlockIndex)
+		{
+			const int32 Index = Start+BlockIndex;
+			Out[BlockIndex] = (Index/7)%3==0 ? 1.0f : 0.0f;
+		}
+	});
+	TestTrue(TEXT("Mask before saving"), Mask->IsMask());
+
+	// Reading every weight mustn't convert it to the full weights.
+	const TArray<float> ExpectedWeights = Mask->GetWeights();
+	TestTrue(TEXT("Mask after GetWeights"), Mask->IsMask());
+
+	USelectionSet *Loaded = RoundTrip(Mask);
+	TestTrue(TEXT("Mask after loading"), Loaded->IsMask());
+	TestTrue(TEXT("Mask words after loading"), Loaded->GetMaskWords()==Mask->GetMaskWords());
+	TestSameWeights(*this, TEXT("Mask"), Loaded, Mask);
+	TestTrue(TEXT("Mask GetWeights after loading"), Loaded->GetWeights()==ExpectedWeights);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSelectionSetContentHashTest, "MeshDeformationToolkit.SelectionSet.ContentHash",
+	EAutomationTestFlags::EditorContext|EAutomationTestFlags::EngineFilter)
+
+bool FSelectionSetContentHashTest::RunTest(const FString &Parameters)
+{
+	USelectionSet *SelectionSet = CreateTestSelectionSet([](int32 Index) { return (Index%7)/7.0f; });
+	const uint32 Hash = SelectionSet->GetContentHash();
+	const uint32 Revision = SelectionSet->GetRevision();
+	TestTrue(TEXT("Hash when nothing has changed"), SelectionSet->GetContentHash()==Hash);
+	TestTrue(TEXT("Revision when nothing has changed"), SelectionSet->GetRevision()==Revision);
+
+	// Each way of changing the weights gives a new hash, which is kept until the next change.
+	SelectionSet->GetMutableWeights()[10] = 0.5f;
+	const uint32 ChangedHash = SelectionSet->GetContentHash();
+	TestTrue(TEXT("Hash after GetMutableWeights"), ChangedHash!=Hash);
+	TestTrue(TEXT("Hash after GetMutableWeights, again"), SelectionSet->GetContentHash()==ChangedHash);
+
+	SelectionSet->SetAllWeights(0.25f);
+	TestTrue(TEXT("Hash after SetAllWeights"), SelectionSet->GetContentHash()!=ChangedHash);
+
+	USelectionSet *Source = CreateTestSelectionSet([](int32 Index) { return (Index%7)/7.0f; });
+	SelectionSet->CopyFrom(*Source);
+	TestTrue(TEXT("Hash after CopyFrom"), SelectionSet->GetContentHash()==Source->GetContentHash());
+
+	// A lazy SelectionSet is hashed by the weights its expression gives.
+	USelectionSet *Lazy = USelectionSetBPLibrary::MultiplySelctionSetByFloat(Source, 1.0f);
+	TestTrue(TEXT("Lazy before hashing"), Lazy->IsLazy());
+	TestTrue(TEXT("Hash of lazy"), Lazy->GetContentHash()==Source->GetContentHash());
+	return true;
+}
+
+#endif
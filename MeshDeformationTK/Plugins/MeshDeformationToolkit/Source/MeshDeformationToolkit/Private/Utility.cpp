@@ -79,3 +79,9 @@ FVector Utility::NearestPointOnPlane(FVector Vertex, FVector PointOnPlane, FVect
 	return (Vertex-(PlaneNormal * DistanceToPlane));
 }
 
+FMatrix Utility::MatrixAboutCenter(const FMatrix &Matrix, const FVector &Center)
+{
+	// UE4 matrices transform row vectors, so this reads left to right: move the center to
+	// the origin, apply the matrix, then move it back.
+	return FTranslationMatrix(-Center) * Matrix * FTranslationMatrix(Center);
+}
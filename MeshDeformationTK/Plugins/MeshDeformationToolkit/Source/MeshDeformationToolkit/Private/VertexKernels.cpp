@@ -0,0 +1,103 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#include "MeshDeformationToolkit.h"
+#include "Math/VectorRegister.h"
+
+#include "VertexKernels.h"
+
+namespace
+{
+	/// Each matrix element splatted across a register.  UE4 matrices transform row vectors,
+	/// so the new X is X*M[0][0] + Y*M[1][0] + Z*M[2][0] + M[3][0] and so on.
+	struct FSplatMatrix
+	{
+		VectorRegister M[4][3];
+
+		explicit FSplatMatrix(const FMatrix &Matrix)
+		{
+			for (int32 Row = 0; Row<4; ++Row)
+			{
+				for (int32 Column = 0; Column<3; ++Column)
+				{
+					M[Row][Column] = VectorSetFloat1(Matrix.M[Row][Column]);
+				}
+			}
+		}
+	};
+
+	/// One component of four transformed positions.  The terms are added as
+	/// (X*M0 + Y*M1) + (Z*M2 + M3), the same as VectorTransformVector and so
+	/// FMatrix::TransformPosition, using separate multiplies and adds so nothing is fused.
+	FORCEINLINE VectorRegister TransformComponent(
+		const VectorRegister &X, const VectorRegister &Y, const VectorRegister &Z, const FSplatMatrix &Matrix,
+		int32 Column)
+	{
+		return VectorAdd(
+			VectorAdd(VectorMultiply(X, Matrix.M[0][Column]), VectorMultiply(Y, Matrix.M[1][Column])),
+			VectorAdd(VectorMultiply(Z, Matrix.M[2][Column]), Matrix.M[3][Column]));
+	}
+
+	/// Transform and blend four packed positions.  Four packed FVectors are twelve floats,
+	/// which load as three registers (X0 Y0 Z0 X1)(Y1 Z1 X2 Y2)(Z2 X3 Y3 Z3) and are
+	/// transposed into one register each of X, Y and Z.  VectorLoad/VectorStore don't
+	/// require alignment.
+	FORCEINLINE void TransformFourPositions(float *Floats, const FSplatMatrix &Matrix, const float *Weights)
+	{
+		const VectorRegister A = VectorLoad(Floats);
+		const VectorRegister B = VectorLoad(Floats+4);
+		const VectorRegister C = VectorLoad(Floats+8);
+
+		const VectorRegister OriginalX = VectorShuffle(A, VectorShuffle(B, C, 2, 2, 1, 1), 0, 3, 0, 2);
+		const VectorRegister OriginalY = VectorShuffle(VectorShuffle(A, B, 1, 1, 0, 0), VectorShuffle(B, C, 3, 3, 2, 2), 0, 2, 0, 2);
+		const VectorRegister OriginalZ = VectorShuffle(VectorShuffle(A, B, 2, 2, 1, 1), C, 0, 2, 0, 3);
+
+		VectorRegister X = TransformComponent(OriginalX, OriginalY, OriginalZ, Matrix, 0);
+		VectorRegister Y = TransformComponent(OriginalX, OriginalY, OriginalZ, Matrix, 1);
+		VectorRegister Z = TransformComponent(OriginalX, OriginalY, OriginalZ, Matrix, 2);
+
+		// Lerp as Original + (Transformed-Original) * Weight like FMath::Lerp, skipping the
+		// blend when unweighted.
+		if (Weights)
+		{
+			const VectorRegister Weight = VectorLoad(Weights);
+			X = VectorAdd(OriginalX, VectorMultiply(VectorSubtract(X, OriginalX), Weight));
+			Y = VectorAdd(OriginalY, VectorMultiply(VectorSubtract(Y, OriginalY), Weight));
+			Z = VectorAdd(OriginalZ, VectorMultiply(VectorSubtract(Z, OriginalZ), Weight));
+		}
+
+		// And transpose back to packed positions.
+		VectorStore(VectorShuffle(VectorShuffle(X, Y, 0, 0, 0, 0), VectorShuffle(Z, X, 0, 0, 1, 1), 0, 2, 0, 2), Floats);
+		VectorStore(VectorShuffle(VectorShuffle(Y, Z, 1, 1, 1, 1), VectorShuffle(X, Y, 2, 2, 2, 2), 0, 2, 0, 2), Floats+4);
+		VectorStore(VectorShuffle(VectorShuffle(Z, X, 2, 2, 3, 3), VectorShuffle(Y, Z, 3, 3, 3, 3), 0, 2, 0, 2), Floats+8);
+	}
+}
+
+void VertexKernels::TransformPositions(FVector *Positions, int32 Count, const FMatrix &Matrix, const float *Weights)
+{
+	const FSplatMatrix SplatMatrix(Matrix);
+
+	// Four vertices at a time.
+	const int32 VectorCount = Count & ~3;
+	for (int32 Index = 0; Index<VectorCount; Index += 4)
+	{
+		TransformFourPositions(&Positions[Index].X, SplatMatrix, Weights ? &Weights[Index] : nullptr);
+	}
+
+	// Any remaining vertices are padded out to four and go through exactly the same
+	// arithmetic, so a vertex's result doesn't depend on where the run or chunk it's in
+	// starts.
+	const int32 RemainderCount = Count-VectorCount;
+	if (RemainderCount>0)
+	{
+		FVector RemainderPositions[4] = {FVector::ZeroVector, FVector::ZeroVector, FVector::ZeroVector, FVector::ZeroVector};
+		float RemainderWeights[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		FMemory::Memcpy(RemainderPositions, &Positions[VectorCount], RemainderCount*sizeof(FVector));
+		if (Weights)
+		{
+			FMemory::Memcpy(RemainderWeights, &Weights[VectorCount], RemainderCount*sizeof(float));
+		}
+
+		TransformFourPositions(&RemainderPositions[0].X, SplatMatrix, Weights ? RemainderWeights : nullptr);
+		FMemory::Memcpy(&Positions[VectorCount], RemainderPositions, RemainderCount*sizeof(FVector));
+	}
+}
@@ -0,0 +1,52 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// Counts the allocations made on the calling thread for as long as it's in scope, for the
+/// benchmark commandlet and the tests which check the deformers don't allocate.
+///
+/// The first counter created puts a counting allocator in front of GMalloc, which stays there
+/// for the rest of the run.  It passes everything on to the allocator it wraps, so a thread
+/// which still sees the old GMalloc, or frees memory allocated through the other one, is
+/// unaffected.  Only allocations on a thread with a counter in scope are counted, so work
+/// handed to other threads (such as a deformer's *ParallelFor* chunks) isn't included: run
+/// with *mdt.ParallelChunkSize* at 0 to keep it all on the counting thread.
+///
+/// A reallocation which grows a buffer is counted as a new allocation of its full size, as it
+/// usually moves.  Frees aren't counted.
+class MESHDEFORMATIONTOOLKIT_API FScopedAllocationCounter
+{
+public:
+
+	/// Start counting the allocations on the calling thread
+	FScopedAllocationCounter();
+
+	/// Stop counting, adding the counts to any counter this one was nested inside
+	~FScopedAllocationCounter();
+
+	FScopedAllocationCounter(const FScopedAllocationCounter &) = delete;
+	FScopedAllocationCounter &operator=(const FScopedAllocationCounter &) = delete;
+
+	/// Zero the counts
+	void Reset();
+
+	/// The number of allocations made since the counter was created or reset
+	int64 GetAllocationCount() const;
+
+	/// The number of bytes requested since the counter was created or reset
+	int64 GetBytesAllocated() const;
+
+	/// Count an allocation of Size bytes against the counter in scope on the calling thread,
+	/// if there is one.  This is called by the counting allocator.
+	static void RecordAllocation(SIZE_T Size);
+
+private:
+
+	/// The counter which was in scope on this thread when this one was created
+	FScopedAllocationCounter *OuterCounter;
+
+	int64 AllocationCount = 0;
+	int64 BytesAllocated = 0;
+};
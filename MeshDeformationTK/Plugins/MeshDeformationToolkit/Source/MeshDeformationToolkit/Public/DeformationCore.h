@@ -0,0 +1,250 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+// This header and DeformationCore.cpp deliberately use no engine types or headers so
+// they can be compiled on their own, outside of the engine, for testing and profiling the
+// kernels.  Standalone/CMakeLists.txt in the plugin does this.
+#include <cstdint>
+
+#ifndef MESHDEFORMATIONTOOLKIT_API
+#define MESHDEFORMATIONTOOLKIT_API
+#endif
+
+/// The deformation and selection math behind *MeshGeometry* and *SelectionSetBPLibrary*,
+/// written against plain runs of positions and weights rather than UObjects.
+///
+/// The UObject classes handle validation, logging, allocation, and splitting the work
+/// into chunks, then hand each contiguous run of vertices to one of these functions.
+///
+/// As with *VertexKernels* the deformers take an optional pointer to the weights for the
+/// vertices being processed, with *nullptr* meaning a weight of 1.0 for every vertex.  The
+/// weight functions write to *Out*, which may be the same array as any of their inputs.
+class MESHDEFORMATIONTOOLKIT_API DeformationCore
+{
+public:
+
+	/// A position or direction, laid out the same as the engine's *FVector* so a run of
+	/// vertices can be passed in without copying
+	struct Float3
+	{
+		float X;
+		float Y;
+		float Z;
+	};
+
+	// Deformers
+
+	/// Move each position along its normal, Position = Lerp(Position, Position+Normal*Offset, Weight)
+	///
+	/// \param Positions		The positions to move in place
+	/// \param Normals			The normal for each position
+	/// \param Count			The number of positions
+	/// \param Offset			The distance to move along the normal
+	/// \param Weights			The weight for each position, or nullptr for all 1.0
+	static void Inflate(Float3 *Positions, const Float3 *Normals, int32_t Count, float Offset, const float *Weights);
+
+	/// Blend each position towards a point, Position = Lerp(Position, Target, Alpha*Weight)
+	///
+	/// \param Positions		The positions to move in place
+	/// \param Count			The number of positions
+	/// \param Target			The point to blend towards
+	/// \param Alpha			How far to blend, 0.0 leaves the positions unchanged
+	/// \param Weights			The weight for each position, or nullptr for all 1.0
+	static void LerpTowards(Float3 *Positions, int32_t Count, const Float3 &Target, float Alpha, const float *Weights);
+
+	/// Move each position a fixed distance towards a point
+	///
+	/// \param Positions		The positions to move in place
+	/// \param Count			The number of positions
+	/// \param Target			The point to move towards
+	/// \param Distance			The distance to move, scaled by the weight
+	/// \param bLimitAtTarget	If true positions stop at the target rather than passing through it
+	/// \param Weights			The weight for each position, or nullptr for all 1.0
+	static void MoveTowards(
+		Float3 *Positions, int32_t Count, const Float3 &Target, float Distance, bool bLimitAtTarget,
+		const float *Weights);
+
+	/// Rotate each position around an infinite line, by an angle scaled by the weight
+	///
+	/// \param Positions		The positions to rotate in place
+	/// \param Count			The number of positions
+	/// \param Center			A point on the axis
+	/// \param Axis				The direction of the axis, which doesn't need to be normalized
+	/// \param UnitAxis			The direction of the axis, normalized
+	/// \param AngleInDegrees	The angle to rotate by
+	/// \param Weights			The weight for each position, or nullptr for all 1.0
+	static void RotateAroundAxis(
+		Float3 *Positions, int32_t Count, const Float3 &Center, const Float3 &Axis, const Float3 &UnitAxis,
+		float AngleInDegrees, const float *Weights);
+
+	/// Scale each position's distance along an infinite line from a center point
+	///
+	/// \param Positions		The positions to scale in place
+	/// \param Count			The number of positions
+	/// \param Center			The point on the axis which is scaled about
+	/// \param Axis				The direction of the axis, which doesn't need to be normalized
+	/// \param Scale			The scale to apply along the axis
+	/// \param Weights			The weight for each position, or nullptr for all 1.0
+	static void ScaleAlongAxis(
+		Float3 *Positions, int32_t Count, const Float3 &Center, const Float3 &Axis, float Scale,
+		const float *Weights);
+
+	/// Blend each position's distance from a center point towards a fixed radius
+	///
+	/// \param Positions		The positions to move in place
+	/// \param Count			The number of positions
+	/// \param Center			The center of the sphere
+	/// \param Radius			The radius of the sphere
+	/// \param Strength			How far to blend towards the sphere, scaled by the weight
+	/// \param Weights			The weight for each position, or nullptr for all 1.0
+	static void Spherize(
+		Float3 *Positions, int32_t Count, const Float3 &Center, float Radius, float Strength,
+		const float *Weights);
+
+	// Selectors, which each write one weight per position
+
+	/// Select positions inside an axis-aligned box, inclusive, with 1.0 inside and 0.0 outside
+	///
+	/// \param Positions		The positions to select from
+	/// \param Count			The number of positions
+	/// \param CornerA			One corner of the box
+	/// \param CornerB			The opposite corner of the box
+	/// \param Out				The weights to write
+	static void SelectInVolume(const Float3 *Positions, int32_t Count, const Float3 &CornerA, const Float3 &CornerB, float *Out);
+
+	/// Select positions by how far along a line they are, 0.0 at the start and 1.0 at the end
+	///
+	/// \param Positions		The positions to select from
+	/// \param Count			The number of positions
+	/// \param LineStart		The start of the line, which must differ from LineEnd
+	/// \param LineEnd			The end of the line
+	/// \param bLimitToLine		If true positions beyond the end of the line get 0.0 rather than 1.0
+	/// \param Out				The weights to write
+	static void SelectLinear(
+		const Float3 *Positions, int32_t Count, const Float3 &LineStart, const Float3 &LineEnd, bool bLimitToLine,
+		float *Out);
+
+	/// Select positions near a point, 1.0 within InnerRadius falling to 0.0 at OuterRadius
+	///
+	/// \param Positions		The positions to select from
+	/// \param Count			The number of positions
+	/// \param Center			The point to measure from
+	/// \param InnerRadius		The distance within which positions are fully selected
+	/// \param OuterRadius		The distance beyond which positions are not selected
+	/// \param Out				The weights to write
+	static void SelectNear(
+		const Float3 *Positions, int32_t Count, const Float3 &Center, float InnerRadius, float OuterRadius,
+		float *Out);
+
+	/// Select positions near a line, 1.0 within InnerRadius falling to 0.0 at OuterRadius
+	///
+	/// \param Positions		The positions to select from
+	/// \param Count			The number of positions
+	/// \param LineStart		The start of the line
+	/// \param LineEnd			The end of the line
+	/// \param InnerRadius		The distance within which positions are fully selected
+	/// \param OuterRadius		The distance beyond which positions are not selected
+	/// \param bLineIsInfinite	If true the line extends beyond its start and end
+	/// \param Out				The weights to write
+	static void SelectNearLine(
+		const Float3 *Positions, int32_t Count, const Float3 &LineStart, const Float3 &LineEnd,
+		float InnerRadius, float OuterRadius, bool bLineIsInfinite, float *Out);
+
+	// Weight arithmetic, all element-wise
+
+	/// Out = A+B
+	static void Add(const float *A, const float *B, int32_t Count, float *Out);
+
+	/// Out = A+Value
+	static void AddScalar(const float *A, float Value, int32_t Count, float *Out);
+
+	/// Out = Clamp(A, Min, Max)
+	static void Clamp(const float *A, float Min, float Max, int32_t Count, float *Out);
+
+	/// Out = A/B
+	static void Divide(const float *A, const float *B, int32_t Count, float *Out);
+
+	/// Out = A/Value, Value must not be zero
+	static void DivideByScalar(const float *A, float Value, int32_t Count, float *Out);
+
+	/// Out = Value/A, with A kept at least 0.01 away from zero
+	static void DivideScalarBy(float Value, const float *A, int32_t Count, float *Out);
+
+	/// Out = Lerp(A, B, Alpha)
+	static void Lerp(const float *A, const float *B, float Alpha, int32_t Count, float *Out);
+
+	/// Out = Lerp(A, B, Alpha) with a separate Alpha for each weight
+	static void LerpByWeights(const float *A, const float *B, const float *Alpha, int32_t Count, float *Out);
+
+	/// Out = Lerp(A, Value, Alpha)
+	static void LerpToScalar(const float *A, float Value, float Alpha, int32_t Count, float *Out);
+
+	/// Out = Max(A, B)
+	static void Max(const float *A, const float *B, int32_t Count, float *Out);
+
+	/// Out = Max(A, Value)
+	static void MaxScalar(const float *A, float Value, int32_t Count, float *Out);
+
+	/// Out = Min(A, B)
+	static void Min(const float *A, const float *B, int32_t Count, float *Out);
+
+	/// Out = Min(A, Value)
+	static void MinScalar(const float *A, float Value, int32_t Count, float *Out);
+
+	/// Out = A*B
+	static void Multiply(const float *A, const float *B, int32_t Count, float *Out);
+
+	/// Out = A*Value
+	static void MultiplyScalar(const float *A, float Value, int32_t Count, float *Out);
+
+	/// Out = 1-A
+	static void OneMinus(const float *A, int32_t Count, float *Out);
+
+	/// Out = A^Exp
+	static void Power(const float *A, float Exp, int32_t Count, float *Out);
+
+	/// Repeat the 0-1 range NumberOfRepeats times, optionally reversing every other repeat
+	static void RemapPeriodic(const float *A, int32_t NumberOfRepeats, bool bIncludeReversals, int32_t Count, float *Out);
+
+	/// Linearly remap A so its smallest value becomes Min and its largest Max.  If every
+	/// value is the same they all become Min.
+	static void RemapToRange(const float *A, float Min, float Max, int32_t Count, float *Out);
+
+	/// Out = Value
+	static void Set(float Value, int32_t Count, float *Out);
+
+	/// Out = A-B
+	static void Subtract(const float *A, const float *B, int32_t Count, float *Out);
+
+	/// Out = Value-A
+	static void SubtractFromScalar(float Value, const float *A, int32_t Count, float *Out);
+
+	/// Out = A-Value
+	static void SubtractScalar(const float *A, float Value, int32_t Count, float *Out);
+
+	// Masks, one bit per weight packed 32 to a word with the first weight in the lowest bit.
+	// Count is the number of weights, so each mask is (Count+31)/32 words.  The bits past
+	// the last weight are left clear.
+
+	/// Out = A&B
+	static void AndMask(const uint32_t *A, const uint32_t *B, int32_t Count, uint32_t *Out);
+
+	/// Return the number of set bits
+	static int32_t CountMask(const uint32_t *A, int32_t Count);
+
+	/// Out = ~A
+	static void NotMask(const uint32_t *A, int32_t Count, uint32_t *Out);
+
+	/// Out = A|B
+	static void OrMask(const uint32_t *A, const uint32_t *B, int32_t Count, uint32_t *Out);
+
+	/// Set the bit for each weight of at least Threshold, and clear the rest
+	static void PackMask(const float *A, float Threshold, int32_t Count, uint32_t *Out);
+
+	/// Out = 1.0 for each set bit and 0.0 for each clear one, starting from bit FirstBit of A
+	static void UnpackMask(const uint32_t *A, int32_t FirstBit, int32_t Count, float *Out);
+
+	/// Out = A^B
+	static void XorMask(const uint32_t *A, const uint32_t *B, int32_t Count, uint32_t *Out);
+};
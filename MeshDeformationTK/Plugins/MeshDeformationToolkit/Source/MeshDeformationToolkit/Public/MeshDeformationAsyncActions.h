@@ -0,0 +1,375 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "Async/Future.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "MeshDeformationComponent.h"
+#include "MeshDeformationAsyncActions.generated.h"
+
+/// The pins of the latent deformer nodes, with the component for chaining and the fraction of
+/// the work which has been done
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(
+	FMeshDeformerAsyncActionEvent, UMeshDeformationComponent *, MeshDeformationComponent, float, Progress);
+
+/// The pins of the latent selection nodes, with the SelectionSet (complete only in *OnCompleted*)
+/// and the fraction of the work which has been done
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(
+	FMeshSelectionAsyncActionEvent, USelectionSet *, Selection, float, Progress);
+
+/// The base for the latent Blueprint versions of the *MeshDeformationComponent* operations which
+/// can take long enough on a large mesh to cause a hitch.
+///
+/// The factory functions check the arguments and prepare the work straight away, against the
+/// geometry as it is when the node runs.  Once activated the work is advanced from the core
+/// ticker, doing at most the node's time budget of work each frame, or waiting for work which
+/// has been sent to another thread.  The *OnProgress* pin fires after each frame's work,
+/// followed by *OnCompleted* when it's done or *OnCancelled* if *Cancel* was called, the
+/// arguments weren't valid, or the geometry was replaced or changed size part way through.
+///
+/// Each node also outputs the action itself, which can be used to *Cancel* it or check its
+/// progress.  The geometry can be read and deformed by other nodes while an operation is running,
+/// but the result is only well defined if it's left alone until the operation completes.
+UCLASS(Abstract)
+class MESHDEFORMATIONTOOLKIT_API UMeshDeformationAsyncAction: public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	/// Start advancing the work from the core ticker, or fire *OnCancelled* if it couldn't be prepared
+	virtual void Activate() override;
+
+	/// Stop the operation before the next frame's work, leaving whatever has been done so far in
+	/// place.  *OnCancelled* fires instead of *OnCompleted*.
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Stop a latent MeshDeformationComponent operation"
+			)
+	)
+		void Cancel();
+
+	/// Return the fraction of the work which has been done, from 0.0 to 1.0
+	UFUNCTION(BlueprintPure, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Get the fraction of a latent MeshDeformationComponent operation which has been done"
+			)
+	)
+		float GetProgress() const;
+
+	/// Stop ticking if we're destroyed part way through
+	virtual void BeginDestroy() override;
+
+protected:
+	/// The component being worked on
+	UPROPERTY()
+		UMeshDeformationComponent *TargetComponent=nullptr;
+
+	/// The geometry being worked on, the operation is cancelled if the component's geometry is
+	/// replaced.  This is nullptr if the work couldn't be prepared.
+	UPROPERTY()
+		UMeshGeometry *Geometry=nullptr;
+
+	/// The SelectionSet the operation uses, or fills in for the selection nodes
+	UPROPERTY()
+		USelectionSet *SelectionSet=nullptr;
+
+	/// The number of vertices in *Geometry* when the operation was prepared
+	int32 VertexCount=0;
+
+	/// The time to spend on the work each frame, in seconds
+	float TimeBudget=0.0f;
+
+	/// The fraction of the work which has been done
+	float Progress=0.0f;
+
+	/// Processes a range of vertices for operations which use the default *Step*, given the
+	/// global index of the first vertex and one past the last.  Returns *False* if the work can't
+	/// continue, eg because an object it needs has been destroyed.
+	TFunction<bool(int32, int32)> VertexRangeFunction;
+
+	/// Set up the common state and apply the component's deferred operations, called by the
+	/// factory functions before they prepare the work.
+	///
+	/// \param InMeshDeformationComponent	The component to work on
+	/// \param TimeBudgetMs					The time to spend on the work each frame, in milliseconds
+	/// \param NodeNameForWarning			The name of the node to display in case of error
+	/// \return *True* if there's geometry to work on, *False* (after logging) if not
+	bool Initialize(UMeshDeformationComponent *InMeshDeformationComponent, float TimeBudgetMs, const TCHAR *NodeNameForWarning);
+
+	/// Check the component still holds *Geometry*, and that it's still the same size, logging a
+	/// warning if not.
+	///
+	/// \return *True* if the prepared work is still valid for the geometry
+	bool CheckGeometryUnchanged() const;
+
+	/// Do the next part of the work.  The default splits the vertices into batches and passes them
+	/// to *VertexRangeFunction* until the deadline passes.
+	///
+	/// \param Deadline				The *FPlatformTime::Seconds* to stop by
+	/// \param bOutCompleted		Set to *True* once all of the work has been done
+	/// \return *False* if the work can't continue
+	virtual bool Step(double Deadline, bool &bOutCompleted);
+
+	/// Fire the matching pin
+	virtual void BroadcastProgress();
+	virtual void BroadcastCompleted();
+	virtual void BroadcastCancelled();
+
+private:
+	/// Our registration with the core ticker, valid while the operation is running
+	FDelegateHandle TickerHandle;
+
+	/// Set by *Cancel*, checked at the start of each frame
+	bool bCancelRequested=false;
+
+	/// The next vertex to pass to *VertexRangeFunction*
+	int32 NextVertex=0;
+
+	/// Advance the operation, called every frame by the core ticker
+	bool Tick(float DeltaTime);
+
+	/// Fire the final pin and release the action
+	void Finish(bool bCompleted);
+};
+
+/// The base for the latent deformers, whose pins pass the component on for chaining
+UCLASS(Abstract)
+class MESHDEFORMATIONTOOLKIT_API UMeshDeformerAsyncAction: public UMeshDeformationAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	/// Fired after each frame's work
+	UPROPERTY(BlueprintAssignable)
+		FMeshDeformerAsyncActionEvent OnProgress;
+
+	/// Fired once the work is done
+	UPROPERTY(BlueprintAssignable)
+		FMeshDeformerAsyncActionEvent OnCompleted;
+
+	/// Fired if the work is stopped before it's done
+	UPROPERTY(BlueprintAssignable)
+		FMeshDeformerAsyncActionEvent OnCancelled;
+
+protected:
+	virtual void BroadcastProgress() override;
+	virtual void BroadcastCompleted() override;
+	virtual void BroadcastCancelled() override;
+};
+
+/// The latent versions of *MeshDeformationComponent::Project* and *ProjectDown*, with the line
+/// traces spread over several frames
+UCLASS(meta = (ExposedAsyncProxy = AsyncAction))
+class MESHDEFORMATIONTOOLKIT_API UProjectAsyncAction: public UMeshDeformerAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	/// Projects the mesh against collision geometry by projecting along an arbitrary vector, as
+	/// *MeshDeformationComponent::Project* but doing at most *TimeBudgetMs* of line traces each frame.
+	///
+	/// \param TimeBudgetMs				The time to spend each frame, in milliseconds
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			BlueprintInternalUseOnly = "true",
+			DisplayName = "Project (Latent)",
+			ToolTip = "Projects the mesh against collision geometry along a specified vector, spread over several frames",
+			AutoCreateRefTerm = "IgnoredActors",
+			WorldContext = "WorldContextObject",
+			Keywords = "drop drape cloth collision soft trace conform project async latent"
+			)
+	)
+		static UProjectAsyncAction *ProjectAsync(
+			UMeshDeformationComponent *MeshDeformationComponent,
+			UObject *WorldContextObject,
+			FTransform Transform,
+			TArray <AActor *> IgnoredActors,
+			FVector Projection = FVector(0, 0, -100),
+			float HeightAdjust = 0,
+			bool bTraceComplex = true,
+			ECollisionChannel CollisionChannel = ECC_WorldStatic,
+			USelectionSet *Selection = nullptr,
+			float TimeBudgetMs = 2.0f
+		);
+
+	/// Projects the mesh against collision geometry by projecting downwards (-Z), as
+	/// *MeshDeformationComponent::ProjectDown* but doing at most *TimeBudgetMs* of line traces
+	/// each frame.
+	///
+	/// \param TimeBudgetMs				The time to spend each frame, in milliseconds
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			BlueprintInternalUseOnly = "true",
+			DisplayName = "Project Down (Latent)",
+			ToolTip = "Conforms the mesh against collision geometry by projecting downwards (-Z), spread over several frames",
+			AutoCreateRefTerm = "IgnoredActors",
+			WorldContext = "WorldContextObject",
+			Keywords = "drop drape cloth collision soft trace conform project async latent"
+			)
+	)
+		static UProjectAsyncAction *ProjectDownAsync(
+			UMeshDeformationComponent *MeshDeformationComponent,
+			UObject *WorldContextObject,
+			FTransform Transform,
+			TArray <AActor *> IgnoredActors,
+			float ProjectionLength = 100,
+			float HeightAdjust = 0,
+			bool bTraceComplex = true,
+			ECollisionChannel CollisionChannel = ECC_WorldStatic,
+			USelectionSet *Selection = nullptr,
+			float TimeBudgetMs = 2.0f
+		);
+
+private:
+	/// Process the vertices with a prepared projection
+	void SetProjection(const FMeshProjection &Projection);
+};
+
+/// The latent version of *MeshDeformationComponent::RebuildNormals*, which rebuilds the normals
+/// and tangents of a copy of the geometry on a worker thread
+UCLASS(meta = (ExposedAsyncProxy = AsyncAction))
+class MESHDEFORMATIONTOOLKIT_API URebuildNormalsAsyncAction: public UMeshDeformerAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	/// Rebuild the normals and tangents on a worker thread.  They're swapped in once they're
+	/// ready, and if the geometry has been deformed in the meantime they're rebuilt again.  A
+	/// mesh which is deformed every frame would never catch up, so after a few rebuilds the
+	/// latest normals are used anyway and *AreNormalsStale* returns *True*.
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			BlueprintInternalUseOnly = "true",
+			DisplayName = "Rebuild Normals (Latent)",
+			ToolTip = "Rebuild all of the normals and tangents on a worker thread",
+			Keywords = "rebuild normals calculate tangents async latent"
+			)
+	)
+		static URebuildNormalsAsyncAction *RebuildNormalsAsync(UMeshDeformationComponent *MeshDeformationComponent);
+
+	/// Return *True* if the geometry was deformed after the normals which were used were
+	/// calculated, so they don't quite match the positions
+	UFUNCTION(BlueprintPure, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Check whether the mesh was deformed while its normals were being rebuilt, so they don't quite match it"
+			)
+	)
+		bool AreNormalsStale() const;
+
+	/// Wait for the worker, which uses *WorkingCopy*
+	virtual void BeginDestroy() override;
+
+protected:
+	virtual bool Step(double Deadline, bool &bOutCompleted) override;
+
+private:
+	/// The copy of the geometry the worker rebuilds
+	UPROPERTY()
+		UMeshGeometry *WorkingCopy=nullptr;
+
+	/// The generation of *Geometry* when it was copied
+	uint32 SourceGeneration=0;
+
+	/// The number of times the worker has been started
+	int32 RebuildCount=0;
+
+	/// Set if the normals were taken from an older copy of the geometry
+	bool bNormalsStale=false;
+
+	/// The worker, if it's running
+	TFuture<void> Rebuild;
+
+	/// Copy the geometry and start the worker
+	void StartRebuild();
+
+	/// Move the rebuilt normals and tangents from *WorkingCopy* into *Geometry*, leaving its
+	/// positions alone.  Returns *False* (after logging) if the sections no longer match.
+	bool TakeNormalsFromWorkingCopy();
+};
+
+/// The latent version of *MeshDeformationComponent::SaveToStaticMesh*, which completes once the
+/// *StaticMesh* has actually been built
+UCLASS(meta = (ExposedAsyncProxy = AsyncAction))
+class MESHDEFORMATIONTOOLKIT_API USaveToStaticMeshAsyncAction: public UMeshDeformerAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	/// Save the geometry to a *StaticMesh*, completing once it's been built.  As with
+	/// *SaveToStaticMesh* this only works in the editor.  Cancelling stops the pins firing but
+	/// not the build.
+	///
+	/// \param StaticMesh				The StaticMesh to save to
+	/// \param Materials				The materials to apply to the mesh
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			BlueprintInternalUseOnly = "true",
+			DisplayName = "Save To Static Mesh (Latent)",
+			ToolTip = "Saves the current geometry to a StaticMesh, completing once the mesh has been built",
+			AutoCreateRefTerm = "Materials",
+			Keywords = "save output write static mesh async latent"
+			)
+	)
+		static USaveToStaticMeshAsyncAction *SaveToStaticMeshAsync(
+			UMeshDeformationComponent *MeshDeformationComponent,
+			UStaticMesh *StaticMesh,
+			TArray<UMaterialInterface *> Materials
+		);
+
+protected:
+	virtual bool Step(double Deadline, bool &bOutCompleted) override;
+
+private:
+	/// Whether the build queue has reported back, and whether the build succeeded
+	bool bBuildFinished=false;
+	bool bBuildSucceeded=false;
+
+	/// Called by the build queue once the mesh has been built
+	void OnStaticMeshBuilt(UStaticMesh *BuiltStaticMesh);
+};
+
+/// The latent version of *MeshDeformationComponent::SelectNearSpline*, with the spline queries
+/// spread over several frames
+UCLASS(meta = (ExposedAsyncProxy = AsyncAction))
+class MESHDEFORMATIONTOOLKIT_API USelectNearSplineAsyncAction: public UMeshDeformationAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	/// Fired after each frame's work, with the partly filled SelectionSet
+	UPROPERTY(BlueprintAssignable)
+		FMeshSelectionAsyncActionEvent OnProgress;
+
+	/// Fired once the SelectionSet is complete
+	UPROPERTY(BlueprintAssignable)
+		FMeshSelectionAsyncActionEvent OnCompleted;
+
+	/// Fired if the work is stopped before it's done, with the partly filled SelectionSet
+	UPROPERTY(BlueprintAssignable)
+		FMeshSelectionAsyncActionEvent OnCancelled;
+
+	/// Select the vertices near a spline, as *MeshDeformationComponent::SelectNearSpline* but
+	/// doing at most *TimeBudgetMs* of spline queries each frame.
+	///
+	/// \param TimeBudgetMs				The time to spend each frame, in milliseconds
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			BlueprintInternalUseOnly = "true",
+			DisplayName = "Select Near Spline (Latent)",
+			ToolTip = "Select the vertices near a SplineComponent, spread over several frames",
+			Keywords = "curve async latent"
+			)
+	)
+		static USelectNearSplineAsyncAction *SelectNearSplineAsync(
+			UMeshDeformationComponent *MeshDeformationComponent,
+			USplineComponent *Spline,
+			float InnerRadius = 0,
+			float OuterRadius = 100,
+			float TimeBudgetMs = 2.0f
+		);
+
+protected:
+	virtual void BroadcastProgress() override;
+	virtual void BroadcastCompleted() override;
+	virtual void BroadcastCancelled() override;
+};
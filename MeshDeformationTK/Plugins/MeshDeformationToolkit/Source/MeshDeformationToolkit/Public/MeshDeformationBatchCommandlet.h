@@ -0,0 +1,65 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "MeshDeformationBatchCommandlet.generated.h"
+
+class UMeshDeformationRecipe;
+class UMeshGeometry;
+class UStaticMesh;
+
+/// A commandlet which applies a *MeshDeformationRecipe* to many *StaticMesh* assets and
+/// saves the results as new assets, for use in offline content pipelines.
+///
+/// This runs headless, including under *-nullrhi*:
+///
+///		UE4Editor-Cmd Project.uproject -run=MeshDeformationBatch -nullrhi
+///			-Recipe=/Game/Recipes/BP_Twist.BP_Twist_C
+///			-Meshes=/Game/Rocks/SM_Rock1,/Game/Rocks/SM_Rock2
+///			-MeshList=Meshes.txt -OutputPath=/Game/Deformed -Report=Report.json -BatchSize=32
+///
+/// * *Recipe* is the class of the recipe to apply.
+/// * *Meshes* is a comma-separated list of meshes, and *MeshList* a file with one mesh per
+///   line.  Either or both can be given.
+/// * *OutputPath* is the content folder the deformed meshes are saved in, under their
+///   original names.  This defaults to /Game/Deformed.  Meshes from different folders keep
+///   their folders relative to the deepest folder they all share, so /Game/Rocks/A/SM_Rock
+///   and /Game/Rocks/B/SM_Rock are saved as <OutputPath>/A/SM_Rock and <OutputPath>/B/SM_Rock.
+/// * *Report* is where the JSON timing report is written, which defaults to
+///   MeshDeformationBatch.json in the project's Saved folder.
+/// * *BatchSize* is how many meshes are held in memory at once, which defaults to 32.
+///
+/// The meshes are processed a batch at a time: each batch is loaded on the game thread,
+/// deformed, prepared by the *StaticMeshBuildQueue*, and saved once it's flushed, before the
+/// garbage collector reclaims it and the next batch starts.  Native recipes are applied to
+/// every mesh in the batch at once across the worker threads, Blueprint recipes one mesh at
+/// a time on the game thread.  Each deformer also splits its work across the worker threads
+/// for large meshes.
+UCLASS()
+class MESHDEFORMATIONTOOLKIT_API UMeshDeformationBatchCommandlet: public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UMeshDeformationBatchCommandlet();
+
+	/// Run the batch, returning 0 if every mesh was processed
+	virtual int32 Main(const FString &Params) override;
+
+private:
+
+	/// The recipe being applied
+	UPROPERTY()
+		UMeshDeformationRecipe *Recipe;
+
+	/// The meshes in the batch being processed, kept here so they're not garbage collected
+	/// until the batch has been saved
+	UPROPERTY()
+		TArray<UStaticMesh *> SourceMeshes;
+
+	/// The geometry for each of *SourceMeshes*
+	UPROPERTY()
+		TArray<UMeshGeometry *> Geometries;
+};
@@ -0,0 +1,93 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "MeshDeformationBenchmarkCommandlet.generated.h"
+
+class UCurveFloat;
+class UMeshGeometry;
+class UProceduralMeshComponent;
+class USelectionSet;
+class USplineComponent;
+
+/// A commandlet which times every *MeshGeometry* deformer and selector, every
+/// *SelectionSetBPLibrary* node, and both save paths against synthetic meshes, writing the
+/// results as JSON so changes to the toolkit's performance can be measured.
+///
+/// This runs headless, including under *-nullrhi*:
+///
+///		UE4Editor-Cmd Project.uproject -run=MeshDeformationBenchmark -nullrhi
+///			-Sizes=1000,100000,10000000 -Iterations=5 -Filter=Select -Output=Benchmark.json
+///
+/// * *Sizes* is a comma-separated list of vertex counts, each of which is rounded up to a
+///   square grid.  This defaults to 1k, 10k, 100k, 1M and 10M vertices.
+/// * *Iterations* is the number of times each benchmark is run at each size, defaulting to 3.
+/// * *Filter* only runs the benchmarks whose names contain the text given.
+/// * *Output* is where the JSON is written, which defaults to MeshDeformationBenchmark.json
+///   in the project's Saved folder.
+///
+/// Each result has the fastest and mean times, and the number of allocations and bytes
+/// requested from the allocator by one more run, which isn't timed and which is run on the
+/// calling thread so all of its allocations are counted (see *FScopedAllocationCounter*).
+///
+/// *Project*, *ProjectDown* and *SelectByTexture* aren't included as they need a game world
+/// or a CPU-readable texture.
+UCLASS()
+class MESHDEFORMATIONTOOLKIT_API UMeshDeformationBenchmarkCommandlet: public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UMeshDeformationBenchmarkCommandlet();
+
+	/// Run the benchmarks, returning 0 on success
+	virtual int32 Main(const FString &Params) override;
+
+private:
+
+	/// The untouched synthetic mesh for the current size, copied before each run
+	UPROPERTY()
+		UMeshGeometry *SourceGeometry;
+
+	/// The mesh each benchmark runs against
+	UPROPERTY()
+		UMeshGeometry *Geometry;
+
+	/// A second mesh for *Lerp* to blend towards
+	UPROPERTY()
+		UMeshGeometry *TargetGeometry;
+
+	/// A gradient selection covering the whole mesh
+	UPROPERTY()
+		USelectionSet *SelectionA;
+
+	/// A second, different, selection covering the whole mesh
+	UPROPERTY()
+		USelectionSet *SelectionB;
+
+	/// The selection the *Into* benchmarks write into, to time reusing one
+	UPROPERTY()
+		USelectionSet *ReusedSelection;
+
+	/// A small selection in one corner of the mesh, which is stored sparsely
+	UPROPERTY()
+		USelectionSet *SparseSelection;
+
+	/// A box covering about half of the mesh, which is stored as a mask
+	UPROPERTY()
+		USelectionSet *MaskSelection;
+
+	/// The spline for *FitToSpline* and *SelectNearSpline*
+	UPROPERTY()
+		USplineComponent *Spline;
+
+	/// The curve for *RemapToCurve* and the *FitToSpline* profile
+	UPROPERTY()
+		UCurveFloat *Curve;
+
+	/// The target for the *ProceduralMeshComponent* save path
+	UPROPERTY()
+		UProceduralMeshComponent *ProceduralMeshComponent;
+};
@@ -2,11 +2,14 @@
 
 #pragma once
 
+#include "Async/Future.h"
 #include "Components/ActorComponent.h"
 #include "MeshGeometry.h"
 #include "Runtime/Engine/Classes/Curves/CurveFloat.h"
 #include "MeshDeformationComponent.generated.h"
 
+class UMeshDeformationOperation;
+
 /// *ActorComponent* for easy geometry deformation.
 ///
 /// This is the main class for the *Mesh Deformation Component*, and
@@ -36,6 +39,22 @@
 /// angle of rotation.  If in doubt look at the actual implementation for the function in
 /// *MeshGeometry*.
 
+/// A single affine operation recorded by *MeshDeformationComponent* while
+/// *bDeferAffineOperations* is set, waiting to be applied to the geometry.
+USTRUCT()
+struct FDeferredAffineOperation
+{
+	GENERATED_BODY()
+
+	/// The matrix for the operation, including any offset for its center
+	UPROPERTY()
+		FMatrix Matrix = FMatrix::Identity;
+
+	/// The SelectionSet weighting the operation, or nullptr if it applies to all vertices
+	UPROPERTY()
+		USelectionSet *Selection = nullptr;
+};
+
 /// \see UActorComponent
 /// \see MeshGeometry
 /// \see SelectionSet
@@ -63,6 +82,108 @@ public:
 	)
 		UMeshGeometry *MeshGeometry=nullptr;
 
+	/// If this is set then *Translate*, *Rotate*, *Scale*, and *Transform* are recorded rather
+	/// than applied straight away, with each run of operations which don't have a *SelectionSet*,
+	/// or which all have masks selecting the same vertices, combined into a single matrix.  The
+	/// recorded operations are applied the next time the geometry is needed- by any other
+	/// operation, by a Select or Get which reads the vertices, by Save, or by calling
+	/// *FlushDeferredOperations*- so a chain of N transforms costs one pass over the vertices.
+	///
+	/// Operations with a weighted *SelectionSet* are still recorded but are applied as separate
+	/// passes, as weighted transforms can't be combined exactly.  Each operation keeps a copy of
+	/// its *SelectionSet*, so the set can be changed straight away.
+	///
+	/// Reading *MeshGeometry* directly does not apply the recorded operations.
+	UPROPERTY(
+		EditAnywhere, BlueprintReadWrite, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Record Translate/Rotate/Scale/Transform and apply them together when the geometry is next needed"
+			)
+	)
+		bool bDeferAffineOperations=false;
+
+	/// If this is set then the deformers which can run away from the game thread are recorded
+	/// rather than applied, and *SaveToProceduralMeshComponent* evaluates them on a worker
+	/// thread against a second copy of the geometry.  When the worker finishes the copy is
+	/// swapped into *MeshGeometry* and saved to the *ProceduralMeshComponent* on the game
+	/// thread, so the save returns straight away and the mesh updates a frame or more later.
+	///
+	/// If *SaveToProceduralMeshComponent* is called again while an evaluation is running then
+	/// the operations keep being recorded and are all evaluated once it finishes, so slow
+	/// deformation drops its own frames rather than rendering frames.
+	///
+	/// The recorded deformers are *Translate*, *Rotate*, *Scale*, *Transform*, *Inflate*,
+	/// *LerpVector*, *MoveTowards*, *RotateAroundAxis*, *ScaleAlongAxis*, *Spherize*,
+	/// *TransformUV*, *FlipTextureUV*, and *RebuildNormals*.  Anything else which needs the
+	/// geometry- the other deformers, Select, Get, and *SaveToStaticMesh*- applies the recorded
+	/// operations first, and waits for a running evaluation unless the geometry has been loaded
+	/// since it started.  Per-frame chains which start by loading the undeformed mesh therefore
+	/// never wait.  The Load functions discard the recorded operations, and an evaluation which
+	/// was running when the geometry was loaded is still saved but isn't swapped in.
+	///
+	/// Each recorded deformer reads a copy of its SelectionSet taken when it was recorded, so
+	/// the SelectionSet can be changed or reused straight away.  The component must be
+	/// registered for the result to be picked up.
+	UPROPERTY(
+		EditAnywhere, BlueprintReadWrite, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Record deformers and evaluate them on a worker thread when saving to a ProceduralMeshComponent"
+			)
+	)
+		bool bEvaluateAsync=false;
+
+	/// If this is set along with *bEvaluateAsync* then evaluations run on the game thread, a
+	/// slice of vertices at a time, within the per-frame budget of *MeshDeformationSubsystem*
+	/// (see *mdt.TimeSliceBudgetMs*) rather than on a worker thread.  The deformers which work
+	/// on whole sections, *TransformUV*, *FlipTextureUV*, and *RebuildNormals*, each run in a
+	/// single slice.
+	///
+	/// This suits many components deforming at once, such as when level content streams in.  The
+	/// work is spread over as many frames as it needs, and each *ProceduralMeshComponent* is only
+	/// updated once all of its component's operations are done.
+	UPROPERTY(
+		EditAnywhere, BlueprintReadWrite, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Evaluate asynchronous operations on the game thread within a per-frame time budget"
+			)
+	)
+		bool bTimeSliceEvaluation=false;
+
+	/// The operations *EvaluateOperationStack* applies to the rest pose, in order.
+	///
+	/// This replaces reloading the mesh every frame and calling the deformers on it: the stack is
+	/// built once, in the details panel or with *AddOperation*, and each frame only the operations'
+	/// parameters change.
+	UPROPERTY(
+		EditAnywhere, Instanced, BlueprintReadWrite, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="The operations applied to the rest pose by EvaluateOperationStack, in order"
+			)
+	)
+		TArray<UMeshDeformationOperation *> OperationStack;
+
+	/// If this is set *EvaluateOperationStack* keeps a hash of each operation's inputs (see
+	/// *UMeshDeformationOperation::GetInputHash*) and a checkpoint of the geometry before the
+	/// first operation which changed.  While the operations before the checkpoint stay the same
+	/// only the ones after it are re-applied, and if nothing has changed the geometry is left as
+	/// it is.
+	///
+	/// This suits tweaking one parameter of a long stack, such as a slider in an editor tool,
+	/// at the cost of one copy of the geometry.
+	UPROPERTY(
+		EditAnywhere, BlueprintReadWrite, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Keep each operation's result so EvaluateOperationStack only re-applies operations whose inputs have changed"
+			)
+	)
+		bool bMemoizeOperationStack=false;
+
+	/// Picks up the result of an asynchronous evaluation, see *bEvaluateAsync*
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+
+	/// Waits for any asynchronous evaluation, which uses this component's geometry
+	virtual void BeginDestroy() override;
+
 	/*
 	##################################################
 	Load Geometry Data
@@ -132,12 +253,81 @@ public:
 			int32 LOD=0
 		);
 
+	/*
+	##################################################
+	Operation Stack
+
+	These functions re-evaluate *OperationStack* against an immutable rest pose, so
+	deformations which change every frame don't need to reload the geometry.
+	##################################################
+	*/
+
+	/// Store a copy of the current geometry as the rest pose which *EvaluateOperationStack*
+	/// starts from, replacing any previous rest pose.
+	///
+	/// \param MeshDeformationComponent		This component (Out param, helps with method chaining)
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Store the current geometry as the rest pose which EvaluateOperationStack starts from",
+			Keywords = "base undeformed original bind"
+			)
+	)
+		void SetRestPose(UMeshDeformationComponent *&MeshDeformationComponent);
+
+	/// Return whether *SetRestPose* has been called.
+	UFUNCTION(
+		BlueprintPure, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Check if a rest pose has been stored"
+			)
+	)
+		bool HasRestPose() const;
+
+	/// Create an operation and add it to the end of *OperationStack*.  This is meant for
+	/// building the stack once, such as in *BeginPlay*, and the operation's parameters can
+	/// then be changed each frame.
+	///
+	/// \param OperationClass				The type of operation to add
+	/// \return The new operation
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Create an operation and add it to the end of the OperationStack",
+			Keywords = "create stack",
+			DeterminesOutputType = "OperationClass"
+			)
+	)
+		UMeshDeformationOperation *AddOperation(TSubclassOf<UMeshDeformationOperation> OperationClass);
+
+	/// Reset *MeshGeometry* to the rest pose and apply each enabled operation in *OperationStack*.
+	///
+	/// The geometry is reset in place, reusing its buffers, and only the sections which end up
+	/// different are sent by the next *SaveToProceduralMeshComponent*- so evaluating the stack
+	/// every frame doesn't create any objects or reallocate the geometry.  Any deferred or
+	/// recorded operations are discarded, as they were for the geometry being reset.
+	///
+	/// The stack is evaluated straight away on the game thread, *bEvaluateAsync* only applies to
+	/// deformers called on the component afterwards.
+	///
+	/// \param MeshDeformationComponent		This component (Out param, helps with method chaining)
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Reset the geometry to the rest pose and apply the OperationStack",
+			Keywords = "evaluate stack animate update"
+			)
+	)
+		void EvaluateOperationStack(UMeshDeformationComponent *&MeshDeformationComponent);
+
 	/*
 	##################################################
 	Select Vertices
 
 	All of these functions serve to select vertices based on some criteria.  They should all
 	have names beginning with *Select*, and return a new USelectionSet.
+
+	Each one also has an *...Into* version which writes into the SelectionSet passed as
+	*Into*, so one set can be reused rather than creating one each time.  These aren't pure,
+	so the set is only written when the node is executed.  Asynchronous evaluations read their
+	own copies of SelectionSets, so *Into* can be reused straight away.
 	##################################################
 	*/
 
@@ -153,6 +343,18 @@ public:
 	)
 		USelectionSet *SelectAll() const;
 
+	/// As *SelectAll*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Selects all of the vertices at full strength, writing the result into an existing SelectionSet",
+			Keywords="everything reuse"
+			)
+	)
+		USelectionSet *SelectAllInto(USelectionSet *Into=nullptr) const;
+
 	/// Selects vertices based on a noise function.
 	///
 	/// This uses the [FastNoise](https://github.com/Auburns/FastNoise) noise library by Jordan Pack and released under the MIT license.
@@ -190,7 +392,32 @@ public:
 			float FractalGain=0.5,
 			EFractalType FractalType=EFractalType::FBM,
 			ECellularDistanceFunction CellularDistanceFunction=ECellularDistanceFunction::Euclidian
-		) const;
+		);
+
+	/// As *SelectByNoise*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Select vertices based on a configurable noise function, useful for terrain or adding controlled randomness to a model, writing the result into an existing SelectionSet",
+			Keywords="random fastnoise perlin fractal terrain reuse",
+			AutoCreateRefTerm="Transform"
+			)
+	)
+		USelectionSet *SelectByNoiseInto(
+			FTransform Transform,
+			int32 Seed=1337,
+			float Frequency=0.01,
+			ENoiseInterpolation NoiseInterpolation=ENoiseInterpolation::Quintic,
+			ENoiseType NoiseType=ENoiseType::Simplex,
+			uint8 FractalOctaves=3,
+			float FractalLacunarity=2.0,
+			float FractalGain=0.5,
+			EFractalType FractalType=EFractalType::FBM,
+			ECellularDistanceFunction CellularDistanceFunction=ECellularDistanceFunction::Euclidian,
+			USelectionSet *Into=nullptr
+		);
 
 	/// Selects vertices with a given normal facing
 	///
@@ -212,7 +439,24 @@ public:
 			FVector Facing = FVector::UpVector,
 			float InnerRadiusInDegrees = 0,
 			float OuterRadiusInDegrees = 30.0f
-		) const;
+		);
+
+	/// As *SelectByNormal*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Select vertices with a given normal facing, writing the result into an existing SelectionSet",
+			Keywords = "facing vector direction reuse"
+			)
+	)
+		USelectionSet *SelectByNormalInto(
+			FVector Facing = FVector::UpVector,
+			float InnerRadiusInDegrees = 0,
+			float OuterRadiusInDegrees = 30.0f,
+			USelectionSet *Into = nullptr
+		);
 
 	/// Select all of the vertices which go to make up one of the Sections that a mesh
 	/// can consist of.  This can be thought of as the same as a Material slot for many
@@ -228,6 +472,18 @@ public:
 	)
 		USelectionSet *SelectBySection(int32 SectionIndex) const;
 
+	/// As *SelectBySection*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category= MeshDeformationComponent,
+		meta=(
+			ToolTip="Select all of the vertices in one of the Sections making up a mesh, writing the result into an existing SelectionSet",
+			Keywords="material geometry reuse"
+			)
+	)
+		USelectionSet *SelectBySectionInto(int32 SectionIndex, USelectionSet *Into=nullptr) const;
+
 	/// Select vertices from a texture.
 	///
 	/// Black in the channel = Unselected, White = Fully selected.  Uses UV0 for texture access as that's
@@ -246,7 +502,23 @@ public:
 		USelectionSet *SelectByTexture(
 			UTexture2D *Texture2D,
 			ETextureChannel TextureChannel=ETextureChannel::Red
-		) const;
+		);
+
+	/// As *SelectByTexture*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Select vertices based on a channel from a texture, writing the result into an existing SelectionSet",
+			Keywords="image picture rgb uv reuse"
+			)
+	)
+		USelectionSet *SelectByTextureInto(
+			UTexture2D *Texture2D,
+			ETextureChannel TextureChannel=ETextureChannel::Red,
+			USelectionSet *Into=nullptr
+		);
 
 	/// Select all of the vertices in a a single section by a range.  This is useful
 	/// when you know the vertex ordering of an item.
@@ -268,6 +540,22 @@ public:
 			int32 SectionIndex = 0
 		);
 
+	/// As *SelectByVertexRange*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+			  meta = (
+				  ToolTip = "Select vertices based on their index in the mesh, writing the result into an existing SelectionSet",
+				  Keywords = "for section reuse"
+				))
+		USelectionSet *SelectByVertexRangeInto(
+			int32 RangeStart,
+			int32 RangeEnd,
+			int32 RangeStep = 1,
+			int32 SectionIndex = 0,
+			USelectionSet *Into = nullptr
+		);
+
 
 	/// Select vertices inside a volume defined by two opposite corner points.
 	/// \param CornerA						The first corner to define the volume
@@ -280,7 +568,19 @@ public:
 			Keywords="aabb bounds bounding space"
 			)
 	)
-		USelectionSet *SelectInVolume(FVector CornerA, FVector CornerB) const;
+		USelectionSet *SelectInVolume(FVector CornerA, FVector CornerB);
+
+	/// As *SelectInVolume*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Select vertices based on a channel from a texture, writing the result into an existing SelectionSet",
+			Keywords="aabb bounds bounding space reuse"
+			)
+	)
+		USelectionSet *SelectInVolumeInto(FVector CornerA, FVector CornerB, USelectionSet *Into=nullptr);
 
 	/// Select vertices linearly between two points.
 	///
@@ -301,7 +601,25 @@ public:
 			FVector LineEnd,
 			bool bReverse=false,
 			bool bLimitToLine=false
-		) const;
+		);
+
+	/// As *SelectLinear*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Select vertices with strength blended linearly between two points, writing the result into an existing SelectionSet",
+			Keywords="gradient between reuse"
+			)
+	)
+		USelectionSet *SelectLinearInto(
+			FVector LineStart,
+			FVector LineEnd,
+			bool bReverse=false,
+			bool bLimitToLine=false,
+			USelectionSet *Into=nullptr
+		);
 
 	/// Selects the vertices near a point in space.
 	///
@@ -323,7 +641,24 @@ public:
 			FVector Center=FVector::ZeroVector,
 			float InnerRadius=0,
 			float OuterRadius=100
-		) const;
+		);
+
+	/// As *SelectNear*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Select the vertices near a point in space, writing the result into an existing SelectionSet",
+			Keywords="close soft reuse"
+			)
+	)
+		USelectionSet *SelectNearInto(
+			FVector Center=FVector::ZeroVector,
+			float InnerRadius=0,
+			float OuterRadius=100,
+			USelectionSet *Into=nullptr
+		);
 
 	/// Selects vertices near a line segment with the provided start/end points.
 	///
@@ -350,7 +685,26 @@ public:
 			float InnerRadius=0,
 			float OuterRadius=100,
 			bool bLineIsInfinite=false
-		) const;
+		);
+
+	/// As *SelectNearLine*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Select vertices near a line with the provided start/end points, writing the result into an existing SelectionSet",
+			Keywords="infinite reuse"
+			)
+		)
+		USelectionSet *SelectNearLineInto(
+			FVector LineStart,
+			FVector LineEnd,
+			float InnerRadius=0,
+			float OuterRadius=100,
+			bool bLineIsInfinite=false,
+			USelectionSet *Into=nullptr
+		);
 
 	/// Selects the vertices near a Spline, allowing curves to easily guide deformation.
 	///
@@ -372,7 +726,24 @@ public:
 			USplineComponent *Spline,
 			float InnerRadius=0,
 			float OuterRadius=100
-		) const;
+		);
+
+	/// As *SelectNearSpline*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(
+		BlueprintCallable, Category=MeshDeformationComponent,
+		meta=(
+			ToolTip="Select the vertices near a SplineCommponent, writing the result into an existing SelectionSet",
+			Keywords="curve reuse"
+			)
+	)
+		USelectionSet *SelectNearSplineInto(
+			USplineComponent *Spline,
+			float InnerRadius=0,
+			float OuterRadius=100,
+			USelectionSet *Into=nullptr
+		);
 
 	/*
 	##################################################
@@ -856,24 +1227,31 @@ public:
 	///
 	/// This will rebuild the mesh, completely replacing any geometry it has there.
 	///
+	/// When saving to the same PMC every frame *bOnlyUpdateChanges* can be set to only send
+	/// the sections and attributes which have changed since the last save, which is much
+	/// cheaper than rebuilding the whole mesh.
+	///
 	/// \param MeshDeformationComponent		This component (Out param, helps with method chaining)
 	/// \param ProceduralMeshComponent		The target *ProceduralMeshComponent
 	/// \param bCreateCollision				Whether to create a collision shape for it
 	/// \param Materials					An optional array of materials to apply to the PMC after copy
+	/// \param bOnlyUpdateChanges			Whether to only send changes since the last save to this PMC
 	/// \return *True* if the update was successful, *False* if not
 	UFUNCTION(
 		BlueprintCallable, Category=MeshDeformationComponent,
 		meta=(
 			ToolTip="Save the current geometry to a ProceduralMeshComponent, replacing any existing geometry",
 			Keywords="pmc output write",
-			AutoCreateRefTerm = "Materials"
+			AutoCreateRefTerm = "Materials",
+			AdvancedDisplay = "bOnlyUpdateChanges"
 			)
 	)
 		bool SaveToProceduralMeshComponent(
 			UMeshDeformationComponent *&MeshDeformationComponent,
 			UProceduralMeshComponent *ProceduralMeshComponent,
 			bool bCreateCollision,
-			TArray <UMaterialInterface *> Materials
+			TArray <UMaterialInterface *> Materials,
+			bool bOnlyUpdateChanges = false
 		);
 
 	/// Save the current geometry to a *StaticMesh*, replacing the geometry in the
@@ -882,8 +1260,8 @@ public:
 	/// 
 	/// \param MeshDeformationComponent		This component (Out param, helps with method chaining)
 	/// \param StaticMesh					The mesh to replace
-	/// \param ProceduralMeshComponent		A ProceduralMeshComponent which will be used to build
-	///										all of the data structures that StaticMesh needs.
+	/// \param ProceduralMeshComponent		No longer used, the mesh data is built directly from the
+	///										geometry.  Kept so existing Blueprints still connect.
 	/// \param Materials					An array of materials which will be applied to the
 	///										built mesh.
 	/// \return *True* if the update was successful, *False* if not
@@ -909,6 +1287,40 @@ public:
 	##################################################
 	*/
 
+	/// Apply any operations recorded while *bDeferAffineOperations* or *bEvaluateAsync* is
+	/// set, first waiting for any asynchronous evaluation of the current geometry.
+	///
+	/// This is called automatically when the geometry is needed, but can be used to control
+	/// when the work is done or before reading *MeshGeometry* directly.
+	///
+	/// \param MeshDeformationComponent		This component (Out param, helps with method chaining)
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Apply any Translate/Rotate/Scale/Transform operations which have been deferred",
+			Keywords = "apply commit"
+			)
+	)
+		void FlushDeferredOperations(UMeshDeformationComponent *&MeshDeformationComponent);
+
+	/// Return whether an evaluation started by *bEvaluateAsync* is running, or waiting to run.
+	UFUNCTION(
+		BlueprintPure, Category = MeshDeformationComponent,
+		meta = (
+			ToolTip = "Check if an asynchronous evaluation is running or waiting to run"
+			)
+	)
+		bool IsEvaluatingAsync() const;
+
+	/// Apply the next slice of vertices of a time-sliced evaluation (see *bTimeSliceEvaluation*),
+	/// and once there are no operations left swap in and save the result.  Each step applies one
+	/// operation to at most *MaxVertexCount* vertices, continuing from where the last step left
+	/// that operation.  Called by *MeshDeformationSubsystem*.
+	///
+	/// \param MaxVertexCount		The most vertices to deform in this step
+	/// \param VertexCount			The number of vertices deformed (Out param)
+	/// \return *True* if the evaluation has finished, or there wasn't one
+	bool StepTimeSlicedEvaluation(int32 MaxVertexCount, int32 &VertexCount);
+
 	/// Return an independent copy of the MeshGeo inside this component
 	UFUNCTION(
 		BlueprintPure, Category = MeshDeformationComponent,
@@ -935,7 +1347,7 @@ public:
 			Keywords="size limits bounds min max"
 			)
 	)
-		FBox GetBoundingBox() const;
+		FBox GetBoundingBox();
 
 	/// Return the number of sections making up the mesh.
 	///
@@ -1000,4 +1412,138 @@ public:
 			)
 	)
 		void RebuildNormals(UMeshDeformationComponent *&MeshDeformationComponent);
+
+private:
+	/// A deformer recorded while *bEvaluateAsync* is set, applied to the geometry passed in
+	typedef TFunction<void(UMeshGeometry *)> FRecordedOperation;
+
+	/// A weighted deformer to record, applied to the geometry and the copy of its SelectionSet
+	/// passed in
+	typedef TFunction<void(UMeshGeometry *, USelectionSet *)> FWeightedOperation;
+
+	/// The operations recorded while *bDeferAffineOperations* is set, in the order they
+	/// are to be applied.  These always follow *RecordedOperations*.
+	UPROPERTY(Transient)
+		TArray<FDeferredAffineOperation> DeferredOperations;
+
+	/// The geometry *EvaluateOperationStack* starts from, which is never deformed
+	UPROPERTY(Transient)
+		UMeshGeometry *RestPose=nullptr;
+
+	/// The hash of the inputs of each operation in *OperationStack* and those of every operation
+	/// before it, while *bMemoizeOperationStack* is set.  Only the operations which could be
+	/// memoized have hashes here.
+	TArray<uint32> MemoizedHashes;
+
+	/// The geometry after the first *MemoizedCheckpointOperationCount* operations, which were the
+	/// ones before the first changed operation at the last evaluation.  Changing the same
+	/// operation again then starts from here.
+	UPROPERTY(Transient)
+		UMeshGeometry *MemoizedCheckpoint=nullptr;
+	int32 MemoizedCheckpointOperationCount=0;
+
+	/// The generation of *MeshGeometry* after the last memoized evaluation, so it's only left
+	/// as it is if nothing else has changed it since
+	uint32 MemoizedGeneration=0;
+
+	/// The operations recorded while *bEvaluateAsync* is set, in the order they are to be applied
+	TArray<FRecordedOperation> RecordedOperations;
+
+	/// The copies of the SelectionSets used by *RecordedOperations*, taken as each was recorded
+	UPROPERTY(Transient)
+		TArray<USelectionSet *> RecordedSelections;
+
+	/// The copy of the geometry which the running evaluation deforms, swapped with
+	/// *MeshGeometry* when it finishes
+	UPROPERTY(Transient)
+		UMeshGeometry *BackBuffer=nullptr;
+
+	/// The copies of the SelectionSets used by the running evaluation
+	UPROPERTY(Transient)
+		TArray<USelectionSet *> EvaluatingSelections;
+
+	/// Copies which are no longer used, kept to be reused by *CopyRecordedSelection*
+	UPROPERTY(Transient)
+		TArray<USelectionSet *> SpareSelections;
+
+	/// The running evaluation, if any
+	TFuture<void> Evaluation;
+
+	/// The operations of a time-sliced evaluation, the next one to run, and the global index of
+	/// the first vertex it's still to be applied to
+	TArray<FRecordedOperation> SlicedOperations;
+	int32 NextSlicedOperation=0;
+	int32 SlicedVertexCursor=0;
+
+	/// Whether there's a time-sliced evaluation which hasn't finished
+	bool bTimeSlicedEvaluationRunning=false;
+
+	/// The geometry the running evaluation was copied from, and its generation at the time.
+	/// The result is only swapped into *MeshGeometry* if neither has changed.
+	TWeakObjectPtr<UMeshGeometry> EvaluationSource;
+	uint32 EvaluationSourceGeneration=0;
+
+	/// Whether *SaveToProceduralMeshComponent* has been called since the running evaluation
+	/// started, so another is needed once it finishes
+	bool bEvaluationRequested=false;
+
+	/// The arguments to the most recent *SaveToProceduralMeshComponent* while *bEvaluateAsync*
+	/// is set, used when each evaluation finishes
+	TWeakObjectPtr<UProceduralMeshComponent> AsyncSaveTarget;
+	UPROPERTY(Transient)
+		TArray<UMaterialInterface *> AsyncSaveMaterials;
+	bool bAsyncSaveCreateCollision=false;
+	bool bAsyncSaveOnlyUpdateChanges=false;
+
+	/// Record an affine operation with a copy of its SelectionSet, combining it with the
+	/// previous operation if neither has a SelectionSet or both have the same mask.
+	///
+	/// \param Matrix			The matrix for the operation, including any center offset
+	/// \param Selection		The SelectionSet weighting the operation, if any
+	void DeferAffineOperation(const FMatrix &Matrix, USelectionSet *Selection);
+
+	/// Apply and clear any deferred operations, first waiting for any asynchronous evaluation of
+	/// the current geometry.  Everything which reads the vertices calls this first, which is why
+	/// those Select and Get functions aren't const.
+	void ApplyDeferredOperations();
+
+	/// Record a deformer if *bEvaluateAsync* is set, after any deferred affine operations.
+	///
+	/// \param Selection		The SelectionSet the deformer uses, if any
+	/// \param Operation		The deformer to apply to the geometry, passed a copy of *Selection*
+	/// \return *True* if the deformer was recorded, *False* if it should be applied now
+	bool RecordOperation(USelectionSet *Selection, FWeightedOperation Operation);
+
+	/// Move any deferred affine operations onto the end of *RecordedOperations*
+	void RecordDeferredOperations();
+
+	/// Copy a SelectionSet for a recorded operation and add the copy to *RecordedSelections*.
+	/// The evaluation only reads the copy, so the game thread can go on changing *Selection*.
+	///
+	/// \param Selection		The SelectionSet to copy, if any
+	/// \return The copy, or nullptr if there's no *Selection*
+	USelectionSet *CopyRecordedSelection(USelectionSet *Selection);
+
+	/// Empty the copies in *Selections* and move them to *SpareSelections*
+	void ReleaseRecordedSelections(TArray<USelectionSet *> &Selections);
+
+	/// Copy the geometry into *BackBuffer* and start applying the recorded operations to it,
+	/// on a worker thread or through *MeshDeformationSubsystem* if *bTimeSliceEvaluation* is set.
+	/// There must not be an evaluation running.
+	void StartAsyncEvaluation();
+
+	/// Wait for the running evaluation, if any, or run the rest of a time-sliced one.  Then swap
+	/// its result into *MeshGeometry* and save it to the *ProceduralMeshComponent*.  If
+	/// *MeshGeometry* has been loaded or changed since the evaluation started the result is
+	/// saved without being swapped in.
+	void FinishAsyncEvaluation();
+
+	/// Return whether there's an evaluation which hasn't finished, on a worker or time-sliced
+	bool IsEvaluationRunning() const;
+
+	/// Save a geometry to a *ProceduralMeshComponent* and apply the materials
+	bool SaveGeometryToProceduralMeshComponent(
+		UMeshGeometry *Geometry, UProceduralMeshComponent *ProceduralMeshComponent, bool bCreateCollision,
+		const TArray<UMaterialInterface *> &Materials, bool bOnlyUpdateChanges
+	);
 };
@@ -0,0 +1,486 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "UObject/NoExportTypes.h"
+#include "FastNoiseBPEnums.h"
+#include "MeshDeformationOperation.generated.h"
+
+class UMeshGeometry;
+class USelectionSet;
+
+/// A single parameterised deformation in a *MeshDeformationComponent*'s *OperationStack*.
+///
+/// The stack is built once, either in the component's details panel or with *AddOperation*,
+/// and then each frame only the operations' parameters are changed before calling
+/// *EvaluateOperationStack*.  That resets the geometry to the component's rest pose and
+/// applies each enabled operation in turn, without creating any objects or reallocating the
+/// geometry.
+///
+/// The native operations cover the deformers which only need their parameters, and the
+/// *MeshSelectOperation* subclasses make selections for the operations after them.  For
+/// anything else subclass this, either in C++ or Blueprint, and override *Apply*.
+///
+/// ## Memoization
+///
+/// If the component's *bMemoizeOperationStack* is set a hash of each operation's inputs (see
+/// *GetInputHash*) and those of every operation before it is kept, along with one checkpoint:
+/// the result of the operations before the first one which changed last time.  Evaluating the
+/// stack starts from that checkpoint while those operations are unchanged, so repeatedly
+/// changing one parameter only re-applies that operation and the ones after it.
+///
+/// \see UMeshDeformationComponent::EvaluateOperationStack
+UCLASS(Blueprintable, Abstract, EditInlineNew, DefaultToInstanced)
+class MESHDEFORMATIONTOOLKIT_API UMeshDeformationOperation: public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/// Whether the operation is applied, so it can be switched off without changing the stack
+	UPROPERTY(
+		EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation,
+		meta=(
+			ToolTip="Whether this operation is applied when the stack is evaluated"
+			)
+	)
+		bool bEnabled=true;
+
+	/// The SelectionSet weighting the operation, or nullptr to apply it to all vertices.  This
+	/// must be for the same geometry as the rest pose.
+	UPROPERTY(
+		Transient, BlueprintReadWrite, Category=MeshDeformationOperation,
+		meta=(
+			ToolTip="The SelectionSet weighting this operation, or none for all vertices"
+			)
+	)
+		USelectionSet *Selection=nullptr;
+
+	/// Apply the operation with its current parameters.
+	///
+	/// \param MeshGeometry			The geometry to deform in place
+	UFUNCTION(
+		BlueprintNativeEvent, Category=MeshDeformationOperation,
+		meta=(
+			ToolTip="Apply the operation to the geometry with its current parameters",
+			Keywords="stack deform"
+			)
+	)
+		void Apply(UMeshGeometry *MeshGeometry);
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry);
+
+	/// Return a hash of everything the result depends on apart from the geometry it's applied to.
+	///
+	/// By default this hashes the class and every property which can be edited or set from
+	/// Blueprint.  SelectionSets are hashed by their weights (see *USelectionSet::GetContentHash*,
+	/// which is only recalculated when they change) and MeshGeometries by their generation,
+	/// other objects by their identity.
+	virtual uint32 GetInputHash() const;
+
+	/// Whether the result only depends on the inputs hashed by *GetInputHash*, so it can be
+	/// memoized.  This is the case for native operations unless they override it- Blueprint
+	/// operations could read anything so they're always re-applied, along with every
+	/// operation after them.
+	virtual bool CanMemoize() const;
+};
+
+/// Applies *UMeshGeometry::Translate*
+UCLASS(meta=(DisplayName="Translate"))
+class MESHDEFORMATIONTOOLKIT_API UMeshTranslateOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The translation delta in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector Delta=FVector::ZeroVector;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::Rotate*
+UCLASS(meta=(DisplayName="Rotate"))
+class MESHDEFORMATIONTOOLKIT_API UMeshRotateOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The rotation to apply
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FRotator Rotation=FRotator::ZeroRotator;
+
+	/// The center of rotation in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector CenterOfRotation=FVector::ZeroVector;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::Scale*
+UCLASS(meta=(DisplayName="Scale"))
+class MESHDEFORMATIONTOOLKIT_API UMeshScaleOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The scale for each axis
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector Scale3d=FVector(1, 1, 1);
+
+	/// The center of scaling in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector CenterOfScale=FVector::ZeroVector;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::Transform*
+UCLASS(meta=(DisplayName="Transform"))
+class MESHDEFORMATIONTOOLKIT_API UMeshTransformOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The transform to apply
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FTransform Transform;
+
+	/// The center of the transform in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector CenterOfTransform=FVector::ZeroVector;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::RotateAroundAxis*
+UCLASS(meta=(DisplayName="Rotate Around Axis"))
+class MESHDEFORMATIONTOOLKIT_API UMeshRotateAroundAxisOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// A point on the axis of rotation, in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector CenterOfRotation=FVector::ZeroVector;
+
+	/// The direction of the axis of rotation
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector Axis=FVector::UpVector;
+
+	/// The angle to rotate by
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float AngleInDegrees=0.0f;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::ScaleAlongAxis*
+UCLASS(meta=(DisplayName="Scale Along Axis"))
+class MESHDEFORMATIONTOOLKIT_API UMeshScaleAlongAxisOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The center of scaling in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector CenterOfScale=FVector::ZeroVector;
+
+	/// The direction to scale along
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector Axis=FVector::UpVector;
+
+	/// The scale along the axis
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float Scale=1.0f;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::Spherize*
+UCLASS(meta=(DisplayName="Spherize"))
+class MESHDEFORMATIONTOOLKIT_API UMeshSpherizeOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The radius of the sphere to morph towards
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float SphereRadius=100.0f;
+
+	/// How far to morph towards the sphere, 0=Not at all, 1=Completely
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float FilterStrength=1.0f;
+
+	/// The center of the sphere in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector SphereCenter=FVector::ZeroVector;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::Inflate*
+UCLASS(meta=(DisplayName="Inflate"))
+class MESHDEFORMATIONTOOLKIT_API UMeshInflateOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The distance to move the vertices along their normals
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float Offset=0.0f;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::Lerp*, blending towards another geometry such as another
+/// component's *MeshGeometry*
+UCLASS(meta=(DisplayName="Lerp"))
+class MESHDEFORMATIONTOOLKIT_API UMeshLerpOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The geometry to blend towards, which must have the same layout as the rest pose
+	UPROPERTY(Transient, BlueprintReadWrite, Category=MeshDeformationOperation)
+		UMeshGeometry *TargetMeshGeometry=nullptr;
+
+	/// How far to blend, 0=Not at all, 1=Completely
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float Alpha=0.0f;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::LerpVector*
+UCLASS(meta=(DisplayName="Lerp Vector"))
+class MESHDEFORMATIONTOOLKIT_API UMeshLerpVectorOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The point to blend towards, in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector Position=FVector::ZeroVector;
+
+	/// How far to blend, 0=Not at all, 1=Collapse completely
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float Alpha=0.0f;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// Applies *UMeshGeometry::MoveTowards*
+UCLASS(meta=(DisplayName="Move Towards"))
+class MESHDEFORMATIONTOOLKIT_API UMeshMoveTowardsOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The point to move towards, in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector Position=FVector::ZeroVector;
+
+	/// The distance to move each vertex, negative values move them away
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float Distance=0.0f;
+
+	/// Whether to stop vertices at *Position* rather than moving through it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		bool bLimitAtPosition=false;
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+};
+
+/// An operation which selects vertices from the geometry as it is at this point in the stack,
+/// rather than deforming it.  The operations after it which should be weighted by the selection
+/// use *GetOutput* as their *Selection*.  If this operation's *Selection* is set the result is
+/// multiplied by it.
+UCLASS(Abstract)
+class MESHDEFORMATIONTOOLKIT_API UMeshSelectOperation: public UMeshDeformationOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// Return the SelectionSet holding the result, which is the same object every time the
+	/// stack is evaluated.
+	UFUNCTION(
+		BlueprintPure, Category=MeshDeformationOperation,
+		meta=(
+			ToolTip="Return the SelectionSet holding this operation's result, for use by later operations"
+			)
+	)
+		USelectionSet *GetOutput();
+
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry) override;
+
+protected:
+
+	/// Make the selection from the geometry, writing it into *Into*
+	virtual USelectionSet *Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const PURE_VIRTUAL(UMeshSelectOperation::Select, return nullptr;);
+
+private:
+
+	/// The result, as returned by *GetOutput*
+	UPROPERTY(Transient)
+		USelectionSet *Output=nullptr;
+};
+
+/// Applies *UMeshGeometry::SelectNear*
+UCLASS(meta=(DisplayName="Select Near"))
+class MESHDEFORMATIONTOOLKIT_API UMeshSelectNearOperation: public UMeshSelectOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The point to select around, in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector Center=FVector::ZeroVector;
+
+	/// The distance within which vertices are fully selected
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float InnerRadius=0.0f;
+
+	/// The distance beyond which vertices aren't selected
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float OuterRadius=100.0f;
+
+protected:
+	virtual USelectionSet *Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const override;
+};
+
+/// Applies *UMeshGeometry::SelectLinear*
+UCLASS(meta=(DisplayName="Select Linear"))
+class MESHDEFORMATIONTOOLKIT_API UMeshSelectLinearOperation: public UMeshSelectOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The point where the selection is zero, in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector LineStart=FVector::ZeroVector;
+
+	/// The point where the selection is one, in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector LineEnd=FVector(0, 0, 100);
+
+	/// Whether to swap the ends of the line
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		bool bReverse=false;
+
+	/// Whether to leave vertices beyond the ends of the line unselected
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		bool bLimitToLine=false;
+
+protected:
+	virtual USelectionSet *Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const override;
+};
+
+/// Applies *UMeshGeometry::SelectByNormal*
+UCLASS(meta=(DisplayName="Select By Normal"))
+class MESHDEFORMATIONTOOLKIT_API UMeshSelectByNormalOperation: public UMeshSelectOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The direction the selected vertices' normals face
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector Facing=FVector::UpVector;
+
+	/// The angle within which vertices are fully selected
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float InnerRadiusInDegrees=0.0f;
+
+	/// The angle beyond which vertices aren't selected
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float OuterRadiusInDegrees=30.0f;
+
+protected:
+	virtual USelectionSet *Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const override;
+};
+
+/// Applies *UMeshGeometry::SelectInVolume*
+UCLASS(meta=(DisplayName="Select In Volume"))
+class MESHDEFORMATIONTOOLKIT_API UMeshSelectInVolumeOperation: public UMeshSelectOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// One corner of the box, in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector CornerA=FVector::ZeroVector;
+
+	/// The opposite corner of the box, in local space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FVector CornerB=FVector(100, 100, 100);
+
+protected:
+	virtual USelectionSet *Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const override;
+};
+
+/// Applies *UMeshGeometry::SelectByNoise*
+UCLASS(meta=(DisplayName="Select By Noise"))
+class MESHDEFORMATIONTOOLKIT_API UMeshSelectByNoiseOperation: public UMeshSelectOperation
+{
+	GENERATED_BODY()
+
+public:
+
+	/// The transform applied to the vertices before sampling the noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		FTransform Transform;
+
+	/// The seed for the noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		int32 Seed=1337;
+
+	/// The frequency of the noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float Frequency=0.01f;
+
+	/// The interpolation used by the noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		ENoiseInterpolation NoiseInterpolation=ENoiseInterpolation::Quintic;
+
+	/// The type of noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		ENoiseType NoiseType=ENoiseType::Simplex;
+
+	/// The number of octaves for fractal noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		uint8 FractalOctaves=3;
+
+	/// The lacunarity for fractal noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float FractalLacunarity=2.0f;
+
+	/// The gain for fractal noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		float FractalGain=0.5f;
+
+	/// The type of fractal noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		EFractalType FractalType=EFractalType::FBM;
+
+	/// The distance function for cellular noise
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=MeshDeformationOperation)
+		ECellularDistanceFunction CellularDistanceFunction=ECellularDistanceFunction::Euclidian;
+
+protected:
+	virtual USelectionSet *Select(UMeshGeometry *MeshGeometry, USelectionSet *Into) const override;
+};
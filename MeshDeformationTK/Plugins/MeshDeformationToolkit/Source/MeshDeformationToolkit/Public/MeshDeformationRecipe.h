@@ -0,0 +1,46 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "UObject/NoExportTypes.h"
+#include "MeshDeformationRecipe.generated.h"
+
+class UMeshGeometry;
+
+/// A reusable deformation which can be applied to many meshes, used by the
+/// *MeshDeformationBatch* commandlet to process assets offline.
+///
+/// Subclass this either in C++ or Blueprint and override *Apply* to make the
+/// selections and run the deformers on the *MeshGeometry* provided.  The batch takes
+/// care of loading the mesh beforehand and saving it afterwards.
+///
+/// Native recipes are applied to several meshes at once on worker threads, so
+/// *Apply_Implementation* must only touch the *MeshGeometry* it's given, and any objects it
+/// creates must be within it as the SelectionSets from its selectors are.  Blueprint recipes
+/// are always applied one mesh at a time on the game thread.
+///
+/// \see UMeshDeformationBatchCommandlet
+UCLASS(Blueprintable, Abstract)
+class MESHDEFORMATIONTOOLKIT_API UMeshDeformationRecipe: public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	/// Apply the deformation to a mesh.
+	///
+	/// \param MeshGeometry			The geometry to deform in place
+	UFUNCTION(
+		BlueprintNativeEvent, Category=MeshDeformationRecipe,
+		meta=(
+			ToolTip="Apply the deformation to a mesh",
+			Keywords="recipe batch deform"
+			)
+	)
+		void Apply(UMeshGeometry *MeshGeometry);
+	virtual void Apply_Implementation(UMeshGeometry *MeshGeometry);
+
+	/// Whether this recipe can be applied to several meshes at once on worker threads, which
+	/// is the case for native recipes unless they override this.
+	virtual bool CanApplyConcurrently() const;
+};
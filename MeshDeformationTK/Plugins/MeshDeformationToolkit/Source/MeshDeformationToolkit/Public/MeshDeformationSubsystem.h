@@ -0,0 +1,75 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "Subsystems/EngineSubsystem.h"
+#include "MeshDeformationSubsystem.generated.h"
+
+class UMeshDeformationComponent;
+
+/// Runs the evaluations of *MeshDeformationComponent*s which have *bTimeSliceEvaluation* set,
+/// on the game thread within a per-frame time budget.
+///
+/// Each frame the queued components are worked through in the order they were queued until
+/// the budget set by *mdt.TimeSliceBudgetMs* is used up.  Each step applies one recorded
+/// operation to a slice of the vertices, sized from the time left and the time per vertex
+/// measured so far, so a long operation is spread over several frames rather than overrunning
+/// one.  At least one step runs each frame so the work always progresses.
+///
+/// A component's *ProceduralMeshComponent* is only updated once all of its operations have run,
+/// so a half-deformed mesh is never shown.
+UCLASS()
+class MESHDEFORMATIONTOOLKIT_API UMeshDeformationSubsystem: public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/// Register with the core ticker
+	virtual void Initialize(FSubsystemCollectionBase &Collection) override;
+
+	/// Unregister from the core ticker, dropping the queue.  Queued components finish their
+	/// evaluation the next time they need the result.
+	virtual void Deinitialize() override;
+
+	/// Queue a component whose time-sliced evaluation has started.  Called by
+	/// *MeshDeformationComponent*, queueing a component which is already queued does nothing.
+	///
+	/// \param MeshDeformationComponent		The component to evaluate
+	void QueueEvaluation(UMeshDeformationComponent *MeshDeformationComponent);
+
+	/// Return the number of components whose evaluations haven't finished
+	UFUNCTION(BlueprintPure, Category = MeshDeformationSubsystem,
+		meta = (
+			ToolTip = "Get the number of MeshDeformationComponents waiting for time-sliced evaluation"
+			)
+	)
+		int32 GetNumQueuedComponents() const;
+
+	/// Finish every queued evaluation now, ignoring the budget.  This is useful behind a
+	/// loading screen, or before taking a screenshot.
+	UFUNCTION(BlueprintCallable, Category = MeshDeformationSubsystem,
+		meta = (
+			ToolTip = "Finish every time-sliced MeshDeformationComponent evaluation now"
+			)
+	)
+		void Flush();
+
+private:
+	/// The components with evaluations which haven't finished, in the order they were queued
+	TArray<TWeakObjectPtr<UMeshDeformationComponent>> Queue;
+
+	/// The measured time to deform a vertex, used to size each step
+	double SecondsPerVertex = 0.0;
+
+	/// Our registration with the core ticker
+	FDelegateHandle TickerHandle;
+
+	/// Run queued steps until the budget is used up, called every frame by the core ticker
+	bool Tick(float DeltaTime);
+
+	/// Run the next step of the first queued component, measuring how long it took
+	///
+	/// \param MaxVertexCount	The most vertices the step is to deform
+	/// \return *False* if the queue is empty
+	bool RunNextStep(int32 MaxVertexCount);
+};
@@ -3,10 +3,29 @@
 #pragma once
 
 #include "ModuleManager.h"
+#include "Stats/Stats.h"
+#include "Runtime/Launch/Resources/Version.h"
 
 // All log messages will be passed through this logger
 DECLARE_LOG_CATEGORY_EXTERN(MDTLog, Log, All);
 
+// The stats shown by 'stat MeshDeformationToolkit'.  Each operation declares its own cycle
+// stat in this group alongside these counters.
+DECLARE_STATS_GROUP(TEXT("MeshDeformationToolkit"), STATGROUP_MeshDeformationToolkit, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Vertices processed"), STAT_MDTVerticesProcessed, STATGROUP_MeshDeformationToolkit, MESHDEFORMATIONTOOLKIT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("SelectionSets allocated"), STAT_MDTSelectionSetsAllocated, STATGROUP_MeshDeformationToolkit, MESHDEFORMATIONTOOLKIT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes copied"), STAT_MDTBytesCopied, STATGROUP_MeshDeformationToolkit, MESHDEFORMATIONTOOLKIT_API);
+
+// Time an operation under a cycle stat, and also as a CPU trace event so it shows in Unreal
+// Insights.  The CPU trace scopes only exist from 4.25, so earlier engines (including the 4.23
+// this project targets) get a named event instead, which shows in the platform profilers.
+#if ENGINE_MAJOR_VERSION>4||ENGINE_MINOR_VERSION>=25
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#define MDT_SCOPE_CYCLE_COUNTER(Stat) SCOPE_CYCLE_COUNTER(Stat); TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+#else
+#define MDT_SCOPE_CYCLE_COUNTER(Stat) SCOPE_CYCLE_COUNTER(Stat); SCOPED_NAMED_EVENT(Stat, FColor::Turquoise)
+#endif
+
 /// \mainpage Mesh Deformation Toolkit
 ///
 /// This is the API documentation for the Mesh Deformation Toolkit, which is
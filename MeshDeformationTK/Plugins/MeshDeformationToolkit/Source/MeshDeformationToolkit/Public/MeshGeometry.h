@@ -5,13 +5,63 @@
 #include "UObject/NoExportTypes.h"
 #include "SectionGeometry.h"
 #include "Math/TransformNonVectorized.h"
+#include "CollisionQueryParams.h"
 #include "Runtime/Engine/Classes/Components/SplineComponent.h"
 #include "ProceduralMeshComponent.h"
 #include "SelectionSet.h"
+#include "StaticMeshBuildQueue.h"
 #include "FastNoise.h"
 #include "FastNoiseBPEnums.h"
 #include "MeshGeometry.generated.h"
 
+struct FRawMesh;
+
+/// The parts of a section which have changed since it was last saved to a
+/// *ProceduralMeshComponent*, allowing *SaveToProceduralMeshComponent* to only send what's changed.
+enum class ESectionChanges : uint8
+{
+	None = 0,
+	Positions = 1<<0,
+	Normals = 1<<1,
+	UVs = 1<<2,
+	Tangents = 1<<3,
+	VertexColors = 1<<4,
+	/// The triangles or number of vertices have changed so the section has to be rebuilt
+	Topology = 1<<5,
+	All = Positions|Normals|UVs|Tangents|VertexColors|Topology
+};
+ENUM_CLASS_FLAGS(ESectionChanges);
+
+/// A *Project* or *ProjectDown* which has been checked and had its line traces set up, ready
+/// to be applied to the vertices by *UMeshGeometry::ProjectVertexRange*.  This allows the
+/// traces to be spread over several frames, see *UProjectAsyncAction*.
+struct FMeshProjection
+{
+	/// The world to trace against
+	TWeakObjectPtr<UWorld> World;
+
+	/// The local->world transform of the mesh
+	FTransform Transform;
+
+	/// The settings shared by every trace
+	FCollisionQueryParams TraceQueryParams;
+	ECollisionChannel CollisionChannel = ECC_WorldStatic;
+
+	/// The projection in world space, before scaling by the SelectionSet
+	FVector Projection = FVector::ZeroVector;
+
+	/// The offset applied to each vertex which hits something
+	float HeightAdjust = 0.0f;
+
+	/// Whether this is a *ProjectDown*, which traces straight down from each vertex
+	bool bProjectDown = false;
+
+	/// For *Project*, the normalized projection and a point on the base plane behind every
+	/// vertex, both in local space
+	FVector ProjectionNormalInLS = FVector::ZeroVector;
+	FVector PointOnBasePlaneLS = FVector::ZeroVector;
+};
+
 /// This class stores the geometry for a mesh which can then be mutated by the
 /// methods provided to allow a range of topological deformations.
 ///
@@ -30,12 +80,32 @@ public:
 	///
 	/// This is stored as an array with each element representing the geometry of a single section
 	/// of the geometry.
-	UPROPERTY(BlueprintReadonly)
+	///
+	/// The vertex/triangle counts are cached, so any C++ code which adds or removes sections,
+	/// vertices, or triangles directly must call *RefreshCachedCounts* afterwards.
+	///
+	/// The triangles, UVs, tangents, and vertex colors are shared between copies of the
+	/// geometry until they're written (see *FSectionGeometry*), so C++ code must use the
+	/// section's accessors for them.  Blueprints read this through *GetSections*.
+	UPROPERTY(BlueprintGetter=GetSections)
 		TArray<FSectionGeometry> Sections;
 
 	/// Default constructor- creates an empty mesh.
 	UMeshGeometry();
 
+	/// Rebuild the cached counts after the geometry has been loaded from disk.
+	virtual void PostLoad() override;
+
+	/// Make sure that no attributes are left in shared buffers when saving, as only the
+	/// section's own arrays are serialized.
+	virtual void Serialize(FArchive &Ar) override;
+
+	/// Return a copy of the sections with all of their attributes in their own arrays.
+	///
+	/// This is the Blueprint view of *Sections*.
+	UFUNCTION(BlueprintGetter)
+		TArray<FSectionGeometry> GetSections() const;
+
 	/*
 	##################################################
 	Load Geometry Data
@@ -81,6 +151,11 @@ public:
 
 	All of these functions serve to select vertices based on some criteria.  They should all
 	have names beginning with *Select*, and return a new USelectionSet.
+
+	Each one also has an *...Into* version which writes into the SelectionSet passed as
+	*Into*, so one set can be reused rather than creating one each time.  These aren't pure,
+	as a pure node runs again for each pin reading its result, so the set is only written
+	when the node is executed.
 	##################################################
 	*/
 
@@ -95,6 +170,17 @@ public:
 	)
 		USelectionSet *SelectAll();
 
+	/// As *SelectAll*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category = MeshGeometry,
+		meta = (
+			ToolTip = "Selects all of the vertices at full strength, writing the result into an existing SelectionSet",
+			Keywords = "everything reuse"
+			)
+	)
+		USelectionSet *SelectAllInto(USelectionSet *Into=nullptr);
+
 	/// Selects vertices based on a noise function.
 	///
 	/// This uses the [FastNoise](https://github.com/Auburns/FastNoise) noise library by Jordan Pack and released under the MIT license.
@@ -133,6 +219,30 @@ public:
 			ECellularDistanceFunction CellularDistanceFunction=ECellularDistanceFunction::Euclidian
 		);
 
+	/// As *SelectByNoise*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category = MeshGeometry,
+		meta = (
+			ToolTip = "Select vertices based on a configurable noise function, useful for terrain or adding controlled randomness to a model, writing the result into an existing SelectionSet",
+			Keywords = "random fastnoise perlin fractal terrain reuse",
+			AutoCreateRefTerm = "Transform"
+			)
+	)
+		USelectionSet *SelectByNoiseInto(
+			FTransform Transform,
+			int32 Seed=1337,
+			float Frequency=0.01,
+			ENoiseInterpolation NoiseInterpolation=ENoiseInterpolation::Quintic,
+			ENoiseType NoiseType=ENoiseType::Simplex,
+			uint8 FractalOctaves=3,
+			float FractalLacunarity=2.0,
+			float FractalGain=0.5,
+			EFractalType FractalType=EFractalType::FBM,
+			ECellularDistanceFunction CellularDistanceFunction=ECellularDistanceFunction::Euclidian,
+			USelectionSet *Into=nullptr
+		);
+
 	/// Selects vertices with a given normal facing
 	///
 	/// This does a smooth linear selection based on the angle from the specified normal direction.
@@ -154,9 +264,25 @@ public:
 			float OuterRadiusInDegrees=30.0f
 		);
 
+	/// As *SelectByNormal*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category = MeshGeometry,
+		meta = (
+			ToolTip = "Select vertices with a given normal facing, writing the result into an existing SelectionSet",
+			Keywords = "facing vector direction reuse"
+			)
+	)
+		USelectionSet *SelectByNormalInto(
+			FVector Facing=FVector::UpVector,
+			float InnerRadiusInDegrees=0,
+			float OuterRadiusInDegrees=30.0f,
+			USelectionSet *Into=nullptr
+		);
+
 	/// Select all of the vertices which go to make up one of the Sections that a mesh
 	/// can consist of.  This can be thought of as the same as a Material slot for many
-	/// uses.
+	/// uses.  The result is stored as a mask, one bit per vertex.
 	///
 	/// \param SectionIndex
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = MeshGeometry,
@@ -167,8 +293,20 @@ public:
 	)
 		USelectionSet *SelectBySection(int32 SectionIndex);
 
+	/// As *SelectBySection*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category = MeshGeometry,
+		meta = (
+			ToolTip = "Select all of the vertices in one of the Sections making up a mesh, writing the result into an existing SelectionSet",
+			Keywords = "material geometry reuse"
+			)
+	)
+		USelectionSet *SelectBySectionInto(int32 SectionIndex, USelectionSet *Into=nullptr);
+
 	/// Select all of the vertices in a a single section by a range.  This is useful
-	/// when you know the vertex ordering of an item.
+	/// when you know the vertex ordering of an item.  The result is stored as a mask, one
+	/// bit per vertex.
 	///
 	/// \param RangeStart		The vertex index of the start of the range
 	/// \param RangeEnd			The vertex index of the end of the range
@@ -187,6 +325,22 @@ public:
 			int32 SectionIndex = 0
 			);
 
+	/// As *SelectByVertexRange*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category = MeshGeometry,
+		meta = (
+			ToolTip = "Select vertices based on their index in the mesh, writing the result into an existing SelectionSet",
+			Keywords = "for section reuse"
+			))
+		USelectionSet *SelectByVertexRangeInto(
+			int32 RangeStart,
+			int32 RangeEnd,
+			int32 RangeStep = 1,
+			int32 SectionIndex = 0,
+			USelectionSet *Into = nullptr
+			);
+
 	/// Select vertices from a texture.
 	///
 	/// Black in the channel = Unselected, White = Fully selected.  Uses UV0 for texture access as that's
@@ -206,7 +360,23 @@ public:
 			ETextureChannel TextureChannel=ETextureChannel::Red
 		);
 
-	/// Select vertices inside a volume defined by two opposite corner points.
+	/// As *SelectByTexture*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category = MeshGeometry,
+		meta = (
+			ToolTip = "Select vertices based on a channel from a texture, writing the result into an existing SelectionSet",
+			Keywords = "image picture rgb uv reuse"
+			)
+	)
+		USelectionSet *SelectByTextureInto(
+			UTexture2D *Texture2D,
+			ETextureChannel TextureChannel=ETextureChannel::Red,
+			USelectionSet *Into=nullptr
+		);
+
+	/// Select vertices inside a volume defined by two opposite corner points.  The result is
+	/// stored as a mask, one bit per vertex.
 	/// \param CornerA						The first corner to define the volume
 	/// \param CornerB						The second corner to define the volume
 	///
@@ -218,6 +388,17 @@ public:
 	)
 		USelectionSet *SelectInVolume(FVector CornerA, FVector CornerB);
 
+	/// As *SelectInVolume*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category=MeshGeometry,
+		meta = (
+			ToolTip = "Select vertices inside a volume defined by two opposite corner points, writing the result into an existing SelectionSet",
+			Keywords = "aabb bounds bounding space reuse"
+			)
+	)
+		USelectionSet *SelectInVolumeInto(FVector CornerA, FVector CornerB, USelectionSet *Into=nullptr);
+
 	/// Select vertices linearly between two points.
 	///
 	/// \param LineStart	The start of the linear gradient where weight=0
@@ -237,6 +418,23 @@ public:
 			bool bLimitToLine=false
 		);
 
+	/// As *SelectLinear*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category=MeshGeometry,
+		meta = (
+			ToolTip = "Select vertices with strength blended linearly between two points, writing the result into an existing SelectionSet",
+			Keywords = "gradient between reuse"
+			)
+	)
+		USelectionSet *SelectLinearInto(
+			FVector LineStart,
+			FVector LineEnd,
+			bool bReverse=false,
+			bool bLimitToLine=false,
+			USelectionSet *Into=nullptr
+		);
+
 	/// Selects the vertices near a point in space.
 	///
 	/// This does a smooth linear radial selection based on distance form the point provided.
@@ -258,6 +456,22 @@ public:
 			float OuterRadius=100
 		);
 
+	/// As *SelectNear*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category=MeshGeometry,
+		meta = (
+			ToolTip = "Select the vertices near a point in space, writing the result into an existing SelectionSet",
+			Keywords = "close soft reuse"
+			)
+	)
+		USelectionSet *SelectNearInto(
+			FVector Center=FVector::ZeroVector,
+			float InnerRadius=0,
+			float OuterRadius=100,
+			USelectionSet *Into=nullptr
+		);
+
 	/// Selects vertices near a line segment with the provided start/end points.
 	///
 	/// This does a smooth linear selection based on the distance from the line points provided.
@@ -284,6 +498,24 @@ public:
 			bool bLineIsInfinite=false
 		);
 
+	/// As *SelectNearLine*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category=MeshGeometry,
+		meta = (
+			ToolTip = "Select vertices near a line with the provided start/end points, writing the result into an existing SelectionSet",
+			Keywords = "infinite reuse"
+			)
+		)
+		USelectionSet *SelectNearLineInto(
+			FVector LineStart, 
+			FVector LineEnd,
+			float InnerRadius=0,
+			float OuterRadius=100,
+			bool bLineIsInfinite=false,
+			USelectionSet *Into=nullptr
+		);
+
 	/// Selects the vertices near a Spline, allowing curves to easily guide deformation.
 	///
 	/// This does a smooth linear radial selection based on distance from the spline provided.
@@ -307,6 +539,23 @@ public:
 			float OuterRadius=100
 		);
 
+	/// As *SelectNearSpline*, but writes the result into *Into* and returns it.
+	///
+	/// \param Into			The SelectionSet to write the result into, a new one is created if this is nullptr
+	UFUNCTION(BlueprintCallable, Category=MeshGeometry,
+		meta = (
+			ToolTip = "Select the vertices near a SplineCommponent, writing the result into an existing SelectionSet",
+			Keywords = "curve reuse"
+			)
+	)
+		USelectionSet *SelectNearSplineInto(
+			USplineComponent *Spline,
+			FTransform Transform,
+			float InnerRadius=0,
+			float OuterRadius=100,
+			USelectionSet *Into=nullptr
+		);
+
 	/*
 	##################################################
 	Transform Vertices
@@ -727,10 +976,13 @@ public:
 	/// Save the current geometry to a *StaticMesh*, replacing the geometry in the
 	/// mesh provided.  This will only work inside the Editor, this can't be done
 	/// in-game.
+	///
+	/// The mesh isn't built immediately, it's passed to the *StaticMeshBuildQueue* which
+	/// prepares it on a worker thread and builds it on a later tick.
 	/// 
 	/// \param StaticMesh					The mesh to replace
-	/// \param ProceduralMeshComponent		A ProceduralMeshComponent which will be used to build
-	///										all of the data structures that StaticMesh needs.
+	/// \param ProceduralMeshComponent		No longer used, the mesh data is built directly from the
+	///										geometry.  Kept so existing Blueprints still connect.
 	/// \param Materials					An array of materials which will be applied to the
 	///										built mesh.
 	/// \return *True* if the update was successful, *False* if not
@@ -746,12 +998,37 @@ public:
 			TArray<UMaterialInterface *> Materials
 		);
 
+	/// Queue the current geometry to be saved to a *StaticMesh*, as *SaveToStaticMesh* but with a
+	/// delegate which is called once the mesh has been built.
+	///
+	/// The geometry is copied when this is called, later changes won't affect the build.  If
+	/// the same mesh is queued again before it's been built then only the latest geometry is
+	/// built, and every delegate is called with the result.
+	///
+	/// \param StaticMesh					The mesh to replace
+	/// \param Materials					An array of materials which will be applied to the
+	///										built mesh.
+	/// \param OnBuilt						Called with the new mesh, or nullptr if the build failed
+	/// \return *True* if the build was queued, *False* if not
+	bool QueueSaveToStaticMesh(
+		UStaticMesh *StaticMesh,
+		const TArray<UMaterialInterface *> &Materials,
+		FOnStaticMeshBuilt OnBuilt = FOnStaticMeshBuilt()
+	);
+
 	/// Save the current geometry to a *ProceduralMeshComponent*.
 	/// 
 	/// This will rebuild the mesh, completely replacing any geometry it has there.
 	///
+	/// If *bOnlyUpdateChanges* is set, this is the same component as we last saved to, and
+	/// nothing else has saved to it since, then only the sections and attributes which have
+	/// changed are sent, using
+	/// *UpdateMeshSection_LinearColor* where the triangles haven't changed.  This avoids
+	/// rebuilding the render and collision data when deforming every frame.
+	///
 	/// \param ProceduralMeshComponent		The target *ProceduralMeshComponent
 	/// \param bCreateCollision				Whether to create a collision shape for it
+	/// \param bOnlyUpdateChanges			Whether to only send changes since the last save
 	/// \return *True* if the update was successful, *False* if not
 	UFUNCTION(BlueprintCallable, Category = MeshGeometry,
 		meta = (
@@ -762,7 +1039,8 @@ public:
 	)
 		bool SaveToProceduralMeshComponent(
 			UProceduralMeshComponent *ProceduralMeshComponent,
-			bool bCreateCollision);
+			bool bCreateCollision,
+			bool bOnlyUpdateChanges = false);
 
 	/*
 	##################################################
@@ -861,15 +1139,290 @@ public:
 	)
 		void RebuildNormals();
 
+	/// Fill a *RawMesh* with the current geometry, ready to be saved as a *StaticMesh* source
+	/// model.  Each section becomes a material index.
+	///
+	/// The arrays are sized up front and the wedges filled in parallel for large meshes, with
+	/// the same defaults for missing normals, tangents, UVs and colors as a *ProceduralMeshComponent*.
+	///
+	/// \param RawMesh						The mesh to fill, replacing anything it holds
+	void BuildRawMesh(FRawMesh &RawMesh) const;
+
+	/// Fill a *RawMesh* from a set of sections, as *BuildRawMesh* but without needing a
+	/// *MeshGeometry* so it can be run on a worker thread against a copy of the sections.
+	///
+	/// \param Sections						The sections to build the mesh from
+	/// \param RawMesh						The mesh to fill, replacing anything it holds
+	static void BuildRawMesh(const TArray<FSectionGeometry> &Sections, FRawMesh &RawMesh);
+
+	/// Rebuild the cached vertex/triangle counts and section offsets from *Sections*.
+	///
+	/// The Load functions call this, it only needs calling by C++ code which changes the
+	/// number of sections, vertices, or triangles directly.
+	void RefreshCachedCounts();
+
+	/// Record that the geometry has changed, invalidating the cached bounding box, radius, and
+	/// projection distances, and marking the changes to be sent by the next
+	/// *SaveToProceduralMeshComponent*.
+	///
+	/// All of the deformers and Load functions call this, it only needs calling by C++ code
+	/// which changes *Sections* directly.
+	///
+	/// \param Changes						The parts of the sections which have changed
+	/// \param SectionIndex					The section which has changed, or INDEX_NONE for all
+	void MarkGeometryChanged(ESectionChanges Changes = ESectionChanges::All, int32 SectionIndex = INDEX_NONE);
+
+	/// Return the changes to a section since it was last saved to a *ProceduralMeshComponent*.
+	ESectionChanges GetSectionChanges(int32 SectionIndex) const;
+
+	/// Return the geometry's generation, which changes every time the geometry does.  This
+	/// allows callers to cache anything they derive from the geometry.
+	uint32 GetGeneration() const;
+
+	/// Limit the deformers which work vertex by vertex to a range of global vertex indices, so
+	/// a long operation can be applied a slice at a time.  Deformers which work on whole
+	/// sections, such as *RebuildNormals* and *TransformUV*, ignore the range.  Used by
+	/// *MeshDeformationComponent*'s time-sliced evaluation.
+	///
+	/// \param StartVertex					The global index of the first vertex to deform
+	/// \param EndVertex					One past the global index of the last vertex to deform
+	void SetVertexRange(int32 StartVertex, int32 EndVertex);
+
+	/// Remove the range set by *SetVertexRange*.
+	///
+	/// \return Whether any deformer has been limited to the range since it was set.  If not,
+	///			the deformers run since then have done all of their work.
+	bool ClearVertexRange();
+
+	/// Copy another geometry into this one, along with the record of which sections have
+	/// changed since it was last saved.  Unlike *LoadFromMeshGeometry* this doesn't mark every
+	/// section as changed, so it can be used to fill a back buffer which is deformed away from
+	/// the game thread and then presented with *SwapGeometry*.
+	///
+	/// \param SourceMeshGeometry			The geometry to copy
+	void CopyGeometryFrom(const UMeshGeometry &SourceMeshGeometry);
+
+	/// Swap the sections, and the record of which have changed, with another geometry.  The
+	/// record of which component the sections were last saved to moves with them, so saving
+	/// this geometry to that *ProceduralMeshComponent* still only sends the changes.
+	///
+	/// \param OtherMeshGeometry			The geometry to swap with
+	void SwapGeometry(UMeshGeometry &OtherMeshGeometry);
+
+	/// Reset this geometry to a copy of another, such as a rest pose, reusing this geometry's
+	/// buffers rather than allocating new ones.  Only the parts of each section which differ
+	/// from the source are copied and marked as changed, so a *ProceduralMeshComponent* this was
+	/// saved to still only receives what's changed.
+	///
+	/// If the sections aren't laid out the same as the source's this is the same as
+	/// *LoadFromMeshGeometry*.  The source's attributes must all be shared, as they are after
+	/// *CopyGeometryFrom* or *LoadFromMeshGeometry*.
+	///
+	/// \param SourceMeshGeometry			The geometry to reset to
+	void ResetToGeometry(const UMeshGeometry &SourceMeshGeometry);
+
+	/// Move every section's triangles, UVs, tangents, and vertex colors into shared buffers (see
+	/// *FSectionGeometry::ShareAttributes*) so that *ResetToGeometry* can reset other geometries to
+	/// this one.  This doesn't change the geometry or copy any data.
+	void ShareAttributes();
+
+	/// Return the global vertex index (as used by *SelectionSet*) of the first vertex in a section.
+	///
+	/// \param SectionIndex					The section, passing the section count gives the
+	///										total number of vertices
+	/// \return The index of the section's first vertex, or INDEX_NONE if out of range
+	int32 GetSectionVertexOffset(int32 SectionIndex) const;
+
+	/// Apply an affine matrix to the vertices, blending each vertex towards its transformed
+	/// position by its weight in the SelectionSet.
+	///
+	/// This is what *Translate*, *Rotate*, *Scale*, and *Transform* use internally and runs
+	/// through the vectorized kernels in *VertexKernels*.
+	///
+	/// \param Matrix						The affine transform to apply to each vertex
+	/// \param Selection					The SelectionSet to use, or nullptr for all vertices
+	void ApplyMatrix(const FMatrix &Matrix, USelectionSet *Selection = nullptr);
+
+	/// Check the arguments to *Project* and set up its line traces, without moving any vertices.
+	/// The arguments are as for *Project*.
+	///
+	/// \param OutProjection				The projection to set up
+	/// \return *True* if the projection is ready to apply, *False* if the arguments weren't valid
+	bool PrepareProject(
+		FMeshProjection &OutProjection,
+		UObject *WorldContextObject,
+		FTransform Transform,
+		const TArray<AActor *> &IgnoredActors,
+		FVector Projection,
+		float HeightAdjust,
+		bool bTraceComplex,
+		ECollisionChannel CollisionChannel,
+		USelectionSet *Selection
+	) const;
+
+	/// Check the arguments to *ProjectDown* and set up its line traces, without moving any
+	/// vertices.  The arguments are as for *ProjectDown*.
+	///
+	/// \param OutProjection				The projection to set up
+	/// \return *True* if the projection is ready to apply, *False* if the arguments weren't valid
+	bool PrepareProjectDown(
+		FMeshProjection &OutProjection,
+		UObject *WorldContextObject,
+		FTransform Transform,
+		const TArray<AActor *> &IgnoredActors,
+		float ProjectionLength,
+		float HeightAdjust,
+		bool bTraceComplex,
+		ECollisionChannel CollisionChannel,
+		USelectionSet *Selection
+	) const;
+
+	/// Apply a projection set up by *PrepareProject* or *PrepareProjectDown* to a range of
+	/// vertices.  Projecting every vertex in any number of ranges gives the same result as a
+	/// single *Project*, provided the vertex count doesn't change in between.
+	///
+	/// \param Projection					The projection to apply
+	/// \param Selection					The SelectionSet it was prepared with, if any
+	/// \param StartVertex					The global index of the first vertex to project
+	/// \param EndVertex					The global index one past the last vertex to project
+	void ProjectVertexRange(const FMeshProjection &Projection, USelectionSet *Selection, int32 StartVertex, int32 EndVertex);
+
+	/// Fill in the weights for a range of vertices in a SelectionSet, as *SelectNearSpline* does
+	/// for every vertex.  This allows the selection to be spread over several frames.  The
+	/// other arguments are as for *SelectNearSpline*.
+	///
+	/// \param Selection					The SelectionSet to write to, which must be the right size
+	/// \param StartVertex					The global index of the first vertex to select
+	/// \param EndVertex					The global index one past the last vertex to select
+	void SelectNearSplineRange(
+		USelectionSet *Selection,
+		USplineComponent *Spline,
+		FTransform Transform,
+		float InnerRadius,
+		float OuterRadius,
+		int32 StartVertex,
+		int32 EndVertex
+	) const;
+
 private:
+	/// The global vertex index of the first vertex in each section, with a final entry
+	/// holding the total vertex count.  Rebuilt by *RefreshCachedCounts*.
+	TArray<int32> SectionVertexOffsets;
+
+	/// The total number of triangles across all sections.  Rebuilt by *RefreshCachedCounts*.
+	int32 TotalTriangleCount = 0;
+
+	/// The changes to each section since it was last saved to *LastSavedComponent*
+	TArray<ESectionChanges> SectionChanges;
+
+	/// The component we last saved to, changes are only tracked relative to this
+	TWeakObjectPtr<UProceduralMeshComponent> LastSavedComponent;
+
+	/// The number given to our last save to *LastSavedComponent*.  If anything has saved to it
+	/// since then it no longer holds what *SectionChanges* is relative to.
+	uint32 LastSaveNumber = 0;
+
+	/// Whether the last save to *LastSavedComponent* created collision
+	bool bLastSavedWithCollision = false;
+
+	/// The current generation of the geometry, bumped by *MarkGeometryChanged*.  This starts at
+	/// 1 so that a cache generation of 0 is never valid.
+	uint32 Generation = 1;
+
+	/// The cached result of *GetBoundingBox*, valid if *BoundingBoxGeneration* matches *Generation*
+	mutable FBox CachedBoundingBox;
+	mutable uint32 BoundingBoxGeneration = 0;
+
+	/// The cached result of *GetRadius*, valid if *RadiusGeneration* matches *Generation*
+	mutable float CachedRadius = 0.0f;
+	mutable uint32 RadiusGeneration = 0;
+
+	/// The cached results of *MiniumProjectionPlaneDistance* keyed by normalized direction, valid
+	/// if *ProjectionPlaneDistanceGeneration* matches *Generation*
+	mutable TMap<FVector, float> CachedProjectionPlaneDistances;
+	mutable uint32 ProjectionPlaneDistanceGeneration = 0;
+
+	/// The range of global vertex indices set by *SetVertexRange*, and whether
+	/// *ForEachVertexChunk* has been limited to it since
+	int32 VertexRangeStart = 0;
+	int32 VertexRangeEnd = MAX_int32;
+	bool bVertexRangeUsed = false;
+
+	/// Apply an affine matrix to the vertices without checking the SelectionSet size.
+	///
+	/// \param Matrix			The affine transform to apply to each vertex
+	/// \param Selection		The SelectionSet to use, which must already have been checked
+	void ApplyMatrixUnchecked(const FMatrix &Matrix, USelectionSet *Selection);
+
+	/// Run a function over every vertex in the mesh, splitting the work into chunks which
+	/// are run in parallel when the mesh is large enough (see *mdt.ParallelChunkSize*).
+	///
+	/// Each chunk only writes to its own vertices so the result is identical to a serial
+	/// pass, but the function must not depend on the order the vertices are visited in.
+	///
+	/// The sections which any chunk reports changing are marked with the provided changes.
+	/// Only the vertices within the range set by *SetVertexRange* are visited.
+	///
+	/// \param Changes			The changes to mark for each section that's changed
+	/// \param ChunkFunction	Called as (FSectionGeometry &Section, int32 StartVertex,
+	///							int32 EndVertex, int32 FirstWeightIndex) for each chunk, with
+	///							EndVertex being one past the last vertex in the chunk.  Returns
+	///							*True* if it changed anything.
+	/// \param bSplittable		If false the chunks are all run on the calling thread, for
+	///							functions which read UObjects such as splines and curves
+	template <typename ChunkFunctionType>
+	void ForEachVertexChunk(ESectionChanges Changes, ChunkFunctionType ChunkFunction, bool bSplittable = true);
+
+	/// Run a function over every vertex in the mesh in parallel, passing the weight from the
+	/// SelectionSet (or 1.0 if there's no SelectionSet).  Chunks where every weight is zero are
+	/// skipped, so sections outside the selection are left unchanged, and with a sparse
+	/// SelectionSet or a mask only the vertices with non-zero weights are visited.
+	///
+	/// \param Selection		The optional SelectionSet to take the weights from
+	/// \param Changes			The changes to mark for each section that's changed
+	/// \param VertexFunction	Called as (FSectionGeometry &Section, int32 VertexIndex, float Weight)
+	/// \param bSplittable		If false the chunks are all run on the calling thread, see
+	///							*ForEachVertexChunk*
+	template <typename VertexFunctionType>
+	void ForEachVertex(
+		USelectionSet *Selection, ESectionChanges Changes, VertexFunctionType VertexFunction, bool bSplittable = true);
+
+	/// Run a function over each chunk of vertices in parallel as a contiguous run, which is the
+	/// form *DeformationCore* and *VertexKernels* take.  As with *ForEachVertex* chunks where
+	/// every weight is zero are skipped, and with a sparse SelectionSet or a mask only the runs
+	/// of vertices with non-zero weights are passed.  A mask's runs are passed with no weights.
+	///
+	/// \param Selection		The optional SelectionSet to take the weights from
+	/// \param Changes			The changes to mark for each section that's changed
+	/// \param RunFunction		Called as (FSectionGeometry &Section, int32 StartVertex, int32 Count,
+	///							const float *Weights), with Weights being nullptr if there's
+	///							no SelectionSet
+	template <typename RunFunctionType>
+	void ForEachVertexRun(USelectionSet *Selection, ESectionChanges Changes, RunFunctionType RunFunction);
+
+	/// Create a SelectionSet, or reuse *Into*, and fill it a run of vertices at a time so it's
+	/// kept sparse when only a few weights are non-zero (see *USelectionSet::SetWeightsByBlock*).
+	///
+	/// \param Into				An existing SelectionSet to write the result into, or nullptr
+	/// \param NodeNameForWarning	The name of the calling node to report problems with
+	/// \param bBinary				If true every weight is 0.0 or 1.0, and they're stored as a mask
+	/// \param RunFunction			Called as (int32 SectionIndex, int32 StartVertex, int32 Count,
+	///								float *Weights) to write the weights of a run of vertices
+	///								within one section
+	template <typename RunFunctionType>
+	USelectionSet *SelectByRuns(USelectionSet *Into, FString NodeNameForWarning, bool bBinary, RunFunctionType RunFunction);
+
 	/// Calculate the minimum distance from the original that a plane with the provided
 	/// projection as normal would have to be to allow a plane to have all verts on one side.
-	float MiniumProjectionPlaneDistance(FVector Projection);
+	///
+	/// The result is cached per-direction until the geometry next changes.
+	float MiniumProjectionPlaneDistance(FVector Projection) const;
 
 	/// Utility function which checks the size of an (optional) selection set against the
 	/// number of vertices in the mesh geometry.  If they match return true, if not then
-	/// log a warning and return false.
-	bool SelectionSetIsRightSize(USelectionSet *Selection, FString NodeNameForWarning) const;
+	/// log a warning and return false.  The name is only formatted into the warning, so the
+	/// check doesn't allocate on the deformers' hot path.
+	bool SelectionSetIsRightSize(USelectionSet *Selection, const TCHAR *NodeNameForWarning) const;
 
 	/// Utility method to check if the mesh geometry looks right, and warns if it doesn't.
 	/// Currently this checks the following for each section:
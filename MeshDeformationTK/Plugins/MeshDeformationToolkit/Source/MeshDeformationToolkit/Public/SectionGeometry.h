@@ -5,12 +5,46 @@
 #include "ProceduralMeshComponent.h"	// Needed for FProcMeshTangent
 #include "SectionGeometry.generated.h"
 
+/// The per-section attributes which can be shared between copies of a section.
+enum class ESectionAttributes : uint8
+{
+	None = 0,
+	Triangles = 1<<0,
+	UVs = 1<<1,
+	Tangents = 1<<2,
+	VertexColors = 1<<3,
+	All = Triangles|UVs|Tangents|VertexColors
+};
+ENUM_CLASS_FLAGS(ESectionAttributes);
+
+/// The read-only buffers shared between copies of a *SectionGeometry*.
+struct FSectionSharedAttributes
+{
+	TArray<int32> Triangles;
+	TArray<FVector2D> UVs;
+	TArray<FProcMeshTangent> Tangents;
+	TArray<FLinearColor> VertexColors;
+};
+
 /// This struct stores all of the data for a single section of geometry
 /// and is basically all of the results from *UKismetProceduralMeshLibrary::GetSectionFromStaticMesh*,
 /// or passed into *ProceduralMeshComponent::CreateMeshSection_LinearColor*,
 /// packaged into a single entity.
+///
+/// ## Shared attributes
+///
+/// The deformers mostly only change the vertices (and sometimes the normals) so the
+/// triangles, UVs, tangents, and vertex colors can be shared between copies of a section
+/// using *ShareAttributes*.  Once shared an attribute is held in a reference-counted,
+/// read-only buffer and its own array is left empty, with copies of the section sharing
+/// the buffer rather than duplicating it.  The first write through a *GetMutable* accessor
+/// gives that section its own copy again.
+///
+/// This means that C++ code should always use the *Get*/*GetMutable* accessors for these
+/// attributes rather than the arrays themselves.  Blueprints never see shared attributes
+/// as *UMeshGeometry::GetSections* returns unshared copies.
 USTRUCT(BlueprintType)
-struct FSectionGeometry
+struct MESHDEFORMATIONTOOLKIT_API FSectionGeometry
 {
 	GENERATED_USTRUCT_BODY()
 
@@ -52,24 +86,108 @@ struct FSectionGeometry
 		TArray<FLinearColor> VertexColors;
 
 	/// Simple constructor of empty section
-	FSectionGeometry()
+	FSectionGeometry() = default;
+
+	/// Copy constructor - copies the contents of one SectionGeometry to another
+	FSectionGeometry(const FSectionGeometry &SourceSectionGeometry) = default;
+
+	/// Move constructor - takes the buffers from another SectionGeometry without copying,
+	/// leaving the source empty
+	FSectionGeometry(FSectionGeometry &&SourceSectionGeometry) = default;
+
+	/// Copy assignment - copies the contents of one SectionGeometry to another
+	FSectionGeometry &operator=(const FSectionGeometry &SourceSectionGeometry) = default;
+
+	/// Move assignment - takes the buffers from another SectionGeometry without copying,
+	/// leaving the source empty
+	FSectionGeometry &operator=(FSectionGeometry &&SourceSectionGeometry) = default;
+
+	/// Move the triangles, UVs, tangents, and vertex colors into a shared buffer so that
+	/// copies of this section will share them rather than duplicating them.  This doesn't
+	/// copy any data.
+	void ShareAttributes();
+
+	/// Give this section its own copy of any shared attributes, leaving it with nothing shared.
+	void UnshareAttributes();
+
+	/// Share all of another section's attributes, which must all be shared already, in place of
+	/// this section's own.  This section's arrays keep their allocations, so writing to the
+	/// attributes again later doesn't need to allocate.
+	///
+	/// \param SourceSection		The section whose attributes are shared
+	/// \return The attributes which this section wasn't already sharing with *SourceSection*
+	ESectionAttributes ShareAttributesWith(const FSectionGeometry &SourceSection);
+
+	/// Check whether attributes are currently held in a shared buffer.
+	///
+	/// \param Attributes		The attributes to check
+	/// \return *True* if any of them are shared
+	bool AreAttributesShared(ESectionAttributes Attributes) const
 	{
-		Vertices=TArray<FVector>();
-		Triangles=TArray<int32>();
-		Normals=TArray<FVector>();
-		UVs=TArray<FVector2D>();
-		Tangents=TArray<FProcMeshTangent>();
-		VertexColors=TArray<FLinearColor>();
+		return EnumHasAnyFlags(SharedAttributeFlags, Attributes);
 	}
 
-	/// Copy constructor - copies the contents of one SectionGeometry to another
-	FSectionGeometry(const FSectionGeometry &SourceSectionGeometry) {
-		// All of the items can be simply copied using the TArray<> copy constructor
-		Vertices = TArray<FVector>(SourceSectionGeometry.Vertices);
-		Triangles = TArray<int32>(SourceSectionGeometry.Triangles);
-		Normals = TArray<FVector>(SourceSectionGeometry.Normals);
-		UVs = TArray<FVector2D>(SourceSectionGeometry.UVs);
-		Tangents = TArray<FProcMeshTangent>(SourceSectionGeometry.Tangents);
-		VertexColors = TArray<FLinearColor>(SourceSectionGeometry.VertexColors);
+	/// Read-only access to the triangles, wherever they're stored
+	const TArray<int32> &GetTriangles() const
+	{
+		return AreAttributesShared(ESectionAttributes::Triangles) ? SharedAttributes->Triangles : Triangles;
 	}
+
+	/// Read-only access to the UVs, wherever they're stored
+	const TArray<FVector2D> &GetUVs() const
+	{
+		return AreAttributesShared(ESectionAttributes::UVs) ? SharedAttributes->UVs : UVs;
+	}
+
+	/// Read-only access to the tangents, wherever they're stored
+	const TArray<FProcMeshTangent> &GetTangents() const
+	{
+		return AreAttributesShared(ESectionAttributes::Tangents) ? SharedAttributes->Tangents : Tangents;
+	}
+
+	/// Read-only access to the vertex colors, wherever they're stored
+	const TArray<FLinearColor> &GetVertexColors() const
+	{
+		return AreAttributesShared(ESectionAttributes::VertexColors) ? SharedAttributes->VertexColors : VertexColors;
+	}
+
+	/// Writable access to the triangles, giving this section its own copy if they're shared.
+	///
+	/// \param bKeepContents	If *False* the contents aren't copied, for when they're about
+	///							to be completely replaced
+	TArray<int32> &GetMutableTriangles(bool bKeepContents = true);
+
+	/// Writable access to the UVs, giving this section its own copy if they're shared.
+	///
+	/// \param bKeepContents	If *False* the contents aren't copied, for when they're about
+	///							to be completely replaced
+	TArray<FVector2D> &GetMutableUVs(bool bKeepContents = true);
+
+	/// Writable access to the tangents, giving this section its own copy if they're shared.
+	///
+	/// \param bKeepContents	If *False* the contents aren't copied, for when they're about
+	///							to be completely replaced
+	TArray<FProcMeshTangent> &GetMutableTangents(bool bKeepContents = true);
+
+	/// Writable access to the vertex colors, giving this section its own copy if they're shared.
+	///
+	/// \param bKeepContents	If *False* the contents aren't copied, for when they're about
+	///							to be completely replaced
+	TArray<FLinearColor> &GetMutableVertexColors(bool bKeepContents = true);
+
+private:
+	/// Give this section its own copy of one attribute if it's shared.
+	template <typename ElementType>
+	TArray<ElementType> &UnshareAttribute(
+		TArray<ElementType> &OwnArray,
+		TArray<ElementType> FSectionSharedAttributes::*SharedArray,
+		ESectionAttributes Attribute,
+		bool bKeepContents
+	);
+
+	/// The shared buffer holding the attributes flagged in *SharedAttributeFlags*
+	TSharedPtr<const FSectionSharedAttributes, ESPMode::ThreadSafe> SharedAttributes;
+
+	/// Which attributes are currently held in *SharedAttributes* rather than the section's own arrays
+	ESectionAttributes SharedAttributeFlags = ESectionAttributes::None;
 };
\ No newline at end of file
@@ -3,9 +3,70 @@
 #pragma once
 
 #include "UObject/NoExportTypes.h"
+#include "HAL/CriticalSection.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "SelectionSet.generated.h"
 
+class USelectionSet;
+
+/// The element-wise operations which a lazily evaluated SelectionSet can be built from, see
+/// *USelectionSet::CreateLazy*.  The parameters each one uses are noted alongside it.
+enum class ESelectionExpressionOperator : uint8
+{
+	Weights,				// A SelectionSet's weights, in Source
+	Set,					// ScalarA
+	AddScalar,				// A+ScalarA
+	SubtractScalar,			// A-ScalarA
+	SubtractFromScalar,		// ScalarA-A
+	MultiplyScalar,			// A*ScalarA
+	DivideByScalar,			// A/ScalarA
+	DivideScalarBy,			// ScalarA/A
+	MinScalar,				// Min(A, ScalarA)
+	MaxScalar,				// Max(A, ScalarA)
+	Clamp,					// Clamp(A, ScalarA, ScalarB)
+	LerpToScalar,			// Lerp(A, ScalarA, ScalarB)
+	OneMinus,				// 1-A
+	Power,					// A^ScalarA
+	RemapPeriodic,			// IntegerA repeats, reversals if IntegerB is non-zero
+	Ease,					// EEasingFunc IntegerA, IntegerB steps, ScalarA blend exponent
+	Add,					// A+B
+	Subtract,				// A-B
+	Multiply,				// A*B
+	Divide,					// A/B
+	Min,					// Min(A, B)
+	Max,					// Max(A, B)
+	Lerp,					// Lerp(A, B, ScalarA)
+	LerpByWeights			// Lerp(A, B, C)
+};
+
+/// A node in the expression behind a lazily evaluated SelectionSet.  Nodes are never changed
+/// once built, so they're shared between the expressions which use them.
+struct FSelectionExpression
+{
+	ESelectionExpressionOperator Operator = ESelectionExpressionOperator::Weights;
+
+	/// The operands A, B, and C, for operators which use them
+	TArray<TSharedRef<const FSelectionExpression>, TInlineAllocator<3>> Inputs;
+
+	/// The SelectionSet read by *Weights*, which is kept alive by the SelectionSets using it
+	const USelectionSet *Source = nullptr;
+
+	/// The operator's parameters
+	float ScalarA = 0.0f;
+	float ScalarB = 0.0f;
+	int32 IntegerA = 0;
+	int32 IntegerB = 0;
+};
+
+/// How a SelectionSet holds its weights, see *Sparse weights* and *Masks* in *USelectionSet*
+UENUM()
+enum class ESelectionSetStorage : uint8
+{
+	Weights,				// Every weight, in Weights
+	Sparse,					// The non-zero weights, in SparseIndices and SparseWeights
+	Mask					// One bit for each weight, all of which are 0.0 or 1.0, in MaskWords
+};
+
 /// This stores a set of weightings for a selection set.
 ///
 /// The initial use for this is to provide the vertex weightins for *MeshGeometry*, but
@@ -16,6 +77,44 @@
 /// having versions which change values and those which return a new SelectionSet would
 /// just be confusing.
 ///
+/// ## Lazy evaluation
+///
+/// Most of the *SelectionSetBPLibrary* math nodes don't calculate anything.  Instead they
+/// return a SelectionSet which records the operation and its inputs as an expression, and
+/// the whole expression is evaluated in a single pass the first time the weights are needed-
+/// usually when a deformer uses the SelectionSet.  So a chain of math nodes allocates one set
+/// of weights and reads each input once, rather than once per node.
+///
+/// This is invisible to Blueprint, and C++ code sees the same results as long as it uses
+/// *GetWeights* and *GetMutableWeights*.  Changing a SelectionSet's weights first evaluates
+/// any expressions which still need its old weights.
+///
+/// ## Pooled weights
+///
+/// Weight buffers are recycled: when a SelectionSet is destroyed its buffer is kept in a pool
+/// by size, and the next SelectionSet needing that many weights takes it rather than
+/// allocating.  Selectors also accept an existing SelectionSet to write into, so a Blueprint
+/// which selects every frame can keep reusing one set.
+///
+/// ## Sparse weights
+///
+/// Selections which only touch a small part of a mesh, such as *SelectNear* with a small
+/// radius, are stored as just their non-zero weights and the indices of those weights.  The
+/// deformers only visit those vertices, so local edits cost time in proportion to the
+/// selection rather than the mesh.  Selectors building their weights with *SetWeightsByBlock*
+/// switch between the two forms automatically, by the proportion of non-zero weights set in
+/// 'mdt.SparseSelectionDensity'.  *GetMutableWeights* converts a sparse SelectionSet back to
+/// the full weights, while *GetWeights* returns a full copy of them and leaves it sparse.
+///
+/// ## Masks
+///
+/// Selectors which only ever give 0.0 or 1.0, such as *SelectInVolume*, store one bit per
+/// weight instead, 32 to a word.  The deformers skip whole words of unselected vertices and
+/// pass runs of selected ones on with a weight of 1.0, and the *SelectionSetBPLibrary*
+/// And/Or/Xor/Not nodes combine masks a word at a time.  Those nodes read any other
+/// SelectionSet as selected where its weight is at least 0.5.  As with sparse weights,
+/// *GetMutableWeights* converts a mask to the full weights and *GetWeights* returns a copy.
+///
 /// \todo Add a Type enum to allow SelectionSets to be used for more than just vertices.
 /// \todo Add a method to check the type/weight count so that we can check if a SelectionSet
 ///       can be used
@@ -26,9 +125,14 @@ class MESHDEFORMATIONTOOLKIT_API USelectionSet: public UObject
 	GENERATED_BODY()
 
 public:
-	/// The weights this set contains.
-	UPROPERTY(BlueprintReadWrite, Category=SelectionSet)
-		TArray<float> Weights;
+	/// Counts the SelectionSets created for 'stat MeshDeformationToolkit'
+	virtual void PostInitProperties() override;
+
+	/// Returns the weights to the pool for reuse
+	virtual void BeginDestroy() override;
+
+	/// Evaluate a lazy SelectionSet before saving, as only its weights are serialized.
+	virtual void Serialize(FArchive &Ar) override;
 
 	/// Create an empty selection set with the provided outer item and
 	/// also log errors if there are any problems.
@@ -36,13 +140,218 @@ public:
 	/// \param RequiredSize			The size of the SelectionSet
 	/// \param OuterObject			The GameObject which will own this SelectionSet
 	/// \param NodeNameForWarning	The name of the node to display in case of error
+	/// \param Into					An existing SelectionSet to reuse instead of creating one, if
+	///								provided.  It's resized and zeroed just as a new one would be.
 	static USelectionSet *CreateAndCheckValid(
-		int32 RequiredSize, UObject *OuterObject, FString NodeNameForWarning);
+		int32 RequiredSize, UObject *OuterObject, FString NodeNameForWarning, USelectionSet *Into=nullptr);
+
+	/// Create a SelectionSet whose weights are calculated from its inputs when they're first
+	/// needed, see *Lazy evaluation* above.
+	///
+	/// The inputs must all be the same size, which the result takes from the first.  Inputs
+	/// which are lazy themselves have their expressions folded into this one.
+	///
+	/// \param Operator				The operation to apply
+	/// \param Inputs				The operands, A, B, and C in order
+	/// \param ScalarA				The first scalar parameter, see *ESelectionExpressionOperator*
+	/// \param ScalarB				The second scalar parameter
+	/// \param IntegerA				The first integer parameter
+	/// \param IntegerB				The second integer parameter
+	/// \return The new SelectionSet, outered to the first input's outer
+	static USelectionSet *CreateLazy(
+		ESelectionExpressionOperator Operator, const TArray<USelectionSet *, TInlineAllocator<3>> &Inputs,
+		float ScalarA=0.0f, float ScalarB=0.0f, int32 IntegerA=0, int32 IntegerB=0
+	);
+
+	/// The number of weights the block functions work on at a time
+	static const int32 WeightBlockSize = 1024;
+
+	/// Return the weights, evaluating them first if this SelectionSet is lazy.  Sparse weights
+	/// and masks are kept as they are and a full copy of their weights is returned, which is
+	/// kept until they change.  Code reading every weight of a SelectionSet which may be sparse
+	/// or a mask should use *CopyWeights* or *GetMaskBlock* a block at a time instead.
+	const TArray<float> &GetWeights() const
+	{
+		if (Expression.IsValid())
+		{
+			const_cast<USelectionSet *>(this)->EvaluateExpression();
+		}
+		if (Storage!=ESelectionSetStorage::Weights)
+		{
+			return GetUnpackedWeights();
+		}
+		return Weights;
+	}
+
+	/// Return the weights for changing them, evaluating them first if this SelectionSet is
+	/// lazy and converting them to the full weights if they're sparse or a mask.  Any lazy
+	/// SelectionSets which read these weights are evaluated before they change.
+	TArray<float> &GetMutableWeights()
+	{
+		if (Expression.IsValid() || Storage!=ESelectionSetStorage::Weights || LazyDependents.Num()>0)
+		{
+			PrepareToModifyWeights();
+		}
+		++Revision;
+		return Weights;
+	}
+
+	/// Return a number which changes whenever the weights do, so anything worked out from them
+	/// can be kept until then.  Changes made through the array from an earlier
+	/// *GetMutableWeights* call aren't seen, so call it again for each change.
+	uint32 GetRevision() const
+	{
+		return Revision;
+	}
+
+	/// Return a hash of the weights in whichever form they're stored, evaluating them first if
+	/// this SelectionSet is lazy.  The hash is kept until the weights next change (see
+	/// *GetRevision*), so this is only safe to call from one thread at a time.
+	uint32 GetContentHash() const;
+
+	/// Return one weight, without converting sparse weights or a mask to the full weights.
+	/// Sparse weights are found by a binary search, so where every weight is needed
+	/// *GetWeights* or *CopyWeights* are quicker.
+	///
+	/// \param Index			The index of the weight
+	float GetWeight(int32 Index) const;
+
+	/// Return whether one weight counts as selected, ie is at least 0.5, reading a mask's bit
+	/// directly.
+	///
+	/// \param Index			The index of the weight
+	bool IsSelected(int32 Index) const;
+
+	/// Copy a run of the weights, without converting sparse weights or a mask to the full weights.
+	///
+	/// \param Start			The index of the first weight
+	/// \param Count			The number of weights to copy
+	/// \param Out				Where to copy them to
+	void CopyWeights(int32 Start, int32 Count, float *Out) const;
+
+	/// Return whether only the non-zero weights are stored, see *Sparse weights* above.
+	/// A lazy SelectionSet is never sparse until it's evaluated.
+	bool IsSparse() const
+	{
+		return Storage==ESelectionSetStorage::Sparse;
+	}
+
+	/// Return the indices of the non-zero weights in ascending order, when *IsSparse*
+	const TArray<int32> &GetSparseIndices() const
+	{
+		return SparseIndices;
+	}
+
+	/// Return the non-zero weights matching *GetSparseIndices*, when *IsSparse*
+	const TArray<float> &GetSparseWeights() const
+	{
+		return SparseWeights;
+	}
+
+	/// Return whether the weights are held one bit each, see *Masks* above.  A lazy
+	/// SelectionSet is never a mask until it's evaluated.
+	bool IsMask() const
+	{
+		return Storage==ESelectionSetStorage::Mask;
+	}
+
+	/// Return the bits of the mask, 32 to a word with the first weight in the lowest bit of the
+	/// first word, when *IsMask*.  The bits past the last weight are always clear.
+	const TArray<uint32> &GetMaskWords() const
+	{
+		return MaskWords;
+	}
+
+	/// Return the mask bits for a block of weights, without converting the weights.  A mask's
+	/// own words are returned where they are, anything else is read as selected where its
+	/// weight is at least 0.5 and packed into *Buffer*.
+	///
+	/// \param Start			The index of the first weight, which must be a multiple of 32
+	/// \param Count			The number of weights, at most *WeightBlockSize*
+	/// \param Buffer			Space for (Count+31)/32 words
+	const uint32 *GetMaskBlock(int32 Start, int32 Count, uint32 *Buffer) const;
+
+	/// Make this SelectionSet a mask of the size provided with every bit clear, see *Masks* above.
+	///
+	/// \param Size				The number of weights
+	/// \return The mask's words, for setting bits in.  The bits past the last weight must stay clear.
+	TArray<uint32> &CreateMask(int32 Size);
+
+	/// Set the weights a block of at most *WeightBlockSize* at a time, keeping only the non-zero
+	/// weights while there are few enough of them and switching to the full weights otherwise.
+	///
+	/// \param Size				The number of weights
+	/// \param FillBlock		Called as FillBlock(Start, Count, Out) to write the weights
+	///							Start to Start+Count-1 to Out, in ascending order of Start
+	template <typename FillBlockFunctionType>
+	void SetWeightsByBlock(int32 Size, FillBlockFunctionType FillBlock)
+	{
+		DiscardExpression();
+		EvaluateLazyDependents();
+		BeginSparseWeights(Size);
+
+		float Block[WeightBlockSize];
+		for (int32 Start = 0; Start<Size; Start += WeightBlockSize)
+		{
+			const int32 Count = FMath::Min<int32>(WeightBlockSize, Size-Start);
+			if (Storage==ESelectionSetStorage::Sparse)
+			{
+				FillBlock(Start, Count, Block);
+				AppendSparseWeights(Start, Count, Block);
+			}
+			else
+			{
+				FillBlock(Start, Count, Weights.GetData()+Start);
+			}
+		}
+	}
+
+	/// Set the weights of a mask a block of at most *WeightBlockSize* at a time, from weights
+	/// which are all 0.0 or 1.0.
+	///
+	/// \param Size				The number of weights
+	/// \param FillBlock		Called as FillBlock(Start, Count, Out) to write the weights
+	///							Start to Start+Count-1 to Out, in ascending order of Start
+	template <typename FillBlockFunctionType>
+	void SetMaskByBlock(int32 Size, FillBlockFunctionType FillBlock)
+	{
+		CreateMask(Size);
+
+		float Block[WeightBlockSize];
+		for (int32 Start = 0; Start<Size; Start += WeightBlockSize)
+		{
+			const int32 Count = FMath::Min<int32>(WeightBlockSize, Size-Start);
+			FillBlock(Start, Count, Block);
+			AppendMaskWeights(Start, Count, Block);
+		}
+	}
+
+	/// Return the memory held by the weights, in whichever form they're in
+	SIZE_T GetAllocatedSize() const;
+
+	/// Evaluate the weights now if this SelectionSet is lazy.  This needs to be done on the
+	/// game thread before passing the SelectionSet to other threads.
+	void EvaluateExpression();
+
+	/// Return whether the weights are waiting to be evaluated
+	bool IsLazy() const
+	{
+		return Expression.IsValid();
+	}
 
 	/// Creates a selection set of the size provided with zero weights.
+	///
+	/// The existing weights are reused if they're big enough, otherwise they're taken from the pool.
+	///
 	/// \param Size			The number of items in the selection set
 	void CreateSelectionSet(int32 Size);
 
+	/// Set the weights to a copy of another SelectionSet's.  If that's lazy it's evaluated
+	/// straight into these weights, leaving it unevaluated.
+	///
+	/// \param Source		The SelectionSet to copy
+	void CopyFrom(const USelectionSet &Source);
+
 	/// Empties the set, setting the size to zero.
 	void Empty();
 
@@ -69,4 +378,109 @@ public:
 		)
 	)
 		int32 Size() const;
+
+	/// Blueprint access to *Weights*, which evaluates them first if needed
+	UFUNCTION(BlueprintGetter)
+		TArray<float> K2_GetWeights() const;
+
+	/// Blueprint access to *Weights*
+	UFUNCTION(BlueprintSetter)
+		void K2_SetWeights(const TArray<float> &NewWeights);
+
+private:
+	/// The weights this set contains, which are only valid once any expression is evaluated.
+	UPROPERTY(BlueprintGetter=K2_GetWeights, BlueprintSetter=K2_SetWeights, Category=SelectionSet, meta=(AllowPrivateAccess="true"))
+		TArray<float> Weights;
+
+	/// The expression the weights are to be evaluated from, if this SelectionSet is lazy
+	TSharedPtr<const FSelectionExpression> Expression;
+
+	/// The number of weights the expression evaluates to
+	int32 ExpressionSize=0;
+
+	/// The SelectionSets the expression reads, kept here so they're not garbage collected
+	UPROPERTY(Transient)
+		TArray<USelectionSet *> ExpressionSources;
+
+	/// The lazy SelectionSets whose expressions read this one's weights, which have to be
+	/// evaluated before they change
+	TArray<TWeakObjectPtr<USelectionSet>> LazyDependents;
+
+	/// Bumped whenever the weights change, see *GetRevision*
+	uint32 Revision=0;
+
+	/// The hash from *GetContentHash*, valid while *bContentHashValid* is set and
+	/// *ContentHashRevision* matches *Revision*
+	mutable uint32 ContentHash=0;
+	mutable uint32 ContentHashRevision=0;
+	mutable bool bContentHashValid=false;
+
+	/// Which of the members below hold the weights
+	UPROPERTY()
+		ESelectionSetStorage Storage=ESelectionSetStorage::Weights;
+
+	/// The number of weights when sparse or a mask
+	UPROPERTY()
+		int32 PackedSize=0;
+
+	/// The indices of the non-zero weights when sparse, in ascending order
+	UPROPERTY()
+		TArray<int32> SparseIndices;
+
+	/// The non-zero weights when sparse, matching *SparseIndices*
+	UPROPERTY()
+		TArray<float> SparseWeights;
+
+	/// The bits when a mask, see *GetMaskWords*
+	UPROPERTY()
+		TArray<uint32> MaskWords;
+
+	/// The full weights of a sparse SelectionSet or mask, made by *GetWeights* and valid while
+	/// *bUnpackedWeightsValid* is set
+	mutable TArray<float> UnpackedWeights;
+
+	/// Whether *UnpackedWeights* holds the current sparse weights or mask
+	mutable bool bUnpackedWeightsValid=false;
+
+	/// Guards *UnpackedWeights*, as any number of threads may be reading the weights
+	mutable FCriticalSection UnpackedWeightsLock;
+
+	/// Return the full weights of a sparse SelectionSet or mask, unpacking them if needed
+	const TArray<float> &GetUnpackedWeights() const;
+
+	/// Throw away *UnpackedWeights*, as the sparse weights or mask are changing
+	void DiscardUnpackedWeights();
+
+	/// Throw away the expression, without evaluating it
+	void DiscardExpression();
+
+	/// Evaluate our expression, and those of any lazy SelectionSets reading our weights, so
+	/// the weights can be changed
+	void PrepareToModifyWeights();
+
+	/// Evaluate any lazy SelectionSets reading our weights
+	void EvaluateLazyDependents();
+
+	/// Evaluate our expression if we're lazy and convert to the full weights if we're sparse
+	/// or a mask
+	void MakeDense();
+
+	/// Start sparse weights with none set, for *AppendSparseWeights*
+	void BeginSparseWeights(int32 Size);
+
+	/// Add the non-zero weights from a block, switching to the full weights if there are too many
+	void AppendSparseWeights(int32 Start, int32 Count, const float *BlockWeights);
+
+	/// Set the bits for a block of weights in a mask
+	void AppendMaskWeights(int32 Start, int32 Count, const float *BlockWeights);
+
+	/// Throw away the sparse weights or mask, leaving the full weights to be set
+	void DiscardPackedWeights();
+
+	/// Resize the weights without initializing them, taking a buffer from the pool if the
+	/// current one isn't big enough
+	void SetNumWeightsUninitialized(int32 Size);
+
+	/// Give the weights back to the pool, leaving this SelectionSet empty
+	void ReleaseWeights();
 };
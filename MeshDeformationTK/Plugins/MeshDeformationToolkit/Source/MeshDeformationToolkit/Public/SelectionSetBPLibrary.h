@@ -13,6 +13,10 @@
 ///
 /// These methods are designed to return modified values of SelectionSets rather than
 /// change the values provided to them.
+///
+/// The arithmetic nodes don't calculate anything when they're called, they return a lazy
+/// SelectionSet holding the expression (see *USelectionSet::CreateLazy*).  The result is only
+/// calculated when it's needed, along with any other math done with it, in a single pass.
 UCLASS()
 class MESHDEFORMATIONTOOLKIT_API USelectionSetBPLibrary: public UBlueprintFunctionLibrary
 {
@@ -54,6 +58,27 @@ public:
 	)
 		static USelectionSet *AddSelectionSets(USelectionSet *A, USelectionSet *B);
 
+	/// Return a mask of the vertices selected in both of two SelectionSets
+	///
+	/// Masks are combined 32 vertices at a time.  Any other SelectionSet counts a vertex as
+	/// selected where its weight is at least 0.5.
+	///
+	/// \param A			The first SelectionSet
+	/// \param B			The second SelectionSet
+	/// \return				A mask selecting the vertices selected in A and B
+	UFUNCTION(
+		BlueprintPure,
+		meta=(
+			DisplayName="SelectionSet AND SelectionSet",
+			CompactNodeTitle="AND",
+			ToolTip="[SelectionSet AND SelectionSet] Select the vertices selected in both SelectionSets, counting weights of 0.5 or more as selected",
+			Keywords="& and mask intersect both",
+			CommutativeAssociativeBinaryOperator="true",
+			Category="Math|SelectionSet"
+		)
+	)
+		static USelectionSet *AndSelectionSets(USelectionSet *A, USelectionSet *B);
+
 	/// Clamp all values i7n the set to the minimum and maximum provided.
 	///
 	/// \param Value	The SelectionSet to clamp
@@ -72,6 +97,23 @@ public:
 	)
 		static USelectionSet *Clamp(USelectionSet *Value, float Min=0, float Max=1);
 
+	/// Count the vertices a SelectionSet selects, ie those with weights of at least 0.5.  For
+	/// a mask this counts its set bits.
+	///
+	/// \param Value		The SelectionSet to count
+	/// \return				The number of selected vertices
+	UFUNCTION(
+		BlueprintPure,
+		meta=(
+			DisplayName="Count Selected (SelectionSet)",
+			CompactNodeTitle="Count",
+			ToolTip="[Count Selected (SelectionSet)] Count the vertices with weights of 0.5 or more",
+			Keywords="count number mask popcount",
+			Category="Math|SelectionSet"
+		)
+	)
+		static int32 CountSelected(USelectionSet *Value);
+
 	/// Divides a float by all the values in a SelectionSet
 	///
 	/// \param Float			The Float to divide [*A*/B]
@@ -316,6 +358,23 @@ public:
 	)
 		static USelectionSet *MultiplySelectionSets(USelectionSet *A, USelectionSet *B);
 
+	/// Return a mask of the vertices not selected in a SelectionSet, counting weights of at
+	/// least 0.5 as selected
+	///
+	/// \param Value		The SelectionSet to invert
+	/// \return				A mask selecting the vertices not selected in Value
+	UFUNCTION(
+		BlueprintPure,
+		meta=(
+			DisplayName="NOT SelectionSet",
+			CompactNodeTitle="NOT",
+			ToolTip="[NOT SelectionSet] Select the vertices not selected in a SelectionSet, counting weights of 0.5 or more as selected",
+			Keywords="! not mask invert inverse",
+			Category="Math|SelectionSet"
+		)
+	)
+		static USelectionSet *NotSelectionSet(USelectionSet *Value);
+
 	/// Returns a SelectionSet with values 1- those of another SelectionSet
 	///
 	/// If a SelectionSet is normalized to the range 0-1 then this will reverse it.
@@ -333,6 +392,25 @@ public:
 	)
 		static USelectionSet *OneMinus(USelectionSet *Value);
 
+	/// Return a mask of the vertices selected in either of two SelectionSets, counting
+	/// weights of at least 0.5 as selected
+	///
+	/// \param A			The first SelectionSet
+	/// \param B			The second SelectionSet
+	/// \return				A mask selecting the vertices selected in A or B
+	UFUNCTION(
+		BlueprintPure,
+		meta=(
+			DisplayName="SelectionSet OR SelectionSet",
+			CompactNodeTitle="OR",
+			ToolTip="[SelectionSet OR SelectionSet] Select the vertices selected in either SelectionSet, counting weights of 0.5 or more as selected",
+			Keywords="| or mask union either",
+			CommutativeAssociativeBinaryOperator="true",
+			Category="Math|SelectionSet"
+		)
+	)
+		static USelectionSet *OrSelectionSets(USelectionSet *A, USelectionSet *B);
+
 	/// Return a SelectionSet with values based on those of another SelectionSet raised
 	/// to a power  (SelectionSet ^ Power)
 	///
@@ -451,6 +529,26 @@ public:
 	)
 		static USelectionSet *Set(USelectionSet *Value, float Float=0);
 
+	/// Store the values of a SelectionSet in an existing SelectionSet, which can then be kept and
+	/// reused rather than creating a new SelectionSet every time.
+	///
+	/// If Value is the result of other math nodes it's calculated straight into Into, so a chain
+	/// of math ending in this node creates no new weights at all.
+	///
+	/// \param Value		The SelectionSet to store
+	/// \param Into			The SelectionSet to store it in, which is resized to match
+	/// \return				Into, holding the values of Value
+	UFUNCTION(
+		BlueprintCallable,
+		meta=(
+			DisplayName="Store Into (SelectionSet)",
+			ToolTip="[Store Into (SelectionSet)] Store the values of a SelectionSet in an existing SelectionSet, to reuse it rather than creating a new one",
+			Category="Math|SelectionSet",
+			Keywords="copy assign reuse pool"
+		)
+	)
+		static USelectionSet *StoreInto(USelectionSet *Value, USelectionSet *Into);
+
 	/// Subtract a constant Float from all values of a SelectionSet
 	///
 	/// \param Value		The SelectionSet to subtract the constant from (*Value* - Float)
@@ -501,4 +599,23 @@ public:
 		)
 	)
 		static USelectionSet *SubtractSelectionSets(USelectionSet *A, USelectionSet *B);
+
+	/// Return a mask of the vertices selected in exactly one of two SelectionSets, counting
+	/// weights of at least 0.5 as selected
+	///
+	/// \param A			The first SelectionSet
+	/// \param B			The second SelectionSet
+	/// \return				A mask selecting the vertices selected in A or B but not both
+	UFUNCTION(
+		BlueprintPure,
+		meta=(
+			DisplayName="SelectionSet XOR SelectionSet",
+			CompactNodeTitle="XOR",
+			ToolTip="[SelectionSet XOR SelectionSet] Select the vertices selected in one SelectionSet but not both, counting weights of 0.5 or more as selected",
+			Keywords="^ xor mask exclusive difference",
+			CommutativeAssociativeBinaryOperator="true",
+			Category="Math|SelectionSet"
+		)
+	)
+		static USelectionSet *XorSelectionSets(USelectionSet *A, USelectionSet *B);
 };
@@ -0,0 +1,119 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "Async/Future.h"
+#include "SectionGeometry.h"
+
+class UStaticMesh;
+class UMaterialInterface;
+struct FRawMesh;
+
+/// Called when a queued *StaticMesh* build has finished, with the new mesh or nullptr if it failed
+DECLARE_DELEGATE_OneParam(FOnStaticMeshBuilt, UStaticMesh *);
+
+/// Broadcast whenever any queued build finishes, with the package name and the new mesh (or nullptr)
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnAnyStaticMeshBuilt, const FString &, UStaticMesh *);
+
+/// A queue of *StaticMesh* builds requested by *UMeshGeometry::SaveToStaticMesh*.
+///
+/// Building a *StaticMesh* is slow, and when tweaking a mesh in the editor the same asset
+/// is often saved many times a second.  Rather than building each request as it arrives
+/// the queue keeps one pending build per package, with a new request replacing the geometry
+/// of any build which hasn't finished yet so only the latest geometry is ever built.
+///
+/// Each build has its *RawMesh* prepared on a worker thread from a copy of the sections.
+/// Once it's ready the *StaticMesh* itself is built on the game thread during a later
+/// tick, at most one per tick, as the engine requires.
+///
+/// \see UMeshGeometry::QueueSaveToStaticMesh
+class MESHDEFORMATIONTOOLKIT_API FStaticMeshBuildQueue: public FGCObject
+{
+public:
+
+	/// Get the queue, creating it on first use
+	static FStaticMeshBuildQueue &Get();
+
+	/// Destroy the queue, dropping any builds which haven't finished.  Called on module shutdown.
+	static void Shutdown();
+
+	virtual ~FStaticMeshBuildQueue();
+
+	/// Queue a build of a *StaticMesh* from a set of sections, merging it with any build
+	/// for the same package which hasn't finished yet.
+	///
+	/// \param PackageName			The long package name of the mesh to build
+	/// \param AssetName			The name of the mesh asset within the package
+	/// \param Sections				The geometry to build, copied so later changes don't affect it
+	/// \param Materials			The materials to apply to the built mesh
+	/// \param OnBuilt				Called with the result once the mesh has been built
+	void QueueBuild(
+		const FString &PackageName,
+		const FString &AssetName,
+		const TArray<FSectionGeometry> &Sections,
+		const TArray<UMaterialInterface *> &Materials,
+		FOnStaticMeshBuilt OnBuilt = FOnStaticMeshBuilt()
+	);
+
+	/// Block until every queued build has finished, for commandlets and other code which
+	/// can't wait for the ticker.  The delegates are called as normal.
+	void Flush();
+
+	/// Return whether there's a build for a package which hasn't finished yet
+	bool IsBuildPending(const FString &PackageName) const;
+
+	/// Return the number of builds which haven't finished yet
+	int32 GetNumPendingBuilds() const;
+
+	/// Broadcast as each build finishes
+	FOnAnyStaticMeshBuilt OnBuildComplete;
+
+	/// Keep the materials for pending builds alive
+	virtual void AddReferencedObjects(FReferenceCollector &Collector) override;
+
+private:
+
+	FStaticMeshBuildQueue();
+
+	/// A build which hasn't finished yet
+	struct FPendingBuild
+	{
+		/// The name of the mesh asset within the package
+		FString AssetName;
+
+		/// The latest geometry to build, moved to the worker when preparation starts
+		TArray<FSectionGeometry> Sections;
+
+		/// The materials to apply to the built mesh
+		TArray<UMaterialInterface *> Materials;
+
+		/// The delegates for every request merged into this build
+		TArray<FOnStaticMeshBuilt> Callbacks;
+
+		/// Bumped every time a request is merged into this build
+		uint32 Revision = 0;
+
+		/// The revision the worker is currently preparing
+		uint32 PreparingRevision = 0;
+
+		/// The RawMesh being prepared on a worker, invalid if there isn't one
+		TFuture<TSharedPtr<FRawMesh, ESPMode::ThreadSafe>> PreparedRawMesh;
+	};
+
+	/// Start and finish builds, called every frame by the core ticker
+	bool Tick(float DeltaTime);
+
+	/// Build the *StaticMesh* from a prepared *RawMesh*, returning nullptr if it failed
+	UStaticMesh *FinishBuild(const FString &PackageName, const FPendingBuild &Build, FRawMesh &RawMesh);
+
+	/// The builds which haven't finished yet, by package name
+	TMap<FString, FPendingBuild> PendingBuilds;
+
+	/// Our registration with the core ticker
+	FDelegateHandle TickerHandle;
+
+	/// The queue, created by *Get*
+	static TUniquePtr<FStaticMeshBuildQueue> Instance;
+};
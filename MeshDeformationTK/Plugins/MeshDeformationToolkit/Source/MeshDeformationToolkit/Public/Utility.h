@@ -26,6 +26,12 @@ public:
 	/// Given a plane this returns the nearest point on it to the vertex provided
 	static FVector NearestPointOnPlane(FVector Vertex, FVector PointOnPlane, FVector PlaneNormal);
 
+	/// Build a matrix which applies the provided matrix about a center point rather than the origin.
+	///
+	/// \param Matrix			The affine transform to apply
+	/// \param Center			The point which the transform should be applied about
+	static FMatrix MatrixAboutCenter(const FMatrix &Matrix, const FVector &Center);
+
 	/// Utility function which checks that two SelectionSets are provided, and are
 	/// the same size.
 	///
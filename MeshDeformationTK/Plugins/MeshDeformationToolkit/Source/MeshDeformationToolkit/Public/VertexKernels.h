@@ -0,0 +1,34 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/// Vectorized inner loops for the deformers which are pure arithmetic.
+///
+/// These use the engine's *VectorRegister* functions (SSE on x86, NEON on ARM) so
+/// they don't need any platform-specific code here.  The weighted blend between the
+/// original and transformed position is done in the same pass as the transform, so
+/// each vertex is only loaded and stored once.
+///
+/// All of the functions take an optional pointer to the weights for the vertices being
+/// processed, with *nullptr* meaning a weight of 1.0 for every vertex.
+class MESHDEFORMATIONTOOLKIT_API VertexKernels
+{
+public:
+
+	/// Transform a run of positions by an affine matrix and blend each towards the result
+	/// by its weight, so Position = Lerp(Position, Position * Matrix, Weight).
+	///
+	/// This works on four vertices per register by transposing each four packed XYZ triples
+	/// into registers of X, Y, and Z, with any remainder padded out to four.  Every vertex goes
+	/// through the same arithmetic wherever it falls in the run, which on SSE gives exactly
+	/// FMath::Lerp(Position, Matrix.TransformPosition(Position), Weight), or
+	/// Matrix.TransformPosition(Position) when unweighted.
+	///
+	/// \param Positions		The positions to transform in place
+	/// \param Count			The number of positions
+	/// \param Matrix			The affine transform to apply
+	/// \param Weights			The weight for each position, or nullptr for all 1.0
+	static void TransformPositions(FVector *Positions, int32 Count, const FMatrix &Matrix, const float *Weights);
+};
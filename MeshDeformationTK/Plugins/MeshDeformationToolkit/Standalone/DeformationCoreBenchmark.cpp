@@ -0,0 +1,184 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+// Benchmarks for the deformation core which run without the engine, see CMakeLists.txt.
+// These time the kernels alone, MeshDeformationBenchmarkCommandlet times the full nodes
+// including chunking and SelectionSets inside the engine.
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DeformationCore.h"
+
+namespace
+{
+	using Float3 = DeformationCore::Float3;
+
+	/// A rippled square grid with at least Count vertices, with a normal for each
+	struct FGrid
+	{
+		std::vector<Float3> Positions;
+		std::vector<Float3> Normals;
+		std::vector<float> Weights;
+
+		explicit FGrid(int64_t Count)
+		{
+			const int32_t Side = (int32_t)std::ceil(std::sqrt((double)Count));
+			for (int32_t Y = 0; Y<Side; ++Y)
+			{
+				for (int32_t X = 0; X<Side; ++X)
+				{
+					Positions.push_back({X*10.0f, Y*10.0f, std::sin(X*0.1f)*std::cos(Y*0.1f)*10.0f});
+					Normals.push_back({0.0f, 0.0f, 1.0f});
+					Weights.push_back(((X+Y)%5)*0.25f);
+				}
+			}
+		}
+
+		int32_t Count() const
+		{
+			return (int32_t)Positions.size();
+		}
+	};
+
+	/// Report the vertices processed per second, so sizes can be compared
+	void SetVerticesProcessed(benchmark::State &State, const FGrid &Grid)
+	{
+		State.SetItemsProcessed((int64_t)State.iterations()*Grid.Count());
+	}
+}
+
+static void BM_Inflate(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	for (auto _:State)
+	{
+		DeformationCore::Inflate(Grid.Positions.data(), Grid.Normals.data(), Grid.Count(), 0.001f, Grid.Weights.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_Inflate)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_LerpTowards(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	for (auto _:State)
+	{
+		DeformationCore::LerpTowards(Grid.Positions.data(), Grid.Count(), {0.0f, 0.0f, 0.0f}, 0.001f, Grid.Weights.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_LerpTowards)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_RotateAroundAxis(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	const Float3 Axis = {0.0f, 0.0f, 1.0f};
+	for (auto _:State)
+	{
+		DeformationCore::RotateAroundAxis(Grid.Positions.data(), Grid.Count(), {0.0f, 0.0f, 0.0f}, Axis, Axis, 1.0f, Grid.Weights.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_RotateAroundAxis)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_Spherize(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	for (auto _:State)
+	{
+		DeformationCore::Spherize(Grid.Positions.data(), Grid.Count(), {0.0f, 0.0f, 0.0f}, 500.0f, 0.001f, Grid.Weights.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_Spherize)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_SelectNear(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	std::vector<float> Out(Grid.Positions.size());
+	for (auto _:State)
+	{
+		DeformationCore::SelectNear(Grid.Positions.data(), Grid.Count(), {0.0f, 0.0f, 0.0f}, 100.0f, 500.0f, Out.data());
+		benchmark::DoNotOptimize(Out.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_SelectNear)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_SelectLinear(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	std::vector<float> Out(Grid.Positions.size());
+	for (auto _:State)
+	{
+		DeformationCore::SelectLinear(Grid.Positions.data(), Grid.Count(), {0.0f, 0.0f, 0.0f}, {1000.0f, 1000.0f, 0.0f}, false, Out.data());
+		benchmark::DoNotOptimize(Out.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_SelectLinear)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_Multiply(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	std::vector<float> Out(Grid.Weights.size());
+	for (auto _:State)
+	{
+		DeformationCore::Multiply(Grid.Weights.data(), Grid.Weights.data(), Grid.Count(), Out.data());
+		benchmark::DoNotOptimize(Out.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_Multiply)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_RemapToRange(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	std::vector<float> Out(Grid.Weights.size());
+	for (auto _:State)
+	{
+		DeformationCore::RemapToRange(Grid.Weights.data(), 0.25f, 0.75f, Grid.Count(), Out.data());
+		benchmark::DoNotOptimize(Out.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_RemapToRange)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_PackMask(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	std::vector<uint32_t> Out((Grid.Weights.size()+31)/32);
+	for (auto _:State)
+	{
+		DeformationCore::PackMask(Grid.Weights.data(), 0.5f, Grid.Count(), Out.data());
+		benchmark::DoNotOptimize(Out.data());
+		benchmark::ClobberMemory();
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_PackMask)->RangeMultiplier(10)->Range(1000, 1000000);
+
+static void BM_CountMask(benchmark::State &State)
+{
+	FGrid Grid(State.range(0));
+	std::vector<uint32_t> Mask((Grid.Weights.size()+31)/32);
+	DeformationCore::PackMask(Grid.Weights.data(), 0.5f, Grid.Count(), Mask.data());
+	for (auto _:State)
+	{
+		benchmark::DoNotOptimize(DeformationCore::CountMask(Mask.data(), Grid.Count()));
+	}
+	SetVerticesProcessed(State, Grid);
+}
+BENCHMARK(BM_CountMask)->RangeMultiplier(10)->Range(1000, 1000000);
+
+BENCHMARK_MAIN();
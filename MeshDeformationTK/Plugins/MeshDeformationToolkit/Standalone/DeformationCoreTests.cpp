@@ -0,0 +1,409 @@
+// (c)2017 Paul Golds, released under MIT License.
+
+// Unit tests for the deformation core which run without the engine, see CMakeLists.txt.
+// The engine's automation tests in Private/Tests/DeformationCoreTests.cpp check the same
+// functions against FVector and FMath, these check them against plain formulas.
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "DeformationCore.h"
+
+namespace
+{
+	using Float3 = DeformationCore::Float3;
+
+	const float Tolerance = 1.e-3f;
+
+	/// Positions scattered around the origin, 67 of them so runs aren't a multiple of
+	/// anything convenient
+	std::vector<Float3> CreateTestPositions()
+	{
+		std::vector<Float3> Positions;
+		for (int32_t Index = 0; Index<67; ++Index)
+		{
+			Positions.push_back({std::sin(Index*0.7f)*120.0f, std::cos(Index*1.3f)*80.0f, Index*3.0f-100.0f});
+		}
+		return Positions;
+	}
+
+	/// A weight for each position, including 0.0 and 1.0
+	std::vector<float> CreateTestWeights(size_t Count)
+	{
+		std::vector<float> Weights;
+		for (size_t Index = 0; Index<Count; ++Index)
+		{
+			Weights.push_back((Index%5)*0.25f);
+		}
+		return Weights;
+	}
+
+	Float3 Add(const Float3 &A, const Float3 &B)
+	{
+		return {A.X+B.X, A.Y+B.Y, A.Z+B.Z};
+	}
+
+	Float3 Subtract(const Float3 &A, const Float3 &B)
+	{
+		return {A.X-B.X, A.Y-B.Y, A.Z-B.Z};
+	}
+
+	Float3 Scale(const Float3 &A, float Scale)
+	{
+		return {A.X*Scale, A.Y*Scale, A.Z*Scale};
+	}
+
+	float Dot(const Float3 &A, const Float3 &B)
+	{
+		return A.X*B.X+A.Y*B.Y+A.Z*B.Z;
+	}
+
+	Float3 Cross(const Float3 &A, const Float3 &B)
+	{
+		return {A.Y*B.Z-A.Z*B.Y, A.Z*B.X-A.X*B.Z, A.X*B.Y-A.Y*B.X};
+	}
+
+	float Length(const Float3 &A)
+	{
+		return std::sqrt(Dot(A, A));
+	}
+
+	Float3 Normalize(const Float3 &A)
+	{
+		return Scale(A, 1.0f/Length(A));
+	}
+
+	/// Check each position against the expected one, to within a small tolerance
+	void ExpectSamePositions(const std::vector<Float3> &Actual, const std::vector<Float3> &Expected)
+	{
+		ASSERT_EQ(Actual.size(), Expected.size());
+		for (size_t Index = 0; Index<Expected.size(); ++Index)
+		{
+			EXPECT_NEAR(Actual[Index].X, Expected[Index].X, Tolerance) << "position " << Index;
+			EXPECT_NEAR(Actual[Index].Y, Expected[Index].Y, Tolerance) << "position " << Index;
+			EXPECT_NEAR(Actual[Index].Z, Expected[Index].Z, Tolerance) << "position " << Index;
+		}
+	}
+}
+
+// Deformers
+
+TEST(DeformationCoreDeformers, Inflate)
+{
+	std::vector<Float3> Actual = CreateTestPositions(), Expected = Actual;
+	std::vector<Float3> Normals;
+	for (const Float3 &Position:Actual)
+	{
+		Normals.push_back(Normalize(Position));
+	}
+	const std::vector<float> Weights = CreateTestWeights(Actual.size());
+
+	DeformationCore::Inflate(Actual.data(), Normals.data(), (int32_t)Actual.size(), 7.0f, Weights.data());
+	for (size_t Index = 0; Index<Expected.size(); ++Index)
+	{
+		Expected[Index] = Add(Expected[Index], Scale(Normals[Index], 7.0f*Weights[Index]));
+	}
+	ExpectSamePositions(Actual, Expected);
+}
+
+TEST(DeformationCoreDeformers, NoWeightsIsFullWeight)
+{
+	std::vector<Float3> Unweighted = CreateTestPositions(), Weighted = Unweighted;
+	const std::vector<float> Ones(Unweighted.size(), 1.0f);
+	const Float3 Center = {10.0f, -20.0f, 5.0f};
+
+	DeformationCore::Spherize(Unweighted.data(), (int32_t)Unweighted.size(), Center, 50.0f, 0.8f, nullptr);
+	DeformationCore::Spherize(Weighted.data(), (int32_t)Weighted.size(), Center, 50.0f, 0.8f, Ones.data());
+	ExpectSamePositions(Unweighted, Weighted);
+}
+
+TEST(DeformationCoreDeformers, LerpTowards)
+{
+	std::vector<Float3> Actual = CreateTestPositions(), Expected = Actual;
+	const std::vector<float> Weights = CreateTestWeights(Actual.size());
+	const Float3 Target = {10.0f, -20.0f, 5.0f};
+
+	DeformationCore::LerpTowards(Actual.data(), (int32_t)Actual.size(), Target, 0.4f, Weights.data());
+	for (size_t Index = 0; Index<Expected.size(); ++Index)
+	{
+		Expected[Index] = Add(Expected[Index], Scale(Subtract(Target, Expected[Index]), 0.4f*Weights[Index]));
+	}
+	ExpectSamePositions(Actual, Expected);
+}
+
+TEST(DeformationCoreDeformers, MoveTowards)
+{
+	const Float3 Target = {0.0f, 0.0f, 0.0f};
+	std::vector<Float3> Positions = {{100.0f, 0.0f, 0.0f}, {0.0f, 10.0f, 0.0f}, {0.0f, 0.0f, -30.0f}};
+
+	// Limited, the second position would pass through the target so stops on it.
+	std::vector<Float3> Limited = Positions;
+	DeformationCore::MoveTowards(Limited.data(), (int32_t)Limited.size(), Target, 20.0f, true, nullptr);
+	ExpectSamePositions(Limited, {{80.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -10.0f}});
+
+	// Unlimited, it carries on out the other side.
+	std::vector<Float3> Unlimited = Positions;
+	DeformationCore::MoveTowards(Unlimited.data(), (int32_t)Unlimited.size(), Target, 20.0f, false, nullptr);
+	ExpectSamePositions(Unlimited, {{80.0f, 0.0f, 0.0f}, {0.0f, -10.0f, 0.0f}, {0.0f, 0.0f, -10.0f}});
+}
+
+TEST(DeformationCoreDeformers, RotateAroundAxis)
+{
+	std::vector<Float3> Actual = CreateTestPositions(), Expected = Actual;
+	const std::vector<float> Weights = CreateTestWeights(Actual.size());
+	const Float3 Center = {10.0f, -20.0f, 5.0f};
+	const Float3 Axis = {1.0f, 2.0f, 0.5f};
+	const Float3 UnitAxis = Normalize(Axis);
+
+	DeformationCore::RotateAroundAxis(Actual.data(), (int32_t)Actual.size(), Center, Axis, UnitAxis, 60.0f, Weights.data());
+
+	// Rodrigues' rotation of the offset from the center, which works for the offset from
+	// any point on the axis as the part along the axis is unchanged.
+	for (size_t Index = 0; Index<Expected.size(); ++Index)
+	{
+		const float Angle = 60.0f*Weights[Index]*3.14159265358979323846f/180.0f;
+		const Float3 Offset = Subtract(Expected[Index], Center);
+		const Float3 Rotated = Add(
+			Add(Scale(Offset, std::cos(Angle)), Scale(Cross(UnitAxis, Offset), std::sin(Angle))),
+			Scale(UnitAxis, Dot(UnitAxis, Offset)*(1.0f-std::cos(Angle)))
+		);
+		Expected[Index] = Add(Center, Rotated);
+	}
+	ExpectSamePositions(Actual, Expected);
+}
+
+TEST(DeformationCoreDeformers, ScaleAlongAxis)
+{
+	std::vector<Float3> Actual = CreateTestPositions(), Expected = Actual;
+	const std::vector<float> Weights = CreateTestWeights(Actual.size());
+	const Float3 Center = {10.0f, -20.0f, 5.0f};
+	const Float3 Axis = {0.0f, 2.0f, 0.0f};
+
+	// Along the Y axis only Y changes.
+	DeformationCore::ScaleAlongAxis(Actual.data(), (int32_t)Actual.size(), Center, Axis, 1.7f, Weights.data());
+	for (size_t Index = 0; Index<Expected.size(); ++Index)
+	{
+		const float ScaledY = Center.Y+(Expected[Index].Y-Center.Y)*1.7f;
+		Expected[Index].Y += (ScaledY-Expected[Index].Y)*Weights[Index];
+	}
+	ExpectSamePositions(Actual, Expected);
+}
+
+TEST(DeformationCoreDeformers, Spherize)
+{
+	std::vector<Float3> Actual = CreateTestPositions(), Expected = Actual;
+	const std::vector<float> Weights = CreateTestWeights(Actual.size());
+	const Float3 Center = {10.0f, -20.0f, 5.0f};
+
+	DeformationCore::Spherize(Actual.data(), (int32_t)Actual.size(), Center, 50.0f, 0.8f, Weights.data());
+	for (size_t Index = 0; Index<Expected.size(); ++Index)
+	{
+		const Float3 RelativeToCenter = Subtract(Expected[Index], Center);
+		const float Distance = Length(RelativeToCenter);
+		const float TargetDistance = Distance+(50.0f-Distance)*0.8f*Weights[Index];
+		Expected[Index] = Add(Center, Scale(RelativeToCenter, TargetDistance/Distance));
+	}
+	ExpectSamePositions(Actual, Expected);
+}
+
+// Selectors
+
+TEST(DeformationCoreSelectors, SelectInVolume)
+{
+	// The volume includes its faces, and the corners can be given either way round.
+	const std::vector<Float3> Positions = {{-10.0f, -10.0f, -10.0f}, {10.0f, 10.0f, 10.0f}, {10.0f, 0.0f, 10.01f}, {0.0f, 0.0f, 0.0f}};
+	std::vector<float> Out(Positions.size());
+	DeformationCore::SelectInVolume(Positions.data(), (int32_t)Positions.size(), {10.0f, 10.0f, 10.0f}, {-10.0f, -10.0f, -10.0f}, Out.data());
+	EXPECT_EQ(Out, (std::vector<float>{1.0f, 1.0f, 0.0f, 1.0f}));
+}
+
+TEST(DeformationCoreSelectors, SelectLinear)
+{
+	const std::vector<Float3> Positions = {{-5.0f, 3.0f, 0.0f}, {25.0f, -8.0f, 1.0f}, {100.0f, 0.0f, 0.0f}, {150.0f, 0.0f, 0.0f}};
+	std::vector<float> Out(Positions.size());
+
+	DeformationCore::SelectLinear(Positions.data(), (int32_t)Positions.size(), {0.0f, 0.0f, 0.0f}, {100.0f, 0.0f, 0.0f}, false, Out.data());
+	EXPECT_EQ(Out, (std::vector<float>{0.0f, 0.25f, 1.0f, 1.0f}));
+
+	// Limited to the line, anything at or past the end isn't selected.
+	DeformationCore::SelectLinear(Positions.data(), (int32_t)Positions.size(), {0.0f, 0.0f, 0.0f}, {100.0f, 0.0f, 0.0f}, true, Out.data());
+	EXPECT_EQ(Out, (std::vector<float>{0.0f, 0.25f, 0.0f, 0.0f}));
+}
+
+TEST(DeformationCoreSelectors, SelectNear)
+{
+	const std::vector<Float3> Positions = CreateTestPositions();
+	std::vector<float> Out(Positions.size());
+	DeformationCore::SelectNear(Positions.data(), (int32_t)Positions.size(), {0.0f, 0.0f, 0.0f}, 50.0f, 150.0f, Out.data());
+	for (size_t Index = 0; Index<Positions.size(); ++Index)
+	{
+		const float Distance = Length(Positions[Index]);
+		const float Expected = Distance<=50.0f ? 1.0f : Distance>=150.0f ? 0.0f : 1.0f-(Distance-50.0f)/100.0f;
+		EXPECT_NEAR(Out[Index], Expected, 1.e-4f) << "weight " << Index;
+	}
+}
+
+TEST(DeformationCoreSelectors, SelectNearLine)
+{
+	// Beside the line, past its end, and far past its end.
+	const std::vector<Float3> Positions = {{50.0f, 10.0f, 0.0f}, {110.0f, 0.0f, 0.0f}, {300.0f, 5.0f, 0.0f}};
+	std::vector<float> Out(Positions.size());
+
+	DeformationCore::SelectNearLine(
+		Positions.data(), (int32_t)Positions.size(), {0.0f, 0.0f, 0.0f}, {100.0f, 0.0f, 0.0f}, 0.0f, 20.0f, false, Out.data());
+	EXPECT_NEAR(Out[0], 0.5f, 1.e-5f);
+	EXPECT_NEAR(Out[1], 0.5f, 1.e-5f);
+	EXPECT_EQ(Out[2], 0.0f);
+
+	// An infinite line carries on past the end.
+	DeformationCore::SelectNearLine(
+		Positions.data(), (int32_t)Positions.size(), {0.0f, 0.0f, 0.0f}, {100.0f, 0.0f, 0.0f}, 0.0f, 20.0f, true, Out.data());
+	EXPECT_NEAR(Out[0], 0.5f, 1.e-5f);
+	EXPECT_EQ(Out[1], 1.0f);
+	EXPECT_NEAR(Out[2], 0.75f, 1.e-5f);
+}
+
+// Weight arithmetic
+
+TEST(DeformationCoreWeights, ElementWise)
+{
+	const std::vector<float> A = CreateTestWeights(67);
+	std::vector<float> B;
+	for (size_t Index = 0; Index<A.size(); ++Index)
+	{
+		B.push_back(1.0f-(Index%3)*0.3f);
+	}
+	const int32_t Count = (int32_t)A.size();
+	std::vector<float> Out(A.size());
+
+	DeformationCore::Add(A.data(), B.data(), Count, Out.data());
+	for (size_t Index = 0; Index<A.size(); ++Index)
+	{
+		EXPECT_EQ(Out[Index], A[Index]+B[Index]);
+	}
+	DeformationCore::Multiply(A.data(), B.data(), Count, Out.data());
+	for (size_t Index = 0; Index<A.size(); ++Index)
+	{
+		EXPECT_EQ(Out[Index], A[Index]*B[Index]);
+	}
+	DeformationCore::LerpByWeights(A.data(), B.data(), B.data(), Count, Out.data());
+	for (size_t Index = 0; Index<A.size(); ++Index)
+	{
+		EXPECT_NEAR(Out[Index], A[Index]+(B[Index]-A[Index])*B[Index], 1.e-6f);
+	}
+	DeformationCore::Clamp(A.data(), 0.2f, 0.6f, Count, Out.data());
+	for (size_t Index = 0; Index<A.size(); ++Index)
+	{
+		EXPECT_EQ(Out[Index], A[Index]<0.2f ? 0.2f : A[Index]>0.6f ? 0.6f : A[Index]);
+	}
+}
+
+TEST(DeformationCoreWeights, InPlace)
+{
+	// The weight functions may write over their input.
+	std::vector<float> Weights = CreateTestWeights(67);
+	const std::vector<float> Original = Weights;
+	DeformationCore::OneMinus(Weights.data(), (int32_t)Weights.size(), Weights.data());
+	DeformationCore::Add(Weights.data(), Original.data(), (int32_t)Weights.size(), Weights.data());
+	EXPECT_EQ(Weights, std::vector<float>(Weights.size(), 1.0f));
+}
+
+TEST(DeformationCoreWeights, DivideScalarBy)
+{
+	// Divisors near zero are pushed 0.01 away from it, keeping their sign.
+	const std::vector<float> A = {2.0f, 0.0f, -0.001f, 0.5f};
+	std::vector<float> Out(A.size());
+	DeformationCore::DivideScalarBy(1.0f, A.data(), (int32_t)A.size(), Out.data());
+	EXPECT_FLOAT_EQ(Out[0], 0.5f);
+	EXPECT_FLOAT_EQ(Out[1], 100.0f);
+	EXPECT_FLOAT_EQ(Out[2], -100.0f);
+	EXPECT_FLOAT_EQ(Out[3], 2.0f);
+}
+
+TEST(DeformationCoreWeights, RemapPeriodic)
+{
+	const std::vector<float> A = {0.0f, 0.125f, 0.375f, 0.625f};
+	std::vector<float> Out(A.size());
+
+	DeformationCore::RemapPeriodic(A.data(), 2, false, (int32_t)A.size(), Out.data());
+	EXPECT_EQ(Out, (std::vector<float>{0.0f, 0.25f, 0.75f, 0.25f}));
+
+	// Every other repeat runs backwards.
+	DeformationCore::RemapPeriodic(A.data(), 2, true, (int32_t)A.size(), Out.data());
+	EXPECT_EQ(Out, (std::vector<float>{0.0f, 0.25f, 0.75f, 0.75f}));
+}
+
+TEST(DeformationCoreWeights, RemapToRange)
+{
+	std::vector<float> Weights = CreateTestWeights(67);
+	DeformationCore::RemapToRange(Weights.data(), 2.0f, 4.0f, (int32_t)Weights.size(), Weights.data());
+	float Minimum = Weights[0], Maximum = Weights[0];
+	for (const float Weight:Weights)
+	{
+		Minimum = Weight<Minimum ? Weight : Minimum;
+		Maximum = Weight>Maximum ? Weight : Maximum;
+	}
+	EXPECT_EQ(Minimum, 2.0f);
+	EXPECT_EQ(Maximum, 4.0f);
+
+	// A flat input has no range, so it all maps to the minimum.
+	DeformationCore::Set(0.5f, (int32_t)Weights.size(), Weights.data());
+	DeformationCore::RemapToRange(Weights.data(), 2.0f, 4.0f, (int32_t)Weights.size(), Weights.data());
+	EXPECT_EQ(Weights, std::vector<float>(Weights.size(), 2.0f));
+}
+
+// Masks
+
+TEST(DeformationCoreMasks, PackCountAndNot)
+{
+	// A partial last word, to check the bits past the last weight stay clear.
+	const int32_t Count = 100;
+	const std::vector<float> Weights = CreateTestWeights(Count);
+	std::vector<uint32_t> Mask((Count+31)/32), NotMask(Mask.size());
+	DeformationCore::PackMask(Weights.data(), 0.5f, Count, Mask.data());
+	DeformationCore::NotMask(Mask.data(), Count, NotMask.data());
+
+	int32_t ExpectedCount = 0;
+	for (int32_t Index = 0; Index<Count; ++Index)
+	{
+		const bool bSet = Weights[Index]>=0.5f;
+		ExpectedCount += bSet ? 1 : 0;
+		EXPECT_EQ((Mask[Index/32]>>(Index%32))&1u, bSet ? 1u : 0u) << "bit " << Index;
+	}
+	EXPECT_EQ(DeformationCore::CountMask(Mask.data(), Count), ExpectedCount);
+	EXPECT_EQ(DeformationCore::CountMask(NotMask.data(), Count), Count-ExpectedCount);
+	EXPECT_EQ(NotMask.back()>>(Count%32), 0u);
+}
+
+TEST(DeformationCoreMasks, Unpack)
+{
+	// Unpacking from part way through a word matches the weights it was packed from.
+	const int32_t Count = 100;
+	const std::vector<float> Weights = CreateTestWeights(Count);
+	std::vector<uint32_t> Mask((Count+31)/32);
+	DeformationCore::PackMask(Weights.data(), 0.5f, Count, Mask.data());
+
+	std::vector<float> Unpacked(Count-37);
+	DeformationCore::UnpackMask(Mask.data(), 37, (int32_t)Unpacked.size(), Unpacked.data());
+	for (size_t Index = 0; Index<Unpacked.size(); ++Index)
+	{
+		EXPECT_EQ(Unpacked[Index], Weights[37+Index]>=0.5f ? 1.0f : 0.0f) << "weight " << 37+Index;
+	}
+}
+
+TEST(DeformationCoreMasks, Combine)
+{
+	const int32_t Count = 40;
+	const std::vector<uint32_t> A = {0xf0f0f0f0u, 0x0000003fu};
+	const std::vector<uint32_t> B = {0xff00ff00u, 0x000000aau};
+	std::vector<uint32_t> Out(A.size());
+
+	DeformationCore::AndMask(A.data(), B.data(), Count, Out.data());
+	EXPECT_EQ(Out, (std::vector<uint32_t>{0xf000f000u, 0x0000002au}));
+	DeformationCore::OrMask(A.data(), B.data(), Count, Out.data());
+	EXPECT_EQ(Out, (std::vector<uint32_t>{0xfff0fff0u, 0x000000bfu}));
+	DeformationCore::XorMask(A.data(), B.data(), Count, Out.data());
+	EXPECT_EQ(Out, (std::vector<uint32_t>{0x0ff00ff0u, 0x00000095u}));
+}